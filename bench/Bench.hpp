@@ -0,0 +1,74 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// Settings shared by every benchmark, filled from the command line
+struct BenchOptions {
+    fs::path root;              // Tree to benchmark against (generated when not given)
+    std::size_t maxThreads = 1; // Upper bound for thread scaling runs
+    int repeat = 3;             // Runs per configuration, best one is reported
+    bool chosenTree = false;    // Root given with --root or --shape rather than the default
+    bool cold = false;          // Filesystem caches are dropped before each measured run
+};
+
+using BenchFunction = int (*)(const BenchOptions&);
+
+struct BenchInfo {
+    const char* name;
+    const char* description;
+    BenchFunction function;
+    bool filesystem; // Reads the disk, so it has cold-cache and warm-cache variants
+};
+
+// Registers a benchmark at static initialization time
+struct BenchRegistration {
+    BenchRegistration(const char* name, const char* description, BenchFunction function, bool filesystem);
+};
+
+const std::vector<BenchInfo>& RegisteredBenchmarks();
+
+#define FFE_BENCHMARK_REGISTER(id, name, description, filesystem)                    \
+    static int id(const BenchOptions& options);                                     \
+    static const BenchRegistration id##Registration(name, description, id, filesystem); \
+    static int id(const BenchOptions& options)
+
+// A benchmark on in-memory data
+#define FFE_BENCHMARK(id, name, description) FFE_BENCHMARK_REGISTER(id, name, description, false)
+
+// A benchmark that reads the filesystem; it runs once per cache variant
+// and calls PrepareRun before each measured run
+#define FFE_FS_BENCHMARK(id, name, description) FFE_BENCHMARK_REGISTER(id, name, description, true)
+
+// Wall-clock timer for a single measured run
+class Stopwatch {
+public:
+    Stopwatch() : start(std::chrono::steady_clock::now()) {}
+
+    double seconds() const {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point start;
+};
+
+// Thread counts 1, 2, 4, ... up to and including maxThreads
+std::vector<std::size_t> ThreadSweep(std::size_t maxThreads);
+
+// Drops the page, dentry and inode caches so the next pass reads from disk.
+// Needs root on Linux; returns false where it cannot.
+bool DropCaches();
+
+// Call before each measured run of a filesystem benchmark: drops the caches
+// for the cold variant
+void PrepareRun(const BenchOptions& options);
+
+// Records a result of the running benchmark for --json, in addition to the
+// printed table. Metric names are short and stable across runs.
+void ReportMetric(const std::string& metric, double value, const char* unit);
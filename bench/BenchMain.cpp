@@ -0,0 +1,243 @@
+#include "Bench.hpp"
+#include "TreeGenerator.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+namespace {
+
+struct Metric {
+    std::string benchmark;
+    std::string cache; // "cold", "warm", or "none" for benchmarks without cache variants
+    std::string metric;
+    double value;
+    std::string unit;
+};
+
+// Results of this run, and the benchmark and variant they belong to
+std::vector<Metric> g_metrics;
+const BenchInfo* g_running = nullptr;
+const char* g_cache = "none";
+
+void AppendJsonString(std::string& out, const std::string& text) {
+    out += '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escape[8];
+            std::snprintf(escape, sizeof(escape), "\\u%04x", static_cast<unsigned>(c));
+            out += escape;
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+const char* OsName() {
+#if defined(_WIN32)
+    return "windows";
+#elif defined(__linux__)
+    return "linux";
+#else
+    return "other";
+#endif
+}
+
+bool WriteJson(const fs::path& file, const BenchOptions& options, const std::string& shape, int failures) {
+    std::string out = "{\n  \"os\": \"";
+    out += OsName();
+    out += "\",\n  \"hardwareThreads\": " + std::to_string(std::thread::hardware_concurrency());
+    out += ",\n  \"maxThreads\": " + std::to_string(options.maxThreads);
+    out += ",\n  \"repeat\": " + std::to_string(options.repeat);
+    out += ",\n  \"time\": " + std::to_string(std::chrono::duration_cast<std::chrono::seconds>(
+                                        std::chrono::system_clock::now().time_since_epoch()).count());
+    out += ",\n  \"shape\": ";
+    AppendJsonString(out, shape);
+    out += ",\n  \"root\": ";
+    AppendJsonString(out, reinterpret_cast<const char*>(options.root.u8string().c_str()));
+    out += ",\n  \"failures\": " + std::to_string(failures);
+    out += ",\n  \"results\": [";
+    for (std::size_t i = 0; i < g_metrics.size(); ++i) {
+        const Metric& metric = g_metrics[i];
+        char value[32];
+        std::snprintf(value, sizeof(value), "%.9g", metric.value);
+        out += i == 0 ? "\n    {\"benchmark\": " : ",\n    {\"benchmark\": ";
+        AppendJsonString(out, metric.benchmark);
+        out += ", \"cache\": ";
+        AppendJsonString(out, metric.cache);
+        out += ", \"metric\": ";
+        AppendJsonString(out, metric.metric);
+        out += ", \"value\": ";
+        out += value;
+        out += ", \"unit\": ";
+        AppendJsonString(out, metric.unit);
+        out += '}';
+    }
+    out += "\n  ]\n}\n";
+
+    std::ofstream stream(file, std::ios::binary);
+    stream << out;
+    return stream.good();
+}
+
+} // namespace
+
+// Function-local static avoids depending on static initialization order
+static std::vector<BenchInfo>& Registry() {
+    static std::vector<BenchInfo> benchmarks;
+    return benchmarks;
+}
+
+BenchRegistration::BenchRegistration(const char* name, const char* description, BenchFunction function,
+                                     bool filesystem) {
+    Registry().push_back({name, description, function, filesystem});
+}
+
+const std::vector<BenchInfo>& RegisteredBenchmarks() {
+    return Registry();
+}
+
+std::vector<std::size_t> ThreadSweep(std::size_t maxThreads) {
+    std::vector<std::size_t> counts;
+    for (std::size_t threads = 1; threads < maxThreads; threads *= 2) {
+        counts.push_back(threads);
+    }
+    counts.push_back(maxThreads);
+    return counts;
+}
+
+bool DropCaches() {
+#if defined(__linux__)
+    ::sync();
+    std::ofstream control("/proc/sys/vm/drop_caches");
+    control << "3" << std::flush;
+    return control.good();
+#else
+    return false;
+#endif
+}
+
+void PrepareRun(const BenchOptions& options) {
+    if (options.cold) {
+        DropCaches();
+    }
+}
+
+void ReportMetric(const std::string& metric, double value, const char* unit) {
+    if (g_running) {
+        g_metrics.push_back({g_running->name, g_cache, metric, value, unit});
+    }
+}
+
+static void PrintUsage() {
+    std::printf("Usage: ffe-bench [--root DIR | --shape NAME] [--threads N] [--repeat N]\n"
+                "                 [--cache warm|cold|both] [--json FILE] [--list] [benchmark...]\n\n");
+    std::printf("Benchmarks (* read the filesystem and have cold and warm variants):\n");
+    for (const auto& bench : RegisteredBenchmarks()) {
+        std::printf("  %-22s %c %s\n", bench.name, bench.filesystem ? '*' : ' ', bench.description);
+    }
+    std::printf("\nTree shapes, generated in the temporary directory on first use:\n");
+    for (const auto& shape : NamedShapes()) {
+        std::printf("  %-24s %s\n", shape.name, shape.description);
+    }
+}
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    options.maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::string> selected;
+    const NamedShape* shape = FindShape("default");
+    fs::path jsonFile;
+    bool warm = true;
+    bool cold = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (std::strcmp(arg, "--root") == 0 && i + 1 < argc) {
+            options.root = argv[++i];
+            options.chosenTree = true;
+        } else if (std::strcmp(arg, "--shape") == 0 && i + 1 < argc) {
+            shape = FindShape(argv[++i]);
+            if (!shape) {
+                std::fprintf(stderr, "Unknown tree shape %s, see --list\n", argv[i]);
+                return 2;
+            }
+            options.chosenTree = true;
+        } else if (std::strcmp(arg, "--cache") == 0 && i + 1 < argc) {
+            const std::string cache = argv[++i];
+            warm = cache == "warm" || cache == "both";
+            cold = cache == "cold" || cache == "both";
+            if (!warm && !cold) {
+                std::fprintf(stderr, "--cache takes warm, cold or both\n");
+                return 2;
+            }
+        } else if (std::strcmp(arg, "--json") == 0 && i + 1 < argc) {
+            jsonFile = argv[++i];
+        } else if (std::strcmp(arg, "--threads") == 0 && i + 1 < argc) {
+            options.maxThreads = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--repeat") == 0 && i + 1 < argc) {
+            options.repeat = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--list") == 0 || std::strcmp(arg, "--help") == 0) {
+            PrintUsage();
+            return 0;
+        } else {
+            selected.emplace_back(arg);
+        }
+    }
+
+    const std::string shapeName = options.root.empty() ? shape->name : "custom";
+    if (options.root.empty()) {
+        std::printf("Generating %s benchmark tree (%s)...\n", shape->name, shape->description);
+        options.root = GenerateNamedTree(*shape);
+    }
+    std::printf("Tree: %s\n", options.root.string().c_str());
+    if (cold && !DropCaches()) {
+        std::printf("Cold-cache runs skipped: dropping caches needs root on Linux\n");
+        cold = false;
+    }
+    std::printf("\n");
+
+    int failures = 0;
+    for (const auto& bench : RegisteredBenchmarks()) {
+        if (!selected.empty() && std::find(selected.begin(), selected.end(), bench.name) == selected.end()) {
+            continue;
+        }
+        g_running = &bench;
+        for (bool coldRun : {true, false}) {
+            if (bench.filesystem ? !(coldRun ? cold : warm) : coldRun) {
+                continue;
+            }
+            options.cold = coldRun;
+            g_cache = !bench.filesystem ? "none" : coldRun ? "cold" : "warm";
+            if (bench.filesystem) {
+                std::printf("== %s (%s): %s\n", bench.name, g_cache, bench.description);
+            } else {
+                std::printf("== %s: %s\n", bench.name, bench.description);
+            }
+            if (bench.function(options) != 0) {
+                std::printf("!! %s failed\n", bench.name);
+                ++failures;
+            }
+            std::printf("\n");
+        }
+        g_running = nullptr;
+    }
+
+    if (!jsonFile.empty() && !WriteJson(jsonFile, options, shapeName, failures)) {
+        std::fprintf(stderr, "Could not write %s\n", jsonFile.string().c_str());
+        return 1;
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,95 @@
+#include "BrowsingSession.hpp"
+
+#include <algorithm>
+#include <random>
+#include <thread>
+
+namespace {
+
+std::vector<fs::path> Subfolders(const fs::path& dir) {
+    std::vector<fs::path> children;
+    std::error_code ec;
+    for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->is_directory(ec)) {
+            children.push_back(it->path());
+        }
+    }
+    std::sort(children.begin(), children.end());
+    return children;
+}
+
+} // namespace
+
+std::vector<BrowsingStep> RecordBrowsingSession(const fs::path& root, std::size_t steps, unsigned seed) {
+    std::mt19937 random(seed);
+    std::vector<fs::path> back;
+    std::vector<fs::path> forward;
+    std::vector<BrowsingStep> session;
+    fs::path current = root;
+    // Trees without subfolders give short sessions rather than none at all
+    for (std::size_t attempt = 0; session.size() < steps && attempt < steps * 10; ++attempt) {
+        const auto children = Subfolders(current);
+        BrowsingStep step;
+
+        // Rows the mouse passes over on its way
+        if (!children.empty()) {
+            for (unsigned i = random() % 3; i > 0; --i) {
+                step.hints.push_back(children[random() % children.size()]);
+            }
+        }
+
+        const unsigned action = random() % 10;
+        if (action < 4) {
+            if (children.empty()) {
+                continue;
+            }
+            step.dir = children[random() % children.size()];
+            // Most folders are selected before they are opened
+            if (random() % 5 != 0) {
+                step.hints.push_back(step.dir);
+            }
+            back.push_back(current);
+            forward.clear();
+        } else if (action < 5) {
+            if (current == root) {
+                continue;
+            }
+            step.dir = current.parent_path();
+            back.push_back(current);
+            forward.clear();
+        } else if (action < 8) {
+            if (back.empty()) {
+                continue;
+            }
+            step.dir = back.back();
+            back.pop_back();
+            forward.push_back(current);
+        } else {
+            if (forward.empty()) {
+                continue;
+            }
+            step.dir = forward.back();
+            forward.pop_back();
+            back.push_back(current);
+        }
+
+        current = step.dir;
+        step.back = back.empty() ? fs::path() : back.back();
+        step.forward = forward.empty() ? fs::path() : forward.back();
+        session.push_back(std::move(step));
+    }
+    return session;
+}
+
+void WaitUntilSettled(const std::vector<BrowsingStep>& session, std::chrono::seconds window) {
+    std::error_code ec;
+    fs::file_time_type newest = fs::file_time_type::min();
+    for (const auto& step : session) {
+        newest = std::max(newest, fs::last_write_time(step.dir, ec));
+    }
+    const auto settled = newest + window;
+    const auto now = fs::file_time_type::clock::now();
+    if (settled > now) {
+        std::this_thread::sleep_for(settled - now);
+    }
+}
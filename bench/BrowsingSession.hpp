@@ -0,0 +1,25 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// One navigation of a browsing session
+struct BrowsingStep {
+    fs::path dir;                // Folder opened
+    std::vector<fs::path> hints; // Folder rows hovered or selected before, last one last
+    fs::path back;               // Top of the Back history once dir is shown, if any
+    fs::path forward;            // Top of the Forward history once dir is shown, if any
+};
+
+// A deterministic session of a user clicking around the tree below root:
+// opening subfolders (usually after selecting them, sometimes after eyeing
+// a sibling), going up, and going back and forward through history
+std::vector<BrowsingStep> RecordBrowsingSession(const fs::path& root, std::size_t steps, unsigned seed);
+
+// Waits until every folder of the session is older than window, so
+// caches that distrust recently changed folders see a settled tree
+void WaitUntilSettled(const std::vector<BrowsingStep>& session, std::chrono::seconds window);
@@ -0,0 +1,230 @@
+#include "Bench.hpp"
+#include "TreeGenerator.hpp"
+
+#include "engine/ContentSearch.hpp"
+#include "engine/Metrics.hpp"
+#include "engine/TreeWalker.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+namespace {
+
+// 73 folders of 16 text files of 128 KiB, about 146 MiB
+constexpr TreeShape ContentShape{8, 2, 16, 128 * 1024};
+
+// Occurs on a few lines of every generated file ("... lazy dog 1234\n"),
+// typed in another case than the text has it
+constexpr const char* Needle = "LAZY DOG 1234";
+
+// Lines holding needle, ignoring ASCII case, found the obvious way
+std::uint64_t CountLines(const std::string& text, std::string needle) {
+    const auto lower = [](char c) { return c >= 'A' && c <= 'Z' ? static_cast<char>(c | 0x20) : c; };
+    std::transform(needle.begin(), needle.end(), needle.begin(), lower);
+    std::uint64_t lines = 0;
+    std::size_t start = 0;
+    while (start < text.size()) {
+        const std::size_t end = std::min(text.find('\n', start), text.size());
+        std::string line = text.substr(start, end - start);
+        std::transform(line.begin(), line.end(), line.begin(), lower);
+        if (line.find(needle) != std::string::npos) {
+            ++lines;
+        }
+        start = end + 1;
+    }
+    return lines;
+}
+
+std::string ReadFile(const fs::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+// Lines holding the needle in every text file below root
+std::uint64_t ExpectedHits(const fs::path& root) {
+    std::uint64_t hits = 0;
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it(root, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->is_regular_file(ec) && it->path().filename() != ".complete") {
+            const std::string text = ReadFile(it->path());
+            if (!ffe::ContentSearcher::IsBinary(text)) {
+                hits += CountLines(text, Needle);
+            }
+        }
+    }
+    return hits;
+}
+
+struct Totals {
+    ffe::ShardedCounter hits;
+    ffe::ShardedCounter bytes;
+};
+
+// Walks root and searches every file on the walk's workers
+double SearchTree(const fs::path& root, const ffe::ContentSearcher& searcher, std::size_t threads, Totals& totals) {
+    ffe::Executor executor(threads);
+    ffe::TreeWalker walker(executor);
+    Stopwatch timer;
+    walker.walk(root, [&](const ffe::WalkDirectory& dir) {
+        for (const auto& entry : dir.entries) {
+            if (!entry.isFile()) {
+                continue;
+            }
+            const ffe::ContentScan scan = searcher.searchFile(dir.path / entry.name, [](const ffe::ContentHit&) {
+                return true;
+            });
+            totals.hits.add(scan.hits);
+            totals.bytes.add(scan.bytes);
+        }
+    }).wait();
+    return timer.seconds();
+}
+
+const char* SimdName(ffe::NameMatcher::SimdLevel level) {
+    switch (level) {
+    case ffe::NameMatcher::SimdLevel::Avx2:
+        return "avx2";
+    case ffe::NameMatcher::SimdLevel::Sse2:
+        return "sse2";
+    case ffe::NameMatcher::SimdLevel::Scalar:
+        break;
+    }
+    return "scalar";
+}
+
+// Outcomes of a text, a binary and an oversized file, and the hits of a
+// short text with lines the kernels must get right
+bool CheckFiles() {
+    const fs::path dir = fs::temp_directory_path() / "ffe-bench-content-check";
+    fs::create_directories(dir);
+    std::ofstream(dir / "text.txt", std::ios::binary) << "first line\r\nsecond Needle here, needle again\nno\nneedle";
+    std::ofstream(dir / "binary.bin", std::ios::binary) << std::string("needle\0needle", 13);
+
+    ffe::ContentOptions options;
+    options.maxFileSize = 64;
+    const ffe::ContentSearcher searcher("needle", options);
+    std::vector<ffe::ContentHit> hits;
+    const auto collect = [&hits](const ffe::ContentHit& hit) {
+        hits.push_back(hit);
+        return true;
+    };
+    const ffe::ContentScan text = searcher.searchFile(dir / "text.txt", collect);
+    const bool textOk = text.outcome == ffe::ContentOutcome::Searched && hits.size() == 2 && hits[0].line == 2 &&
+                        hits[0].column == 8 && hits[0].offset == 19 && hits[0].text == "second Needle here, needle again" &&
+                        hits[1].line == 4 && hits[1].column == 1 && hits[1].text == "needle";
+    const bool binaryOk = searcher.searchFile(dir / "binary.bin", collect).outcome == ffe::ContentOutcome::Binary;
+
+    options.maxFileSize = 16;
+    const bool largeOk = ffe::ContentSearcher("needle", options).searchFile(dir / "text.txt", collect).outcome ==
+                         ffe::ContentOutcome::TooLarge;
+    fs::remove_all(dir);
+    if (!textOk || !binaryOk || !largeOk) {
+        std::printf("file checks failed: text %d, binary %d, too large %d\n", textOk, binaryOk, largeOk);
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+FFE_BENCHMARK(ContentMatch, "content-match", "Content needle scan GB/s in memory, scalar against SSE2 and AVX2") {
+    if (!CheckFiles()) {
+        return 1;
+    }
+
+    // 64 MiB of generated text lines, as in the content tree's files
+    std::string text;
+    while (text.size() < (64u << 20)) {
+        text += "The quick brown fox jumps over the lazy dog " + std::to_string(text.size() % 200000) + "\n";
+    }
+    const std::uint64_t expected = CountLines(text, Needle);
+
+    std::printf("%-10s %-8s %10s %10s\n", "kernel", "case", "GB/s", "hits");
+    const ffe::NameMatcher::SimdLevel best = ffe::NameMatcher::BestSimdLevel();
+    for (auto level : {ffe::NameMatcher::SimdLevel::Scalar, ffe::NameMatcher::SimdLevel::Sse2,
+                       ffe::NameMatcher::SimdLevel::Avx2}) {
+        if (level > best) {
+            continue;
+        }
+        for (bool ignoreCase : {false, true}) {
+            ffe::ContentOptions contentOptions;
+            contentOptions.ignoreCase = ignoreCase;
+            contentOptions.maxHitsPerFile = SIZE_MAX;
+            const ffe::ContentSearcher searcher(ignoreCase ? Needle : "lazy dog 1234", contentOptions, level);
+
+            double bestSeconds = 1e9;
+            std::size_t hits = 0;
+            for (int run = 0; run < options.repeat; ++run) {
+                Stopwatch timer;
+                hits = searcher.searchText(text, [](const ffe::ContentHit&) { return true; });
+                bestSeconds = std::min(bestSeconds, timer.seconds());
+            }
+            if (hits != expected) {
+                std::printf("%s found %zu lines, expected %llu\n", SimdName(level), hits,
+                            static_cast<unsigned long long>(expected));
+                return 1;
+            }
+            const double gbPerSecond = text.size() / bestSeconds / 1e9;
+            const char* caseName = ignoreCase ? "ignore" : "match";
+            std::printf("%-10s %-8s %10.2f %10zu\n", SimdName(level), caseName, gbPerSecond, hits);
+            ReportMetric(std::string(SimdName(level)) + ", " + caseName + " case", gbPerSecond, "GB/s");
+        }
+    }
+    return 0;
+}
+
+FFE_FS_BENCHMARK(ContentSearch, "content-search", "Content search GB/s over a tree of text files, read against mapped") {
+    fs::path root = options.root;
+    if (!options.chosenTree) {
+        root = fs::temp_directory_path() / "ffe-bench-content";
+        GenerateTree(root, ContentShape);
+    }
+
+    struct Config {
+        const char* name;
+        std::uint64_t mapThreshold;
+    };
+    const Config configs[] = {
+        {"read", UINT64_MAX},
+        {"mapped", 0},
+    };
+
+    std::uint64_t expected = UINT64_MAX;
+    std::printf("%-10s %8s %10s %10s %10s\n", "files", "threads", "GB/s", "MiB", "hits");
+    for (const Config& config : configs) {
+        for (std::size_t threads : ThreadSweep(options.maxThreads)) {
+            ffe::ContentOptions contentOptions;
+            contentOptions.mapThreshold = config.mapThreshold;
+            const ffe::ContentSearcher searcher(Needle, contentOptions);
+
+            double best = 1e9;
+            std::uint64_t hits = 0;
+            std::uint64_t bytes = 0;
+            for (int run = 0; run < options.repeat; ++run) {
+                Totals totals;
+                PrepareRun(options);
+                best = std::min(best, SearchTree(root, searcher, threads, totals));
+                hits = totals.hits.value();
+                bytes = totals.bytes.value();
+            }
+
+            // Counted after the measured runs, which it would warm up
+            if (expected == UINT64_MAX) {
+                expected = ExpectedHits(root);
+            }
+            if (hits != expected) {
+                std::printf("%s search found %llu lines, expected %llu\n", config.name,
+                            static_cast<unsigned long long>(hits), static_cast<unsigned long long>(expected));
+                return 1;
+            }
+            const double gbPerSecond = bytes / best / 1e9;
+            std::printf("%-10s %8zu %10.2f %10.1f %10llu\n", config.name, threads, gbPerSecond, bytes / 1048576.0,
+                        static_cast<unsigned long long>(hits));
+            ReportMetric(std::string(config.name) + ", " + std::to_string(threads) + " threads", gbPerSecond, "GB/s");
+        }
+    }
+    return 0;
+}
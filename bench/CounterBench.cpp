@@ -0,0 +1,61 @@
+#include "Bench.hpp"
+
+#include "engine/Metrics.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+namespace {
+
+constexpr std::uint64_t AddsPerThread = 10000000;
+
+// Every thread adds one at a time, as the search did per file
+template<typename Add>
+double AddsPerSecond(std::size_t threads, int repeat, const Add& add) {
+    double best = 1e9;
+    for (int run = 0; run < repeat; ++run) {
+        std::vector<std::thread> workers;
+        Stopwatch timer;
+        for (std::size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&add] {
+                for (std::uint64_t i = 0; i < AddsPerThread; ++i) {
+                    add();
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        best = std::min(best, timer.seconds());
+    }
+    return threads * AddsPerThread / best;
+}
+
+} // namespace
+
+FFE_BENCHMARK(Counters, "counters", "Hot-path counters: one shared atomic against per-thread shards") {
+    std::printf("%8s %16s %16s\n", "threads", "atomic Madd/s", "sharded Madd/s");
+    for (std::size_t threads : ThreadSweep(std::max<std::size_t>(options.maxThreads, 2))) {
+        std::atomic<std::uint64_t> shared{0};
+        const double atomic = AddsPerSecond(threads, options.repeat, [&shared] {
+            shared.fetch_add(1, std::memory_order_relaxed);
+        });
+
+        ffe::ShardedCounter sharded;
+        const double shards = AddsPerSecond(threads, options.repeat, [&sharded] { sharded.add(); });
+
+        const std::uint64_t expected = threads * AddsPerThread * options.repeat;
+        if (shared.load() != expected || sharded.value() != expected) {
+            std::printf("counted %llu and %llu, expected %llu\n", static_cast<unsigned long long>(shared.load()),
+                        static_cast<unsigned long long>(sharded.value()), static_cast<unsigned long long>(expected));
+            return 1;
+        }
+        std::printf("%8zu %16.1f %16.1f\n", threads, atomic / 1e6, shards / 1e6);
+        ReportMetric("atomic, " + std::to_string(threads) + " threads", atomic, "adds/s");
+        ReportMetric("sharded, " + std::to_string(threads) + " threads", shards, "adds/s");
+    }
+    return 0;
+}
@@ -0,0 +1,231 @@
+#include "Bench.hpp"
+
+#include "engine/DuplicateFinder.hpp"
+#include "engine/Hash64.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <random>
+#include <string>
+
+namespace {
+
+// Files per generated tree, spread over 6 folders of 4 subfolders each
+constexpr std::size_t TreeFiles = 1000;
+
+// Sizes are drawn from a few values so that many files share a size
+// without sharing contents, which the first stage cannot settle
+constexpr std::size_t SizeSteps[] = {1000, 6000, 8192, 9000, 32768, 65536, 100000, 262144};
+
+// What the finder must report for a tree
+struct Expected {
+    std::uint64_t groups = 0;
+    std::uint64_t duplicates = 0; // Copies beyond the first of each group
+    std::uint64_t reclaimable = 0;
+    std::uint64_t bytes = 0;      // Of all files, hard links once
+};
+
+bool operator==(const Expected& a, const Expected& b) {
+    return a.groups == b.groups && a.duplicates == b.duplicates && a.reclaimable == b.reclaimable;
+}
+
+void WriteFile(const fs::path& path, const std::string& contents) {
+    std::ofstream(path, std::ios::binary).write(contents.data(), static_cast<std::streamsize>(contents.size()));
+}
+
+// Generates a tree in which about ratio of the files are copies of
+// another, one in eight of those a hard link rather than a copy, and one
+// in ten files differs from another only in a middle byte: same size and
+// ends, so only the whole-file hash tells them apart. Reuses a tree that
+// a previous run generated with the same ratio.
+Expected GenerateDuplicateTree(const fs::path& root, double ratio) {
+    Expected expected;
+    const fs::path marker = root / ".complete";
+    if (std::ifstream in{marker}) {
+        unsigned long long values[4];
+        if (in >> values[0] >> values[1] >> values[2] >> values[3]) {
+            return {values[0], values[1], values[2], values[3]};
+        }
+    }
+    fs::remove_all(root);
+
+    std::vector<fs::path> dirs;
+    for (int top = 0; top < 6; ++top) {
+        for (int sub = 0; sub < 4; ++sub) {
+            dirs.push_back(root / ("dir_" + std::to_string(top)) / ("sub_" + std::to_string(sub)));
+            fs::create_directories(dirs.back());
+        }
+    }
+
+    struct Original {
+        fs::path path;
+        std::string contents;
+        std::uint64_t copies = 1; // Hard links not counted
+        std::size_t variants = 0; // Near-copies made of it
+        bool variant = false;     // A near-copy itself
+    };
+    std::vector<Original> originals;
+    std::mt19937_64 random(static_cast<std::uint64_t>(ratio * 1000) + 17);
+    const auto chance = [&random](double p) { return std::uniform_real_distribution<double>(0, 1)(random) < p; };
+
+    for (std::size_t index = 0; index < TreeFiles; ++index) {
+        const fs::path path = dirs[index % dirs.size()] / ("file_" + std::to_string(index) + ".bin");
+        if (!originals.empty() && chance(ratio)) {
+            Original& original = originals[random() % originals.size()];
+            std::error_code ec;
+            if (chance(0.125)) {
+                fs::create_hard_link(original.path, path, ec);
+                if (!ec) {
+                    continue;
+                }
+            }
+            WriteFile(path, original.contents);
+            original.copies++;
+            continue;
+        }
+
+        // Near-copies differ from their original, and from each other, in
+        // one byte each
+        Original file{path, {}, 1};
+        Original& parent = originals.empty() ? file : originals[random() % originals.size()];
+        if (&parent != &file && !parent.variant && chance(0.1)) {
+            file.contents = parent.contents;
+            file.contents[(file.contents.size() / 2 + parent.variants++) % file.contents.size()] ^= 0x5A;
+            file.variant = true;
+        } else {
+            file.contents.resize(SizeSteps[random() % std::size(SizeSteps)]);
+            std::generate(file.contents.begin(), file.contents.end(), [&random] { return static_cast<char>(random()); });
+        }
+        WriteFile(path, file.contents);
+        originals.push_back(std::move(file));
+    }
+
+    for (const Original& original : originals) {
+        expected.bytes += original.contents.size() * original.copies;
+        if (original.copies > 1) {
+            expected.groups++;
+            expected.duplicates += original.copies - 1;
+            expected.reclaimable += original.contents.size() * (original.copies - 1);
+        }
+    }
+    std::ofstream(marker) << expected.groups << ' ' << expected.duplicates << ' ' << expected.reclaimable << ' '
+                          << expected.bytes << '\n';
+    return expected;
+}
+
+std::string ReadFile(const fs::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+// Duplicates below a tree found the obvious way: every file read whole and
+// grouped by size and hash, hard links told apart by fs::equivalent
+Expected NaiveDuplicates(const fs::path& root) {
+    std::map<std::pair<std::uint64_t, std::uint64_t>, std::vector<fs::path>> groups;
+    Expected expected;
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it(root, ec), end; !ec && it != end; it.increment(ec)) {
+        if (!it->is_regular_file(ec) || it->is_symlink(ec) || it->file_size(ec) == 0) {
+            continue;
+        }
+        const std::string contents = ReadFile(it->path());
+        auto& group = groups[{contents.size(), ffe::Hash64(contents)}];
+        const bool linked = it->hard_link_count(ec) > 1 &&
+                            std::any_of(group.begin(), group.end(), [&](const fs::path& other) {
+                                std::error_code equivalentError;
+                                return fs::equivalent(other, it->path(), equivalentError);
+                            });
+        if (!linked) {
+            group.push_back(it->path());
+            expected.bytes += contents.size();
+        }
+    }
+    for (const auto& [key, copies] : groups) {
+        if (copies.size() > 1) {
+            expected.groups++;
+            expected.duplicates += copies.size() - 1;
+            expected.reclaimable += key.first * (copies.size() - 1);
+        }
+    }
+    return expected;
+}
+
+Expected Summarize(const ffe::DuplicateReport& report) {
+    Expected found;
+    found.groups = report.groups.size();
+    found.reclaimable = report.reclaimable;
+    for (const auto& group : report.groups) {
+        found.duplicates += group.copies.size() - 1;
+    }
+    return found;
+}
+
+} // namespace
+
+FFE_FS_BENCHMARK(Duplicates, "dupes", "Duplicate finder files/s and GB/s on trees with 0, 20 and 60% duplicates") {
+    struct Tree {
+        std::string name;
+        fs::path root;
+        Expected expected;
+        bool known; // Expected from generation, else found naively after the runs
+    };
+    std::vector<Tree> trees;
+    if (options.chosenTree) {
+        trees.push_back({"root", options.root, {}, false});
+    } else {
+        for (int percent : {0, 20, 60}) {
+            const fs::path root = fs::temp_directory_path() / ("ffe-bench-dupes-" + std::to_string(percent));
+            trees.push_back({std::to_string(percent) + "%", root, GenerateDuplicateTree(root, percent / 100.0), true});
+        }
+    }
+
+    std::printf("%-6s %8s %10s %10s %10s %8s %8s\n", "dupes", "threads", "files/s", "read GB/s", "tree GB/s", "read %",
+                "groups");
+    for (Tree& tree : trees) {
+        for (std::size_t threads : ThreadSweep(options.maxThreads)) {
+            double best = 1e9;
+            ffe::DuplicateReport report;
+            for (int run = 0; run < options.repeat; ++run) {
+                ffe::Executor executor(threads);
+                ffe::DuplicateFinder finder(executor);
+                PrepareRun(options);
+                Stopwatch timer;
+                report = finder.find(tree.root);
+                best = std::min(best, timer.seconds());
+            }
+
+            // Counted after the measured runs, which it would warm up
+            if (!tree.known) {
+                tree.expected = NaiveDuplicates(tree.root);
+                tree.known = true;
+            }
+            const Expected found = Summarize(report);
+            if (!(found == tree.expected) || report.stats.errors != 0) {
+                std::printf("%s: found %llu groups, %llu duplicates, %llu bytes reclaimable, %llu errors; expected "
+                            "%llu, %llu, %llu\n",
+                            tree.name.c_str(), static_cast<unsigned long long>(found.groups),
+                            static_cast<unsigned long long>(found.duplicates),
+                            static_cast<unsigned long long>(found.reclaimable),
+                            static_cast<unsigned long long>(report.stats.errors),
+                            static_cast<unsigned long long>(tree.expected.groups),
+                            static_cast<unsigned long long>(tree.expected.duplicates),
+                            static_cast<unsigned long long>(tree.expected.reclaimable));
+                return 1;
+            }
+
+            const double filesPerSecond = report.stats.files / best;
+            const double readGbPerSecond = report.stats.bytesRead / best / 1e9;
+            const double treeGbPerSecond = tree.expected.bytes / best / 1e9;
+            const double readPercent = tree.expected.bytes ? 100.0 * report.stats.bytesRead / tree.expected.bytes : 0;
+            std::printf("%-6s %8zu %10.0f %10.2f %10.2f %8.1f %8zu\n", tree.name.c_str(), threads, filesPerSecond,
+                        readGbPerSecond, treeGbPerSecond, readPercent, report.groups.size());
+            const std::string name = tree.name + " dupes, " + std::to_string(threads) + " threads";
+            ReportMetric(name, filesPerSecond, "files/s");
+            ReportMetric(name + ", read", readGbPerSecond, "GB/s");
+        }
+    }
+    return 0;
+}
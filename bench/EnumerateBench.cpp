@@ -0,0 +1,129 @@
+#include "Bench.hpp"
+#include "TreeGenerator.hpp"
+
+#include "engine/DirectoryReader.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+namespace {
+
+// 11,111 folders of 90 files each: just over a million entries
+constexpr TreeShape MillionShape{10, 4, 90};
+
+struct WalkCount {
+    std::uint64_t directories = 0;
+    std::uint64_t entries = 0;
+    std::uint64_t files = 0;
+    std::uint64_t bytes = 0;
+};
+
+// What the explorer did before ReadDirectory: directory_iterator and a
+// separate query per property of every entry
+void WalkIterator(const fs::path& dir, bool sizes, WalkCount& count) {
+    count.directories++;
+    std::error_code ec;
+    std::vector<fs::path> subdirectories;
+    for (fs::directory_iterator it(dir, fs::directory_options::skip_permission_denied, ec), end; !ec && it != end;
+         it.increment(ec)) {
+        count.entries++;
+        const fs::path& path = it->path();
+        if (fs::is_symlink(path, ec)) {
+            continue;
+        }
+        if (fs::is_directory(path, ec)) {
+            subdirectories.push_back(path);
+        } else if (fs::is_regular_file(path, ec)) {
+            count.files++;
+            if (sizes) {
+                count.bytes += fs::file_size(path, ec);
+            }
+        }
+    }
+    for (const auto& subdirectory : subdirectories) {
+        WalkIterator(subdirectory, sizes, count);
+    }
+}
+
+// Names and types in one pass, then size on demand where the listing did
+// not carry it
+template<bool Native>
+void WalkReader(const fs::path& dir, bool sizes, std::vector<ffe::DirEntry>& entries, WalkCount& count) {
+    count.directories++;
+    std::error_code ec;
+    if (Native) {
+        ffe::ReadDirectory(dir, entries, ec);
+    } else {
+        ffe::ReadDirectoryPortable(dir, entries, ec);
+    }
+    count.entries += entries.size();
+
+    std::vector<fs::path> subdirectories;
+    for (auto& entry : entries) {
+        if (entry.isDirectory()) {
+            subdirectories.push_back(dir / entry.name);
+        } else if (entry.isFile()) {
+            count.files++;
+            if (sizes && ffe::StatEntry(dir, entry)) {
+                count.bytes += entry.size;
+            }
+        }
+    }
+    for (const auto& subdirectory : subdirectories) {
+        WalkReader<Native>(subdirectory, sizes, entries, count);
+    }
+}
+
+} // namespace
+
+FFE_FS_BENCHMARK(Enumerate, "enumerate", "Directory enumeration: native batched reads against directory_iterator") {
+    fs::path root = options.root;
+    if (!options.chosenTree) {
+        root = fs::temp_directory_path() / "ffe-bench-million";
+        std::printf("Generating million-entry tree...\n");
+        GenerateTree(root, MillionShape);
+    }
+
+    // A listing needs names and types; sizes cost a stat per file unless
+    // the backend returns them with the names
+    std::printf("%-28s %-14s %10s %12s %14s\n", "backend", "pass", "ms", "dirs", "entries/s");
+    for (bool sizes : {false, true}) {
+        WalkCount reference;
+        for (int backend = 0; backend < 3; ++backend) {
+            const char* const names[] = {"directory_iterator + stat", "ReadDirectoryPortable", "ReadDirectory"};
+            double best = 1e9;
+            WalkCount count;
+            for (int run = 0; run < options.repeat; ++run) {
+                count = {};
+                std::vector<ffe::DirEntry> entries;
+                PrepareRun(options);
+                Stopwatch timer;
+                if (backend == 0) {
+                    WalkIterator(root, sizes, count);
+                } else if (backend == 1) {
+                    WalkReader<false>(root, sizes, entries, count);
+                } else {
+                    WalkReader<true>(root, sizes, entries, count);
+                }
+                best = std::min(best, timer.seconds());
+            }
+            std::printf("%-28s %-14s %10.1f %12llu %14.0f\n", names[backend], sizes ? "names + sizes" : "names, types",
+                        best * 1000.0, static_cast<unsigned long long>(count.directories), count.entries / best);
+            ReportMetric(std::string(names[backend]) + (sizes ? ", sizes" : ""), count.entries / best, "entries/s");
+
+            if (backend == 0) {
+                reference = count;
+            } else if (count.directories != reference.directories || count.entries != reference.entries ||
+                       count.files != reference.files || count.bytes != reference.bytes) {
+                std::printf("%s disagrees: %llu entries, %llu files, expected %llu and %llu\n", names[backend],
+                            static_cast<unsigned long long>(count.entries),
+                            static_cast<unsigned long long>(count.files),
+                            static_cast<unsigned long long>(reference.entries),
+                            static_cast<unsigned long long>(reference.files));
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,163 @@
+#include "Bench.hpp"
+
+#include "engine/Executor.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+
+namespace {
+
+// The single-queue pool the explorer used before the work-stealing
+// executor, kept here as the baseline
+class LegacyThreadPool {
+public:
+    explicit LegacyThreadPool(std::size_t threads) {
+        for (std::size_t i = 0; i < threads; ++i) {
+            workers.emplace_back([this] {
+                while (true) {
+                    std::function<void()> task;
+                    {
+                        std::unique_lock<std::mutex> lock(queueMutex);
+                        condition.wait(lock, [this] { return stop || !tasks.empty(); });
+                        if (stop && tasks.empty()) {
+                            return;
+                        }
+                        task = std::move(tasks.front());
+                        tasks.pop();
+                    }
+                    task();
+                }
+            });
+        }
+    }
+
+    template<class F>
+    void submit(F&& f) {
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            tasks.emplace(std::forward<F>(f));
+        }
+        condition.notify_one();
+    }
+
+    ~LegacyThreadPool() {
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            stop = true;
+        }
+        condition.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex queueMutex;
+    std::condition_variable condition;
+    bool stop = false;
+};
+
+struct WalkState {
+    std::atomic<std::size_t> outstanding{1};
+    std::atomic<std::size_t> directories{0};
+    std::atomic<bool> done{false};
+};
+
+template<class Pool>
+void WalkDirectory(Pool& pool, WalkState& state, const fs::path& dir) {
+    state.directories.fetch_add(1, std::memory_order_relaxed);
+
+    std::error_code ec;
+    for (fs::directory_iterator it(dir, fs::directory_options::skip_permission_denied, ec), end;
+         !ec && it != end; it.increment(ec)) {
+        if (it->is_directory(ec) && !it->is_symlink(ec)) {
+            state.outstanding.fetch_add(1);
+            auto task = [&pool, &state, path = it->path()] { WalkDirectory(pool, state, path); };
+            if constexpr (std::is_same_v<Pool, ffe::Executor>) {
+                static_assert(ffe::Task::FitsInline<decltype(task)>, "walk tasks must not allocate");
+            }
+            pool.submit(std::move(task));
+        }
+    }
+
+    if (state.outstanding.fetch_sub(1) == 1) {
+        state.done.store(true);
+        state.done.notify_all();
+    }
+}
+
+template<class Pool>
+double DirectoriesPerSecond(const fs::path& root, std::size_t threads, int repeat, std::size_t& directories) {
+    double best = 0.0;
+    for (int run = 0; run < repeat; ++run) {
+        Pool pool(threads);
+        WalkState state;
+        Stopwatch timer;
+        pool.submit([&pool, &state, &root] { WalkDirectory(pool, state, root); });
+        state.done.wait(false);
+        const double seconds = timer.seconds();
+
+        directories = state.directories.load();
+        best = std::max(best, static_cast<double>(directories) / seconds);
+    }
+    return best;
+}
+
+} // namespace
+
+FFE_BENCHMARK(ExecutorWalk, "executor-walk", "Directories/second walking the tree, 1..N threads") {
+    std::printf("%8s %14s %14s %8s\n", "threads", "legacy dirs/s", "steal dirs/s", "speedup");
+
+    for (std::size_t threads : ThreadSweep(options.maxThreads)) {
+        std::size_t legacyDirs = 0;
+        std::size_t stealDirs = 0;
+        const double legacy = DirectoriesPerSecond<LegacyThreadPool>(options.root, threads, options.repeat, legacyDirs);
+        const double steal = DirectoriesPerSecond<ffe::Executor>(options.root, threads, options.repeat, stealDirs);
+        if (legacyDirs != stealDirs) {
+            std::printf("directory count mismatch: %zu vs %zu\n", legacyDirs, stealDirs);
+            return 1;
+        }
+        std::printf("%8zu %14.0f %14.0f %7.2fx\n", threads, legacy, steal, steal / legacy);
+    }
+    return 0;
+}
+
+FFE_BENCHMARK(ExecutorSpawn, "executor-spawn", "Throughput of tiny tasks spawned from workers") {
+    constexpr std::size_t Tasks = 1 << 20;
+    std::printf("%8s %14s\n", "threads", "tasks/s");
+
+    for (std::size_t threads : ThreadSweep(options.maxThreads)) {
+        double best = 0.0;
+        for (int run = 0; run < options.repeat; ++run) {
+            ffe::Executor pool(threads);
+            std::atomic<std::size_t> remaining{Tasks};
+            Stopwatch timer;
+            // Binary fan-out so spawning happens on the workers, like a tree walk
+            std::function<void(std::size_t)> spawn = [&](std::size_t count) {
+                while (count > 1) {
+                    std::size_t half = count / 2;
+                    pool.submit([&spawn, half] { spawn(half); });
+                    count -= half;
+                }
+                if (remaining.fetch_sub(1) == 1) {
+                    remaining.notify_all();
+                }
+            };
+            pool.submit([&spawn] { spawn(Tasks); });
+            for (std::size_t left = remaining.load(); left != 0; left = remaining.load()) {
+                remaining.wait(left);
+            }
+            best = std::max(best, Tasks / timer.seconds());
+        }
+        std::printf("%8zu %14.0f\n", threads, best);
+    }
+    return 0;
+}
@@ -0,0 +1,141 @@
+#include "Bench.hpp"
+
+#include "engine/FolderSizer.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Size of a tree found the obvious way: a sequential walk adding up every
+// regular file, hard links told apart by fs::equivalent
+ffe::FolderSize NaiveFolderSize(const fs::path& root) {
+    ffe::FolderSize size;
+    std::map<std::uint64_t, std::vector<fs::path>> linked; // Files with several names, by size
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it(root, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->is_symlink(ec)) {
+            continue;
+        }
+        if (it->is_directory(ec)) {
+            size.directories++;
+            continue;
+        }
+        if (!it->is_regular_file(ec)) {
+            continue;
+        }
+        const std::uint64_t bytes = it->file_size(ec);
+        if (it->hard_link_count(ec) > 1) {
+            auto& names = linked[bytes];
+            const bool seen = std::any_of(names.begin(), names.end(), [&](const fs::path& other) {
+                std::error_code equivalentError;
+                return fs::equivalent(other, it->path(), equivalentError);
+            });
+            if (seen) {
+                continue;
+            }
+            names.push_back(it->path());
+        }
+        size.bytes += bytes;
+        size.files++;
+    }
+    return size;
+}
+
+// Measures root once and returns its size, or nothing when it failed
+bool Measure(ffe::FolderSizer& sizer, const fs::path& root, ffe::FolderSize& size) {
+    sizer.measure({{0, root}});
+    sizer.wait();
+    std::vector<ffe::FolderSizeResult> results;
+    sizer.drain(results);
+    if (results.size() != 1) {
+        return false;
+    }
+    size = results.front().size;
+    return true;
+}
+
+} // namespace
+
+FFE_FS_BENCHMARK(FolderSizes, "folder-sizes",
+                 "FolderSizer directories/s on a first pass, a revisit and the parent of measured folders") {
+    const ffe::FolderSize expected = NaiveFolderSize(options.root);
+
+    // The rows of the root, measured before the root itself as when a
+    // folder is shown and then its parent
+    std::vector<ffe::FolderSizeRequest> children;
+    std::error_code ec;
+    for (fs::directory_iterator it(options.root, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->is_directory(ec) && !it->is_symlink(ec)) {
+            children.push_back({static_cast<std::uint32_t>(children.size()), it->path()});
+        }
+    }
+
+    std::printf("%8s %12s %12s %10s %10s %10s %10s\n", "threads", "first dirs/s", "again dirs/s", "first ms",
+                "again ms", "up ms", "memo KB");
+    for (std::size_t threads : ThreadSweep(options.maxThreads)) {
+        double bestFirst = 1e9;
+        double bestAgain = 1e9;
+        double bestUp = 1e9;
+        std::size_t memoBytes = 0;
+        for (int run = 0; run < options.repeat; ++run) {
+            ffe::Executor executor(threads);
+            ffe::FolderSize first;
+            ffe::FolderSize again;
+            ffe::FolderSize up;
+            bool measured = false;
+            {
+                ffe::FolderSizer sizer(executor);
+                PrepareRun(options);
+                Stopwatch firstTimer;
+                measured = Measure(sizer, options.root, first);
+                bestFirst = std::min(bestFirst, firstTimer.seconds());
+                memoBytes = sizer.stats().cachedBytes;
+
+                PrepareRun(options);
+                Stopwatch againTimer;
+                measured = Measure(sizer, options.root, again) && measured;
+                bestAgain = std::min(bestAgain, againTimer.seconds());
+            }
+            {
+                ffe::FolderSizer sizer(executor);
+                sizer.measure(children);
+                sizer.wait();
+                PrepareRun(options);
+                Stopwatch upTimer;
+                measured = Measure(sizer, options.root, up) && measured;
+                bestUp = std::min(bestUp, upTimer.seconds());
+            }
+
+            for (const ffe::FolderSize* size : {&first, &again, &up}) {
+                if (!measured || size->bytes != expected.bytes || size->files != expected.files ||
+                    size->directories != expected.directories || size->errors != 0) {
+                    std::printf("measured %llu bytes in %llu files and %llu folders, %llu errors; expected %llu, "
+                                "%llu, %llu\n",
+                                static_cast<unsigned long long>(size->bytes),
+                                static_cast<unsigned long long>(size->files),
+                                static_cast<unsigned long long>(size->directories),
+                                static_cast<unsigned long long>(size->errors),
+                                static_cast<unsigned long long>(expected.bytes),
+                                static_cast<unsigned long long>(expected.files),
+                                static_cast<unsigned long long>(expected.directories));
+                    return 1;
+                }
+            }
+        }
+
+        // The root itself is a folder measured too
+        const double folders = static_cast<double>(expected.directories + 1);
+        std::printf("%8zu %12.0f %12.0f %10.1f %10.2f %10.2f %10zu\n", threads, folders / bestFirst,
+                    folders / bestAgain, bestFirst * 1000.0, bestAgain * 1000.0, bestUp * 1000.0, memoBytes / 1024);
+        const std::string name = std::to_string(threads) + " threads";
+        ReportMetric(name + ", first", folders / bestFirst, "dirs/s");
+        ReportMetric(name + ", again", folders / bestAgain, "dirs/s");
+        ReportMetric(name + ", up", bestUp * 1000.0, "ms");
+        ReportMetric(name + ", memo", static_cast<double>(memoBytes), "bytes");
+    }
+    return 0;
+}
@@ -0,0 +1,135 @@
+#include "Bench.hpp"
+#include "NameCorpus.hpp"
+
+#include "engine/FuzzyMatcher.hpp"
+#include "engine/TopK.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+
+namespace {
+
+constexpr std::size_t TopCount = 100;
+
+struct Hit {
+    std::int32_t score;
+    std::uint32_t index;
+
+    // Higher scores first, then corpus order
+    bool operator<(const Hit& other) const {
+        return score != other.score ? score < other.score : index > other.index;
+    }
+};
+
+} // namespace
+
+FFE_BENCHMARK(FuzzyRank, "fuzzy-rank", "Fuzzy subsequence prefilter, scoring and per-thread top-K merge") {
+    const std::vector<std::wstring> wide = GenerateNames(200000);
+    std::vector<fs::path::string_type> names;
+    names.reserve(wide.size());
+    for (const auto& name : wide) {
+        names.push_back(ToNative(name));
+    }
+    // Pretend the names come from a tree six levels deep
+    const auto depthOf = [](std::size_t index) { return static_cast<std::uint32_t>(index % 6); };
+
+    std::vector<ffe::NameMatcher::SimdLevel> levels{ffe::NameMatcher::SimdLevel::Scalar};
+    if (ffe::NameMatcher::BestSimdLevel() >= ffe::NameMatcher::SimdLevel::Sse2) {
+        levels.push_back(ffe::NameMatcher::SimdLevel::Sse2);
+    }
+    if (ffe::NameMatcher::BestSimdLevel() >= ffe::NameMatcher::SimdLevel::Avx2) {
+        levels.push_back(ffe::NameMatcher::SimdLevel::Avx2);
+    }
+
+    const std::size_t threads = options.maxThreads;
+    std::printf("%zu names, ns per name; ranking on %zu threads keeps the top %zu\n", names.size(), threads, TopCount);
+    std::printf("%-10s %8s %10s %10s %10s %10s\n", "pattern", "matches", "prefilter", "simd", "score", "ranked ms");
+
+    for (const char* pattern : {"qrpt", "imgjpg", "tw", "readme", "xyzq"}) {
+        const fs::path::string_type native = ToNative(std::wstring(pattern, pattern + std::char_traits<char>::length(pattern)));
+
+        // Subsequence prefilter per instruction set; all must agree
+        std::size_t expected = 0;
+        double scalarTime = 0;
+        double simdTime = 0;
+        for (auto level : levels) {
+            const ffe::FuzzyMatcher matcher(native, level);
+            std::size_t matches = 0;
+            double best = 1e9;
+            for (int run = 0; run < options.repeat; ++run) {
+                Stopwatch timer;
+                matches = static_cast<std::size_t>(std::count_if(names.begin(), names.end(),
+                    [&](const fs::path::string_type& name) { return matcher.matches(name); }));
+                best = std::min(best, timer.seconds());
+            }
+            if (level == ffe::NameMatcher::SimdLevel::Scalar) {
+                expected = matches;
+                scalarTime = best;
+            } else if (matches != expected) {
+                std::printf("prefilter level %d found %zu matches, scalar %zu\n", static_cast<int>(level), matches,
+                            expected);
+                return 1;
+            }
+            simdTime = best;
+        }
+
+        // Scoring every name, one thread
+        const ffe::FuzzyMatcher matcher(native);
+        std::vector<Hit> all;
+        Stopwatch scoreTimer;
+        for (std::size_t i = 0; i < names.size(); ++i) {
+            if (auto score = matcher.score(names[i], depthOf(i))) {
+                all.push_back({*score, static_cast<std::uint32_t>(i)});
+            }
+        }
+        const double scoreTime = scoreTimer.seconds();
+
+        // Ranked search: each thread keeps its own top-K, merged at the end
+        double rankedTime = 1e9;
+        std::vector<Hit> ranked;
+        for (int run = 0; run < options.repeat; ++run) {
+            std::vector<ffe::TopK<Hit>> perThread(threads, ffe::TopK<Hit>(TopCount));
+            Stopwatch timer;
+            {
+                std::vector<std::jthread> workers;
+                for (std::size_t t = 0; t < threads; ++t) {
+                    workers.emplace_back([&, t] {
+                        for (std::size_t i = t; i < names.size(); i += threads) {
+                            if (auto score = matcher.score(names[i], depthOf(i))) {
+                                perThread[t].push({*score, static_cast<std::uint32_t>(i)});
+                            }
+                        }
+                    });
+                }
+            }
+            ffe::TopK<Hit> merged(TopCount);
+            for (const auto& top : perThread) {
+                merged.merge(top);
+            }
+            ranked = merged.sorted();
+            rankedTime = std::min(rankedTime, timer.seconds());
+        }
+
+        // The merged top-K must equal the head of a full sort
+        std::sort(all.begin(), all.end(), [](const Hit& a, const Hit& b) { return b < a; });
+        all.resize(std::min(all.size(), TopCount));
+        const bool same = ranked.size() == all.size() &&
+                          std::equal(ranked.begin(), ranked.end(), all.begin(), [](const Hit& a, const Hit& b) {
+                              return a.score == b.score && a.index == b.index;
+                          });
+
+        const double perName = 1e9 / static_cast<double>(names.size());
+        std::printf("%-10s %8zu %10.1f %10.1f %10.1f %10.2f\n", pattern, expected, scalarTime * perName,
+                    simdTime * perName, scoreTime * perName, rankedTime * 1000.0);
+        if (!same) {
+            std::printf("top-%zu merge differs from a full sort\n", TopCount);
+            return 1;
+        }
+        if (!ranked.empty()) {
+            const auto best = fs::path(names[ranked.front().index]).u8string();
+            std::printf("           best: %s (%d)\n", reinterpret_cast<const char*>(best.c_str()), ranked.front().score);
+        }
+    }
+    return 0;
+}
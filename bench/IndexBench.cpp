@@ -0,0 +1,85 @@
+#include "Bench.hpp"
+
+#include "engine/FileIndex.hpp"
+#include "engine/TreeWalker.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <mutex>
+#include <set>
+
+namespace {
+
+bool Contains(ffe::NameView name, ffe::NameView needle) {
+    return name.find(needle) != ffe::NameView::npos;
+}
+
+} // namespace
+
+FFE_BENCHMARK(IndexQuery, "index-query", "Build, open and query a memory-mapped name index vs a live walk") {
+    ffe::Executor executor(options.maxThreads);
+    const ffe::IndexStore store(fs::temp_directory_path() / "ffe-bench-index");
+    const fs::path::string_type needle = fs::path("file_1").native();
+
+    Stopwatch buildTimer;
+    std::error_code ec;
+    const auto entries = store.build(options.root, executor, ec);
+    const double buildSeconds = buildTimer.seconds();
+    if (!entries) {
+        std::printf("index build failed: %s\n", ec.message().c_str());
+        return 1;
+    }
+
+    Stopwatch openTimer;
+    ffe::IndexSnapshot snapshot;
+    if (!store.openCovering(options.root, snapshot)) {
+        std::printf("index open failed\n");
+        return 1;
+    }
+    const double openSeconds = openTimer.seconds();
+
+    double querySeconds = 1e9;
+    std::vector<std::uint32_t> hits;
+    for (int run = 0; run < options.repeat; ++run) {
+        hits.clear();
+        Stopwatch queryTimer;
+        snapshot.forEachMatch(0, [&](ffe::NameView name) { return Contains(name, needle); },
+                              [&](std::uint32_t entry) {
+                                  if (snapshot.type(entry) == ffe::EntryType::File) {
+                                      hits.push_back(entry);
+                                  }
+                              });
+        querySeconds = std::min(querySeconds, queryTimer.seconds());
+    }
+
+    std::set<fs::path> indexed;
+    for (std::uint32_t entry : hits) {
+        indexed.insert(snapshot.path(entry));
+    }
+
+    // The live walk is the reference the index has to agree with
+    std::mutex liveMutex;
+    std::set<fs::path> live;
+    Stopwatch walkTimer;
+    ffe::TreeWalker walker(executor);
+    walker.walk(options.root, [&](const ffe::WalkDirectory& dir) {
+        for (const auto& entry : dir.entries) {
+            if (entry.isFile() && Contains(entry.name, needle)) {
+                std::lock_guard<std::mutex> lock(liveMutex);
+                live.insert(ffe::NormalizeRoot(dir.path) / entry.name);
+            }
+        }
+    }).wait();
+    const double walkSeconds = walkTimer.seconds();
+
+    std::printf("entries %zu, matches %zu\n", *entries, indexed.size());
+    std::printf("build %.1f ms, open %.3f ms, query %.3f ms, live walk %.1f ms (%.0fx)\n",
+                buildSeconds * 1000.0, openSeconds * 1000.0, querySeconds * 1000.0,
+                walkSeconds * 1000.0, walkSeconds / querySeconds);
+
+    if (indexed != live) {
+        std::printf("index results differ from live walk (%zu vs %zu)\n", indexed.size(), live.size());
+        return 1;
+    }
+    return 0;
+}
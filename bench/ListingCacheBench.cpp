@@ -0,0 +1,104 @@
+#include "Bench.hpp"
+#include "BrowsingSession.hpp"
+
+#include "engine/ListingCache.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+namespace {
+
+constexpr std::size_t SessionSteps = 3000;
+
+// Reads each visited folder through the cache; returns seconds, or a
+// negative value when a listing comes back empty (no bench folder is)
+double ReplaySession(const std::vector<BrowsingStep>& session, ffe::ListingCache& cache) {
+    Stopwatch timer;
+    std::error_code ec;
+    for (const auto& step : session) {
+        if (cache.read(step.dir, ec)->empty() && !ec) {
+            return -1;
+        }
+    }
+    return timer.seconds();
+}
+
+} // namespace
+
+FFE_BENCHMARK(ListingCache, "listing-cache", "Back/forward navigation: directory listings from memory, validated by mtime") {
+    const auto session = RecordBrowsingSession(options.root, SessionSteps, 7);
+    std::error_code ec;
+
+    // Listings of folders changed less than RacyWindow ago are read again
+    // on every hit, so let a freshly generated tree settle first
+    WaitUntilSettled(session, ffe::ListingCache::RacyWindow);
+
+    std::printf("%zu navigations\n", session.size());
+    std::printf("%-14s %10s %12s %10s %10s %10s %10s\n", "cache", "ms", "us/visit", "hit rate", "evictions",
+                "listings", "memory");
+
+    // Without the cache every visit is a fetch: the listing and the sizes
+    // it is shown with, as the list view read folders before
+    double uncached = 1e9;
+    std::size_t totalBytes = 0;
+    for (int run = 0; run < options.repeat; ++run) {
+        ffe::ListingCache::Fetched fetched;
+        Stopwatch timer;
+        for (const auto& step : session) {
+            ffe::ListingCache::Fetch(step.dir, fetched, ec);
+        }
+        uncached = std::min(uncached, timer.seconds());
+    }
+    std::printf("%-14s %10.1f %12.1f %10s %10s %10s %10s\n", "none", uncached * 1000.0,
+                uncached * 1e6 / session.size(), "-", "-", "-", "-");
+
+    {
+        ffe::ListingCache unbounded;
+        ReplaySession(session, unbounded);
+        totalBytes = unbounded.stats().bytes;
+    }
+
+    for (std::size_t capacity : {totalBytes / 4, ffe::ListingCache::DefaultCapacityBytes}) {
+        ffe::ListingCache cache(capacity);
+        const double seconds = ReplaySession(session, cache);
+        if (seconds < 0) {
+            std::printf("empty listing from the cache\n");
+            return 1;
+        }
+        const auto stats = cache.stats();
+        std::printf("%-14s %10.1f %12.1f %9.1f%% %10zu %10zu %8.1fKB\n",
+                    capacity == ffe::ListingCache::DefaultCapacityBytes ? "default" : "quarter",
+                    seconds * 1000.0, seconds * 1e6 / session.size(), 100.0 * stats.hits / (stats.hits + stats.misses),
+                    stats.evictions, stats.listings, stats.bytes / 1024.0);
+        if (stats.bytes > capacity) {
+            std::printf("cache holds more than its capacity\n");
+            return 1;
+        }
+    }
+
+    // A folder gains a file: the cached listing must not be shown
+    const fs::path dir = fs::temp_directory_path() / "ffe-bench-listing";
+    fs::remove_all(dir, ec);
+    fs::create_directories(dir, ec);
+    for (int i = 0; i < 10; ++i) {
+        std::ofstream(dir / ("file_" + std::to_string(i) + ".txt")) << i;
+    }
+    fs::last_write_time(dir, fs::file_time_type::clock::now() - std::chrono::hours(1), ec);
+
+    ffe::ListingCache cache;
+    const auto first = cache.read(dir, ec);
+    const auto second = cache.read(dir, ec);
+    std::ofstream(dir / "added.txt") << "new";
+    const auto third = cache.read(dir, ec);
+    const auto stats = cache.stats();
+    fs::remove_all(dir, ec);
+
+    std::printf("\nchanged folder: %zu, %zu, then %zu entries; %zu hits, %zu stale\n", first->size(), second->size(),
+                third->size(), stats.hits, stats.stale);
+    if (first != second || third->size() != first->size() + 1 || stats.stale != 1) {
+        std::printf("stale listing shown after a change\n");
+        return 1;
+    }
+    return 0;
+}
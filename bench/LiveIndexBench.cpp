@@ -0,0 +1,101 @@
+#include "Bench.hpp"
+
+#include "engine/LiveIndex.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+namespace {
+
+// Polls until the indexer reports the expected entry count or times out
+bool WaitForEntries(const ffe::LiveIndexer& indexer, std::size_t expected, std::chrono::seconds timeout) {
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (indexer.stats().entries != expected) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return true;
+}
+
+} // namespace
+
+FFE_BENCHMARK(LiveIndex, "live-index", "Index update latency for single files and a 100k-file extraction") {
+    constexpr int ExtractDirectories = 100;
+    constexpr int FilesPerDirectory = 1000;
+    constexpr int SingleFiles = 20;
+
+    const fs::path root = fs::temp_directory_path() / "ffe-bench-live";
+    std::error_code ec;
+    fs::remove_all(root, ec);
+    fs::create_directories(root / "base", ec);
+
+    ffe::Executor executor(options.maxThreads);
+    ffe::LiveIndexer indexer(ffe::IndexStore(fs::temp_directory_path() / "ffe-bench-live-index"), executor);
+    if (!indexer.start(root, true, ec)) {
+        std::printf("live index start failed: %s\n", ec.message().c_str());
+        return 1;
+    }
+    const std::size_t baseline = indexer.stats().entries;
+
+    // Single file creation: time from the write until the index contains it
+    std::vector<double> latencies;
+    for (int i = 0; i < SingleFiles; ++i) {
+        const std::size_t before = indexer.stats().entries;
+        Stopwatch timer;
+        std::ofstream(root / "base" / ("single_" + std::to_string(i) + ".txt")) << i;
+        if (!WaitForEntries(indexer, before + 1, std::chrono::seconds(10))) {
+            std::printf("single file %d never reached the index\n", i);
+            return 1;
+        }
+        latencies.push_back(timer.seconds());
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    // Extraction storm: many directories of files appearing at once
+    const auto eventsBefore = indexer.stats().events;
+    Stopwatch extractTimer;
+    for (int d = 0; d < ExtractDirectories; ++d) {
+        const fs::path dir = root / "extract" / ("dir_" + std::to_string(d));
+        fs::create_directories(dir, ec);
+        for (int f = 0; f < FilesPerDirectory; ++f) {
+            std::ofstream(dir / ("file_" + std::to_string(f) + ".dat"));
+        }
+    }
+    const double extractSeconds = extractTimer.seconds();
+    const std::size_t extracted = 1 + ExtractDirectories * (1 + FilesPerDirectory);
+    const std::size_t withExtract = baseline + SingleFiles + extracted;
+    if (!WaitForEntries(indexer, withExtract, std::chrono::seconds(60))) {
+        std::printf("extraction not fully indexed: %zu of %zu entries\n", indexer.stats().entries, withExtract);
+        return 1;
+    }
+    const double catchUpSeconds = extractTimer.seconds();
+    const ffe::LiveIndexStats afterExtract = indexer.stats();
+
+    Stopwatch removeTimer;
+    fs::remove_all(root / "extract", ec);
+    if (!WaitForEntries(indexer, baseline + SingleFiles, std::chrono::seconds(60))) {
+        std::printf("removal not fully indexed: %zu entries left\n", indexer.stats().entries);
+        return 1;
+    }
+    const double removeSeconds = removeTimer.seconds();
+
+    indexer.flush();
+    const ffe::LiveIndexStats final = indexer.stats();
+    indexer.stop();
+    fs::remove_all(root, ec);
+
+    std::printf("single file: median %.1f ms, worst %.1f ms\n",
+                latencies[latencies.size() / 2] * 1000.0, latencies.back() * 1000.0);
+    std::printf("extract %zu entries: created in %.1f ms, indexed after %.1f ms (%llu events, last batch %.1f ms)\n",
+                extracted, extractSeconds * 1000.0, catchUpSeconds * 1000.0,
+                static_cast<unsigned long long>(afterExtract.events - eventsBefore),
+                std::chrono::duration<double, std::milli>(afterExtract.lastApply).count());
+    std::printf("remove: indexed after %.1f ms\n", removeSeconds * 1000.0);
+    std::printf("batches %llu, overflows %llu, saves %llu\n", static_cast<unsigned long long>(final.batches),
+                static_cast<unsigned long long>(final.overflows), static_cast<unsigned long long>(final.saves));
+    return 0;
+}
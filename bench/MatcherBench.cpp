@@ -0,0 +1,126 @@
+#include "Bench.hpp"
+#include "NameCorpus.hpp"
+
+#include "engine/NameMatcher.hpp"
+
+#include <algorithm>
+#include <clocale>
+#include <cstdio>
+#include <cwctype>
+#include <string>
+
+namespace {
+
+// The search functions NameMatcher replaced, as they were in main.cpp
+std::wstring LegacyToLowerCase(const std::wstring& str) {
+    std::wstring lowerStr = str;
+    std::transform(lowerStr.begin(), lowerStr.end(), lowerStr.begin(),
+                   [](wchar_t c) { return std::towlower(c); });
+    return lowerStr;
+}
+
+bool LegacyMatchesSearchTerm(const std::wstring& filename, const std::wstring& searchTerm) {
+    if (searchTerm.empty()) {
+        return true;
+    }
+    std::wstring lowerFilename = LegacyToLowerCase(filename);
+    std::wstring lowerSearchTerm = LegacyToLowerCase(searchTerm);
+    return lowerFilename.find(lowerSearchTerm) != std::wstring::npos;
+}
+
+const char* LevelName(ffe::NameMatcher::SimdLevel level) {
+    switch (level) {
+    case ffe::NameMatcher::SimdLevel::Avx2:
+        return "avx2";
+    case ffe::NameMatcher::SimdLevel::Sse2:
+        return "sse2";
+    default:
+        return "scalar";
+    }
+}
+
+// Best nanoseconds per name over the configured number of runs
+template<class Run>
+double TimePerName(const BenchOptions& options, std::size_t names, std::size_t& matches, Run&& run) {
+    double best = 1e18;
+    for (int repeat = 0; repeat < options.repeat; ++repeat) {
+        Stopwatch timer;
+        matches = run();
+        best = std::min(best, timer.seconds());
+    }
+    return best * 1e9 / static_cast<double>(names);
+}
+
+} // namespace
+
+FFE_BENCHMARK(NameMatch, "name-match", "Case-insensitive name matching: NameMatcher vs the lowered-copy search") {
+    // The legacy functions fold through towlower, which needs a Unicode locale
+    if (!std::setlocale(LC_CTYPE, "C.UTF-8")) {
+        std::setlocale(LC_CTYPE, "");
+    }
+
+    const std::vector<std::wstring> wide = GenerateNames(200000);
+    std::vector<fs::path::string_type> native;
+    native.reserve(wide.size());
+    for (const auto& name : wide) {
+        native.push_back(ToNative(name));
+    }
+
+    std::vector<ffe::NameMatcher::SimdLevel> levels{ffe::NameMatcher::SimdLevel::Scalar};
+    if (ffe::NameMatcher::BestSimdLevel() >= ffe::NameMatcher::SimdLevel::Sse2) {
+        levels.push_back(ffe::NameMatcher::SimdLevel::Sse2);
+    }
+    if (ffe::NameMatcher::BestSimdLevel() >= ffe::NameMatcher::SimdLevel::Avx2) {
+        levels.push_back(ffe::NameMatcher::SimdLevel::Avx2);
+    }
+
+    std::printf("%zu names, ns per name\n", wide.size());
+    std::printf("%-12s %8s %10s %10s", "pattern", "matches", "per-call", "lowered");
+    for (auto level : levels) {
+        std::printf(" %10s", LevelName(level));
+    }
+    std::printf("\n");
+
+    const struct {
+        const char* label;
+        std::wstring pattern;
+    } cases[] = {
+        {"report", L"report"}, {"IMG_2023", L"IMG_2023"}, {"e", L"e"}, {".JSON", L".JSON"},
+        {"xyzzyq", L"xyzzyq"}, {"CAFE'", L"CAFÉ"}, {"privet", L"привет"},
+    };
+    for (const auto& [label, pattern] : cases) {
+        std::size_t expected = 0;
+        const double perCall = TimePerName(options, wide.size(), expected, [&] {
+            return static_cast<std::size_t>(std::count_if(wide.begin(), wide.end(), [&](const std::wstring& name) {
+                return LegacyMatchesSearchTerm(name, pattern);
+            }));
+        });
+
+        // The search hot path lowered the term once but still copied every name
+        const std::wstring lowerPattern = LegacyToLowerCase(pattern);
+        std::size_t lowered = 0;
+        const double loweredTime = TimePerName(options, wide.size(), lowered, [&] {
+            return static_cast<std::size_t>(std::count_if(wide.begin(), wide.end(), [&](const std::wstring& name) {
+                return LegacyToLowerCase(name).find(lowerPattern) != std::wstring::npos;
+            }));
+        });
+
+        std::printf("%-12s %8zu %10.1f %10.1f", label, expected, perCall, loweredTime);
+        for (auto level : levels) {
+            const ffe::NameMatcher matcher(ToNative(pattern), level);
+            std::size_t matches = 0;
+            const double time = TimePerName(options, native.size(), matches, [&] {
+                return static_cast<std::size_t>(std::count_if(native.begin(), native.end(),
+                    [&](const fs::path::string_type& name) { return matcher.matches(name); }));
+            });
+            if (matches != expected) {
+                std::printf("\n%s matcher found %zu matches, expected %zu\n", LevelName(level), matches, expected);
+                return 1;
+            }
+            std::printf(" %10.1f", time);
+            ReportMetric(std::string(label) + ", " + LevelName(level), time, "ns/name");
+        }
+        std::printf("\n");
+    }
+    return 0;
+}
@@ -0,0 +1,172 @@
+#include "Bench.hpp"
+
+#include "engine/MetadataPipeline.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <thread>
+
+namespace {
+
+constexpr std::uint32_t RowCount = 4000;
+constexpr std::uint32_t VisibleRows = 40;
+constexpr std::uint32_t FirstVisible = 2000; // The user scrolled halfway down
+
+using namespace std::chrono_literals;
+
+// A stat backend that answers after a fixed delay, like a slow disk or a
+// network share
+struct SlowBackend {
+    std::chrono::microseconds latency;
+    std::atomic<std::size_t> calls = 0;
+    std::atomic<bool> afterReset = false;
+    std::atomic<std::size_t> callsAfterReset = 0;
+
+    bool fetch(const fs::path&, ffe::EntryMetadata& metadata) {
+        calls++;
+        if (afterReset) {
+            callsAfterReset++;
+        }
+        std::this_thread::sleep_for(latency);
+        metadata.type = ffe::EntryType::File;
+        metadata.size = 1;
+        return true;
+    }
+};
+
+std::vector<ffe::MetadataRequest> Requests(std::uint32_t first, std::uint32_t last) {
+    std::vector<ffe::MetadataRequest> requests;
+    for (std::uint32_t row = first; row < last; ++row) {
+        requests.push_back({row, fs::path("/data") / std::to_string(row)});
+    }
+    return requests;
+}
+
+// Drains like the UI thread would until every row in [first, last) has
+// arrived; returns seconds since start, or a negative value on timeout
+double WaitForRows(ffe::MetadataPipeline& pipeline, std::vector<bool>& arrived, std::uint32_t first,
+                   std::uint32_t last, std::size_t& results, const Stopwatch& since) {
+    std::vector<ffe::EntryMetadata> drained;
+    while (since.seconds() < 30) {
+        drained.clear();
+        results += pipeline.drain(drained);
+        for (const auto& metadata : drained) {
+            arrived[metadata.row] = true;
+        }
+        if (std::all_of(arrived.begin() + first, arrived.begin() + last, [](bool row) { return row; })) {
+            return since.seconds();
+        }
+        std::this_thread::sleep_for(100us);
+    }
+    return -1;
+}
+
+} // namespace
+
+FFE_BENCHMARK(Metadata, "metadata", "Background row metadata: visible-first scheduling against a slow stat backend") {
+    const std::size_t threads = std::max<std::size_t>(options.maxThreads, 8);
+    ffe::Executor executor(threads);
+    std::printf("%u rows, %u visible from row %u, %zu fetch threads\n", RowCount, VisibleRows, FirstVisible, threads);
+    std::printf("%-10s %-12s %12s %12s %12s\n", "latency", "schedule", "visible ms", "all rows ms", "updates");
+
+    for (auto latency : {100us, 1000us}) {
+        // The UI thread stats the visible rows itself before showing them
+        {
+            SlowBackend backend{latency};
+            Stopwatch timer;
+            ffe::EntryMetadata metadata;
+            for (const auto& request : Requests(FirstVisible, FirstVisible + VisibleRows)) {
+                backend.fetch(request.path, metadata);
+            }
+            std::printf("%-10lld %-12s %12.1f %12s %12s\n", static_cast<long long>(latency.count()), "synchronous",
+                        timer.seconds() * 1000.0, "-", "-");
+        }
+
+        // Every row queued in order, then (or not) the visible ones first
+        for (bool prioritized : {false, true}) {
+            SlowBackend backend{latency};
+            std::atomic<std::size_t> updates = 0;
+            ffe::MetadataPipeline pipeline(
+                executor,
+                [&backend](const fs::path& path, ffe::EntryMetadata& metadata) { return backend.fetch(path, metadata); },
+                [&updates] { updates++; });
+
+            std::vector<bool> arrived(RowCount, false);
+            std::size_t results = 0;
+            Stopwatch timer;
+            pipeline.enqueue(Requests(0, RowCount));
+            if (prioritized) {
+                pipeline.prioritize(Requests(FirstVisible, FirstVisible + VisibleRows));
+            }
+            const double visible =
+                WaitForRows(pipeline, arrived, FirstVisible, FirstVisible + VisibleRows, results, timer);
+            const double all = WaitForRows(pipeline, arrived, 0, RowCount, results, timer);
+            std::printf("%-10lld %-12s %12.1f %12.1f %12zu\n", static_cast<long long>(latency.count()),
+                        prioritized ? "visible first" : "in order", visible * 1000.0, all * 1000.0, updates.load());
+            if (visible < 0 || all < 0 || results != RowCount || backend.calls != RowCount) {
+                std::printf("expected every row fetched once: %zu results, %zu fetches\n", results,
+                            backend.calls.load());
+                return 1;
+            }
+        }
+    }
+
+    // Scrolling: a new screen every 10 ms while the rest of the folder is queued
+    {
+        SlowBackend backend{1000us};
+        ffe::MetadataPipeline pipeline(executor, [&backend](const fs::path& path, ffe::EntryMetadata& metadata) {
+            return backend.fetch(path, metadata);
+        });
+        pipeline.enqueue(Requests(0, RowCount));
+
+        std::vector<bool> arrived(RowCount, false);
+        std::size_t results = 0;
+        double worst = 0;
+        double total = 0;
+        constexpr int Screens = 20;
+        for (int screen = 0; screen < Screens; ++screen) {
+            const std::uint32_t first = 3000 - static_cast<std::uint32_t>(screen) * VisibleRows;
+            Stopwatch timer;
+            pipeline.prioritize(Requests(first, first + VisibleRows));
+            const double seconds = WaitForRows(pipeline, arrived, first, first + VisibleRows, results, timer);
+            if (seconds < 0) {
+                std::printf("screen %d never completed\n", screen);
+                return 1;
+            }
+            worst = std::max(worst, seconds);
+            total += seconds;
+            std::this_thread::sleep_for(10ms);
+        }
+        std::printf("\nscrolling at 1000 us latency: screen complete after %.1f ms on average, %.1f ms at worst\n",
+                    total * 1000.0 / Screens, worst * 1000.0);
+    }
+
+    // Navigating away: queued work is dropped, running batches stop early
+    {
+        SlowBackend backend{1000us};
+        std::atomic<std::size_t> updates = 0;
+        ffe::MetadataPipeline pipeline(
+            executor,
+            [&backend](const fs::path& path, ffe::EntryMetadata& metadata) { return backend.fetch(path, metadata); },
+            [&updates] { updates++; });
+        pipeline.enqueue(Requests(0, RowCount));
+        std::this_thread::sleep_for(20ms);
+
+        backend.afterReset = true;
+        pipeline.reset();
+        const std::size_t updatesAtReset = updates;
+        std::this_thread::sleep_for(50ms);
+
+        std::vector<ffe::EntryMetadata> drained;
+        const std::size_t stale = pipeline.drain(drained);
+        std::printf("reset after 20 ms: %zu of %u rows fetched, %zu fetches started afterwards, %zu stale results "
+                    "drained\n",
+                    backend.calls.load(), RowCount, backend.callsAfterReset.load(), stale);
+        if (stale != 0 || updates != updatesAtReset || backend.callsAfterReset > threads) {
+            std::printf("stale work survived the reset\n");
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,152 @@
+#include "Bench.hpp"
+#include "NameCorpus.hpp"
+
+#include "engine/EntryModel.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+
+namespace {
+
+constexpr std::size_t RowCount = 10000000;
+constexpr std::size_t RowsPerFolder = 1000;
+constexpr std::size_t VisibleRows = 40; // One screen of a maximized report view
+
+// Order-sensitive checksum of the rows' names and sizes
+std::uint64_t Mix(std::uint64_t hash, ffe::NameView name, std::uint64_t size) {
+    for (auto c : name) {
+        hash = (hash ^ static_cast<std::uint64_t>(c)) * 0x100000001b3ull;
+    }
+    return (hash ^ size) * 0x100000001b3ull;
+}
+
+// What a view does for one visible row: copy the name into the control's
+// buffer and format the size column
+std::size_t FormatRow(const ffe::EntryModel::Row& row, char* nameBuffer, char* sizeBuffer) {
+    const std::size_t length = std::min<std::size_t>(row.name.size(), 259);
+    for (std::size_t i = 0; i < length; ++i) {
+        nameBuffer[i] = static_cast<char>(row.name[i]);
+    }
+    nameBuffer[length] = 0;
+
+    double size = static_cast<double>(row.size);
+    const char* suffix = "B";
+    for (const char* next : {"KB", "MB", "GB"}) {
+        if (size < 1024.0) {
+            break;
+        }
+        size /= 1024.0;
+        suffix = next;
+    }
+    return length + static_cast<std::size_t>(std::snprintf(sizeBuffer, 32, "%.1f %s", size, suffix));
+}
+
+} // namespace
+
+FFE_BENCHMARK(ModelScroll, "model-scroll", "Virtual list model: 10M rows built, paged and jumped through") {
+    const std::vector<std::wstring> wide = GenerateNames(100000);
+    std::vector<fs::path::string_type> names;
+    names.reserve(wide.size());
+    std::size_t nameUnits = 0;
+    for (const auto& name : wide) {
+        names.push_back(ToNative(name));
+        nameUnits += names.back().size();
+    }
+
+    // Build: one folder per RowsPerFolder rows, like a listing of many folders
+    ffe::EntryModel model;
+    std::uint64_t expected = 0xcbf29ce484222325ull;
+    Stopwatch buildTimer;
+    model.reserve(RowCount, nameUnits * (RowCount / names.size()));
+    std::uint32_t folder = 0;
+    for (std::size_t i = 0; i < RowCount; ++i) {
+        if (i % RowsPerFolder == 0) {
+            folder = model.addDirectory(fs::path("/data/folder" + std::to_string(i / RowsPerFolder)));
+        }
+        ffe::DirEntry entry;
+        entry.name = names[i % names.size()];
+        entry.type = ffe::EntryType::File;
+        entry.hasStat = true;
+        entry.size = (i * 2654435761u) % (1ull << 32);
+        model.append(folder, entry);
+        expected = Mix(expected, entry.name, entry.size);
+    }
+    const double buildSeconds = buildTimer.seconds();
+    std::printf("%zu rows built in %.0f ms, %.0f MB\n", model.size(), buildSeconds * 1000.0,
+                static_cast<double>(model.memoryUsage()) / 1e6);
+
+    // The eager list this replaces kept a heap-allocated path per row
+    {
+        Stopwatch timer;
+        std::vector<fs::path> paths;
+        paths.reserve(RowCount / 10);
+        for (std::size_t i = 0; i < RowCount / 10; ++i) {
+            paths.push_back(fs::path("/data/folder" + std::to_string(i / RowsPerFolder)) / names[i % names.size()]);
+        }
+        std::printf("%zu eager paths built in %.0f ms (1/10 of the rows)\n", paths.size(), timer.seconds() * 1000.0);
+    }
+
+    // Page through every row, one screen at a time
+    char nameBuffer[260];
+    char sizeBuffer[32];
+    std::uint64_t checksum = 0xcbf29ce484222325ull;
+    std::size_t formatted = 0;
+    double longestPage = 0;
+    Stopwatch scrollTimer;
+    for (std::size_t top = 0; top < model.size(); top += VisibleRows) {
+        Stopwatch pageTimer;
+        model.forEachRow(top, top + VisibleRows, [&](std::size_t, const ffe::EntryModel::Row& row) {
+            formatted += FormatRow(row, nameBuffer, sizeBuffer);
+            checksum = Mix(checksum, row.name, row.size);
+        });
+        longestPage = std::max(longestPage, pageTimer.seconds());
+    }
+    const double scrollSeconds = scrollTimer.seconds();
+    const double pages = static_cast<double>((model.size() + VisibleRows - 1) / VisibleRows);
+    std::printf("paged through %.0f screens of %zu rows: %.2f us per screen, longest %.1f us\n", pages, VisibleRows,
+                scrollSeconds * 1e6 / pages, longestPage * 1e6);
+
+    // Dragging the scroll thumb: screens at random positions
+    constexpr int Jumps = 100000;
+    double jumpSeconds = 1e9;
+    for (int run = 0; run < options.repeat; ++run) {
+        std::mt19937_64 random(42);
+        Stopwatch timer;
+        for (int jump = 0; jump < Jumps; ++jump) {
+            const std::size_t top = random() % model.size();
+            model.forEachRow(top, top + VisibleRows, [&](std::size_t, const ffe::EntryModel::Row& row) {
+                formatted += FormatRow(row, nameBuffer, sizeBuffer);
+            });
+        }
+        jumpSeconds = std::min(jumpSeconds, timer.seconds());
+    }
+    std::printf("%d random jumps: %.2f us per screen (%zu characters formatted)\n", Jumps, jumpSeconds * 1e6 / Jumps,
+                formatted);
+
+    // Rows must read back exactly as appended, paths included
+    if (checksum != expected) {
+        std::printf("rows read back differ from the rows appended\n");
+        return 1;
+    }
+    const std::size_t probe = RowCount - 1;
+    const fs::path expectedPath = fs::path("/data/folder" + std::to_string(probe / RowsPerFolder)) /
+                                  names[probe % names.size()];
+    if (model.path(probe) != expectedPath) {
+        std::printf("path of row %zu is wrong\n", probe);
+        return 1;
+    }
+
+    // Search results arrive as full paths grouped by folder
+    ffe::EntryModel results;
+    for (std::size_t i = 0; i < 10000; ++i) {
+        results.appendPath(fs::path("/data/folder" + std::to_string(i / 100)) / names[i], ffe::EntryType::File);
+    }
+    for (std::size_t i = 0; i < 10000; ++i) {
+        if (results.path(i) != fs::path("/data/folder" + std::to_string(i / 100)) / names[i]) {
+            std::printf("search result %zu reads back wrong\n", i);
+            return 1;
+        }
+    }
+    return 0;
+}
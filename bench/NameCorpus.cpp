@@ -0,0 +1,69 @@
+#include "NameCorpus.hpp"
+
+#include <random>
+
+// Wide strings hold UTF-16 on Windows and UTF-32 elsewhere
+fs::path::string_type ToNative(const std::wstring& wide) {
+#ifdef _WIN32
+    return wide;
+#else
+    std::string out;
+    for (wchar_t wc : wide) {
+        const auto c = static_cast<char32_t>(wc);
+        if (c < 0x80) {
+            out += static_cast<char>(c);
+        } else if (c < 0x800) {
+            out += static_cast<char>(0xC0 | (c >> 6));
+            out += static_cast<char>(0x80 | (c & 0x3F));
+        } else if (c < 0x10000) {
+            out += static_cast<char>(0xE0 | (c >> 12));
+            out += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (c & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (c >> 18));
+            out += static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (c & 0x3F));
+        }
+    }
+    return out;
+#endif
+}
+
+std::vector<std::wstring> GenerateNames(std::size_t count) {
+    static const wchar_t* const Stems[] = {
+        L"IMG_", L"DSC", L"Screenshot ", L"report", L"Invoice", L"README", L"main", L"libfoo",
+        L"Setup", L"Thumbs", L"node_modules", L"__init__", L"config", L"TreeWalker", L"backup",
+        L"Quarterly Report", L"meeting-notes", L"package-lock", L"index", L"VID_",
+    };
+    static const wchar_t* const Foreign[] = {
+        L"Résumé", L"Café Menü", L"Привет мир", L"Übersicht", L"Ελληνικά", L"naïve", L"Straße", L"ÉTÉ",
+    };
+    static const wchar_t* const Extensions[] = {
+        L".jpg", L".png", L".txt", L".cpp", L".hpp", L".docx", L".pdf", L".mp3", L".json", L".dll", L"",
+    };
+
+    std::mt19937 random(42);
+    std::vector<std::wstring> names;
+    names.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        std::wstring name = random() % 10 == 0 ? Foreign[random() % std::size(Foreign)]
+                                               : Stems[random() % std::size(Stems)];
+        switch (random() % 4) {
+        case 0:
+            name += L"2023" + std::to_wstring(1000 + random() % 9000) + L"_" + std::to_wstring(random() % 1000000);
+            break;
+        case 1:
+            name += L" (" + std::to_wstring(random() % 20) + L")";
+            break;
+        case 2:
+            name += L"_v" + std::to_wstring(random() % 10) + L"." + std::to_wstring(random() % 100);
+            break;
+        default:
+            break;
+        }
+        name += Extensions[random() % std::size(Extensions)];
+        names.push_back(std::move(name));
+    }
+    return names;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// Deterministic file names shaped like a user profile and a source tree:
+// camera and screenshot names, documents, code, dependencies, and about one
+// in ten names outside ASCII
+std::vector<std::wstring> GenerateNames(std::size_t count);
+
+// Converts a generated name to the native encoding (UTF-8 outside Windows)
+fs::path::string_type ToNative(const std::wstring& wide);
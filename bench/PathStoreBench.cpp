@@ -0,0 +1,175 @@
+#include "Bench.hpp"
+#include "NameCorpus.hpp"
+
+#include "engine/EntryModel.hpp"
+#include "engine/PathStore.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+#include <random>
+
+namespace {
+
+constexpr std::size_t HitCount = 2000000;
+constexpr std::size_t FolderCount = 4000;
+constexpr std::size_t FolderDepth = 6;
+
+// Folders of a source tree or a user profile: a few levels of generated
+// names below a common root, each folder below a random earlier one
+std::vector<fs::path> GenerateFolders(const std::vector<fs::path::string_type>& names) {
+    std::vector<fs::path> folders;
+    folders.reserve(FolderCount);
+    std::mt19937_64 random(11);
+    const fs::path root = fs::path("/home/user/projects");
+    for (std::size_t i = 0; i < FolderCount; ++i) {
+        if (folders.empty() || random() % 8 == 0) {
+            folders.push_back(root / names[i % names.size()]);
+            continue;
+        }
+        fs::path parent = folders[random() % folders.size()];
+        while (std::distance(parent.begin(), parent.end()) > static_cast<std::ptrdiff_t>(FolderDepth + 4)) {
+            parent = parent.parent_path();
+        }
+        folders.push_back(parent / (names[i % names.size()] + fs::path::string_type(1, '_') +
+                                    fs::path(std::to_string(i)).native()));
+    }
+    return folders;
+}
+
+// Bytes a vector of paths holds: the vector itself and the text of every
+// path outside its inline buffer. A lower bound, as implementations also
+// keep a parsed component list per path.
+std::size_t PathVectorBytes(const std::vector<fs::path>& paths) {
+    std::size_t bytes = paths.capacity() * sizeof(fs::path);
+    const std::size_t inlineUnits = fs::path::string_type().capacity();
+    for (const auto& path : paths) {
+        if (path.native().capacity() > inlineUnits) {
+            bytes += (path.native().capacity() + 1) * sizeof(fs::path::value_type);
+        }
+    }
+    return bytes;
+}
+
+} // namespace
+
+FFE_BENCHMARK(PathStore, "path-store", "Search hits as interned path handles versus one fs::path per hit") {
+    const std::vector<std::wstring> wide = GenerateNames(100000);
+    std::vector<fs::path::string_type> names;
+    names.reserve(wide.size());
+    for (const auto& name : wide) {
+        names.push_back(ToNative(name));
+    }
+    const auto folders = GenerateFolders(names);
+
+    // Hits arrive grouped by folder, as a walk or an index search yields them
+    std::vector<fs::path> hits;
+    hits.reserve(HitCount);
+    for (std::size_t i = 0; i < HitCount; ++i) {
+        hits.push_back(folders[i * FolderCount / HitCount] / names[(i * 7919) % names.size()]);
+    }
+    std::printf("%zu hits in %zu folders\n", hits.size(), folders.size());
+    std::printf("%-22s %10s %12s %12s %12s\n", "representation", "build ms", "paths ms", "memory", "bytes/hit");
+
+    // Today: every hit keeps its own fs::path
+    double vectorBuild = 1e9;
+    double vectorPaths = 1e9;
+    std::size_t vectorBytes = 0;
+    std::size_t vectorUnits = 0;
+    for (int run = 0; run < options.repeat; ++run) {
+        Stopwatch buildTimer;
+        std::vector<fs::path> kept;
+        kept.reserve(hits.size());
+        for (const auto& hit : hits) {
+            kept.push_back(hit);
+        }
+        vectorBuild = std::min(vectorBuild, buildTimer.seconds());
+
+        Stopwatch pathsTimer;
+        std::size_t units = 0;
+        for (const auto& path : kept) {
+            units += path.native().size();
+        }
+        vectorPaths = std::min(vectorPaths, pathsTimer.seconds());
+        vectorBytes = PathVectorBytes(kept);
+        vectorUnits = units;
+    }
+    std::printf("%-22s %10.1f %12.1f %10.1fMB %12.1f\n", "vector<fs::path>", vectorBuild * 1000.0,
+                vectorPaths * 1000.0, vectorBytes / 1e6, static_cast<double>(vectorBytes) / hits.size());
+
+    // Interned: a handle per hit, folders and their ancestors shared
+    ffe::PathStore store;
+    std::vector<ffe::PathStore::Handle> handles;
+    double storeBuild = 1e9;
+    double storePaths = 1e9;
+    for (int run = 0; run < options.repeat; ++run) {
+        store.clear();
+        handles = {};
+
+        Stopwatch buildTimer;
+        handles.reserve(hits.size());
+        for (const auto& hit : hits) {
+            handles.push_back(store.intern(hit));
+        }
+        storeBuild = std::min(storeBuild, buildTimer.seconds());
+
+        // Full paths are only put together for what is shown or opened, but
+        // materializing all of them bounds that cost
+        Stopwatch pathsTimer;
+        std::size_t units = 0;
+        for (const auto handle : handles) {
+            units += store.path(handle).native().size();
+        }
+        storePaths = std::min(storePaths, pathsTimer.seconds());
+        if (units != vectorUnits) {
+            std::printf("materialized paths differ in length from the hits\n");
+            return 1;
+        }
+    }
+    const std::size_t storeBytes = store.memoryUsage() + handles.capacity() * sizeof(ffe::PathStore::Handle);
+    std::printf("%-22s %10.1f %12.1f %10.1fMB %12.1f   %zu nodes\n", "PathStore + handles", storeBuild * 1000.0,
+                storePaths * 1000.0, storeBytes / 1e6, static_cast<double>(storeBytes) / hits.size(), store.size());
+
+    // Search result rows: names in the model, folders interned once per run
+    // of hits in the same folder
+    double modelBuild = 1e9;
+    double modelPaths = 1e9;
+    ffe::EntryModel model;
+    for (int run = 0; run < options.repeat; ++run) {
+        model.clear();
+
+        Stopwatch buildTimer;
+        for (const auto& hit : hits) {
+            model.appendPath(hit, ffe::EntryType::File);
+        }
+        modelBuild = std::min(modelBuild, buildTimer.seconds());
+
+        Stopwatch pathsTimer;
+        std::size_t units = 0;
+        for (std::size_t i = 0; i < model.size(); ++i) {
+            units += model.path(i).native().size();
+        }
+        modelPaths = std::min(modelPaths, pathsTimer.seconds());
+        if (units != vectorUnits) {
+            std::printf("model paths differ in length from the hits\n");
+            return 1;
+        }
+    }
+    std::printf("%-22s %10.1f %12.1f %10.1fMB %12.1f\n", "EntryModel rows", modelBuild * 1000.0,
+                modelPaths * 1000.0, model.memoryUsage() / 1e6, static_cast<double>(model.memoryUsage()) / hits.size());
+
+    // Every hit must read back exactly, and interning it again must give the
+    // same handle without adding nodes
+    const std::size_t nodes = store.size();
+    for (std::size_t i = 0; i < hits.size(); i += 97) {
+        if (store.path(handles[i]) != hits[i] || store.intern(hits[i]) != handles[i] || model.path(i) != hits[i]) {
+            std::printf("hit %zu reads back wrong\n", i);
+            return 1;
+        }
+    }
+    if (store.size() != nodes) {
+        std::printf("interning a known path added nodes\n");
+        return 1;
+    }
+    return 0;
+}
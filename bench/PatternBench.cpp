@@ -0,0 +1,88 @@
+#include "Bench.hpp"
+#include "NameCorpus.hpp"
+
+#include "engine/NameQuery.hpp"
+
+#include <algorithm>
+#include <clocale>
+#include <cstdio>
+#include <regex>
+
+namespace {
+
+struct PatternCase {
+    const char* label;
+    std::wstring query;     // Search box text
+    std::wstring regex;     // std::wregex equivalent
+    bool wholeName;         // regex_match rather than regex_search
+};
+
+} // namespace
+
+FFE_BENCHMARK(NamePattern, "name-pattern", "Glob and regex queries: compiled DFA vs std::wregex") {
+    if (!std::setlocale(LC_CTYPE, "C.UTF-8")) {
+        std::setlocale(LC_CTYPE, "");
+    }
+
+    const std::vector<std::wstring> wide = GenerateNames(100000);
+    std::vector<fs::path::string_type> native;
+    native.reserve(wide.size());
+    for (const auto& name : wide) {
+        native.push_back(ToNative(name));
+    }
+
+    const PatternCase cases[] = {
+        {"*.json", L"*.json", L".*\\.json", true},
+        {"IMG_2023*.jpg", L"IMG_2023*.jpg", L"IMG_2023.*\\.jpg", true},
+        {"report_v?.*", L"report_v?.*", L"report_v.\\..*", true},
+        {"*[0-9][0-9]).*", L"*[0-9][0-9]).*", L".*[0-9][0-9]\\)\\..*", true},
+        {"re:^(img|vid)_...$", L"re:^(img|vid)_\\d+_\\d+\\.(jpg|mp3)$", L"^(img|vid)_\\d+_\\d+\\.(jpg|mp3)$", false},
+        {"re:v[0-9]\\.[0-9]+", L"re:v[0-9]\\.[0-9]+", L"v[0-9]\\.[0-9]+", false},
+        {"re:(report|inv...)", L"re:(report|invoice).*\\(1[0-9]\\)", L"(report|invoice).*\\(1[0-9]\\)", false},
+    };
+
+    std::printf("%zu names, ns per name\n", wide.size());
+    std::printf("%-22s %8s %8s %10s %10s %8s\n", "query", "matches", "states", "wregex", "dfa", "speedup");
+    for (const PatternCase& test : cases) {
+        ffe::NameQuery query;
+        std::string error;
+        if (!query.parse(ToNative(test.query), error)) {
+            std::printf("%s: %s\n", test.label, error.c_str());
+            return 1;
+        }
+        const std::wregex regex(test.regex, std::regex_constants::icase | std::regex_constants::optimize);
+
+        std::size_t expected = 0;
+        double regexSeconds = 1e9;
+        for (int run = 0; run < options.repeat; ++run) {
+            Stopwatch timer;
+            expected = static_cast<std::size_t>(std::count_if(wide.begin(), wide.end(), [&](const std::wstring& name) {
+                return test.wholeName ? std::regex_match(name, regex) : std::regex_search(name, regex);
+            }));
+            regexSeconds = std::min(regexSeconds, timer.seconds());
+        }
+
+        std::size_t matches = 0;
+        double dfaSeconds = 1e9;
+        for (int run = 0; run < options.repeat; ++run) {
+            Stopwatch timer;
+            matches = static_cast<std::size_t>(std::count_if(native.begin(), native.end(),
+                [&](const fs::path::string_type& name) { return query.matches(name); }));
+            dfaSeconds = std::min(dfaSeconds, timer.seconds());
+        }
+
+        ffe::NamePattern pattern;
+        const bool isRegex = query.mode() == ffe::NameQuery::Mode::Regex;
+        pattern.compile(ToNative(test.query.substr(isRegex ? 3 : 0)),
+                        isRegex ? ffe::NamePattern::Syntax::Regex : ffe::NamePattern::Syntax::Glob, error);
+
+        const double perName = 1e9 / static_cast<double>(wide.size());
+        std::printf("%-22s %8zu %8zu %10.1f %10.1f %7.0fx\n", test.label, matches, pattern.stateCount(),
+                    regexSeconds * perName, dfaSeconds * perName, regexSeconds / dfaSeconds);
+        if (matches != expected) {
+            std::printf("DFA found %zu matches, std::wregex %zu\n", matches, expected);
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,135 @@
+#include "Bench.hpp"
+#include "BrowsingSession.hpp"
+
+#include "engine/DirectoryPrefetcher.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+
+namespace {
+
+constexpr std::size_t SessionSteps = 200;
+
+using namespace std::chrono_literals;
+
+// Listing a folder on a cold disk or a network share
+constexpr auto ListingLatency = 3ms;
+
+// Time between arriving in a folder and opening the next one; real users
+// take far longer, which only helps the prefetcher
+constexpr auto ThinkTime = 15ms;
+
+bool SlowFetch(const fs::path& dir, ffe::ListingCache::Fetched& fetched, std::error_code& ec) {
+    std::this_thread::sleep_for(ListingLatency);
+    return ffe::ListingCache::Fetch(dir, fetched, ec);
+}
+
+enum class Mode {
+    Uncached,
+    Cache,
+    Prefetch,
+};
+
+struct Replay {
+    std::vector<double> latencies; // Seconds per navigation
+    ffe::ListingCache::Stats cache;
+    std::size_t prefetched = 0;
+};
+
+// Replays the session like the frontend: hints while the user looks at a
+// folder, then cancel, drain and list on navigation
+Replay ReplaySession(const std::vector<BrowsingStep>& session, Mode mode, ffe::Executor& executor) {
+    Replay replay;
+    ffe::ListingCache cache;
+    ffe::DirectoryPrefetcher prefetcher(executor, ffe::DirectoryPrefetcher::DefaultBudgetBytes, SlowFetch);
+    const BrowsingStep* previous = nullptr;
+    std::error_code ec;
+
+    for (const auto& step : session) {
+        if (mode == Mode::Prefetch && previous) {
+            std::vector<fs::path> history;
+            for (const fs::path& dir : {previous->back, previous->forward}) {
+                if (!dir.empty() && !cache.contains(dir)) {
+                    history.push_back(dir);
+                }
+            }
+            prefetcher.prefetch(std::move(history));
+        }
+        // Without a prefetcher nothing happens while the user looks
+        if (mode == Mode::Prefetch) {
+            const auto pause = ThinkTime / (step.hints.size() + 1);
+            for (const fs::path& hint : step.hints) {
+                std::this_thread::sleep_for(pause);
+                if (!cache.contains(hint)) {
+                    prefetcher.prefetch({hint});
+                }
+            }
+            std::this_thread::sleep_for(pause);
+        }
+
+        Stopwatch timer;
+        std::shared_ptr<const ffe::ListingCache::Listing> entries;
+        if (mode != Mode::Uncached) {
+            prefetcher.cancel();
+            prefetcher.drainInto(cache);
+            entries = cache.lookup(step.dir);
+        }
+        if (!entries) {
+            ffe::ListingCache::Fetched fetched;
+            SlowFetch(step.dir, fetched, ec);
+            entries = fetched.entries;
+            if (mode != Mode::Uncached && !ec) {
+                cache.insert(std::move(fetched));
+            }
+        }
+        replay.latencies.push_back(timer.seconds());
+        previous = &step;
+    }
+    replay.cache = cache.stats();
+    replay.prefetched = prefetcher.fetched();
+    return replay;
+}
+
+} // namespace
+
+FFE_BENCHMARK(Prefetch, "prefetch", "Navigation latency with folders listed ahead from hover, selection and history") {
+    const auto session = RecordBrowsingSession(options.root, SessionSteps, 11);
+    WaitUntilSettled(session, ffe::ListingCache::RacyWindow);
+
+    ffe::Executor executor(std::max<std::size_t>(options.maxThreads, 2));
+    std::printf("%zu navigations, %lld ms per listing, %lld ms between navigations\n", session.size(),
+                static_cast<long long>(ListingLatency.count()), static_cast<long long>(ThinkTime.count()));
+    std::printf("%-10s %10s %10s %10s %10s %12s %12s\n", "mode", "mean ms", "p50 ms", "p95 ms", "hit rate",
+                "prefetched", "pf hits");
+
+    double cacheMean = 0;
+    double prefetchMean = 0;
+    for (Mode mode : {Mode::Uncached, Mode::Cache, Mode::Prefetch}) {
+        Replay replay = ReplaySession(session, mode, executor);
+        auto& latencies = replay.latencies;
+        double total = 0;
+        for (double seconds : latencies) {
+            total += seconds;
+        }
+        std::sort(latencies.begin(), latencies.end());
+        const double mean = total / latencies.size();
+        const auto& stats = replay.cache;
+        const char* name = mode == Mode::Uncached ? "uncached" : mode == Mode::Cache ? "cache" : "prefetch";
+        std::printf("%-10s %10.2f %10.2f %10.2f %9.1f%% %12zu %12zu\n", name, mean * 1000.0,
+                    latencies[latencies.size() / 2] * 1000.0, latencies[latencies.size() * 95 / 100] * 1000.0,
+                    mode == Mode::Uncached ? 0.0 : 100.0 * stats.hits / (stats.hits + stats.misses), replay.prefetched,
+                    stats.prefetchHits);
+        if (mode == Mode::Cache) {
+            cacheMean = mean;
+        } else if (mode == Mode::Prefetch) {
+            prefetchMean = mean;
+        }
+    }
+
+    if (prefetchMean > cacheMean) {
+        std::printf("prefetching made navigation slower\n");
+        return 1;
+    }
+    return 0;
+}
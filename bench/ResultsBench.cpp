@@ -0,0 +1,223 @@
+#include "Bench.hpp"
+
+#include "engine/FramePacer.hpp"
+#include "engine/ResultChannel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+constexpr std::size_t ItemsPerProducer = 1000000;
+
+struct Item {
+    std::uint32_t producer;
+    std::uint32_t sequence;
+};
+
+// Checks that every producer's items arrived exactly once and in order
+bool CheckOrder(const std::vector<Item>& items, std::size_t producers) {
+    std::vector<std::uint32_t> next(producers, 0);
+    for (const Item& item : items) {
+        if (item.sequence != next[item.producer]++) {
+            return false;
+        }
+    }
+    return std::all_of(next.begin(), next.end(), [](std::uint32_t n) { return n == ItemsPerProducer; });
+}
+
+// Producers push through the channel while one consumer drains it
+double RunChannel(std::size_t producers, std::size_t batchSize, bool& ordered) {
+    std::atomic<std::size_t> wakeups = 0;
+    ffe::ResultChannel<Item> channel([&wakeups] { wakeups.fetch_add(1, std::memory_order_relaxed); });
+    std::vector<Item> received;
+    received.reserve(producers * ItemsPerProducer);
+
+    Stopwatch timer;
+    {
+        std::vector<std::jthread> threads;
+        for (std::size_t p = 0; p < producers; ++p) {
+            threads.emplace_back([&channel, p, batchSize] {
+                ffe::ResultChannel<Item>::Batch batch(channel, batchSize);
+                for (std::uint32_t i = 0; i < ItemsPerProducer; ++i) {
+                    batch.add({static_cast<std::uint32_t>(p), i});
+                }
+            });
+        }
+        while (received.size() < producers * ItemsPerProducer) {
+            if (channel.drain(received) == 0) {
+                std::this_thread::yield();
+            }
+        }
+    }
+    const double seconds = timer.seconds();
+    ordered = CheckOrder(received, producers);
+    return seconds;
+}
+
+// The previous scheme: one mutex around a shared vector, taken per result
+double RunLocked(std::size_t producers, bool& ordered) {
+    std::mutex mutex;
+    std::vector<Item> shared;
+    std::vector<Item> received;
+    received.reserve(producers * ItemsPerProducer);
+
+    Stopwatch timer;
+    {
+        std::vector<std::jthread> threads;
+        for (std::size_t p = 0; p < producers; ++p) {
+            threads.emplace_back([&, p] {
+                for (std::uint32_t i = 0; i < ItemsPerProducer; ++i) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    shared.push_back({static_cast<std::uint32_t>(p), i});
+                }
+            });
+        }
+        std::vector<Item> taken;
+        while (received.size() < producers * ItemsPerProducer) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                taken.swap(shared);
+            }
+            if (taken.empty()) {
+                std::this_thread::yield();
+            }
+            received.insert(received.end(), taken.begin(), taken.end());
+            taken.clear();
+        }
+    }
+    const double seconds = timer.seconds();
+    ordered = CheckOrder(received, producers);
+    return seconds;
+}
+
+struct PacingResult {
+    std::size_t refreshes = 0;
+    double busySeconds = 0;    // Time spent inserting rows
+    double longestRefresh = 0; // Longest single stall of the UI thread
+    double lastShown = 0;      // When the last result became visible
+};
+
+// Replays results arriving at a steady rate against a simulated list view
+// whose inserts cost insertCost each
+PacingResult SimulatePaced(std::size_t total, double arrivalSeconds, double insertCost) {
+    using namespace std::chrono;
+    const auto origin = ffe::FramePacer::Clock::time_point();
+    const auto at = [origin](double seconds) {
+        return origin + duration_cast<ffe::FramePacer::Clock::duration>(duration<double>(seconds));
+    };
+    const auto seconds = [origin](ffe::FramePacer::Clock::time_point t) {
+        return duration<double>(t - origin).count();
+    };
+
+    ffe::FramePacer pacer;
+    PacingResult result;
+    std::size_t shown = 0;
+    double now = 0;
+    while (shown < total) {
+        const std::size_t arrived =
+            std::min(total, static_cast<std::size_t>(static_cast<double>(total) * now / arrivalSeconds));
+        const double wait = duration<double>(pacer.wait(at(now))).count();
+        if (arrived == shown || wait > 0) {
+            // Idle until the pacer allows a refresh or more results arrive
+            now += std::max(wait, 0.001);
+            continue;
+        }
+
+        const std::size_t count = std::min(arrived - shown, pacer.itemBudget());
+        const double cost = static_cast<double>(count) * insertCost;
+        pacer.record(at(now), at(now + cost), count);
+        shown += count;
+        now += cost;
+
+        result.refreshes++;
+        result.busySeconds += cost;
+        result.longestRefresh = std::max(result.longestRefresh, cost);
+        result.lastShown = seconds(at(now));
+    }
+    return result;
+}
+
+// The previous scheme: every 20 results the whole list is cleared and
+// every result found so far inserted again
+PacingResult SimulateRebuild(std::size_t total, double arrivalSeconds, double insertCost) {
+    PacingResult result;
+    double now = 0;
+    for (std::size_t found = 20; found <= total; found += 20) {
+        now = std::max(now, arrivalSeconds * static_cast<double>(found) / static_cast<double>(total));
+        const double cost = static_cast<double>(found) * insertCost;
+        now += cost;
+        result.refreshes++;
+        result.busySeconds += cost;
+        result.longestRefresh = std::max(result.longestRefresh, cost);
+    }
+    result.lastShown = now;
+    return result;
+}
+
+} // namespace
+
+FFE_BENCHMARK(ResultChannel, "result-channel", "Batched MPSC result channel and frame-paced list refreshes") {
+    const std::size_t producers = std::max<std::size_t>(2, options.maxThreads);
+    std::printf("%zu producers x %zu results, one consumer, million results per second\n", producers,
+                ItemsPerProducer);
+    std::printf("%-18s %10s\n", "scheme", "Mres/s");
+
+    const double total = static_cast<double>(producers * ItemsPerProducer) / 1e6;
+    double best = 1e9;
+    bool ordered = true;
+    for (int run = 0; run < options.repeat; ++run) {
+        best = std::min(best, RunLocked(producers, ordered));
+        if (!ordered) {
+            std::printf("locked vector lost or reordered results\n");
+            return 1;
+        }
+    }
+    std::printf("%-18s %10.1f\n", "mutex per result", total / best);
+    ReportMetric("mutex per result", total / best, "Mres/s");
+
+    for (std::size_t batchSize : {std::size_t(1), std::size_t(16), std::size_t(256)}) {
+        best = 1e9;
+        for (int run = 0; run < options.repeat; ++run) {
+            best = std::min(best, RunChannel(producers, batchSize, ordered));
+            if (!ordered) {
+                std::printf("channel with batches of %zu lost or reordered results\n", batchSize);
+                return 1;
+            }
+        }
+        char label[32];
+        std::snprintf(label, sizeof(label), "channel, batch %zu", batchSize);
+        std::printf("%-18s %10.1f\n", label, total / best);
+        ReportMetric(label, total / best, "Mres/s");
+    }
+
+    // List refreshes: results arrive over two seconds, a row insert costs 4 us
+    constexpr double ArrivalSeconds = 2.0;
+    constexpr double InsertCost = 4e-6;
+    std::printf("\nRefresh pacing, results arriving over %.0f s, %.0f us per row insert\n", ArrivalSeconds,
+                InsertCost * 1e6);
+    std::printf("%-10s %-10s %10s %10s %12s %12s\n", "results", "scheme", "refreshes", "busy s", "longest ms",
+                "last shown s");
+    for (std::size_t results : {std::size_t(10000), std::size_t(100000), std::size_t(1000000)}) {
+        const PacingResult paced = SimulatePaced(results, ArrivalSeconds, InsertCost);
+        std::printf("%-10zu %-10s %10zu %10.2f %12.2f %12.2f\n", results, "paced", paced.refreshes, paced.busySeconds,
+                    paced.longestRefresh * 1000.0, paced.lastShown);
+        if (results <= 100000) {
+            const PacingResult rebuild = SimulateRebuild(results, ArrivalSeconds, InsertCost);
+            std::printf("%-10zu %-10s %10zu %10.2f %12.2f %12.2f\n", results, "rebuild", rebuild.refreshes,
+                        rebuild.busySeconds, rebuild.longestRefresh * 1000.0, rebuild.lastShown);
+        }
+
+        // Appending costs each result one insert and no refresh may blow the budget
+        const double budget = std::chrono::duration<double>(ffe::FramePacer().budget()).count();
+        if (paced.longestRefresh > budget * 1.01 ||
+            paced.busySeconds > static_cast<double>(results) * InsertCost * 1.01) {
+            std::printf("paced refreshes exceeded the frame budget\n");
+            return 1;
+        }
+    }
+    return 0;
+}
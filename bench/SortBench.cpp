@@ -0,0 +1,171 @@
+#include "Bench.hpp"
+#include "NameCorpus.hpp"
+
+#include "engine/Collation.hpp"
+#include "engine/RowSorter.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <string>
+
+namespace {
+
+constexpr std::size_t RowCount = 10000000;
+constexpr std::size_t BaselineRows = 1000000; // Comparators that allocate are too slow for all rows
+
+std::string Key(ffe::NameView name) {
+    std::string key;
+    ffe::AppendCollationKey(name, key);
+    return key;
+}
+
+// Rows must be in collation order, folders first, with names compared by
+// keys computed here rather than by the sorter
+bool InNameOrder(const ffe::EntryModel& model) {
+    for (std::size_t i = 1; i < model.size(); ++i) {
+        const auto previous = model.row(i - 1);
+        const auto row = model.row(i);
+        if (previous.isDirectory() != row.isDirectory()) {
+            if (!previous.isDirectory()) {
+                return false;
+            }
+        } else if (Key(row.name) < Key(previous.name)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+FFE_BENCHMARK(Sort, "sort", "Sorting 10M rows by name, type and size with precomputed collation keys") {
+    const std::vector<std::wstring> wide = GenerateNames(100000);
+    std::vector<fs::path::string_type> names;
+    names.reserve(wide.size());
+    for (const auto& name : wide) {
+        names.push_back(ToNative(name));
+    }
+
+    // Rows in enumeration order: one in ten a folder, sizes spread widely
+    ffe::EntryModel model;
+    model.reserve(RowCount, 0);
+    const auto folder = model.addDirectory(fs::path("/data"));
+    std::mt19937_64 random(5);
+    for (std::size_t i = 0; i < RowCount; ++i) {
+        ffe::DirEntry entry;
+        entry.name = names[random() % names.size()];
+        entry.type = i % 10 == 0 ? ffe::EntryType::Directory : ffe::EntryType::File;
+        entry.hasStat = true;
+        entry.size = entry.type == ffe::EntryType::File ? random() % (1ull << 32) : 0;
+        entry.mtime = static_cast<std::int64_t>(random() % (1ull << 40));
+        model.append(folder, entry);
+    }
+    std::vector<std::uint32_t> shuffle(RowCount);
+    std::iota(shuffle.begin(), shuffle.end(), 0u);
+    std::shuffle(shuffle.begin(), shuffle.end(), random);
+    std::printf("%zu rows, %zu distinct names\n", model.size(), names.size());
+    std::printf("%-34s %10s %8s %10s\n", "sort", "rows", "threads", "ms");
+
+    // Before: full paths compared through file name temporaries, as the
+    // search results used to be (filename().wstring(), native on Windows)
+    {
+        std::vector<fs::path> paths;
+        paths.reserve(BaselineRows);
+        for (std::size_t i = 0; i < BaselineRows; ++i) {
+            paths.push_back(model.path(i));
+        }
+        Stopwatch timer;
+        std::sort(paths.begin(), paths.end(), [](const fs::path& a, const fs::path& b) {
+            return a.filename().native() < b.filename().native();
+        });
+        std::printf("%-34s %10zu %8d %10.0f\n", "path comparator", paths.size(), 1, timer.seconds() * 1000.0);
+    }
+
+    // Natural order without precomputed keys: keys built in every comparison
+    {
+        std::vector<ffe::NameView> rows;
+        rows.reserve(BaselineRows);
+        model.forEachRow(0, BaselineRows, [&rows](std::size_t, const ffe::EntryModel::Row& row) {
+            rows.push_back(row.name);
+        });
+        Stopwatch timer;
+        std::sort(rows.begin(), rows.end(), [](ffe::NameView a, ffe::NameView b) { return Key(a) < Key(b); });
+        std::printf("%-34s %10zu %8d %10.0f\n", "keys per comparison", rows.size(), 1, timer.seconds() * 1000.0);
+    }
+
+    for (std::size_t threads : ThreadSweep(options.maxThreads)) {
+        ffe::Executor executor(threads);
+        double keyed = 1e9;
+        double bySize = 1e9;
+        double byType = 1e9;
+        double flipped = 1e9;
+        for (int run = 0; run < options.repeat; ++run) {
+            model.reorder(shuffle);
+            ffe::RowSorter sorter(&executor);
+
+            // First sort: keys for every row, then the sort itself
+            Stopwatch keyTimer;
+            sorter.sort(model, ffe::SortOrder());
+            keyed = std::min(keyed, keyTimer.seconds());
+            if (run == 0 && !InNameOrder(model)) {
+                std::printf("rows are not in name order\n");
+                return 1;
+            }
+
+            // Header clicks: other columns reuse the keys, the same column
+            // flips by reversing
+            ffe::SortOrder size;
+            size.keys = {{ffe::SortColumn::Size, false}};
+            Stopwatch sizeTimer;
+            sorter.sort(model, size);
+            bySize = std::min(bySize, sizeTimer.seconds());
+            for (std::size_t i = 1; run == 0 && i < model.size(); ++i) {
+                const auto previous = model.row(i - 1);
+                const auto row = model.row(i);
+                if (previous.isDirectory() == row.isDirectory() && row.size < previous.size) {
+                    std::printf("rows are not in size order at %zu\n", i);
+                    return 1;
+                }
+            }
+
+            ffe::SortOrder type;
+            type.keys = {{ffe::SortColumn::Type, false}};
+            Stopwatch typeTimer;
+            sorter.sort(model, type);
+            byType = std::min(byType, typeTimer.seconds());
+
+            Stopwatch flipTimer;
+            sorter.sort(model, type.reversed());
+            flipped = std::min(flipped, flipTimer.seconds());
+            if (run == 0 && (model.row(0).isDirectory() || !model.row(model.size() - 1).isDirectory())) {
+                std::printf("folders are not last after flipping\n");
+                return 1;
+            }
+        }
+        std::printf("%-34s %10zu %8zu %10.0f\n", "name, keys computed", model.size(), threads, keyed * 1000.0);
+        std::printf("%-34s %10zu %8zu %10.0f\n", "size, keys reused", model.size(), threads, bySize * 1000.0);
+        std::printf("%-34s %10zu %8zu %10.0f\n", "type, keys reused", model.size(), threads, byType * 1000.0);
+        std::printf("%-34s %10zu %8zu %10.0f\n", "type flipped", model.size(), threads, flipped * 1000.0);
+        const std::string suffix = ", " + std::to_string(threads) + " threads";
+        ReportMetric("name" + suffix, keyed * 1000.0, "ms");
+        ReportMetric("size" + suffix, bySize * 1000.0, "ms");
+        ReportMetric("type" + suffix, byType * 1000.0, "ms");
+        ReportMetric("flip" + suffix, flipped * 1000.0, "ms");
+    }
+
+    // Explorer's order on names where plain comparison gets it wrong
+    const auto native = [](const char* name) { return fs::path(name).native(); };
+    const std::pair<const char*, const char*> ordered[] = {
+        {"file2.txt", "file10.txt"}, {"File2", "file10"}, {"a", "B"}, {"IMG_9", "img_0010"}, {"v1.9", "v1.10"},
+        {"report", "report 2"}, {"x 7", "x7"},
+    };
+    for (const auto& [first, second] : ordered) {
+        if (!(Key(native(first)) < Key(native(second)))) {
+            std::printf("\"%s\" does not sort before \"%s\"\n", first, second);
+            return 1;
+        }
+    }
+    return 0;
+}
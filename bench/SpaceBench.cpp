@@ -0,0 +1,170 @@
+#include "Bench.hpp"
+
+#include "engine/SpaceAnalyzer.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <random>
+#include <string>
+
+namespace {
+
+// Extensions of the generated files, in mixed case; the last one is too
+// long to be tallied apart
+constexpr const char* Extensions[] = {".txt", ".JPG", ".mp4", ".log", ".tar.gz", "", ".Bin", ".cache-0123456789abcdef"};
+
+// Generates 585 folders (fanout 8, depth 3) of 24 files each, their sizes
+// spread over powers of two up to 64 KiB so that the largest stand out.
+// Reuses a tree that a previous run generated.
+fs::path GenerateSpaceTree() {
+    const fs::path root = fs::temp_directory_path() / "ffe-bench-space";
+    const fs::path marker = root / ".complete";
+    if (fs::exists(marker)) {
+        return root;
+    }
+    fs::remove_all(root);
+
+    std::mt19937_64 random(25);
+    const std::function<void(const fs::path&, int)> fill = [&](const fs::path& dir, int depth) {
+        fs::create_directories(dir);
+        for (int index = 0; index < 24; ++index) {
+            const std::size_t size = (std::size_t{1} << (random() % 17)) + random() % 100;
+            const char* extension = Extensions[random() % std::size(Extensions)];
+            std::string contents(size, static_cast<char>('a' + index));
+            std::ofstream(dir / ("file_" + std::to_string(index) + extension), std::ios::binary)
+                .write(contents.data(), static_cast<std::streamsize>(contents.size()));
+        }
+        if (depth < 3) {
+            for (int sub = 0; sub < 8; ++sub) {
+                fill(dir / ("dir_" + std::to_string(sub)), depth + 1);
+            }
+        }
+    };
+    fill(root, 0);
+    std::ofstream(marker) << "space\n";
+    return root;
+}
+
+// Totals, largest file sizes and bytes per extension of a tree, found with
+// a sequential walk; every name of a hard linked file counts
+struct NaiveSpace {
+    ffe::FolderSize total;
+    std::vector<std::uint64_t> largest; // Largest first
+    std::map<std::string, std::uint64_t> extensions; // "(other)" for overly long ones
+};
+
+std::string ExtensionKey(const fs::path& path) {
+    std::string extension = path.extension().string();
+    if (extension.size() > 17) {
+        return "(other)";
+    }
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](char c) { return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c; });
+    return extension.empty() ? extension : extension.substr(1);
+}
+
+NaiveSpace NaiveSpaceOf(const fs::path& root, std::size_t top) {
+    NaiveSpace space;
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it(root, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->is_symlink(ec)) {
+            continue;
+        }
+        if (it->is_directory(ec)) {
+            space.total.directories++;
+        } else if (it->is_regular_file(ec)) {
+            const std::uint64_t bytes = it->file_size(ec);
+            space.total.bytes += bytes;
+            space.total.files++;
+            space.largest.push_back(bytes);
+            space.extensions[ExtensionKey(it->path())] += bytes;
+        }
+    }
+    std::sort(space.largest.rbegin(), space.largest.rend());
+    space.largest.resize(std::min(space.largest.size(), top));
+    return space;
+}
+
+// Compares a report taken without identities, where allocation is the
+// size, with the naive walk; prints the first difference
+bool Matches(const ffe::SpaceReport& report, const NaiveSpace& expected) {
+    if (report.total.bytes != expected.total.bytes || report.total.files != expected.total.files ||
+        report.total.directories != expected.total.directories || report.total.errors != 0) {
+        std::printf("counted %llu bytes in %llu files and %llu folders, %llu errors; expected %llu, %llu, %llu\n",
+                    static_cast<unsigned long long>(report.total.bytes),
+                    static_cast<unsigned long long>(report.total.files),
+                    static_cast<unsigned long long>(report.total.directories),
+                    static_cast<unsigned long long>(report.total.errors),
+                    static_cast<unsigned long long>(expected.total.bytes),
+                    static_cast<unsigned long long>(expected.total.files),
+                    static_cast<unsigned long long>(expected.total.directories));
+        return false;
+    }
+    std::vector<std::uint64_t> largest;
+    for (const auto& file : report.files) {
+        largest.push_back(file.bytes);
+    }
+    if (largest != expected.largest) {
+        std::printf("largest files differ from the naive ranking\n");
+        return false;
+    }
+    std::map<std::string, std::uint64_t> extensions;
+    for (const auto& extension : report.extensions) {
+        extensions[extension.other ? "(other)" : fs::path(extension.extension).string()] += extension.bytes;
+    }
+    if (extensions != expected.extensions) {
+        std::printf("bytes per extension differ from the naive tally\n");
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+FFE_FS_BENCHMARK(Space, "space", "SpaceAnalyzer directories/s and folders pending at once, 1..N threads") {
+    const fs::path root = options.chosenTree ? options.root : GenerateSpaceTree();
+    const ffe::SpaceOptions defaults;
+    const NaiveSpace expected = NaiveSpaceOf(root, defaults.topFiles);
+
+    std::printf("%8s %12s %12s %10s %12s\n", "threads", "dirs/s", "files/s", "ms", "peak pending");
+    for (std::size_t threads : ThreadSweep(options.maxThreads)) {
+        ffe::Executor executor(threads);
+        double best = 1e9;
+        ffe::SpaceReport report;
+        for (int run = 0; run < options.repeat; ++run) {
+            ffe::SpaceAnalyzer analyzer(executor);
+            PrepareRun(options);
+            Stopwatch timer;
+            analyzer.scan({root});
+            analyzer.wait();
+            best = std::min(best, timer.seconds());
+            report = analyzer.snapshot();
+            if (!report.done || report.total.directories != expected.total.directories) {
+                std::printf("scan ended after %llu of %llu folders\n",
+                            static_cast<unsigned long long>(report.total.directories),
+                            static_cast<unsigned long long>(expected.total.directories));
+                return 1;
+            }
+        }
+
+        // Checked apart, without identities, so the ranking is by size as
+        // the naive one is
+        ffe::SpaceOptions bySize;
+        bySize.identities = false;
+        ffe::SpaceAnalyzer analyzer(executor, bySize);
+        analyzer.scan({root});
+        analyzer.wait();
+        if (!Matches(analyzer.snapshot(), expected)) {
+            return 1;
+        }
+
+        const double folders = static_cast<double>(report.total.directories + 1);
+        std::printf("%8zu %12.0f %12.0f %10.1f %12llu\n", threads, folders / best, report.total.files / best,
+                    best * 1000.0, static_cast<unsigned long long>(report.peakPendingFolders));
+        ReportMetric(std::to_string(threads) + " threads", folders / best, "dirs/s");
+    }
+    return 0;
+}
@@ -0,0 +1,127 @@
+#include "Bench.hpp"
+#include "TreeGenerator.hpp"
+
+#include "engine/DirectoryReader.hpp"
+#include "engine/StatEngine.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+namespace {
+
+// 2,801 folders of 90 files each, about 250 thousand entries
+constexpr TreeShape StatShape{7, 4, 90};
+
+struct Listing {
+    fs::path dir;
+    std::vector<ffe::DirEntry> entries;
+};
+
+std::vector<Listing> ListTree(const fs::path& root) {
+    std::vector<Listing> listings;
+    std::vector<fs::path> pending{root};
+    std::error_code ec;
+    while (!pending.empty()) {
+        Listing listing{pending.back(), {}};
+        pending.pop_back();
+        ffe::ReadDirectory(listing.dir, listing.entries, ec);
+        for (const auto& entry : listing.entries) {
+            if (entry.isDirectory()) {
+                pending.push_back(listing.dir / entry.name);
+            }
+        }
+        listings.push_back(std::move(listing));
+    }
+    return listings;
+}
+
+void ForgetStats(std::vector<Listing>& listings) {
+    for (auto& listing : listings) {
+        for (auto& entry : listing.entries) {
+            entry.hasStat = false;
+            entry.size = 0;
+            entry.mtime = 0;
+        }
+    }
+}
+
+std::uint64_t TotalSize(const std::vector<Listing>& listings) {
+    std::uint64_t total = 0;
+    for (const auto& listing : listings) {
+        for (const auto& entry : listing.entries) {
+            total += entry.hasStat ? entry.size + 1 : 0;
+        }
+    }
+    return total;
+}
+
+} // namespace
+
+FFE_FS_BENCHMARK(Stat, "statx", "Batched metadata: io_uring statx against per-entry and thread-pool stat") {
+    fs::path root = options.root;
+    if (!options.chosenTree) {
+        root = fs::temp_directory_path() / "ffe-bench-stat";
+        GenerateTree(root, StatShape);
+    }
+    auto listings = ListTree(root);
+    std::size_t entryCount = 0;
+    for (const auto& listing : listings) {
+        entryCount += listing.entries.size();
+    }
+
+    ffe::Executor executor(std::max<std::size_t>(options.maxThreads, 4));
+    const bool uring = ffe::StatEngine::IoUringAvailable();
+    std::printf("%zu entries in %zu folders, io_uring %s\n", entryCount, listings.size(),
+                uring ? "available" : "unavailable");
+    std::printf("%-28s %12s %14s\n", "backend", "ms", "entries/s");
+
+    struct Config {
+        std::string name;
+        int kind; // 0: StatEntry per entry, 1: engine
+        ffe::StatEngine engine;
+    };
+    using Backend = ffe::StatEngine::Backend;
+    std::vector<Config> configs = {
+        {"StatEntry per entry", 0, ffe::StatEngine(nullptr, Backend::Threads)},
+        {"statx inline", 1, ffe::StatEngine(nullptr, Backend::Threads)},
+        {"thread pool", 1, ffe::StatEngine(&executor, Backend::Threads)},
+    };
+    if (uring) {
+        for (unsigned depth : {8u, 64u, 256u}) {
+            configs.push_back(
+                {"io_uring depth " + std::to_string(depth), 1, ffe::StatEngine(nullptr, Backend::IoUring, depth)});
+        }
+    }
+
+    std::uint64_t expected = 0;
+    for (const auto& config : configs) {
+        double best = 1e9;
+        for (int run = 0; run < options.repeat; ++run) {
+            ForgetStats(listings);
+            PrepareRun(options);
+            Stopwatch timer;
+            for (auto& listing : listings) {
+                if (config.kind == 0) {
+                    for (auto& entry : listing.entries) {
+                        ffe::StatEntry(listing.dir, entry);
+                    }
+                } else {
+                    config.engine.statEntries(listing.dir, listing.entries);
+                }
+            }
+            best = std::min(best, timer.seconds());
+        }
+        std::printf("%-28s %12.1f %14.0f\n", config.name.c_str(), best * 1000.0, entryCount / best);
+        ReportMetric(config.name, entryCount / best, "entries/s");
+
+        const std::uint64_t total = TotalSize(listings);
+        if (expected == 0) {
+            expected = total;
+        } else if (total != expected) {
+            std::printf("%s filled in different sizes\n", config.name.c_str());
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,110 @@
+#include "Bench.hpp"
+
+#include "engine/Trace.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+
+namespace {
+
+constexpr std::size_t Spans = 10000000;
+
+double NanosPerSpan(const BenchOptions& options) {
+    double best = 1e9;
+    for (int run = 0; run < options.repeat; ++run) {
+        Stopwatch timer;
+        for (std::size_t i = 0; i < Spans; ++i) {
+            ffe::TraceSpan span("bench span");
+            span.arg("i", static_cast<std::int64_t>(i));
+        }
+        best = std::min(best, timer.seconds());
+    }
+    return best * 1e9 / Spans;
+}
+
+// Checks the spans written by Recorder: span n starts at n us, lasts n % 7
+// us and carries n, so a span torn by a concurrent write shows up
+bool CheckExport(const std::string& json, std::size_t& spans) {
+    spans = 0;
+    for (const char* at = std::strstr(json.c_str(), "\"check span\""); at; at = std::strstr(at + 1, "\"check span\"")) {
+        double ts = 0;
+        double dur = 0;
+        long long n = 0;
+        const char* fields = std::strstr(at, "\"ts\":");
+        if (!fields) {
+            return false;
+        }
+        // sscanf measures its whole input, so give it only this span
+        char record[128] = {};
+        std::strncpy(record, fields, sizeof(record) - 1);
+        if (std::sscanf(record, "\"ts\":%lf,\"dur\":%lf,\"args\":{\"n\":%lld", &ts, &dur, &n) != 3) {
+            return false;
+        }
+        if (static_cast<long long>(ts) != n || static_cast<long long>(dur) != n % 7) {
+            return false;
+        }
+        ++spans;
+    }
+    return true;
+}
+
+} // namespace
+
+FFE_BENCHMARK(TraceSpans, "trace", "Tracing span cost with tracing off and on, and export while threads record") {
+    ffe::Trace::Clear();
+    ffe::Trace::Enable(false);
+    const double off = NanosPerSpan(options);
+    ffe::Trace::Enable(true);
+    const double on = NanosPerSpan(options);
+    std::printf("%-24s %10s\n", "span", "ns");
+    std::printf("%-24s %10.2f\n", "tracing off", off);
+    std::printf("%-24s %10.2f\n", "tracing on", on);
+    ReportMetric("span, tracing off", off, "ns");
+    ReportMetric("span, tracing on", on, "ns");
+
+    // Recorders wrap their rings many times over while the trace is exported
+    const std::size_t recorders = std::max<std::size_t>(2, options.maxThreads);
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < recorders; ++t) {
+        threads.emplace_back([&stop] {
+            for (std::int64_t n = 0; !stop.load(std::memory_order_relaxed); ++n) {
+                ffe::Trace::Record("check span", n * 1000, (n + n % 7) * 1000, "n", n);
+            }
+        });
+    }
+
+    double longest = 0;
+    std::size_t exported = 0;
+    bool valid = true;
+    for (int run = 0; run < 10 && valid; ++run) {
+        std::string json;
+        Stopwatch timer;
+        ffe::Trace::AppendChromeJson(json);
+        longest = std::max(longest, timer.seconds());
+        valid = CheckExport(json, exported);
+    }
+    stop = true;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ffe::Trace::Enable(false);
+    ffe::Trace::Clear();
+
+    std::printf("%-24s %10.1f ms for %zu spans of %zu recording threads\n", "export", longest * 1000.0, exported,
+                recorders);
+    ReportMetric("export", longest * 1000.0, "ms");
+    if (!valid) {
+        std::printf("export contained a torn span\n");
+        return 1;
+    }
+    if (exported > recorders * ffe::Trace::ThreadCapacity) {
+        std::printf("export held %zu spans, more than the rings can\n", exported);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,166 @@
+#include "TreeGenerator.hpp"
+#include "NameCorpus.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace {
+
+// Names stay below this many native units, leaving room for the " (N)"
+// suffix that keeps them unique within a folder
+constexpr std::size_t LongNameUnits = 240;
+
+// Mixed-script padding for long names: Latin, Cyrillic, Greek and CJK
+constexpr const wchar_t* LongPadding = L" – Überarbeitete Fassung, черновик, τελικό, 最終版";
+
+struct Generator {
+    const TreeShape& shape;
+    std::vector<std::wstring> corpus;
+    std::string content;
+    std::size_t directories = 0;
+    std::size_t files = 0;
+
+    explicit Generator(const TreeShape& shape) : shape(shape) {
+        if (shape.names != NameStyle::Numbered) {
+            corpus = GenerateNames(4096);
+        }
+        // Plain text lines; each file gets its own number at the start so
+        // no two files have the same content
+        while (content.size() < shape.fileBytes) {
+            content += "The quick brown fox jumps over the lazy dog " + std::to_string(content.size()) + "\n";
+        }
+        content.resize(shape.fileBytes);
+    }
+
+    fs::path::string_type name(bool directory, std::size_t index) const {
+        if (shape.names == NameStyle::Numbered) {
+            const std::string name = directory ? "dir_" + std::to_string(index)
+                                               : "file_" + std::to_string(index) + ".txt";
+            return fs::path(name).native();
+        }
+
+        std::wstring base = corpus[(directories * 131 + index * 7 + (directory ? 1 : 0)) % corpus.size()];
+        std::wstring extension;
+        const std::size_t dot = base.rfind(L'.');
+        if (dot != std::wstring::npos && dot > 0) {
+            extension = base.substr(dot);
+            base.resize(dot);
+        }
+        if (directory) {
+            extension.clear();
+        }
+        if (shape.names == NameStyle::Long) {
+            const std::size_t budget = LongNameUnits - ToNative(extension).size();
+            while (ToNative(base).size() < budget) {
+                base += LongPadding;
+            }
+            while (ToNative(base).size() > budget) {
+                base.pop_back();
+            }
+        }
+        return ToNative(base + L" (" + std::to_wstring(index) + L")" + extension);
+    }
+
+    void writeFile(const fs::path& path) {
+        std::ofstream out(path, std::ios::binary);
+        if (content.empty()) {
+            return;
+        }
+        const std::string number = std::to_string(files) + " ";
+        const std::size_t prefix = std::min(number.size(), content.size());
+        out.write(number.data(), static_cast<std::streamsize>(prefix));
+        out.write(content.data() + prefix, static_cast<std::streamsize>(content.size() - prefix));
+    }
+
+    void level(const fs::path& dir, std::size_t depth) {
+        fs::create_directories(dir);
+        for (std::size_t i = 0; i < shape.filesPerDir; ++i) {
+            writeFile(dir / name(false, i));
+            ++files;
+        }
+        ++directories;
+
+        if (depth < shape.depth) {
+            // Names are picked before descending, which moves the counter
+            std::vector<fs::path::string_type> children;
+            for (std::size_t i = 0; i < shape.fanout; ++i) {
+                children.push_back(name(true, i));
+            }
+            for (const auto& child : children) {
+                level(dir / child, depth + 1);
+            }
+        }
+    }
+};
+
+// Written to the marker, so a tree of a different shape is regenerated
+std::string Signature(const TreeShape& shape) {
+    std::ostringstream signature;
+    signature << shape.fanout << ' ' << shape.depth << ' ' << shape.filesPerDir << ' ' << shape.fileBytes << ' '
+              << static_cast<int>(shape.names);
+    return signature.str();
+}
+
+fs::path NamedTreePath(const NamedShape& shape) {
+    const std::string name = shape.name;
+    return fs::temp_directory_path() / (name == "default" ? "ffe-bench-tree" : "ffe-bench-" + name);
+}
+
+} // namespace
+
+std::size_t GenerateTree(const fs::path& root, const TreeShape& shape) {
+    // A marker written last means an interrupted generation is redone
+    const fs::path marker = root / ".complete";
+    std::size_t directories = 1;
+    std::size_t levelSize = 1;
+    for (std::size_t level = 0; level < shape.depth; ++level) {
+        levelSize *= shape.fanout;
+        directories += levelSize;
+    }
+
+    const std::string signature = Signature(shape);
+    std::string existing;
+    std::getline(std::ifstream(marker), existing);
+    if (existing == signature) {
+        return directories;
+    }
+
+    fs::remove_all(root);
+    Generator generator(shape);
+    generator.level(root, 0);
+    std::ofstream(marker) << signature << '\n';
+    return directories;
+}
+
+const std::vector<NamedShape>& NamedShapes() {
+    static const std::vector<NamedShape> shapes = {
+        {"default", "4,681 folders of 16 empty files", TreeShape{}},
+        {"wide", "200,000 files in one folder", TreeShape{0, 0, 200000}},
+        {"deep", "a chain of 256 nested folders of 4 files", TreeShape{1, 256, 4}},
+        {"small-files", "a million 1 KiB files in 11,111 folders", TreeShape{10, 4, 90, 1024}},
+        {"unicode", "585 folders of 64 realistic names, one in ten outside ASCII", TreeShape{8, 3, 64, 0, NameStyle::Corpus}},
+        {"long-names", "341 folders of 32 names near the 255 limit", TreeShape{4, 4, 32, 0, NameStyle::Long}},
+    };
+    return shapes;
+}
+
+const NamedShape* FindShape(std::string_view name) {
+    for (const auto& shape : NamedShapes()) {
+        if (name == shape.name) {
+            return &shape;
+        }
+    }
+    return nullptr;
+}
+
+fs::path GenerateNamedTree(const NamedShape& shape) {
+    fs::path root = NamedTreePath(shape);
+    GenerateTree(root, shape.shape);
+    return root;
+}
+
+fs::path DefaultBenchTree() {
+    return GenerateNamedTree(*FindShape("default"));
+}
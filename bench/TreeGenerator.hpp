@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// How generated entries are named
+enum class NameStyle {
+    Numbered, // file_N.txt and dir_N
+    Corpus,   // Realistic names from NameCorpus, about one in ten outside ASCII
+    Long,     // Corpus names padded with mixed-script text to near the 255 limit
+};
+
+// Shape of a synthetic directory tree
+struct TreeShape {
+    std::size_t fanout = 8;               // Subdirectories per directory
+    std::size_t depth = 4;                // Levels below the root
+    std::size_t filesPerDir = 16;         // Files per directory
+    std::size_t fileBytes = 0;            // Content per file, empty files when 0
+    NameStyle names = NameStyle::Numbered;
+};
+
+// Creates the tree below root unless a previous run already made one of the
+// same shape. Returns the number of directories in the tree, root included.
+// The same shape always gives the same names and contents.
+std::size_t GenerateTree(const fs::path& root, const TreeShape& shape);
+
+// Trees selectable with ffe-bench --shape
+struct NamedShape {
+    const char* name;
+    const char* description;
+    TreeShape shape;
+};
+
+const std::vector<NamedShape>& NamedShapes();
+
+// Null for an unknown name
+const NamedShape* FindShape(std::string_view name);
+
+// Generates the named tree in the temporary directory, returns its root
+fs::path GenerateNamedTree(const NamedShape& shape);
+
+// Default benchmark tree in the temporary directory
+fs::path DefaultBenchTree();
@@ -0,0 +1,100 @@
+#include "Bench.hpp"
+#include "NameCorpus.hpp"
+
+#include "engine/TypeCache.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+
+namespace {
+
+constexpr std::size_t NameCount = 50000;
+constexpr std::size_t FolderCount = 500;
+
+// Stands in for a shell round trip (registry reads, icon extraction)
+constexpr auto ResolveLatency = std::chrono::microseconds(20);
+
+struct CountingResolver {
+    std::atomic<std::size_t> calls = 0;
+
+    ffe::FileType resolve(const fs::path& path, ffe::EntryType type) {
+        calls++;
+        const auto until = std::chrono::steady_clock::now() + ResolveLatency;
+        while (std::chrono::steady_clock::now() < until) {
+        }
+        return ffe::MimeFileType(path, type);
+    }
+};
+
+// Rows of a few listings: names spread over folders, with a program and a
+// shortcut here and there
+std::vector<fs::path> CorpusPaths() {
+    const auto names = GenerateNames(NameCount);
+    std::vector<fs::path> paths;
+    paths.reserve(names.size());
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        fs::path path = fs::path("/data") / std::to_string(i % FolderCount) / ToNative(names[i]);
+        if (i % 97 == 0) {
+            path.replace_extension(i % 2 ? ".exe" : ".LNK");
+        }
+        paths.push_back(std::move(path));
+    }
+    return paths;
+}
+
+} // namespace
+
+FFE_BENCHMARK(TypeCache, "type-cache", "File type resolution: per-file lookups against an extension-keyed LRU cache") {
+    const auto paths = CorpusPaths();
+    std::printf("%zu files in %zu folders, %lld us per resolver call\n", paths.size(), FolderCount,
+                static_cast<long long>(ResolveLatency.count()));
+    std::printf("%-12s %10s %12s %10s %10s %8s %8s %12s\n", "cache", "ms", "resolves", "hit rate", "evictions",
+                "keys", "types", "memory");
+
+    // Every file resolved on its own, as the shell would be asked per row
+    std::vector<ffe::FileType> expected;
+    expected.reserve(paths.size());
+    {
+        CountingResolver resolver;
+        double best = 1e9;
+        for (int run = 0; run < options.repeat; ++run) {
+            expected.clear();
+            Stopwatch timer;
+            for (const auto& path : paths) {
+                expected.push_back(resolver.resolve(path, ffe::EntryType::File));
+            }
+            best = std::min(best, timer.seconds());
+        }
+        std::printf("%-12s %10.1f %12zu %10s %10s %8s %8s %12s\n", "none", best * 1000.0, paths.size(), "-", "-", "-",
+                    "-", "-");
+    }
+
+    for (std::size_t capacity : {std::size_t(16), std::size_t(64), std::size_t(256), ffe::TypeCache::DefaultCapacity}) {
+        CountingResolver resolver;
+        ffe::TypeCache cache(
+            [&resolver](const fs::path& path, ffe::EntryType type, bool) { return resolver.resolve(path, type); },
+            capacity);
+
+        Stopwatch timer;
+        for (std::size_t i = 0; i < paths.size(); ++i) {
+            const auto type = cache.lookup(paths[i], ffe::EntryType::File);
+            if (type->description != expected[i].description) {
+                std::printf("wrong type for %s\n", paths[i].string().c_str());
+                return 1;
+            }
+        }
+        const double seconds = timer.seconds();
+
+        const auto stats = cache.stats();
+        const char* label = capacity == ffe::TypeCache::DefaultCapacity ? "default" : "";
+        std::printf("%-4zu %-7s %10.1f %12zu %9.1f%% %10zu %8zu %8zu %10.1fKB\n", capacity, label, seconds * 1000.0,
+                    resolver.calls.load(), 100.0 * stats.hits / (stats.hits + stats.misses), stats.evictions,
+                    stats.keys, stats.types, cache.memoryUsage() / 1024.0);
+        if (stats.keys > capacity || resolver.calls != stats.misses) {
+            std::printf("cache exceeded its bound or resolved a hit\n");
+            return 1;
+        }
+    }
+    return 0;
+}
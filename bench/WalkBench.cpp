@@ -0,0 +1,48 @@
+#include "Bench.hpp"
+
+#include "engine/TreeWalker.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <string>
+
+FFE_FS_BENCHMARK(TreeWalk, "tree-walk", "TreeWalker directories/entries per second, 1..N threads") {
+    // Reference count from the standard library's sequential walk
+    std::uint64_t expectedEntries = 0;
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it(options.root, ec), end; !ec && it != end; it.increment(ec)) {
+        ++expectedEntries;
+    }
+
+    std::printf("%8s %12s %14s %10s\n", "threads", "dirs/s", "entries/s", "ms");
+    for (std::size_t threads : ThreadSweep(options.maxThreads)) {
+        ffe::Executor executor(threads);
+        ffe::TreeWalker walker(executor);
+
+        ffe::WalkStats best;
+        for (int run = 0; run < options.repeat; ++run) {
+            std::atomic<std::uint64_t> visited{0};
+            PrepareRun(options);
+            ffe::WalkStats stats = walker.walk(options.root, [&visited](const ffe::WalkDirectory& dir) {
+                visited.fetch_add(dir.entries.size(), std::memory_order_relaxed);
+            }).wait();
+
+            if (stats.entries != expectedEntries || visited.load() != expectedEntries) {
+                std::printf("entry count mismatch: walked %llu, visited %llu, expected %llu\n",
+                            static_cast<unsigned long long>(stats.entries),
+                            static_cast<unsigned long long>(visited.load()),
+                            static_cast<unsigned long long>(expectedEntries));
+                return 1;
+            }
+            if (run == 0 || stats.elapsed < best.elapsed) {
+                best = stats;
+            }
+        }
+
+        const double seconds = std::chrono::duration<double>(best.elapsed).count();
+        std::printf("%8zu %12.0f %14.0f %10.1f\n", threads, best.directories / seconds,
+                    best.entries / seconds, seconds * 1000.0);
+        ReportMetric(std::to_string(threads) + " threads", best.entries / seconds, "entries/s");
+    }
+    return 0;
+}
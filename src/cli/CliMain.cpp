@@ -0,0 +1,835 @@
+// Headless frontend: the explorer's listing, search, grep, dupes, size and
+// space operations on the same engine code as the window, with results streamed to
+// stdout so they can be scripted, profiled and benchmarked without a UI.
+
+#include "cli/Output.hpp"
+
+#include "engine/ContentSearch.hpp"
+#include "engine/DirectoryReader.hpp"
+#include "engine/DuplicateFinder.hpp"
+#include "engine/EntryModel.hpp"
+#include "engine/Executor.hpp"
+#include "engine/FolderSizer.hpp"
+#include "engine/ListingCache.hpp"
+#include "engine/Metrics.hpp"
+#include "engine/NameQuery.hpp"
+#include "engine/ResultChannel.hpp"
+#include "engine/RowSorter.hpp"
+#include "engine/SpaceAnalyzer.hpp"
+#include "engine/TopK.hpp"
+#include "engine/Trace.hpp"
+#include "engine/TreeWalker.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace std::chrono_literals;
+
+namespace {
+
+using ffe::cli::OutputFormat;
+using ffe::cli::RecordWriter;
+
+// Results found but not yet written before search workers wait for the
+// output to catch up
+constexpr std::size_t MaxUnwrittenResults = 64 * 1024;
+
+constexpr std::size_t MaxRankedResults = 500;
+
+struct Options {
+    OutputFormat format = OutputFormat::Text;
+    std::size_t threads = ffe::Executor::DefaultThreadCount();
+    ffe::SortOrder order;
+    bool sorted = false;
+    bool stats = true;
+    std::chrono::milliseconds metricsInterval{0}; // Live metrics on stderr while walking, off when zero
+    ffe::ContentOptions content;                  // For grep
+    ffe::DuplicateOptions duplicates;             // For dupes
+    ffe::SpaceOptions space{20, 20};              // For space
+    bool allocated = false;                       // size and space print bytes on disk rather than apparent bytes
+};
+
+// What a command did, printed to stderr when it finishes
+struct RunStats {
+    std::uint64_t results = 0;
+    std::uint64_t entries = 0;
+    std::uint64_t directories = 0;
+    std::uint64_t errors = 0;
+    std::chrono::steady_clock::duration elapsed{};
+    std::chrono::steady_clock::duration firstResult{}; // Zero without results
+};
+
+void PrintStats(const char* command, const RunStats& stats, const Options& options) {
+    if (!options.stats) {
+        return;
+    }
+    const double ms = std::chrono::duration<double, std::milli>(stats.elapsed).count();
+    const double firstMs = std::chrono::duration<double, std::milli>(stats.firstResult).count();
+    const double entriesPerSecond = ms > 0 ? stats.entries * 1000.0 / ms : 0;
+    if (options.format == OutputFormat::Ndjson) {
+        std::fprintf(stderr,
+                     "{\"stats\":{\"command\":\"%s\",\"results\":%llu,\"entries\":%llu,\"directories\":%llu,"
+                     "\"errors\":%llu,\"ms\":%.3f,\"firstResultMs\":%.3f,\"entriesPerSecond\":%.0f}}\n",
+                     command, static_cast<unsigned long long>(stats.results),
+                     static_cast<unsigned long long>(stats.entries), static_cast<unsigned long long>(stats.directories),
+                     static_cast<unsigned long long>(stats.errors), ms, firstMs, entriesPerSecond);
+    } else {
+        std::fprintf(stderr,
+                     "%s: %llu results, %llu entries in %llu directories, %llu errors, %.1f ms "
+                     "(first result %.1f ms, %.0f entries/s)\n",
+                     command, static_cast<unsigned long long>(stats.results),
+                     static_cast<unsigned long long>(stats.entries), static_cast<unsigned long long>(stats.directories),
+                     static_cast<unsigned long long>(stats.errors), ms, firstMs, entriesPerSecond);
+    }
+}
+
+// Prints live metrics of a running command to stderr, as a JSON line in
+// ndjson mode
+void DumpMetrics(const char* command, const ffe::Metrics& metrics, const Options& options) {
+    const ffe::MetricsSnapshot snapshot = metrics.snapshot();
+    if (options.format == OutputFormat::Ndjson) {
+        std::string line = "{\"metrics\":";
+        ffe::AppendMetricsJson(snapshot, line);
+        line += ",\"command\":\"";
+        line += command;
+        line += "\"}\n";
+        std::fputs(line.c_str(), stderr);
+    } else {
+        std::fprintf(stderr, "%s: %llu entries in %llu directories, %llu matches, %.0f entries/s, %llu queued\n",
+                     command, static_cast<unsigned long long>(snapshot.entries),
+                     static_cast<unsigned long long>(snapshot.directories),
+                     static_cast<unsigned long long>(snapshot.matches), snapshot.entriesPerSecond(),
+                     static_cast<unsigned long long>(snapshot.queueDepth));
+    }
+    ffe::TraceMetrics(snapshot);
+}
+
+// Waits for a walk, dumping live metrics meanwhile when asked to
+ffe::WalkStats WaitForWalk(const ffe::TreeWalk& walk, const char* command, const ffe::Metrics& metrics,
+                           const Options& options) {
+    if (options.metricsInterval.count() > 0) {
+        const auto completion = walk.completion();
+        while (completion.wait_for(options.metricsInterval) != std::future_status::ready) {
+            DumpMetrics(command, metrics, options);
+        }
+    }
+    return walk.wait();
+}
+
+// Keeps search workers from running ahead of stdout: every published
+// result counts as unwritten until the writer has written it, and workers
+// wait while too many are
+class Backpressure {
+public:
+    explicit Backpressure(std::size_t limit) : limit(limit) {}
+
+    // Worker side, before publishing count results
+    void produced(std::size_t count) {
+        unwritten.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    // Worker side, after publishing
+    void waitForRoom() {
+        std::size_t current = unwritten.load(std::memory_order_acquire);
+        while (current > limit && !stopped.load(std::memory_order_relaxed)) {
+            unwritten.wait(current, std::memory_order_acquire);
+            current = unwritten.load(std::memory_order_acquire);
+        }
+    }
+
+    // Writer side
+    void written(std::size_t count) {
+        unwritten.fetch_sub(count, std::memory_order_release);
+        unwritten.notify_all();
+    }
+
+    // Releases every waiting worker for good, when output has failed
+    void stop() {
+        stopped.store(true, std::memory_order_relaxed);
+        unwritten.store(0, std::memory_order_release); // Waiters only wake on a change
+        unwritten.notify_all();
+    }
+
+private:
+    std::size_t limit;
+    std::atomic<std::size_t> unwritten{0};
+    std::atomic<bool> stopped{false};
+};
+
+int List(const fs::path& dir, const Options& options) {
+    ffe::TraceSpan span("List");
+    const auto start = std::chrono::steady_clock::now();
+    RunStats stats;
+
+    ffe::ListingCache::Fetched fetched;
+    std::error_code ec;
+    ffe::ListingCache::Fetch(dir, fetched, ec);
+    if (ec) {
+        std::fprintf(stderr, "ffe-cli: %s: %s\n", dir.string().c_str(), ec.message().c_str());
+        stats.errors++;
+    }
+
+    // Rows go through the window's model and sorter, so the order matches
+    ffe::EntryModel model;
+    const auto folder = model.addDirectory(dir);
+    for (const auto& entry : *fetched.entries) {
+        model.append(folder, entry);
+    }
+    if (options.sorted) {
+        ffe::Executor executor(options.threads);
+        ffe::RowSorter sorter(&executor);
+        sorter.sort(model, options.order);
+    }
+
+    RecordWriter writer(stdout, options.format);
+    ffe::DirEntry entry;
+    for (std::size_t index = 0; index < model.size() && !writer.failed(); ++index) {
+        const auto row = model.row(index);
+        entry.name.assign(row.name);
+        entry.type = row.type;
+        entry.hasStat = row.hasStat;
+        entry.size = row.size;
+        entry.mtime = row.mtime;
+        if (index == 0) {
+            stats.firstResult = std::chrono::steady_clock::now() - start;
+        }
+        writer.entry(dir / entry.name, entry);
+    }
+    writer.flush();
+
+    stats.results = stats.entries = model.size();
+    stats.directories = 1;
+    stats.elapsed = std::chrono::steady_clock::now() - start;
+    PrintStats("list", stats, options);
+    return stats.errors == 0 && !writer.failed() ? 0 : 1;
+}
+
+struct RankedHit {
+    std::int32_t score;
+    fs::path path;
+
+    bool operator<(const RankedHit& other) const {
+        if (score != other.score) {
+            return score < other.score;
+        }
+        return path.native().size() > other.path.native().size();
+    }
+};
+
+struct WorkerHits {
+    std::mutex mutex;
+    ffe::TopK<RankedHit> hits{MaxRankedResults};
+};
+
+// Fuzzy queries: each worker keeps its best hits, merged and written once
+// the walk is done
+int SearchRanked(const fs::path& root, const ffe::NameQuery& query, const Options& options) {
+    ffe::TraceSpan span("SearchRanked");
+    const auto start = std::chrono::steady_clock::now();
+    ffe::Executor executor(options.threads);
+    std::vector<WorkerHits> workers(executor.threadCount());
+    ffe::Metrics metrics;
+    metrics.start();
+
+    ffe::TreeWalker walker(executor);
+    const auto walk = walker.walk(root, [&](const ffe::WalkDirectory& dir) {
+        WorkerHits& worker = workers[std::min(dir.worker, workers.size() - 1)];
+        metrics.directories.add();
+        metrics.entries.add(dir.entries.size());
+        for (const auto& entry : dir.entries) {
+            if (!entry.isFile()) {
+                continue;
+            }
+            const auto score = query.fuzzyMatcher().score(entry.name, dir.depth);
+            if (!score) {
+                continue;
+            }
+            metrics.matches.add();
+            metrics.resultFound();
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            if (!worker.hits.full() || *score > worker.hits.worst().score) {
+                worker.hits.push({*score, dir.path / entry.name});
+            }
+        }
+    });
+    metrics.setQueueDepth([walk] { return walk.progress().pending; });
+    const auto walkStats = WaitForWalk(walk, "search", metrics, options);
+
+    ffe::TopK<RankedHit> merged(MaxRankedResults);
+    for (auto& worker : workers) {
+        merged.merge(worker.hits);
+    }
+    RecordWriter writer(stdout, options.format);
+    const auto best = merged.sorted();
+    for (const auto& hit : best) {
+        writer.rankedHit(hit.path, hit.score);
+    }
+    writer.flush();
+
+    RunStats stats;
+    stats.results = best.size();
+    stats.entries = walkStats.entries;
+    stats.directories = walkStats.directories;
+    stats.errors = walkStats.errors;
+    stats.elapsed = std::chrono::steady_clock::now() - start;
+    stats.firstResult = best.empty() ? std::chrono::steady_clock::duration{} : stats.elapsed;
+    PrintStats("search", stats, options);
+    if (options.stats) {
+        std::fprintf(stderr, "search: %llu names matched, best %zu kept\n",
+                     static_cast<unsigned long long>(metrics.matches.value()), best.size());
+    }
+    return writer.failed() ? 1 : 0;
+}
+
+int Search(const fs::path& root, const std::string& text, const Options& options) {
+    ffe::NameQuery query;
+    std::string error;
+    if (!query.parse(fs::path(text).native(), error)) {
+        std::fprintf(stderr, "ffe-cli: invalid query: %s\n", error.c_str());
+        return 2;
+    }
+    if (query.isRanked()) {
+        return SearchRanked(root, query, options);
+    }
+
+    ffe::TraceSpan span("Search");
+    const auto start = std::chrono::steady_clock::now();
+    RunStats stats;
+
+    // Workers publish each directory's hits; this thread writes them out
+    std::mutex readyMutex;
+    std::condition_variable readyCondition;
+    bool ready = false;
+    ffe::ResultChannel<fs::path> channel([&] {
+        std::lock_guard<std::mutex> lock(readyMutex);
+        ready = true;
+        readyCondition.notify_one();
+    });
+    Backpressure backpressure(MaxUnwrittenResults);
+
+    ffe::Metrics metrics;
+    metrics.start();
+
+    ffe::Executor executor(options.threads);
+    ffe::TreeWalker walker(executor);
+    auto walk = walker.walk(root, [&](const ffe::WalkDirectory& dir) {
+        std::vector<fs::path> hits;
+        for (const auto& entry : dir.entries) {
+            if (entry.isFile() && query.matches(entry.name)) {
+                hits.push_back(dir.path / entry.name);
+            }
+        }
+        metrics.directories.add();
+        metrics.entries.add(dir.entries.size());
+        if (!hits.empty()) {
+            metrics.matches.add(hits.size());
+            metrics.resultFound();
+            backpressure.produced(hits.size());
+            channel.publish(std::move(hits));
+            backpressure.waitForRoom();
+        }
+    });
+
+    metrics.setQueueDepth([walk] { return walk.progress().pending; });
+
+    RecordWriter writer(stdout, options.format);
+    std::vector<fs::path> pending;
+    ffe::DirEntry hit;
+    hit.type = ffe::EntryType::File;
+    auto nextDump = start + options.metricsInterval;
+    while (true) {
+        if (options.metricsInterval.count() > 0 && std::chrono::steady_clock::now() >= nextDump) {
+            DumpMetrics("search", metrics, options);
+            nextDump += options.metricsInterval;
+        }
+        // Read done() first: whatever was published before the walk ended is
+        // then certain to be drained below
+        const bool finished = walk.done();
+        pending.clear();
+        channel.drain(pending);
+        if (!pending.empty() && stats.results == 0) {
+            stats.firstResult = std::chrono::steady_clock::now() - start;
+        }
+        for (const auto& path : pending) {
+            writer.entry(path, hit);
+        }
+        if (!pending.empty()) {
+            stats.results += pending.size();
+            writer.flush();
+            backpressure.written(pending.size());
+        }
+        if (writer.failed()) {
+            // Nobody reads the output any more (a closed pipe); stop the walk
+            walk.cancel();
+            backpressure.stop();
+            break;
+        }
+        if (finished && channel.empty()) {
+            break;
+        }
+        std::unique_lock<std::mutex> lock(readyMutex);
+        readyCondition.wait_for(lock, 20ms, [&] { return ready; });
+        ready = false;
+    }
+    const auto walkStats = walk.wait();
+
+    stats.entries = walkStats.entries;
+    stats.directories = walkStats.directories;
+    stats.errors = walkStats.errors;
+    stats.elapsed = std::chrono::steady_clock::now() - start;
+    PrintStats("search", stats, options);
+    return writer.failed() ? 1 : 0;
+}
+
+// A hit of grep, with the file it is in
+struct ContentMatch {
+    fs::path path;
+    ffe::ContentHit hit;
+};
+
+// Lines holding text in the files below root. Workers search the files of
+// the directories they visit and publish each file's hits; this thread
+// writes them out, as search does with names.
+int Grep(const fs::path& root, const std::string& text, const Options& options) {
+    ffe::TraceSpan span("Grep");
+    const auto start = std::chrono::steady_clock::now();
+    RunStats stats;
+
+    std::mutex readyMutex;
+    std::condition_variable readyCondition;
+    bool ready = false;
+    ffe::ResultChannel<ContentMatch> channel([&] {
+        std::lock_guard<std::mutex> lock(readyMutex);
+        ready = true;
+        readyCondition.notify_one();
+    });
+    Backpressure backpressure(MaxUnwrittenResults);
+
+    ffe::Metrics metrics;
+    metrics.start();
+    ffe::ShardedCounter binary;
+    ffe::ShardedCounter tooLarge;
+    ffe::ShardedCounter failed;
+
+    const ffe::ContentSearcher searcher(text, options.content);
+    ffe::Executor executor(options.threads);
+    ffe::TreeWalker walker(executor);
+    auto walk = walker.walk(root, [&](const ffe::WalkDirectory& dir) {
+        metrics.directories.add();
+        for (const auto& entry : dir.entries) {
+            if (!entry.isFile()) {
+                continue;
+            }
+            metrics.entries.add();
+            std::vector<ContentMatch> hits;
+            const fs::path path = dir.path / entry.name;
+            const ffe::ContentScan scan = searcher.searchFile(path, [&](const ffe::ContentHit& hit) {
+                hits.push_back({path, hit});
+                return true;
+            });
+            metrics.bytes.add(scan.bytes);
+            switch (scan.outcome) {
+            case ffe::ContentOutcome::Binary:
+                binary.add();
+                break;
+            case ffe::ContentOutcome::TooLarge:
+                tooLarge.add();
+                break;
+            case ffe::ContentOutcome::Failed:
+                failed.add();
+                break;
+            case ffe::ContentOutcome::Searched:
+                break;
+            }
+            if (!hits.empty()) {
+                metrics.matches.add(hits.size());
+                metrics.resultFound();
+                backpressure.produced(hits.size());
+                channel.publish(std::move(hits));
+                backpressure.waitForRoom();
+            }
+        }
+    });
+
+    metrics.setQueueDepth([walk] { return walk.progress().pending; });
+
+    RecordWriter writer(stdout, options.format);
+    std::vector<ContentMatch> pending;
+    auto nextDump = start + options.metricsInterval;
+    while (true) {
+        if (options.metricsInterval.count() > 0 && std::chrono::steady_clock::now() >= nextDump) {
+            DumpMetrics("grep", metrics, options);
+            nextDump += options.metricsInterval;
+        }
+        const bool finished = walk.done();
+        pending.clear();
+        channel.drain(pending);
+        if (!pending.empty() && stats.results == 0) {
+            stats.firstResult = std::chrono::steady_clock::now() - start;
+        }
+        for (const auto& match : pending) {
+            writer.contentHit(match.path, match.hit);
+        }
+        if (!pending.empty()) {
+            stats.results += pending.size();
+            writer.flush();
+            backpressure.written(pending.size());
+        }
+        if (writer.failed()) {
+            walk.cancel();
+            backpressure.stop();
+            break;
+        }
+        if (finished && channel.empty()) {
+            break;
+        }
+        std::unique_lock<std::mutex> lock(readyMutex);
+        readyCondition.wait_for(lock, 20ms, [&] { return ready; });
+        ready = false;
+    }
+    const auto walkStats = walk.wait();
+
+    stats.entries = walkStats.entries;
+    stats.directories = walkStats.directories;
+    stats.errors = walkStats.errors + failed.value();
+    stats.elapsed = std::chrono::steady_clock::now() - start;
+    PrintStats("grep", stats, options);
+    if (options.stats) {
+        const double seconds = std::chrono::duration<double>(stats.elapsed).count();
+        const std::uint64_t bytes = metrics.bytes.value();
+        std::fprintf(stderr, "grep: %llu bytes read, %.2f GB/s; skipped %llu binary and %llu too large files\n",
+                     static_cast<unsigned long long>(bytes), seconds > 0 ? bytes / seconds / 1e9 : 0.0,
+                     static_cast<unsigned long long>(binary.value()),
+                     static_cast<unsigned long long>(tooLarge.value()));
+    }
+    return writer.failed() ? 1 : 0;
+}
+
+// Groups of files with the same contents below root, written once every
+// stage has finished and sorted by the space they waste
+int Dupes(const fs::path& root, const Options& options) {
+    ffe::TraceSpan span("Dupes");
+    const auto start = std::chrono::steady_clock::now();
+    ffe::Executor executor(options.threads);
+    ffe::DuplicateFinder finder(executor, options.duplicates);
+    const ffe::DuplicateReport report = finder.find(root);
+
+    RecordWriter writer(stdout, options.format);
+    std::uint64_t duplicates = 0;
+    for (const auto& group : report.groups) {
+        if (writer.failed()) {
+            break;
+        }
+        writer.duplicateGroup(group);
+        duplicates += group.copies.size() - 1;
+    }
+    writer.flush();
+
+    RunStats stats;
+    stats.results = report.groups.size();
+    stats.entries = report.stats.files;
+    stats.directories = report.stats.directories;
+    stats.errors = report.stats.errors;
+    stats.elapsed = std::chrono::steady_clock::now() - start;
+    stats.firstResult = stats.elapsed;
+    PrintStats("dupes", stats, options);
+    if (options.stats) {
+        const double seconds = std::chrono::duration<double>(stats.elapsed).count();
+        const ffe::DuplicateStats& found = report.stats;
+        std::fprintf(stderr,
+                     "dupes: %llu duplicate files, %llu bytes reclaimable; hashed the ends of %llu and all of %llu "
+                     "files, %llu bytes read, %.2f GB/s; %llu hard links\n",
+                     static_cast<unsigned long long>(duplicates), static_cast<unsigned long long>(report.reclaimable),
+                     static_cast<unsigned long long>(found.partialHashes),
+                     static_cast<unsigned long long>(found.fullHashes), static_cast<unsigned long long>(found.bytesRead),
+                     seconds > 0 ? found.bytesRead / seconds / 1e9 : 0.0,
+                     static_cast<unsigned long long>(found.hardLinks));
+    }
+    return writer.failed() ? 1 : 0;
+}
+
+// Bytes below root, per child folder as each one finishes, then in total.
+// The total is measured after the children, so it reuses what they read
+// and only reads root itself.
+int Size(const fs::path& root, const Options& options) {
+    ffe::TraceSpan span("Size");
+    const auto start = std::chrono::steady_clock::now();
+    RunStats stats;
+
+    std::mutex readyMutex;
+    std::condition_variable readyCondition;
+    bool ready = false;
+    ffe::Executor executor(options.threads);
+    ffe::FolderSizer sizer(executor, [&] {
+        std::lock_guard<std::mutex> lock(readyMutex);
+        ready = true;
+        readyCondition.notify_one();
+    });
+
+    std::vector<ffe::DirEntry> entries;
+    std::error_code ec;
+    if (!ffe::ReadDirectory(root, entries, ec)) {
+        std::fprintf(stderr, "ffe-cli: %s: %s\n", root.string().c_str(), ec.message().c_str());
+        return 1;
+    }
+    std::vector<fs::path> children;
+    std::vector<ffe::FolderSizeRequest> requests;
+    for (const auto& entry : entries) {
+        if (entry.isDirectory()) {
+            requests.push_back({static_cast<std::uint32_t>(children.size()), root / entry.name});
+            children.push_back(root / entry.name);
+        }
+    }
+    sizer.measure(std::move(requests));
+
+    RecordWriter writer(stdout, options.format);
+    std::vector<ffe::FolderSizeResult> results;
+    while (stats.results < children.size() && !writer.failed()) {
+        results.clear();
+        sizer.drain(results);
+        if (!results.empty() && stats.results == 0) {
+            stats.firstResult = std::chrono::steady_clock::now() - start;
+        }
+        for (const auto& result : results) {
+            writer.size(children[result.id], result.size, options.allocated);
+        }
+        if (!results.empty()) {
+            stats.results += results.size();
+            writer.flush();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(readyMutex);
+        readyCondition.wait_for(lock, 20ms, [&] { return ready; });
+        ready = false;
+    }
+    if (writer.failed()) {
+        sizer.cancel();
+        return 1;
+    }
+
+    sizer.measure({{0, root}});
+    sizer.wait();
+    results.clear();
+    sizer.drain(results);
+    ffe::FolderSize total;
+    if (!results.empty()) {
+        total = results.front().size;
+        writer.size(root, total, options.allocated);
+        stats.results++;
+    }
+    writer.flush();
+
+    const ffe::FolderSizer::Stats sizerStats = sizer.stats();
+    stats.entries = total.files + total.directories;
+    stats.directories = total.directories + 1;
+    stats.errors = total.errors;
+    stats.elapsed = std::chrono::steady_clock::now() - start;
+    if (stats.firstResult == std::chrono::steady_clock::duration{}) {
+        stats.firstResult = stats.elapsed;
+    }
+    PrintStats("size", stats, options);
+    if (options.stats) {
+        std::fprintf(stderr, "size: %llu bytes allocated; %llu folders read, %llu reused, %llu subtrees reused\n",
+                     static_cast<unsigned long long>(total.allocated),
+                     static_cast<unsigned long long>(sizerStats.listingsRead),
+                     static_cast<unsigned long long>(sizerStats.listingsReused),
+                     static_cast<unsigned long long>(sizerStats.subtreesReused));
+    }
+    return writer.failed() ? 1 : 0;
+}
+
+// The largest folders and files below root and the space per extension,
+// written once the walk is done. Live metrics show the totals so far.
+int Space(const fs::path& root, const Options& options) {
+    ffe::TraceSpan span("Space");
+    const auto start = std::chrono::steady_clock::now();
+    ffe::Executor executor(options.threads);
+    ffe::SpaceAnalyzer analyzer(executor, options.space);
+    analyzer.scan({root});
+    if (options.metricsInterval.count() > 0) {
+        for (ffe::SpaceReport progress = analyzer.snapshot(); !progress.done; progress = analyzer.snapshot()) {
+            std::fprintf(stderr, "space: %llu bytes in %llu files and %llu folders, %llu folders pending\n",
+                         static_cast<unsigned long long>(progress.total.bytes),
+                         static_cast<unsigned long long>(progress.total.files),
+                         static_cast<unsigned long long>(progress.total.directories),
+                         static_cast<unsigned long long>(progress.pendingFolders));
+            std::this_thread::sleep_for(options.metricsInterval);
+        }
+    }
+    analyzer.wait();
+    const ffe::SpaceReport report = analyzer.snapshot();
+
+    RecordWriter writer(stdout, options.format);
+    for (const auto& folder : report.folders) {
+        writer.spaceItem("folder", folder, options.allocated);
+    }
+    for (const auto& file : report.files) {
+        writer.spaceItem("file", file, options.allocated);
+    }
+    const std::size_t extensions = std::min(report.extensions.size(), options.space.topFiles);
+    for (std::size_t index = 0; index < extensions; ++index) {
+        writer.extensionSpace(report.extensions[index], options.allocated);
+    }
+    writer.flush();
+
+    RunStats stats;
+    stats.results = report.folders.size() + report.files.size() + extensions;
+    stats.entries = report.total.files + report.total.directories;
+    stats.directories = report.total.directories + 1;
+    stats.errors = report.total.errors;
+    stats.elapsed = std::chrono::steady_clock::now() - start;
+    stats.firstResult = stats.elapsed;
+    PrintStats("space", stats, options);
+    if (options.stats) {
+        std::fprintf(stderr, "space: %llu bytes, %llu allocated; at most %llu folders pending at once\n",
+                     static_cast<unsigned long long>(report.total.bytes),
+                     static_cast<unsigned long long>(report.total.allocated),
+                     static_cast<unsigned long long>(report.peakPendingFolders));
+    }
+    return writer.failed() ? 1 : 0;
+}
+
+void PrintUsage() {
+    std::printf("Usage: ffe-cli [options] <command> [arguments]\n\n");
+    std::printf("Commands:\n");
+    std::printf("  list <dir>              Entries of a folder\n");
+    std::printf("  search <root> <query>   Files below root whose names match query; same syntax as\n");
+    std::printf("                          the search box (substring, *?[ glob, re: regex, ~ fuzzy)\n");
+    std::printf("  grep <root> <text>      Lines holding text in the files below root, as path:line:column:text\n");
+    std::printf("  dupes <root>            Files below root with the same contents, a blank line after\n");
+    std::printf("                          each group; hard links count as one file\n");
+    std::printf("  size <dir>              Bytes below dir, per child folder as each finishes and then in\n");
+    std::printf("                          total; hard links count once\n");
+    std::printf("  space <dir>             Largest folders and files below dir, and bytes per extension,\n");
+    std::printf("                          as kind, bytes and path\n\n");
+    std::printf("Options:\n");
+    std::printf("  --format text|ndjson    Paths one per line (default), or one JSON object per line\n");
+    std::printf("  --threads N             Worker threads (default: one per core)\n");
+    std::printf("  --sort name|type|size|modified   Order of list output, folders first\n");
+    std::printf("  --reverse               Sort descending\n");
+    std::printf("  --match-case            grep compares letters as typed rather than ignoring case\n");
+    std::printf("  --max-filesize BYTES    grep skips larger files (default 256 MiB)\n");
+    std::printf("  --min-size BYTES        dupes ignores smaller files (default 1)\n");
+    std::printf("  --allocated             size and space print bytes allocated on disk rather than apparent\n");
+    std::printf("                          bytes\n");
+    std::printf("  --top N                 space lists N folders, files and extensions (default 20)\n");
+    std::printf("  --quiet                 No timing stats on stderr\n");
+    std::printf("  --metrics MS            Live counters and rates on stderr every MS milliseconds\n");
+    std::printf("  --trace FILE            Write a Chrome trace of the run to FILE (chrome://tracing, Perfetto)\n");
+}
+
+bool ParseSortColumn(const char* text, ffe::SortColumn& column) {
+    static constexpr std::pair<const char*, ffe::SortColumn> Columns[] = {
+        {"name", ffe::SortColumn::Name},
+        {"type", ffe::SortColumn::Type},
+        {"size", ffe::SortColumn::Size},
+        {"modified", ffe::SortColumn::Modified},
+    };
+    for (const auto& [name, value] : Columns) {
+        if (std::strcmp(text, name) == 0) {
+            column = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    bool reverse = false;
+    fs::path traceFile;
+    std::vector<std::string> arguments;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (std::strcmp(arg, "--format") == 0 && i + 1 < argc) {
+            const char* format = argv[++i];
+            if (std::strcmp(format, "ndjson") == 0) {
+                options.format = OutputFormat::Ndjson;
+            } else if (std::strcmp(format, "text") != 0) {
+                std::fprintf(stderr, "ffe-cli: unknown format %s\n", format);
+                return 2;
+            }
+        } else if (std::strcmp(arg, "--threads") == 0 && i + 1 < argc) {
+            options.threads = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--sort") == 0 && i + 1 < argc) {
+            ffe::SortColumn column;
+            if (!ParseSortColumn(argv[++i], column)) {
+                std::fprintf(stderr, "ffe-cli: unknown sort column %s\n", argv[i]);
+                return 2;
+            }
+            options.order.keys = {{column, false}};
+            options.sorted = true;
+        } else if (std::strcmp(arg, "--reverse") == 0) {
+            reverse = true;
+            options.sorted = true;
+        } else if (std::strcmp(arg, "--match-case") == 0) {
+            options.content.ignoreCase = false;
+        } else if (std::strcmp(arg, "--max-filesize") == 0 && i + 1 < argc) {
+            options.content.maxFileSize = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(arg, "--min-size") == 0 && i + 1 < argc) {
+            options.duplicates.minSize = std::max<std::uint64_t>(1, std::strtoull(argv[++i], nullptr, 10));
+        } else if (std::strcmp(arg, "--allocated") == 0) {
+            options.allocated = true;
+        } else if (std::strcmp(arg, "--top") == 0 && i + 1 < argc) {
+            const auto top = static_cast<std::size_t>(std::max(1, std::atoi(argv[++i])));
+            options.space.topFiles = options.space.topFolders = top;
+        } else if (std::strcmp(arg, "--quiet") == 0) {
+            options.stats = false;
+        } else if (std::strcmp(arg, "--metrics") == 0 && i + 1 < argc) {
+            options.metricsInterval = std::chrono::milliseconds(std::max(1, std::atoi(argv[++i])));
+        } else if (std::strcmp(arg, "--trace") == 0 && i + 1 < argc) {
+            traceFile = argv[++i];
+        } else if (std::strcmp(arg, "--help") == 0) {
+            PrintUsage();
+            return 0;
+        } else {
+            arguments.emplace_back(arg);
+        }
+    }
+    if (reverse) {
+        options.order = options.order.reversed();
+    }
+
+    if (!traceFile.empty()) {
+        ffe::Trace::SetThreadName("main");
+        ffe::Trace::Enable(true);
+    }
+
+    const std::string command = arguments.empty() ? std::string() : arguments[0];
+    int status = 2;
+    if (command == "list" && arguments.size() == 2) {
+        status = List(arguments[1], options);
+    } else if (command == "search" && arguments.size() == 3) {
+        status = Search(arguments[1], arguments[2], options);
+    } else if (command == "grep" && arguments.size() == 3) {
+        status = Grep(arguments[1], arguments[2], options);
+    } else if (command == "dupes" && arguments.size() == 2) {
+        status = Dupes(arguments[1], options);
+    } else if (command == "size" && arguments.size() == 2) {
+        status = Size(arguments[1], options);
+    } else if (command == "space" && arguments.size() == 2) {
+        status = Space(arguments[1], options);
+    } else {
+        PrintUsage();
+    }
+
+    std::error_code ec;
+    if (!traceFile.empty() && !ffe::Trace::WriteChromeJson(traceFile, ec)) {
+        std::fprintf(stderr, "ffe-cli: %s: %s\n", traceFile.string().c_str(), ec.message().c_str());
+        return 1;
+    }
+    return status;
+}
@@ -0,0 +1,291 @@
+#include "cli/Output.hpp"
+
+#include "engine/Trace.hpp"
+#include "engine/Unicode.hpp"
+
+#include <charconv>
+
+namespace ffe::cli {
+
+namespace {
+
+// Records are written out in blocks of about this size
+constexpr std::size_t FlushBytes = 64 * 1024;
+
+void AppendNumber(std::string& out, std::int64_t value) {
+    char digits[24];
+    const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, result.ptr);
+}
+
+void AppendCodePoint(char32_t c, std::string& out) {
+    if (c < 0x80) {
+        out += static_cast<char>(c);
+    } else if (c < 0x800) {
+        out += static_cast<char>(0xC0 | (c >> 6));
+        out += static_cast<char>(0x80 | (c & 0x3F));
+    } else if (c < 0x10000) {
+        out += static_cast<char>(0xE0 | (c >> 12));
+        out += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (c & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (c >> 18));
+        out += static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (c & 0x3F));
+    }
+}
+
+void AppendEscape(std::string& out, char32_t unit) {
+    static constexpr char Hex[] = "0123456789abcdef";
+    out += "\\u";
+    for (int shift = 12; shift >= 0; shift -= 4) {
+        out += Hex[(unit >> shift) & 0xF];
+    }
+}
+
+// Appends text that is UTF-8 already as a JSON string's contents. Bytes of
+// invalid sequences are copied as they are.
+void AppendJsonBytes(std::string_view text, std::string& out) {
+    for (const char c : text) {
+        if (static_cast<unsigned char>(c) < 0x20) {
+            AppendEscape(out, static_cast<unsigned char>(c));
+        } else if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else {
+            out += c;
+        }
+    }
+}
+
+} // namespace
+
+void AppendUtf8(NameView name, std::string& out, bool json) {
+#if !defined(_WIN32)
+    if (!json) {
+        out.append(name); // Already the bytes the user's tools expect
+        return;
+    }
+#endif
+    std::size_t i = 0;
+    while (i < name.size()) {
+        const char32_t c = DecodeNext(name, i);
+        const bool surrogate = c >= 0xD800 && c <= 0xDFFF;
+        if (json && (c < 0x20 || surrogate)) {
+            AppendEscape(out, c);
+        } else if (json && (c == '"' || c == '\\')) {
+            out += '\\';
+            out += static_cast<char>(c);
+        } else {
+            AppendCodePoint(c, out);
+        }
+    }
+}
+
+const char* EntryTypeName(EntryType type) noexcept {
+    switch (type) {
+    case EntryType::File:
+        return "file";
+    case EntryType::Directory:
+        return "directory";
+    case EntryType::Symlink:
+        return "symlink";
+    case EntryType::Other:
+        return "other";
+    case EntryType::Unknown:
+        break;
+    }
+    return "unknown";
+}
+
+void RecordWriter::entry(const fs::path& path, const DirEntry& entry) {
+    beginRecord(path);
+    if (format == OutputFormat::Ndjson) {
+        buffer += ",\"type\":\"";
+        buffer += EntryTypeName(entry.type);
+        buffer += '"';
+        if (entry.hasStat) {
+            if (entry.isFile()) {
+                buffer += ",\"size\":";
+                AppendNumber(buffer, static_cast<std::int64_t>(entry.size));
+            }
+            buffer += ",\"mtime\":";
+            AppendNumber(buffer, entry.mtime);
+        }
+    }
+    endRecord();
+}
+
+void RecordWriter::rankedHit(const fs::path& path, std::int32_t score) {
+    beginRecord(path);
+    if (format == OutputFormat::Ndjson) {
+        buffer += ",\"score\":";
+        AppendNumber(buffer, score);
+    }
+    endRecord();
+}
+
+void RecordWriter::contentHit(const fs::path& path, const ContentHit& hit) {
+    beginRecord(path);
+    if (format == OutputFormat::Ndjson) {
+        buffer += ",\"line\":";
+        AppendNumber(buffer, static_cast<std::int64_t>(hit.line));
+        buffer += ",\"column\":";
+        AppendNumber(buffer, hit.column);
+        buffer += ",\"offset\":";
+        AppendNumber(buffer, static_cast<std::int64_t>(hit.offset));
+        buffer += ",\"text\":\"";
+        AppendJsonBytes(hit.text, buffer);
+        buffer += '"';
+    } else {
+        // path:line:column:text, as editors read grep output
+        buffer += ':';
+        AppendNumber(buffer, static_cast<std::int64_t>(hit.line));
+        buffer += ':';
+        AppendNumber(buffer, hit.column);
+        buffer += ':';
+        buffer += hit.text;
+    }
+    endRecord();
+}
+
+void RecordWriter::duplicateGroup(const DuplicateGroup& group) {
+    if (format == OutputFormat::Text) {
+        for (const auto& copy : group.copies) {
+            for (const auto& path : copy.paths) {
+                AppendUtf8(path.native(), buffer, false);
+                buffer += '\n';
+            }
+        }
+        endRecord();
+        return;
+    }
+    // The hash is a hex string: JSON numbers lose bits past 2^53
+    char hash[17];
+    std::snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(group.hash));
+    buffer += "{\"size\":";
+    AppendNumber(buffer, static_cast<std::int64_t>(group.size));
+    buffer += ",\"hash\":\"";
+    buffer += hash;
+    buffer += "\",\"reclaimable\":";
+    AppendNumber(buffer, static_cast<std::int64_t>(group.reclaimable()));
+    buffer += ",\"copies\":[";
+    for (std::size_t i = 0; i < group.copies.size(); ++i) {
+        buffer += i == 0 ? "[" : ",[";
+        const auto& paths = group.copies[i].paths;
+        for (std::size_t j = 0; j < paths.size(); ++j) {
+            buffer += j == 0 ? "\"" : ",\"";
+            AppendUtf8(paths[j].native(), buffer, true);
+            buffer += '"';
+        }
+        buffer += ']';
+    }
+    buffer += ']';
+    endRecord();
+}
+
+void RecordWriter::size(const fs::path& path, const FolderSize& size, bool allocated) {
+    if (format == OutputFormat::Text) {
+        AppendNumber(buffer, static_cast<std::int64_t>(allocated ? size.allocated : size.bytes));
+        buffer += '\t';
+        AppendUtf8(path.native(), buffer, false);
+        endRecord();
+        return;
+    }
+    beginRecord(path);
+    buffer += ",\"bytes\":";
+    AppendNumber(buffer, static_cast<std::int64_t>(size.bytes));
+    buffer += ",\"allocated\":";
+    AppendNumber(buffer, static_cast<std::int64_t>(size.allocated));
+    buffer += ",\"files\":";
+    AppendNumber(buffer, static_cast<std::int64_t>(size.files));
+    buffer += ",\"directories\":";
+    AppendNumber(buffer, static_cast<std::int64_t>(size.directories));
+    buffer += ",\"errors\":";
+    AppendNumber(buffer, static_cast<std::int64_t>(size.errors));
+    endRecord();
+}
+
+void RecordWriter::spaceItem(const char* kind, const SpaceItem& item, bool allocated) {
+    if (format == OutputFormat::Text) {
+        buffer += kind;
+        buffer += '\t';
+        AppendNumber(buffer, static_cast<std::int64_t>(allocated ? item.allocated : item.bytes));
+        buffer += '\t';
+        AppendUtf8(item.path.native(), buffer, false);
+        endRecord();
+        return;
+    }
+    beginRecord(item.path);
+    buffer += ",\"kind\":\"";
+    buffer += kind;
+    buffer += "\",\"bytes\":";
+    AppendNumber(buffer, static_cast<std::int64_t>(item.bytes));
+    buffer += ",\"allocated\":";
+    AppendNumber(buffer, static_cast<std::int64_t>(item.allocated));
+    buffer += ",\"files\":";
+    AppendNumber(buffer, static_cast<std::int64_t>(item.files));
+    endRecord();
+}
+
+void RecordWriter::extensionSpace(const ExtensionSpace& extension, bool allocated) {
+    if (format == OutputFormat::Text) {
+        buffer += "extension\t";
+        AppendNumber(buffer, static_cast<std::int64_t>(allocated ? extension.allocated : extension.bytes));
+        buffer += '\t';
+        if (extension.other) {
+            buffer += "(other)";
+        } else if (extension.extension.empty()) {
+            buffer += "(none)";
+        } else {
+            buffer += '.';
+            AppendUtf8(extension.extension, buffer, false);
+        }
+        endRecord();
+        return;
+    }
+    buffer += "{\"extension\":\"";
+    AppendUtf8(extension.extension, buffer, true);
+    buffer += "\",\"other\":";
+    buffer += extension.other ? "true" : "false";
+    buffer += ",\"bytes\":";
+    AppendNumber(buffer, static_cast<std::int64_t>(extension.bytes));
+    buffer += ",\"allocated\":";
+    AppendNumber(buffer, static_cast<std::int64_t>(extension.allocated));
+    buffer += ",\"files\":";
+    AppendNumber(buffer, static_cast<std::int64_t>(extension.files));
+    endRecord();
+}
+
+bool RecordWriter::flush() {
+    if (!buffer.empty() && !broken) {
+        TraceSpan span("RecordWriter::flush");
+        span.arg("bytes", static_cast<std::int64_t>(buffer.size()));
+        broken = std::fwrite(buffer.data(), 1, buffer.size(), stream) != buffer.size() || std::fflush(stream) != 0;
+    }
+    buffer.clear();
+    return !broken;
+}
+
+void RecordWriter::beginRecord(const fs::path& path) {
+    if (format == OutputFormat::Ndjson) {
+        buffer += "{\"path\":\"";
+        AppendUtf8(path.native(), buffer, true);
+        buffer += '"';
+    } else {
+        AppendUtf8(path.native(), buffer, false);
+    }
+}
+
+void RecordWriter::endRecord() {
+    if (format == OutputFormat::Ndjson) {
+        buffer += '}';
+    }
+    buffer += '\n';
+    if (buffer.size() >= FlushBytes) {
+        flush();
+    }
+}
+
+} // namespace ffe::cli
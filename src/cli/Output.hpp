@@ -0,0 +1,83 @@
+#pragma once
+
+#include "engine/ContentSearch.hpp"
+#include "engine/DirEntry.hpp"
+#include "engine/DuplicateFinder.hpp"
+#include "engine/FolderSizer.hpp"
+#include "engine/SpaceAnalyzer.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace ffe::cli {
+
+enum class OutputFormat {
+    Text,   // One path per line
+    Ndjson, // One JSON object per line
+};
+
+// Writes result records to a stream through a large buffer, in UTF-8
+// whatever the native encoding. Names that are not valid UTF-8 (Linux) or
+// UTF-16 (Windows) keep their undecodable units as lone surrogates: escaped
+// as \udcXX in JSON, like Python's surrogateescape, and as the raw bytes in
+// text on Linux, so a path printed as text can be passed back in.
+class RecordWriter {
+public:
+    RecordWriter(std::FILE* stream, OutputFormat format) : stream(stream), format(format) {}
+
+    ~RecordWriter() {
+        flush();
+    }
+
+    RecordWriter(const RecordWriter&) = delete;
+    RecordWriter& operator=(const RecordWriter&) = delete;
+
+    // An entry found at path: listings and search hits
+    void entry(const fs::path& path, const DirEntry& entry);
+
+    // A ranked search hit, best first
+    void rankedHit(const fs::path& path, std::int32_t score);
+
+    // A line of the file at path holding a match, for grep
+    void contentHit(const fs::path& path, const ContentHit& hit);
+
+    // Files with the same contents, for dupes: their paths one per line and
+    // a blank line after, as fdupes writes them, or one JSON object
+    void duplicateGroup(const DuplicateGroup& group);
+
+    // Bytes below path, for size: apparent or allocated ones in text, both
+    // in JSON
+    void size(const fs::path& path, const FolderSize& size, bool allocated = false);
+
+    // A largest file or folder, for space: its kind, size and path in
+    // text, as du prints them
+    void spaceItem(const char* kind, const SpaceItem& item, bool allocated = false);
+
+    // The files of one extension, for space
+    void extensionSpace(const ExtensionSpace& extension, bool allocated = false);
+
+    // Writes what is buffered; returns false once the stream failed (a
+    // closed pipe, say), so producers can stop
+    bool flush();
+
+    bool failed() const noexcept {
+        return broken;
+    }
+
+private:
+    void beginRecord(const fs::path& path);
+    void endRecord();
+
+    std::FILE* stream;
+    OutputFormat format;
+    std::string buffer;
+    bool broken = false;
+};
+
+// Appends name as UTF-8, escaped for a JSON string when json is set
+void AppendUtf8(NameView name, std::string& out, bool json);
+
+const char* EntryTypeName(EntryType type) noexcept;
+
+} // namespace ffe::cli
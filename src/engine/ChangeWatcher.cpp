@@ -0,0 +1,309 @@
+#include "engine/ChangeWatcher.hpp"
+
+#include "engine/DirectoryReader.hpp"
+
+#include <atomic>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <unordered_map>
+#endif
+
+namespace ffe {
+
+#ifdef _WIN32
+
+struct ChangeWatcher::Impl {
+    fs::path root;
+    Callback callback;
+    HANDLE directory = INVALID_HANDLE_VALUE;
+    HANDLE stopEvent = NULL;
+    std::thread thread;
+
+    // DWORD-aligned, as ReadDirectoryChangesW requires
+    alignas(DWORD) BYTE buffer[64 * 1024];
+
+    ~Impl() {
+        if (thread.joinable()) {
+            SetEvent(stopEvent);
+            thread.join();
+        }
+        if (directory != INVALID_HANDLE_VALUE) {
+            CloseHandle(directory);
+        }
+        if (stopEvent) {
+            CloseHandle(stopEvent);
+        }
+    }
+
+    void run() {
+        OVERLAPPED overlapped = {};
+        overlapped.hEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+        const DWORD filter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME |
+                             FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE;
+
+        while (true) {
+            ResetEvent(overlapped.hEvent);
+            if (!ReadDirectoryChangesW(directory, buffer, sizeof(buffer), TRUE, filter, NULL, &overlapped, NULL)) {
+                break;
+            }
+
+            HANDLE handles[] = {overlapped.hEvent, stopEvent};
+            if (WaitForMultipleObjects(2, handles, FALSE, INFINITE) != WAIT_OBJECT_0) {
+                CancelIoEx(directory, &overlapped);
+                DWORD ignored = 0;
+                GetOverlappedResult(directory, &overlapped, &ignored, TRUE);
+                break;
+            }
+
+            DWORD bytes = 0;
+            std::vector<ChangeEvent> events;
+            if (!GetOverlappedResult(directory, &overlapped, &bytes, FALSE) || bytes == 0) {
+                // ERROR_NOTIFY_ENUM_DIR or an empty result: the buffer overflowed
+                events.push_back({ChangeKind::Overflow, root});
+            } else {
+                for (DWORD offset = 0;;) {
+                    auto* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(buffer + offset);
+                    fs::path path = root / std::wstring_view(info->FileName, info->FileNameLength / sizeof(WCHAR));
+                    switch (info->Action) {
+                    case FILE_ACTION_ADDED:
+                    case FILE_ACTION_RENAMED_NEW_NAME:
+                        events.push_back({ChangeKind::Added, std::move(path)});
+                        break;
+                    case FILE_ACTION_REMOVED:
+                    case FILE_ACTION_RENAMED_OLD_NAME:
+                        events.push_back({ChangeKind::Removed, std::move(path)});
+                        break;
+                    default:
+                        events.push_back({ChangeKind::Modified, std::move(path)});
+                        break;
+                    }
+                    if (info->NextEntryOffset == 0) {
+                        break;
+                    }
+                    offset += info->NextEntryOffset;
+                }
+            }
+            callback(std::move(events));
+        }
+
+        CloseHandle(overlapped.hEvent);
+    }
+};
+
+bool ChangeWatcher::start(const fs::path& root, Callback callback, std::error_code& ec) {
+    stop();
+    ec.clear();
+
+    auto state = std::make_unique<Impl>();
+    state->root = root;
+    state->callback = std::move(callback);
+    state->directory = CreateFileW(root.c_str(), FILE_LIST_DIRECTORY,
+                                   FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING,
+                                   FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+    state->stopEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+    if (state->directory == INVALID_HANDLE_VALUE || !state->stopEvent) {
+        ec.assign(static_cast<int>(GetLastError()), std::system_category());
+        return false;
+    }
+
+    Impl* raw = state.get();
+    state->thread = std::thread([raw] { raw->run(); });
+    impl = std::move(state);
+    return true;
+}
+
+#else
+
+struct ChangeWatcher::Impl {
+    static constexpr std::uint32_t WatchMask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+                                               IN_CLOSE_WRITE | IN_ATTRIB | IN_ONLYDIR | IN_DONT_FOLLOW |
+                                               IN_EXCL_UNLINK;
+
+    fs::path root;
+    Callback callback;
+    int inotifyFd = -1;
+    int wakeFd = -1;
+    std::unordered_map<int, fs::path> watches;
+    std::thread thread;
+
+    ~Impl() {
+        if (thread.joinable()) {
+            const std::uint64_t one = 1;
+            [[maybe_unused]] auto written = ::write(wakeFd, &one, sizeof(one));
+            thread.join();
+        }
+        if (inotifyFd >= 0) {
+            ::close(inotifyFd);
+        }
+        if (wakeFd >= 0) {
+            ::close(wakeFd);
+        }
+    }
+
+    // Watches dir and every directory below it. Re-adding a watched inode
+    // returns its existing descriptor, which also refreshes the path of a
+    // directory that was moved.
+    void addWatches(const fs::path& dir) {
+        std::vector<fs::path> pending{dir};
+        std::vector<DirEntry> entries;
+        while (!pending.empty()) {
+            fs::path current = std::move(pending.back());
+            pending.pop_back();
+
+            const int wd = ::inotify_add_watch(inotifyFd, current.c_str(), WatchMask);
+            if (wd < 0) {
+                // Out of watches (ENOSPC) or the directory vanished: changes below go unnoticed
+                continue;
+            }
+            watches[wd] = current;
+
+            std::error_code ec;
+            ReadDirectory(current, entries, ec);
+            for (const DirEntry& entry : entries) {
+                if (entry.isDirectory()) {
+                    pending.push_back(current / entry.name);
+                }
+            }
+        }
+    }
+
+    // Stops watching dir and every directory below it, for a directory moved
+    // out of the root: its watches would report changes under paths that
+    // no longer exist
+    void removeWatches(const fs::path& dir) {
+        const fs::path::string_type& prefix = dir.native();
+        for (auto it = watches.begin(); it != watches.end();) {
+            const fs::path::string_type& path = it->second.native();
+            const bool below = path.compare(0, prefix.size(), prefix) == 0 &&
+                               (path.size() == prefix.size() || path[prefix.size()] == '/');
+            if (below) {
+                ::inotify_rm_watch(inotifyFd, it->first);
+                it = watches.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    void run() {
+        alignas(inotify_event) char buffer[64 * 1024];
+        pollfd fds[2] = {{inotifyFd, POLLIN, 0}, {wakeFd, POLLIN, 0}};
+
+        while (true) {
+            if (::poll(fds, 2, -1) < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                break;
+            }
+            if (fds[1].revents & POLLIN) {
+                break;
+            }
+
+            const ssize_t length = ::read(inotifyFd, buffer, sizeof(buffer));
+            if (length <= 0) {
+                continue;
+            }
+
+            std::vector<ChangeEvent> events;
+            std::unordered_map<std::uint32_t, fs::path> movedOut; // Directories moved away, by cookie
+            for (ssize_t offset = 0; offset < length;) {
+                const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+                if (event->mask & IN_Q_OVERFLOW) {
+                    events.push_back({ChangeKind::Overflow, root});
+                    continue;
+                }
+                if (event->mask & IN_IGNORED) {
+                    watches.erase(event->wd);
+                    continue;
+                }
+
+                auto watch = watches.find(event->wd);
+                if (watch == watches.end() || event->len == 0) {
+                    continue;
+                }
+                fs::path path = watch->second / event->name;
+
+                if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                    if (event->mask & IN_ISDIR) {
+                        // A rename within the root: re-adding refreshes the paths
+                        movedOut.erase(event->cookie);
+                        addWatches(path);
+                    }
+                    events.push_back({ChangeKind::Added, std::move(path)});
+                } else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                    if ((event->mask & (IN_MOVED_FROM | IN_ISDIR)) == (IN_MOVED_FROM | IN_ISDIR)) {
+                        movedOut[event->cookie] = path;
+                    }
+                    events.push_back({ChangeKind::Removed, std::move(path)});
+                } else {
+                    events.push_back({ChangeKind::Modified, std::move(path)});
+                }
+            }
+
+            // Moves whose other half did not arrive left the root; should it
+            // come in a later read, it adds the watches back
+            for (const auto& [cookie, dir] : movedOut) {
+                removeWatches(dir);
+            }
+
+            if (!events.empty()) {
+                callback(std::move(events));
+            }
+        }
+    }
+};
+
+bool ChangeWatcher::start(const fs::path& root, Callback callback, std::error_code& ec) {
+    stop();
+    ec.clear();
+
+    auto state = std::make_unique<Impl>();
+    state->root = root;
+    state->callback = std::move(callback);
+    state->inotifyFd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    state->wakeFd = ::eventfd(0, EFD_CLOEXEC);
+    if (state->inotifyFd < 0 || state->wakeFd < 0) {
+        ec.assign(errno, std::system_category());
+        return false;
+    }
+
+    state->addWatches(root);
+    if (state->watches.empty()) {
+        ec = std::make_error_code(std::errc::no_such_file_or_directory);
+        return false;
+    }
+
+    Impl* raw = state.get();
+    state->thread = std::thread([raw] { raw->run(); });
+    impl = std::move(state);
+    return true;
+}
+
+#endif
+
+ChangeWatcher::ChangeWatcher() = default;
+
+ChangeWatcher::~ChangeWatcher() {
+    stop();
+}
+
+void ChangeWatcher::stop() {
+    impl.reset();
+}
+
+bool ChangeWatcher::running() const noexcept {
+    return impl != nullptr;
+}
+
+} // namespace ffe
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <system_error>
+#include <vector>
+
+namespace ffe {
+
+namespace fs = std::filesystem;
+
+enum class ChangeKind : std::uint8_t {
+    Added,
+    Removed,
+    Modified,
+    Overflow, // The notification queue overflowed; changes below path were lost
+};
+
+struct ChangeEvent {
+    ChangeKind kind;
+    fs::path path;
+};
+
+// Recursive file system change notifications for one root: inotify on Linux,
+// ReadDirectoryChangesW on Windows. Renames arrive as Removed + Added.
+// Events are delivered in batches from the watcher's own thread.
+class ChangeWatcher {
+public:
+    using Callback = std::function<void(std::vector<ChangeEvent>&& events)>;
+
+    ChangeWatcher();
+    ~ChangeWatcher();
+
+    ChangeWatcher(const ChangeWatcher&) = delete;
+    ChangeWatcher& operator=(const ChangeWatcher&) = delete;
+
+    bool start(const fs::path& root, Callback callback, std::error_code& ec);
+    void stop();
+
+    bool running() const noexcept;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
+
+} // namespace ffe
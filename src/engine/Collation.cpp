@@ -0,0 +1,86 @@
+#include "engine/Collation.hpp"
+
+#include "engine/Unicode.hpp"
+
+#include <algorithm>
+#include <type_traits>
+
+namespace ffe {
+
+namespace {
+
+// Digit runs are introduced by the byte '0' itself, so they sort where a
+// digit would: after spaces and most punctuation, before letters
+constexpr char DigitRun = '0';
+
+bool IsDigit(char32_t c) noexcept {
+    return c >= '0' && c <= '9';
+}
+
+// UTF-8 keeps code point order in byte order
+void AppendUtf8(char32_t c, std::string& key) {
+    if (c < 0x80) {
+        key += static_cast<char>(c);
+    } else if (c < 0x800) {
+        key += static_cast<char>(0xC0 | (c >> 6));
+        key += static_cast<char>(0x80 | (c & 0x3F));
+    } else if (c < 0x10000) {
+        key += static_cast<char>(0xE0 | (c >> 12));
+        key += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+        key += static_cast<char>(0x80 | (c & 0x3F));
+    } else {
+        key += static_cast<char>(0xF0 | (c >> 18));
+        key += static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+        key += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+        key += static_cast<char>(0x80 | (c & 0x3F));
+    }
+}
+
+} // namespace
+
+void AppendCollationKey(NameView name, std::string& key) {
+    std::size_t i = 0;
+    while (i < name.size()) {
+        const std::size_t start = i;
+        const auto unit = static_cast<std::make_unsigned_t<NativeChar>>(name[i]);
+        if (unit < 0x80 && !IsDigit(unit)) {
+            // ASCII, most of most names
+            key += static_cast<char>(unit >= 'A' && unit <= 'Z' ? unit + 0x20 : unit);
+            ++i;
+            continue;
+        }
+        const char32_t c = DecodeNext(name, i);
+        if (!IsDigit(c)) {
+            AppendUtf8(FoldCodePoint(c), key);
+            continue;
+        }
+
+        // A number: its length without leading zeros, then its digits, so a
+        // longer number is a larger one. The length byte is offset by one to
+        // keep zero bytes out of the key.
+        i = start;
+        while (i < name.size() && name[i] == '0') {
+            ++i;
+        }
+        const std::size_t first = i;
+        while (i < name.size() && IsDigit(static_cast<char32_t>(name[i]))) {
+            ++i;
+        }
+        const std::size_t digits = i - first;
+        key += DigitRun;
+        key += static_cast<char>(std::min<std::size_t>(digits + 1, 0xFF));
+        for (std::size_t d = first; d < i; ++d) {
+            key += static_cast<char>(name[d]);
+        }
+    }
+}
+
+NameView FileExtension(NameView name) noexcept {
+    const std::size_t dot = name.rfind('.');
+    if (dot == NameView::npos || dot == 0) {
+        return {};
+    }
+    return name.substr(dot + 1);
+}
+
+} // namespace ffe
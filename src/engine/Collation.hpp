@@ -0,0 +1,22 @@
+#pragma once
+
+#include "engine/DirEntry.hpp"
+
+#include <string>
+
+namespace ffe {
+
+// Appends the collation key of name to key. Keys compare byte by byte
+// (unsigned, shorter first) in the order Explorer shows names in: case
+// folded, and runs of digits compared by their value, so "File2" sorts
+// before "file10" and "a01" next to "a1". Computing the key once per name
+// makes every later comparison a memcmp.
+//
+// Keys never contain a zero byte.
+void AppendCollationKey(NameView name, std::string& key);
+
+// Extension of a file name as compared by the Type column: what follows the
+// last dot, "" when there is none or the name starts with its only dot
+NameView FileExtension(NameView name) noexcept;
+
+} // namespace ffe
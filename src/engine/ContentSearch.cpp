@@ -0,0 +1,279 @@
+#include "engine/ContentSearch.hpp"
+
+#include "engine/MappedFile.hpp"
+#include "engine/NameMatcherKernels.hpp"
+#include "engine/Trace.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <memory>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ffe {
+
+static_assert(ContentMatcher::npos == NoBytesFound);
+
+namespace {
+
+// Holds the largest file a thread has read whole, at most mapThreshold bytes
+struct ReadBuffer {
+    std::unique_ptr<char[]> data;
+    std::size_t capacity = 0;
+
+    char* reserve(std::size_t size) {
+        if (size > capacity) {
+            capacity = std::max(size, capacity * 2);
+            data = std::make_unique_for_overwrite<char[]>(capacity);
+        }
+        return data.get();
+    }
+};
+
+thread_local ReadBuffer t_readBuffer;
+
+// Contents of one file: read into the thread's buffer, or mapped
+struct Contents {
+    std::string_view text;
+    MappedFile mapping;
+    bool tooLarge = false;
+};
+
+bool MapContents(const fs::path& path, Contents& contents, std::error_code& ec) {
+    if (!contents.mapping.open(path, ec)) {
+        return false;
+    }
+    contents.mapping.adviseSequential();
+    const auto bytes = contents.mapping.bytes();
+    contents.text = {reinterpret_cast<const char*>(bytes.data()), bytes.size()};
+    return true;
+}
+
+#ifdef _WIN32
+
+bool LoadContents(const fs::path& path, const ContentOptions& options, Contents& contents, std::error_code& ec) {
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        ec.assign(static_cast<int>(GetLastError()), std::system_category());
+        return false;
+    }
+
+    LARGE_INTEGER fileSize = {};
+    if (!GetFileSizeEx(file, &fileSize)) {
+        ec.assign(static_cast<int>(GetLastError()), std::system_category());
+        CloseHandle(file);
+        return false;
+    }
+    const auto size = static_cast<std::uint64_t>(fileSize.QuadPart);
+    if (size > options.maxFileSize) {
+        CloseHandle(file);
+        contents.tooLarge = true;
+        return true;
+    }
+    if (size >= options.mapThreshold) {
+        CloseHandle(file);
+        return MapContents(path, contents, ec);
+    }
+
+    char* buffer = t_readBuffer.reserve(static_cast<std::size_t>(size));
+    std::size_t done = 0;
+    while (done < size) {
+        DWORD read = 0;
+        if (!ReadFile(file, buffer + done, static_cast<DWORD>(size - done), &read, NULL)) {
+            ec.assign(static_cast<int>(GetLastError()), std::system_category());
+            CloseHandle(file);
+            return false;
+        }
+        if (read == 0) {
+            break; // Shrunk since its size was taken
+        }
+        done += read;
+    }
+    CloseHandle(file);
+    contents.text = {buffer, done};
+    return true;
+}
+
+#else
+
+bool LoadContents(const fs::path& path, const ContentOptions& options, Contents& contents, std::error_code& ec) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        ec.assign(errno, std::system_category());
+        return false;
+    }
+
+    struct stat st = {};
+    if (::fstat(fd, &st) != 0) {
+        ec.assign(errno, std::system_category());
+        ::close(fd);
+        return false;
+    }
+    const auto size = static_cast<std::uint64_t>(st.st_size);
+    if (size > options.maxFileSize) {
+        ::close(fd);
+        contents.tooLarge = true;
+        return true;
+    }
+    if (size >= options.mapThreshold) {
+        ::close(fd);
+        return MapContents(path, contents, ec);
+    }
+
+#ifdef POSIX_FADV_SEQUENTIAL
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    char* buffer = t_readBuffer.reserve(static_cast<std::size_t>(size));
+    std::size_t done = 0;
+    while (done < size) {
+        const ssize_t read = ::read(fd, buffer + done, size - done);
+        if (read < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ec.assign(errno, std::system_category());
+            ::close(fd);
+            return false;
+        }
+        if (read == 0) {
+            break; // Shrunk since its size was taken
+        }
+        done += static_cast<std::size_t>(read);
+    }
+    ::close(fd);
+    contents.text = {buffer, done};
+    return true;
+}
+
+#endif
+
+bool IsUtf8Continuation(char c) noexcept {
+    return (static_cast<unsigned char>(c) & 0xC0) == 0x80;
+}
+
+// Copies line to out, cut to at most maxBytes around the match at column
+// without splitting a UTF-8 sequence
+void CutLine(std::string_view line, std::size_t column, std::size_t maxBytes, std::string& out) {
+    if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+    }
+    if (line.size() <= maxBytes) {
+        out.assign(line);
+        return;
+    }
+    // Keep a little of what precedes the match
+    std::size_t start = std::min(column - std::min(column, maxBytes / 4), line.size() - maxBytes);
+    std::size_t end = start + maxBytes;
+    while (start < end && IsUtf8Continuation(line[start])) {
+        ++start;
+    }
+    while (end > start && end < line.size() && IsUtf8Continuation(line[end])) {
+        --end;
+    }
+    out.assign(line.substr(start, end - start));
+}
+
+} // namespace
+
+ContentMatcher::ContentMatcher(std::string_view needle, bool ignoreCase, NameMatcher::SimdLevel level)
+    : needle(needle), fold(ignoreCase), level(std::min(level, NameMatcher::BestSimdLevel())) {
+    if (fold) {
+        std::transform(this->needle.begin(), this->needle.end(), this->needle.begin(), FoldAsciiUnit<char>);
+    }
+}
+
+std::size_t ContentMatcher::find(std::string_view text) const noexcept {
+    if (needle.empty() || text.size() < needle.size()) {
+        return npos;
+    }
+    switch (level) {
+#ifdef FFE_MATCHER_X86
+    case NameMatcher::SimdLevel::Avx2:
+        return FindBytesAvx2(text.data(), text.size(), needle.data(), needle.size(), fold);
+    case NameMatcher::SimdLevel::Sse2:
+        return FindBytesSse2(text.data(), text.size(), needle.data(), needle.size(), fold);
+#endif
+    default:
+        return FindBytesScalar(text.data(), text.size(), needle.data(), needle.size(), fold);
+    }
+}
+
+ContentSearcher::ContentSearcher(std::string_view needle, const ContentOptions& options,
+                                 NameMatcher::SimdLevel level)
+    : matcher(needle, options.ignoreCase, level), settings(options) {
+}
+
+bool ContentSearcher::IsBinary(std::string_view contents) noexcept {
+    const std::size_t probe = std::min(contents.size(), BinaryProbeBytes);
+    return std::memchr(contents.data(), '\0', probe) != nullptr;
+}
+
+ContentScan ContentSearcher::searchFile(const fs::path& path, const HitVisitor& visit) const {
+    TraceSpan span("ContentSearcher::searchFile");
+    ContentScan scan;
+    Contents contents;
+    if (!LoadContents(path, settings, contents, scan.error)) {
+        scan.outcome = ContentOutcome::Failed;
+        return scan;
+    }
+    if (contents.tooLarge) {
+        scan.outcome = ContentOutcome::TooLarge;
+        return scan;
+    }
+    scan.bytes = contents.text.size();
+    span.arg("bytes", static_cast<std::int64_t>(scan.bytes));
+    if (IsBinary(contents.text)) {
+        scan.outcome = ContentOutcome::Binary;
+        return scan;
+    }
+    scan.hits = searchText(contents.text, visit);
+    return scan;
+}
+
+std::size_t ContentSearcher::searchText(std::string_view text, const HitVisitor& visit) const {
+    ContentHit hit;
+    std::size_t hits = 0;
+    std::uint64_t line = 1;
+    std::size_t lineStart = 0; // Line breaks before here are counted in line
+    std::size_t from = 0;
+    while (hits < settings.maxHitsPerFile && from < text.size()) {
+        const std::size_t found = matcher.find(text.substr(from));
+        if (found == ContentMatcher::npos) {
+            break;
+        }
+        // Lines are only counted up to a match, so text without one is
+        // scanned once, by the matcher
+        const std::size_t at = from + found;
+        while (const void* newline = std::memchr(text.data() + lineStart, '\n', at - lineStart)) {
+            lineStart = static_cast<std::size_t>(static_cast<const char*>(newline) - text.data()) + 1;
+            ++line;
+        }
+        const std::size_t lineEnd = std::min(text.find('\n', at), text.size());
+
+        hit.offset = at;
+        hit.line = line;
+        hit.column = static_cast<std::uint32_t>(
+            std::min<std::size_t>(at - lineStart + 1, std::numeric_limits<std::uint32_t>::max()));
+        CutLine(text.substr(lineStart, lineEnd - lineStart), at - lineStart, settings.maxLineBytes, hit.text);
+        ++hits;
+        if (!visit(hit)) {
+            break;
+        }
+
+        // One hit per line: carry on after its line break
+        from = lineStart = lineEnd + 1;
+        ++line;
+    }
+    return hits;
+}
+
+} // namespace ffe
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "engine/NameMatcher.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+namespace ffe {
+
+namespace fs = std::filesystem;
+
+// Literal byte-string search in file contents. The needle is taken as
+// UTF-8 bytes; ignoring case folds ASCII letters only, so text in other
+// scripts matches as typed. Vector kernels compare the first and last
+// needle bytes at many positions at once and check the rest only where
+// both agree.
+class ContentMatcher {
+public:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    // level is clamped to what the CPU supports
+    ContentMatcher(std::string_view needle, bool ignoreCase,
+                   NameMatcher::SimdLevel level = NameMatcher::BestSimdLevel());
+
+    // Position of the first match in text, or npos. An empty needle matches nothing.
+    std::size_t find(std::string_view text) const noexcept;
+
+    std::size_t size() const noexcept {
+        return needle.size();
+    }
+
+    bool empty() const noexcept {
+        return needle.empty();
+    }
+
+private:
+    std::string needle; // Folded when ignoring case
+    bool fold;
+    NameMatcher::SimdLevel level;
+};
+
+struct ContentOptions {
+    bool ignoreCase = true;
+    std::uint64_t maxFileSize = 256ull << 20;  // Larger files are skipped
+    std::uint64_t mapThreshold = 1ull << 20;   // Files this large are mapped, smaller ones read whole
+    std::size_t maxHitsPerFile = 1000;         // The rest of a file is skipped after this many
+    std::size_t maxLineBytes = 256;            // Longer lines are cut around the match
+};
+
+// A line holding a match; a line with several matches is reported once
+struct ContentHit {
+    std::uint64_t offset = 0; // Bytes from the start of the file to the first match on the line
+    std::uint64_t line = 0;   // From 1
+    std::uint32_t column = 0; // Bytes from the start of the line to the match, from 1
+    std::string text;         // The line in UTF-8 as stored, without its line break
+};
+
+enum class ContentOutcome : std::uint8_t {
+    Searched,
+    Binary,   // A NUL byte near the start; not searched
+    TooLarge, // Over maxFileSize; not read
+    Failed,   // Could not be opened or read
+};
+
+struct ContentScan {
+    ContentOutcome outcome = ContentOutcome::Searched;
+    std::uint64_t bytes = 0; // Read from the file
+    std::size_t hits = 0;
+    std::error_code error; // Why, when Failed
+};
+
+// Searches whole files for one needle; safe to share between threads.
+// Small files are read into a per-thread buffer in one go, larger ones are
+// mapped, both with sequential access hints so the system reads ahead.
+class ContentSearcher {
+public:
+    // Called for every hit of a file, in order; the hit is reused for the
+    // next one. Returning false skips the rest of the file.
+    using HitVisitor = std::function<bool(const ContentHit&)>;
+
+    // Files with a NUL in this many leading bytes count as binary
+    static constexpr std::size_t BinaryProbeBytes = 8 * 1024;
+
+    ContentSearcher(std::string_view needle, const ContentOptions& options = {},
+                    NameMatcher::SimdLevel level = NameMatcher::BestSimdLevel());
+
+    ContentScan searchFile(const fs::path& path, const HitVisitor& visit) const;
+
+    // Searches text as the contents of one file; returns the hits visited
+    std::size_t searchText(std::string_view text, const HitVisitor& visit) const;
+
+    static bool IsBinary(std::string_view contents) noexcept;
+
+    const ContentOptions& options() const noexcept {
+        return settings;
+    }
+
+private:
+    ContentMatcher matcher;
+    ContentOptions settings;
+};
+
+} // namespace ffe
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+
+namespace ffe {
+
+namespace fs = std::filesystem;
+
+using NativeChar = fs::path::value_type;
+using NameView = std::basic_string_view<NativeChar>;
+
+enum class EntryType : std::uint8_t {
+    Unknown,
+    File,
+    Directory,
+    Symlink,
+    Other,
+};
+
+// One directory entry as produced by enumeration. The name is kept in the
+// platform's native encoding (UTF-16 on Windows, bytes on Linux) so no
+// conversion happens on the hot path.
+struct DirEntry {
+    fs::path::string_type name;
+    EntryType type = EntryType::Unknown;
+    bool hasStat = false;   // size and mtime are valid
+    std::uint64_t size = 0; // Bytes, files only
+    std::int64_t mtime = 0; // Last write time, nanoseconds since the Unix epoch
+
+    bool isFile() const noexcept {
+        return type == EntryType::File;
+    }
+
+    bool isDirectory() const noexcept {
+        return type == EntryType::Directory;
+    }
+};
+
+// Where the data of an entry lives, to tell hard links from copies and to
+// count the space files really take. Enumeration does not provide it; it
+// costs a stat per entry, so it is only gathered on request (StatEngine).
+struct FileIdentity {
+    std::uint64_t device = 0;    // Volume holding the data
+    std::uint64_t file = 0;      // Inode, or NTFS file index; unique within the volume
+    std::uint32_t links = 0;     // Names the data has, 0 when the identity is unknown
+    std::uint64_t allocated = 0; // Bytes allocated on disk, less than the size for sparse or compressed files
+
+    bool known() const noexcept {
+        return links != 0;
+    }
+
+    bool sameFile(const FileIdentity& other) const noexcept {
+        return known() && device == other.device && file == other.file;
+    }
+};
+
+} // namespace ffe
@@ -0,0 +1,94 @@
+#include "engine/DirectoryPrefetcher.hpp"
+
+#include <algorithm>
+
+namespace ffe {
+
+DirectoryPrefetcher::DirectoryPrefetcher(Executor& executor, std::size_t budgetBytes, Fetch fetch)
+    : executor(executor), budgetBytes(budgetBytes), fetch(std::move(fetch)),
+      current(std::make_shared<Generation>()) {}
+
+DirectoryPrefetcher::~DirectoryPrefetcher() {
+    std::unique_lock<std::mutex> lock(mutex);
+    current->cancelled = true;
+    queue.clear();
+    idle.wait(lock, [this] { return loops == 0; });
+}
+
+void DirectoryPrefetcher::prefetch(std::vector<fs::path> candidates) {
+    std::shared_ptr<Generation> generation;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto it = candidates.rbegin(); it != candidates.rend(); ++it) {
+            const bool listed = std::any_of(finished.begin(), finished.end(), [&](const ListingCache::Fetched& done) {
+                return done.dir == *it;
+            });
+            if (listed) {
+                continue;
+            }
+            std::erase(queue, *it);
+            queue.push_front(std::move(*it));
+        }
+        if (queue.empty() || current->running) {
+            return;
+        }
+        current->running = true;
+        loops++;
+        generation = current;
+    }
+    executor.submit([this, generation] { run(generation); });
+}
+
+void DirectoryPrefetcher::cancel() {
+    std::lock_guard<std::mutex> lock(mutex);
+    current->cancelled = true;
+    current = std::make_shared<Generation>();
+    queue.clear();
+}
+
+std::size_t DirectoryPrefetcher::drainInto(ListingCache& cache) {
+    std::vector<ListingCache::Fetched> done;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        done.swap(finished);
+        finishedBytes = 0;
+    }
+    for (auto& listing : done) {
+        cache.insert(std::move(listing), true);
+    }
+    return done.size();
+}
+
+void DirectoryPrefetcher::run(std::shared_ptr<Generation> generation) {
+    while (true) {
+        fs::path dir;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (generation->cancelled || queue.empty() || finishedBytes >= budgetBytes) {
+                generation->running = false;
+                if (--loops == 0) {
+                    idle.notify_all();
+                }
+                return;
+            }
+            dir = std::move(queue.front());
+            queue.pop_front();
+        }
+
+        ListingCache::Fetched listing;
+        std::error_code ec;
+        const bool ok = fetch(dir, listing, ec);
+        fetchCount.fetch_add(1, std::memory_order_relaxed);
+
+        // A partial listing is not worth keeping; the folder is read again
+        // when it is opened
+        std::lock_guard<std::mutex> lock(mutex);
+        const std::size_t bytes = ok ? ListingCache::ListingBytes(*listing.entries) : 0;
+        if (ok && !generation->cancelled && finishedBytes + bytes <= budgetBytes) {
+            finishedBytes += bytes;
+            finished.push_back(std::move(listing));
+        }
+    }
+}
+
+} // namespace ffe
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "engine/Executor.hpp"
+#include "engine/ListingCache.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ffe {
+
+// Lists folders the user is likely to open next (the row under the mouse,
+// the selected folder, the next step back in history) before they are
+// opened. Prefetching is low priority: one folder is read at a time, and
+// everything queued or running is dropped as soon as a real navigation
+// starts.
+//
+// Finished listings wait here, up to budgetBytes, until the frontend moves
+// them into its ListingCache with drainInto(); the cache then validates
+// them like any other listing when they are opened.
+class DirectoryPrefetcher {
+public:
+    using Fetch = std::function<bool(const fs::path& dir, ListingCache::Fetched& fetched, std::error_code& ec)>;
+
+    static constexpr std::size_t DefaultBudgetBytes = 8u << 20;
+
+    explicit DirectoryPrefetcher(Executor& executor, std::size_t budgetBytes = DefaultBudgetBytes,
+                                 Fetch fetch = ListingCache::Fetch);
+    ~DirectoryPrefetcher();
+
+    DirectoryPrefetcher(const DirectoryPrefetcher&) = delete;
+    DirectoryPrefetcher& operator=(const DirectoryPrefetcher&) = delete;
+
+    // Queues candidates, most likely first, ahead of earlier ones. Folders
+    // already queued or listed are not read again.
+    void prefetch(std::vector<fs::path> candidates);
+
+    // Drops queued candidates and stops the running read from being kept;
+    // listings already finished stay available to drainInto()
+    void cancel();
+
+    // Moves finished listings into cache, returns how many
+    std::size_t drainInto(ListingCache& cache);
+
+    // Folders read ahead so far
+    std::size_t fetched() const noexcept {
+        return fetchCount.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Generation {
+        std::atomic<bool> cancelled{false};
+        bool running = false; // A read loop works for this generation
+    };
+
+    void run(std::shared_ptr<Generation> generation);
+
+    Executor& executor;
+    const std::size_t budgetBytes;
+    const Fetch fetch;
+
+    std::mutex mutex;
+    std::shared_ptr<Generation> current;
+    std::deque<fs::path> queue;
+    std::vector<ListingCache::Fetched> finished;
+    std::size_t finishedBytes = 0;
+    std::size_t loops = 0; // Read loops not finished, of any generation
+    std::condition_variable idle;
+    std::atomic<std::size_t> fetchCount{0};
+};
+
+} // namespace ffe
@@ -0,0 +1,292 @@
+#include "engine/DirectoryReader.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__linux__)
+#include <cerrno>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace ffe {
+
+namespace {
+
+#if defined(_WIN32)
+
+// FILETIME counts 100 ns intervals since 1601
+std::int64_t FileTimeToUnixNanos(const FILETIME& time) {
+    const std::uint64_t ticks = (static_cast<std::uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+    return (static_cast<std::int64_t>(ticks) - 116444736000000000LL) * 100;
+}
+
+EntryType ClassifyFindData(const WIN32_FIND_DATAW& data) {
+    // Junctions behave like symlinks to folders; other reparse points
+    // (OneDrive placeholders, dedup) are ordinary files and folders
+    if ((data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) &&
+        (data.dwReserved0 == IO_REPARSE_TAG_SYMLINK || data.dwReserved0 == IO_REPARSE_TAG_MOUNT_POINT)) {
+        return EntryType::Symlink;
+    }
+    if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+        return EntryType::Directory;
+    }
+    return (data.dwFileAttributes & FILE_ATTRIBUTE_DEVICE) ? EntryType::Other : EntryType::File;
+}
+
+// FindFirstFileEx without short names and with large fetches returns name,
+// attributes, size and times of many entries per kernel call
+bool ReadDirectoryNative(const fs::path& dir, std::vector<DirEntry>& entries, std::error_code& ec) {
+    WIN32_FIND_DATAW data;
+    const std::wstring pattern = (dir / L"*").native();
+    HANDLE find = FindFirstFileExW(pattern.c_str(), FindExInfoBasic, &data, FindExSearchNameMatch, NULL,
+                                   FIND_FIRST_EX_LARGE_FETCH);
+    if (find == INVALID_HANDLE_VALUE) {
+        const DWORD error = GetLastError();
+        // An empty drive root has no entries at all; a folder we may not
+        // read is an error like any other, for callers to report or skip
+        if (error == ERROR_FILE_NOT_FOUND) {
+            return true;
+        }
+        ec.assign(static_cast<int>(error), std::system_category());
+        return false;
+    }
+
+    do {
+        if (data.cFileName[0] == L'.' &&
+            (data.cFileName[1] == L'\0' || (data.cFileName[1] == L'.' && data.cFileName[2] == L'\0'))) {
+            continue;
+        }
+        DirEntry& entry = entries.emplace_back();
+        entry.name = data.cFileName;
+        entry.type = ClassifyFindData(data);
+        entry.size = entry.isFile() ? (static_cast<std::uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow : 0;
+        entry.mtime = FileTimeToUnixNanos(data.ftLastWriteTime);
+        entry.hasStat = true;
+    } while (FindNextFileW(find, &data));
+
+    const DWORD error = GetLastError();
+    FindClose(find);
+    if (error != ERROR_NO_MORE_FILES) {
+        ec.assign(static_cast<int>(error), std::system_category());
+        return false;
+    }
+    return true;
+}
+
+#elif defined(__linux__)
+
+// Layout of the records getdents64 fills the buffer with
+struct LinuxDirent64 {
+    std::uint64_t inode;
+    std::int64_t offset;
+    unsigned short length;
+    unsigned char type;
+    char name[1];
+};
+
+// Large enough for a few thousand entries per call; glibc's readdir asks
+// for 32 KiB at a time
+constexpr std::size_t DirentBufferSize = 256 * 1024;
+
+EntryType FromDirentType(unsigned char type) {
+    switch (type) {
+    case DT_REG:
+        return EntryType::File;
+    case DT_DIR:
+        return EntryType::Directory;
+    case DT_LNK:
+        return EntryType::Symlink;
+    case DT_UNKNOWN:
+        return EntryType::Unknown;
+    default:
+        return EntryType::Other;
+    }
+}
+
+// getdents64 hands out many entries per call together with their type, so
+// a listing costs no per-entry syscalls except on file systems that leave
+// d_type unknown, where the entry is stat'ed (and so gets size and mtime)
+bool ReadDirectoryNative(const fs::path& dir, std::vector<DirEntry>& entries, std::error_code& ec) {
+    const int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        ec.assign(errno, std::generic_category());
+        return false;
+    }
+
+    thread_local const std::unique_ptr<std::uint64_t[]> buffer(new std::uint64_t[DirentBufferSize / 8]);
+    char* const bytes = reinterpret_cast<char*>(buffer.get());
+    bool ok = true;
+    while (true) {
+        const long read = ::syscall(SYS_getdents64, fd, bytes, DirentBufferSize);
+        if (read <= 0) {
+            if (read < 0) {
+                ec.assign(errno, std::generic_category());
+                ok = false;
+            }
+            break;
+        }
+
+        for (long position = 0; position < read;) {
+            const auto* dirent = reinterpret_cast<const LinuxDirent64*>(bytes + position);
+            position += dirent->length;
+            const char* name = dirent->name;
+            if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+                continue;
+            }
+
+            DirEntry& entry = entries.emplace_back();
+            entry.name = name;
+            entry.type = FromDirentType(dirent->type);
+            if (entry.type == EntryType::Unknown) {
+                struct stat status;
+                if (::fstatat(fd, name, &status, AT_SYMLINK_NOFOLLOW) == 0) {
+                    entry.type = S_ISREG(status.st_mode)   ? EntryType::File
+                                 : S_ISDIR(status.st_mode) ? EntryType::Directory
+                                 : S_ISLNK(status.st_mode) ? EntryType::Symlink
+                                                           : EntryType::Other;
+                    entry.size = entry.isFile() ? static_cast<std::uint64_t>(status.st_size) : 0;
+                    entry.mtime = static_cast<std::int64_t>(status.st_mtim.tv_sec) * 1000000000LL +
+                                  status.st_mtim.tv_nsec;
+                    entry.hasStat = true;
+                }
+            }
+        }
+    }
+    ::close(fd);
+    return ok;
+}
+
+#endif
+
+EntryType ClassifyEntry(const fs::directory_entry& entry) {
+    std::error_code ec;
+    if (entry.is_symlink(ec)) {
+        return EntryType::Symlink;
+    }
+    if (entry.is_directory(ec)) {
+        return EntryType::Directory;
+    }
+    if (entry.is_regular_file(ec)) {
+        return EntryType::File;
+    }
+    return ec ? EntryType::Unknown : EntryType::Other;
+}
+
+} // namespace
+
+EntryType ToEntryType(const fs::file_status& status) {
+    switch (status.type()) {
+    case fs::file_type::regular:
+        return EntryType::File;
+    case fs::file_type::directory:
+        return EntryType::Directory;
+    case fs::file_type::symlink:
+        return EntryType::Symlink;
+    case fs::file_type::none:
+    case fs::file_type::not_found:
+    case fs::file_type::unknown:
+        return EntryType::Unknown;
+    default:
+        return EntryType::Other;
+    }
+}
+
+std::int64_t ToUnixNanos(fs::file_time_type time) {
+    const auto system = std::chrono::file_clock::to_sys(time);
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(system.time_since_epoch()).count();
+}
+
+bool StatEntry(const fs::path& dir, DirEntry& entry) {
+    if (entry.hasStat) {
+        return true;
+    }
+
+    const fs::path path = dir / entry.name;
+    std::error_code ec;
+    const auto mtime = fs::last_write_time(path, ec);
+    if (ec) {
+        return false;
+    }
+    entry.mtime = ToUnixNanos(mtime);
+    entry.size = entry.isFile() ? fs::file_size(path, ec) : 0;
+    if (ec) {
+        entry.size = 0;
+    }
+    entry.hasStat = true;
+    return true;
+}
+
+bool StatIdentity(const fs::path& dir, const DirEntry& entry, FileIdentity& identity) {
+    const fs::path path = dir / entry.name;
+#if defined(_WIN32)
+    // Opening with no access rights reads attributes without touching the data
+    HANDLE file = CreateFileW(path.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+                              OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OPEN_REPARSE_POINT, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    BY_HANDLE_FILE_INFORMATION info = {};
+    FILE_STANDARD_INFO standard = {};
+    const bool ok = GetFileInformationByHandle(file, &info) &&
+                    GetFileInformationByHandleEx(file, FileStandardInfo, &standard, sizeof(standard));
+    CloseHandle(file);
+    if (!ok) {
+        return false;
+    }
+    identity.device = info.dwVolumeSerialNumber;
+    identity.file = (static_cast<std::uint64_t>(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+    identity.links = std::max<DWORD>(info.nNumberOfLinks, 1);
+    identity.allocated = static_cast<std::uint64_t>(standard.AllocationSize.QuadPart);
+    return true;
+#elif defined(__linux__)
+    struct stat status;
+    if (::lstat(path.c_str(), &status) != 0) {
+        return false;
+    }
+    identity.device = status.st_dev;
+    identity.file = status.st_ino;
+    identity.links = std::max<std::uint32_t>(static_cast<std::uint32_t>(status.st_nlink), 1);
+    identity.allocated = static_cast<std::uint64_t>(status.st_blocks) * 512;
+    return true;
+#else
+    (void)path;
+    (void)identity;
+    return false;
+#endif
+}
+
+bool ReadDirectory(const fs::path& dir, std::vector<DirEntry>& entries, std::error_code& ec) {
+#if defined(_WIN32) || defined(__linux__)
+    entries.clear();
+    ec.clear();
+    return ReadDirectoryNative(dir, entries, ec);
+#else
+    return ReadDirectoryPortable(dir, entries, ec);
+#endif
+}
+
+bool ReadDirectoryPortable(const fs::path& dir, std::vector<DirEntry>& entries, std::error_code& ec) {
+    entries.clear();
+    ec.clear();
+
+    fs::directory_iterator it(dir, ec);
+    if (ec) {
+        return false;
+    }
+
+    for (fs::directory_iterator end; it != end; it.increment(ec)) {
+        DirEntry& entry = entries.emplace_back();
+        entry.name = it->path().filename().native();
+        entry.type = ClassifyEntry(*it);
+    }
+    return !ec;
+}
+
+} // namespace ffe
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "engine/DirEntry.hpp"
+
+#include <system_error>
+#include <vector>
+
+namespace ffe {
+
+// Reads every entry of a directory into entries (which is cleared first).
+// Symlinks are reported as EntryType::Symlink and never followed. Returns
+// false and sets ec when the directory cannot be opened, access denied
+// included; entries read before a mid-listing error are kept.
+//
+// Directories are read in large batches with the entry type included
+// (getdents64 on Linux, FindFirstFileEx with large fetches on Windows), so
+// a listing takes a few kernel calls however many entries it has. Windows
+// fills in size and mtime as well (hasStat).
+bool ReadDirectory(const fs::path& dir, std::vector<DirEntry>& entries, std::error_code& ec);
+
+// ReadDirectory on top of std::filesystem::directory_iterator, used where
+// there is no native backend and as the reference in benchmarks
+bool ReadDirectoryPortable(const fs::path& dir, std::vector<DirEntry>& entries, std::error_code& ec);
+
+// Entry type for a status obtained without following symlinks
+EntryType ToEntryType(const fs::file_status& status);
+
+// Fills size and mtime of an entry of dir that enumeration left without them
+bool StatEntry(const fs::path& dir, DirEntry& entry);
+
+// Looks up the identity of an entry of dir, without following symlinks
+bool StatIdentity(const fs::path& dir, const DirEntry& entry, FileIdentity& identity);
+
+// Nanoseconds since the Unix epoch, the time unit stored in DirEntry and indexes
+std::int64_t ToUnixNanos(fs::file_time_type time);
+
+} // namespace ffe
@@ -0,0 +1,479 @@
+#include "engine/DuplicateFinder.hpp"
+
+#include "engine/Hash64.hpp"
+#include "engine/Metrics.hpp"
+#include "engine/Trace.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cerrno>
+#include <unordered_map>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace ffe {
+
+namespace {
+
+// Groups are spread over this many locks, so workers adding files of
+// different sizes rarely wait for each other
+constexpr std::size_t Stripes = 64;
+
+// Whole files are hashed in reads of this size
+constexpr std::size_t ReadChunk = 1 << 20;
+
+std::uint64_t Mix(std::uint64_t value) noexcept {
+    value ^= value >> 33;
+    value *= 0xFF51AFD7ED558CCDull;
+    value ^= value >> 33;
+    return value;
+}
+
+// (size, hash) of a group, or (device, file) of a file with several names
+struct PairKey {
+    std::uint64_t first;
+    std::uint64_t second;
+
+    bool operator==(const PairKey&) const = default;
+};
+
+struct PairKeyHash {
+    std::size_t operator()(const PairKey& key) const noexcept {
+        return static_cast<std::size_t>(Mix(key.first ^ std::rotl(key.second, 29)));
+    }
+};
+
+// The data of one file, reached through one name or several
+struct Copy {
+    fs::path path;                // First name seen; the one read
+    std::vector<fs::path> links;  // Further names, added under the size stripe's lock
+    std::uint64_t size = 0;
+    std::uint64_t partial = 0;    // Hash of the head and tail
+    std::uint64_t full = 0;       // Hash of the whole file
+};
+
+struct alignas(64) SizeStripe {
+    std::mutex mutex;
+    std::unordered_map<std::uint64_t, std::vector<std::unique_ptr<Copy>>> sizes;
+    std::unordered_map<PairKey, Copy*, PairKeyHash> links; // Files with several names, by identity
+};
+
+struct alignas(64) HashStripe {
+    std::mutex mutex;
+    std::unordered_map<PairKey, std::vector<Copy*>, PairKeyHash> groups;
+};
+
+// Adds copy to the group it now belongs to. Returns the copies that have to
+// go on to the next stage: both once a group has a second member, then each
+// newcomer.
+std::size_t Join(std::vector<Copy*>& group, Copy* copy, Copy* (&ready)[2]) {
+    group.push_back(copy);
+    if (group.size() == 2) {
+        ready[0] = group[0];
+        ready[1] = group[1];
+        return 2;
+    }
+    ready[0] = copy;
+    return group.size() > 2 ? 1 : 0;
+}
+
+// Largest block a thread has read, reused for the next file
+thread_local std::vector<char> t_buffer;
+
+char* ReserveBuffer(std::size_t size) {
+    if (t_buffer.size() < size) {
+        t_buffer.resize(size);
+    }
+    return t_buffer.data();
+}
+
+// A file opened for reading at any offset
+class InputFile {
+public:
+    InputFile() = default;
+    InputFile(const InputFile&) = delete;
+    InputFile& operator=(const InputFile&) = delete;
+    ~InputFile();
+
+    // sequential hints that the whole file is read front to back
+    bool open(const fs::path& path, bool sequential, std::error_code& ec);
+
+    // Reads up to size bytes at offset; fewer only at the end of the file
+    std::size_t readAt(std::uint64_t offset, char* data, std::size_t size, std::error_code& ec);
+
+private:
+#ifdef _WIN32
+    HANDLE handle = INVALID_HANDLE_VALUE;
+#else
+    int fd = -1;
+#endif
+};
+
+#ifdef _WIN32
+
+InputFile::~InputFile() {
+    if (handle != INVALID_HANDLE_VALUE) {
+        CloseHandle(handle);
+    }
+}
+
+bool InputFile::open(const fs::path& path, bool sequential, std::error_code& ec) {
+    handle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+                         OPEN_EXISTING, sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS, NULL);
+    if (handle == INVALID_HANDLE_VALUE) {
+        ec.assign(static_cast<int>(GetLastError()), std::system_category());
+        return false;
+    }
+    return true;
+}
+
+std::size_t InputFile::readAt(std::uint64_t offset, char* data, std::size_t size, std::error_code& ec) {
+    std::size_t done = 0;
+    while (done < size) {
+        OVERLAPPED position = {};
+        position.Offset = static_cast<DWORD>(offset + done);
+        position.OffsetHigh = static_cast<DWORD>((offset + done) >> 32);
+        DWORD read = 0;
+        const DWORD want = static_cast<DWORD>(std::min<std::size_t>(size - done, 1u << 30));
+        if (!ReadFile(handle, data + done, want, &read, &position)) {
+            const DWORD error = GetLastError();
+            if (error == ERROR_HANDLE_EOF) {
+                break;
+            }
+            ec.assign(static_cast<int>(error), std::system_category());
+            break;
+        }
+        if (read == 0) {
+            break;
+        }
+        done += read;
+    }
+    return done;
+}
+
+#else
+
+InputFile::~InputFile() {
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+bool InputFile::open(const fs::path& path, bool sequential, std::error_code& ec) {
+    fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        ec.assign(errno, std::system_category());
+        return false;
+    }
+#ifdef POSIX_FADV_SEQUENTIAL
+    ::posix_fadvise(fd, 0, 0, sequential ? POSIX_FADV_SEQUENTIAL : POSIX_FADV_RANDOM);
+#else
+    (void)sequential;
+#endif
+    return true;
+}
+
+std::size_t InputFile::readAt(std::uint64_t offset, char* data, std::size_t size, std::error_code& ec) {
+    std::size_t done = 0;
+    while (done < size) {
+        const ssize_t read = ::pread(fd, data + done, size - done, static_cast<off_t>(offset + done));
+        if (read < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ec.assign(errno, std::system_category());
+            break;
+        }
+        if (read == 0) {
+            break;
+        }
+        done += static_cast<std::size_t>(read);
+    }
+    return done;
+}
+
+#endif
+
+} // namespace
+
+struct DuplicateFinder::Search {
+    Search(Executor& executor, const DuplicateOptions& options) : executor(executor), options(options) {}
+
+    Executor& executor;
+    const DuplicateOptions& options;
+    std::array<SizeStripe, Stripes> sizes;
+    std::array<HashStripe, Stripes> partials; // Stage 2 groups, by size and the hash of the ends
+    std::array<HashStripe, Stripes> fulls;    // Final groups, by size and the hash of the contents
+    std::atomic<std::uint64_t> outstanding{0}; // Hash tasks queued or running
+    std::atomic<bool> cancelled{false};
+    TreeWalk walk;
+
+    ShardedCounter files;
+    ShardedCounter hardLinks;
+    ShardedCounter partialHashes;
+    ShardedCounter fullHashes;
+    ShardedCounter bytesRead;
+    ShardedCounter errors;
+
+    void offer(const WalkDirectory& dir);
+    void hashEnds(Copy& copy);
+    void hashWhole(Copy& copy);
+
+    // Adds copy to its group of a stage's stripes, under the stripe lock
+    std::size_t join(std::array<HashStripe, Stripes>& stage, PairKey key, Copy* copy, Copy* (&ready)[2]) {
+        HashStripe& stripe = stage[PairKeyHash()(key) % Stripes];
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        return Join(stripe.groups[key], copy, ready);
+    }
+
+    template<class Stage>
+    void queue(Copy* copy, Stage stage) {
+        outstanding.fetch_add(1, std::memory_order_relaxed);
+        executor.submit([this, copy, stage] {
+            if (!cancelled.load(std::memory_order_relaxed)) {
+                (this->*stage)(*copy);
+            }
+            if (outstanding.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                outstanding.notify_all();
+            }
+        });
+    }
+};
+
+// Stage 1: groups the files of a directory by size
+void DuplicateFinder::Search::offer(const WalkDirectory& dir) {
+    for (std::size_t index = 0; index < dir.entries.size(); ++index) {
+        const DirEntry& entry = dir.entries[index];
+        if (!entry.isFile() || !entry.hasStat || entry.size < options.minSize) {
+            continue;
+        }
+        if (options.include && !options.include(dir.path, entry)) {
+            continue;
+        }
+        files.add();
+
+        const FileIdentity identity = index < dir.identities.size() ? dir.identities[index] : FileIdentity{};
+        SizeStripe& stripe = sizes[Mix(entry.size) % Stripes];
+        Copy* ready[2];
+        std::size_t count = 0;
+        {
+            std::lock_guard<std::mutex> lock(stripe.mutex);
+            Copy** linked = nullptr;
+            if (identity.links > 1) {
+                auto [it, added] = stripe.links.try_emplace({identity.device, identity.file}, nullptr);
+                if (!added) {
+                    it->second->links.push_back(dir.path / entry.name);
+                    hardLinks.add();
+                    continue;
+                }
+                linked = &it->second;
+            }
+
+            auto copy = std::make_unique<Copy>();
+            copy->path = dir.path / entry.name;
+            copy->size = entry.size;
+            if (linked) {
+                *linked = copy.get();
+            }
+            auto& group = stripe.sizes[entry.size];
+            group.push_back(std::move(copy));
+            if (group.size() == 2) {
+                ready[0] = group[0].get();
+                ready[1] = group[1].get();
+                count = 2;
+            } else if (group.size() > 2) {
+                ready[0] = group.back().get();
+                count = 1;
+            }
+        }
+        for (std::size_t i = 0; i < count; ++i) {
+            queue(ready[i], &Search::hashEnds);
+        }
+    }
+}
+
+// Stage 2: hashes the head and tail of a file sharing its size with another
+void DuplicateFinder::Search::hashEnds(Copy& copy) {
+    TraceSpan span("DuplicateFinder::hashEnds");
+    std::error_code ec;
+    InputFile file;
+    if (!file.open(copy.path, false, ec)) {
+        errors.add();
+        return;
+    }
+
+    // Files up to both ends are read whole, with a byte to spare to notice growth
+    const std::size_t part = options.partialBytes;
+    const bool whole = copy.size <= 2 * static_cast<std::uint64_t>(part);
+    std::size_t read = 0;
+    std::size_t expected = 0;
+    char* buffer = nullptr;
+    if (whole) {
+        expected = static_cast<std::size_t>(copy.size);
+        buffer = ReserveBuffer(expected + 1);
+        read = file.readAt(0, buffer, expected + 1, ec);
+    } else {
+        expected = 2 * part;
+        buffer = ReserveBuffer(expected);
+        read = file.readAt(0, buffer, part, ec);
+        if (!ec) {
+            read += file.readAt(copy.size - part, buffer + part, part, ec);
+        }
+    }
+    bytesRead.add(read);
+    if (ec || read != expected) {
+        errors.add(); // Unreadable, or its size changed since the walk
+        return;
+    }
+    partialHashes.add();
+    copy.partial = Hash64(buffer, expected);
+
+    Copy* ready[2];
+    if (whole) {
+        copy.full = copy.partial;
+        join(fulls, {copy.size, copy.full}, &copy, ready);
+        return;
+    }
+    const std::size_t count = join(partials, {copy.size, copy.partial}, &copy, ready);
+    for (std::size_t i = 0; i < count; ++i) {
+        queue(ready[i], &Search::hashWhole);
+    }
+}
+
+// Stage 3: hashes the whole of a file whose ends match another's
+void DuplicateFinder::Search::hashWhole(Copy& copy) {
+    TraceSpan span("DuplicateFinder::hashWhole");
+    span.arg("bytes", static_cast<std::int64_t>(copy.size));
+    std::error_code ec;
+    InputFile file;
+    if (!file.open(copy.path, true, ec)) {
+        errors.add();
+        return;
+    }
+
+    char* buffer = ReserveBuffer(ReadChunk);
+    Hasher64 hasher;
+    std::uint64_t offset = 0;
+    while (!cancelled.load(std::memory_order_relaxed)) {
+        const std::size_t read = file.readAt(offset, buffer, ReadChunk, ec);
+        hasher.update(buffer, read);
+        offset += read;
+        if (ec || read < ReadChunk) {
+            break;
+        }
+    }
+    bytesRead.add(offset);
+    if (ec || offset != copy.size || cancelled.load(std::memory_order_relaxed)) {
+        errors.add(); // Unreadable, or its size changed since the walk
+        return;
+    }
+    fullHashes.add();
+    copy.full = hasher.digest();
+
+    Copy* ready[2];
+    join(fulls, {copy.size, copy.full}, &copy, ready);
+}
+
+DuplicateFinder::DuplicateFinder(Executor& executor, DuplicateOptions options)
+    : executor(executor), options(std::move(options)) {
+}
+
+DuplicateFinder::~DuplicateFinder() {
+    cancel();
+}
+
+DuplicateReport DuplicateFinder::find(const fs::path& root) {
+    auto current = std::make_shared<Search>(executor, options);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        search = current;
+    }
+
+    // The walk stats every entry for its identity, to know hard links
+    WalkOptions walkOptions;
+    walkOptions.identities = true;
+    Search* state = current.get();
+    TreeWalk walk = TreeWalker(executor).walk(
+        root, [state](const WalkDirectory& dir) { state->offer(dir); }, walkOptions);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        current->walk = walk;
+        if (current->cancelled) {
+            walk.cancel();
+        }
+    }
+    const WalkStats walked = walk.wait();
+    current->errors.add(walked.errors);
+
+    // The walk queues no more hashing; hash tasks queue the next stage
+    // before they count themselves done, so zero means all stages are
+    while (const std::uint64_t outstanding = current->outstanding.load(std::memory_order_acquire)) {
+        current->outstanding.wait(outstanding, std::memory_order_acquire);
+    }
+
+    DuplicateReport report;
+    for (HashStripe& stripe : current->fulls) {
+        for (auto& [key, members] : stripe.groups) {
+            if (members.size() < 2) {
+                continue;
+            }
+            DuplicateGroup group;
+            group.size = key.first;
+            group.hash = key.second;
+            for (Copy* member : members) {
+                DuplicateGroup::Copy copy;
+                copy.paths.reserve(member->links.size() + 1);
+                copy.paths.push_back(std::move(member->path));
+                std::move(member->links.begin(), member->links.end(), std::back_inserter(copy.paths));
+                std::sort(copy.paths.begin(), copy.paths.end());
+                group.copies.push_back(std::move(copy));
+            }
+            std::sort(group.copies.begin(), group.copies.end(),
+                      [](const DuplicateGroup::Copy& a, const DuplicateGroup::Copy& b) { return a.paths < b.paths; });
+            report.reclaimable += group.reclaimable();
+            report.groups.push_back(std::move(group));
+        }
+    }
+    std::sort(report.groups.begin(), report.groups.end(), [](const DuplicateGroup& a, const DuplicateGroup& b) {
+        if (a.reclaimable() != b.reclaimable()) {
+            return a.reclaimable() > b.reclaimable();
+        }
+        return a.copies.front().paths < b.copies.front().paths;
+    });
+    report.stats = progress();
+    return report;
+}
+
+void DuplicateFinder::cancel() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (search) {
+        search->cancelled = true;
+        if (search->walk.valid()) {
+            search->walk.cancel();
+        }
+    }
+}
+
+DuplicateStats DuplicateFinder::progress() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    DuplicateStats stats;
+    if (search) {
+        stats.directories = search->walk.valid() ? search->walk.progress().directories : 0;
+        stats.files = search->files.value();
+        stats.hardLinks = search->hardLinks.value();
+        stats.partialHashes = search->partialHashes.value();
+        stats.fullHashes = search->fullHashes.value();
+        stats.bytesRead = search->bytesRead.value();
+        stats.errors = search->errors.value();
+        stats.cancelled = search->cancelled.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+} // namespace ffe
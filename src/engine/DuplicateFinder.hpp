@@ -0,0 +1,98 @@
+#pragma once
+
+#include "engine/DirEntry.hpp"
+#include "engine/Executor.hpp"
+#include "engine/TreeWalker.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ffe {
+
+struct DuplicateOptions {
+    std::uint64_t minSize = 1;          // Smaller files are not compared; empty ones are all alike
+    std::uint32_t partialBytes = 4096;  // Hashed at the head and at the tail of files sharing a size
+
+    // Optional filter deciding whether a file of dir is compared at all
+    std::function<bool(const fs::path& dir, const DirEntry& entry)> include;
+};
+
+// Files with the same contents. Hard links to one file are one copy with
+// several paths: deleting a name of theirs frees nothing.
+struct DuplicateGroup {
+    struct Copy {
+        std::vector<fs::path> paths; // Sorted; more than one for hard links
+    };
+
+    std::uint64_t size = 0;
+    std::uint64_t hash = 0; // Hash64 of the contents
+    std::vector<Copy> copies; // At least two, sorted by first path
+
+    // Bytes freed by keeping one copy only
+    std::uint64_t reclaimable() const noexcept {
+        return copies.empty() ? 0 : size * (copies.size() - 1);
+    }
+};
+
+// Counters for one search; a snapshot while running, final once complete
+struct DuplicateStats {
+    std::uint64_t directories = 0;   // Enumerated by the walk
+    std::uint64_t files = 0;         // Files the walk offered at minSize or larger
+    std::uint64_t hardLinks = 0;     // Further names of files already seen
+    std::uint64_t partialHashes = 0; // Files sharing their size with another, hashed at both ends
+    std::uint64_t fullHashes = 0;    // Files sharing size and ends with another, hashed whole
+    std::uint64_t bytesRead = 0;     // Read to hash, both stages together
+    std::uint64_t errors = 0;        // Directories and files that could not be read, or changed while read
+    bool cancelled = false;
+};
+
+struct DuplicateReport {
+    std::vector<DuplicateGroup> groups; // Most reclaimable first
+    std::uint64_t reclaimable = 0;      // Over all groups
+    DuplicateStats stats;
+};
+
+// Finds files with equal contents below a folder. Each stage only reads
+// what the one before could not tell apart:
+//
+//   1. the walk groups files by size, which costs nothing past the stat;
+//   2. files sharing a size are hashed over their first and last
+//      partialBytes, which tells most of them apart in two small reads;
+//   3. files still alike are hashed whole, sequentially.
+//
+// The stages overlap on the executor: a file is queued for the next stage
+// as soon as a second one joins its group, while the walk is still going.
+// Files small enough for stage 2 to read whole skip stage 3. Hard links are
+// recognized by FileIdentity and read once.
+class DuplicateFinder {
+public:
+    DuplicateFinder(Executor& executor, DuplicateOptions options = {});
+    ~DuplicateFinder();
+
+    DuplicateFinder(const DuplicateFinder&) = delete;
+    DuplicateFinder& operator=(const DuplicateFinder&) = delete;
+
+    // Blocks until every stage has finished, so it must not be called from
+    // one of the executor's workers. One search at a time.
+    DuplicateReport find(const fs::path& root);
+
+    // Stops the search in progress; find() returns what was confirmed so far
+    void cancel();
+
+    DuplicateStats progress() const;
+
+private:
+    struct Search;
+
+    Executor& executor;
+    DuplicateOptions options;
+    mutable std::mutex mutex; // Guards search
+    std::shared_ptr<Search> search;
+};
+
+} // namespace ffe
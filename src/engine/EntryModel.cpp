@@ -0,0 +1,104 @@
+#include "engine/EntryModel.hpp"
+
+#include <limits>
+
+namespace ffe {
+
+void EntryModel::clear() noexcept {
+    records.clear();
+    tags.clear();
+    names.clear();
+    folders.clear();
+    lastFolder.clear();
+    lastFolderHandle = NoDirectory;
+}
+
+void EntryModel::reserve(std::size_t rows, std::size_t nameUnits) {
+    records.reserve(rows);
+    names.reserve(nameUnits);
+}
+
+PathStore::Handle EntryModel::addDirectory(const fs::path& dir) {
+    return folders.intern(dir);
+}
+
+void EntryModel::append(PathStore::Handle directory, const DirEntry& entry) {
+    const std::size_t length = std::min<std::size_t>(entry.name.size(), std::numeric_limits<std::uint16_t>::max());
+    records.push_back({names.size(), directory, static_cast<std::uint16_t>(length), entry.type, entry.hasStat, false,
+                       0, 0, entry.size, entry.mtime});
+    names.append(entry.name, 0, length);
+}
+
+void EntryModel::appendPath(const fs::path& path, EntryType type) {
+    const fs::path parent = path.parent_path();
+    if (lastFolderHandle == NoDirectory || parent.native() != lastFolder) {
+        lastFolderHandle = addDirectory(parent);
+        lastFolder = parent.native();
+    }
+
+    DirEntry entry;
+    entry.name = path.filename().native();
+    entry.type = type;
+    append(lastFolderHandle, entry);
+}
+
+EntryModel::Row EntryModel::toRow(const Record& record) const noexcept {
+    return {NameView(names).substr(record.nameOffset, record.nameLength), record.directory, record.type, record.hasStat,
+            record.hasDetails, record.kind, record.attributes, record.size, record.mtime};
+}
+
+EntryModel::Row EntryModel::row(std::size_t index) const noexcept {
+    return toRow(records[index]);
+}
+
+fs::path EntryModel::path(std::size_t index) const {
+    const Row entry = row(index);
+    return folders.path(entry.directory) / fs::path(entry.name);
+}
+
+void EntryModel::setStat(std::size_t index, std::uint64_t size, std::int64_t mtime) noexcept {
+    Record& record = records[index];
+    record.size = size;
+    record.mtime = mtime;
+    record.hasStat = true;
+}
+
+void EntryModel::setDetails(std::size_t index, std::uint32_t attributes, std::uint16_t kind) noexcept {
+    Record& record = records[index];
+    record.attributes = attributes;
+    record.kind = kind;
+    record.hasDetails = true;
+}
+
+void EntryModel::setTag(std::size_t index, std::uint32_t tag) {
+    if (tags.size() < records.size()) {
+        tags.resize(records.size());
+    }
+    tags[index] = tag;
+}
+
+void EntryModel::reorder(std::span<const std::uint32_t> order) {
+    std::vector<Record> ordered;
+    ordered.reserve(records.size());
+    for (const std::uint32_t index : order) {
+        ordered.push_back(records[index]);
+    }
+    records.swap(ordered);
+
+    if (!tags.empty()) {
+        tags.resize(records.size());
+        std::vector<std::uint32_t> orderedTags;
+        orderedTags.reserve(tags.size());
+        for (const std::uint32_t index : order) {
+            orderedTags.push_back(tags[index]);
+        }
+        tags.swap(orderedTags);
+    }
+}
+
+std::size_t EntryModel::memoryUsage() const noexcept {
+    return records.capacity() * sizeof(Record) + tags.capacity() * sizeof(std::uint32_t) +
+           names.capacity() * sizeof(NativeChar) + folders.memoryUsage();
+}
+
+} // namespace ffe
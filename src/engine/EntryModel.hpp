@@ -0,0 +1,152 @@
+#pragma once
+
+#include "engine/DirEntry.hpp"
+#include "engine/PathStore.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace ffe {
+
+// Rows of a file list (a folder listing or search results) kept compactly
+// for a virtual list view: names live in one shared buffer, folders are
+// interned in a PathStore and referenced by handle, and a row costs 40
+// bytes plus its name. Nothing is formatted here; views ask for the rows
+// they show, by index, when they show them.
+//
+// Rows can start out with just a name and type, as enumeration or a search
+// produces them; size, attributes and a frontend-defined kind (say, an
+// index into a table of type names and icons) are filled in later.
+class EntryModel {
+public:
+    // Folder of rows that have none, such as the drives of This PC
+    static constexpr PathStore::Handle NoDirectory = PathStore::Empty;
+
+    // A row as handed to views; the views point into the model and stay
+    // valid until it is changed
+    struct Row {
+        NameView name;
+        PathStore::Handle directory; // Folder containing the entry, see directoryPath
+        EntryType type;
+        bool hasStat;       // size and mtime are valid
+        bool hasDetails;    // attributes and kind are valid
+        std::uint16_t kind;
+        std::uint32_t attributes;
+        std::uint64_t size;
+        std::int64_t mtime;
+
+        bool isDirectory() const noexcept {
+            return type == EntryType::Directory;
+        }
+    };
+
+    std::size_t size() const noexcept {
+        return records.size();
+    }
+
+    bool empty() const noexcept {
+        return records.empty();
+    }
+
+    void clear() noexcept;
+    void reserve(std::size_t rows, std::size_t nameUnits);
+
+    // Adds a folder that rows can refer to and returns its handle; adding
+    // the same folder again returns the same handle
+    PathStore::Handle addDirectory(const fs::path& dir);
+
+    // Appends entry, found in the folder with handle directory
+    void append(PathStore::Handle directory, const DirEntry& entry);
+
+    // Appends the entry at path; rows in the same folder share one copy of
+    // it, and folders share their common ancestors
+    void appendPath(const fs::path& path, EntryType type);
+
+    Row row(std::size_t index) const noexcept;
+
+    // Full path of a row
+    fs::path path(std::size_t index) const;
+
+    // Full path of a folder rows refer to
+    fs::path directoryPath(PathStore::Handle directory) const {
+        return folders.path(directory);
+    }
+
+    // Fills in size and mtime of a row that was appended without them
+    void setStat(std::size_t index, std::uint64_t size, std::int64_t mtime) noexcept;
+
+    // Fills in attributes and kind of a row
+    void setDetails(std::size_t index, std::uint32_t attributes, std::uint16_t kind) noexcept;
+
+    // A frontend-defined number attached to a row, such as an index into a
+    // table of what a content search found on it; 0 for rows without one.
+    // Tags are stored apart from the rows, only once one is set, and move
+    // with their rows when the model is reordered.
+    void setTag(std::size_t index, std::uint32_t tag);
+
+    std::uint32_t tag(std::size_t index) const noexcept {
+        return index < tags.size() ? tags[index] : 0;
+    }
+
+    // Bytes held for rows, names and folders
+    std::size_t memoryUsage() const noexcept;
+
+    // Calls visit(index, row) for the rows in [first, last), clamped to the
+    // model, as a view does for the range it is about to show
+    template<class Visit>
+    void forEachRow(std::size_t first, std::size_t last, Visit&& visit) const {
+        last = std::min(last, records.size());
+        for (std::size_t index = first; index < last; ++index) {
+            visit(index, row(index));
+        }
+    }
+
+    // Puts the rows in the given order: row i becomes the row that was at
+    // order[i]. order must be a permutation of the row indexes.
+    void reorder(std::span<const std::uint32_t> order);
+
+    // Reorders the rows; less compares two Rows
+    template<class Less>
+    void sort(Less&& less) {
+        std::vector<std::uint32_t> order(records.size());
+        for (std::uint32_t index = 0; index < order.size(); ++index) {
+            order[index] = index;
+        }
+        std::sort(order.begin(), order.end(), [this, &less](std::uint32_t a, std::uint32_t b) {
+            return less(toRow(records[a]), toRow(records[b]));
+        });
+        reorder(order);
+    }
+
+private:
+    struct Record {
+        std::uint64_t nameOffset;
+        PathStore::Handle directory;
+        std::uint16_t nameLength; // File names are at most 255 units on every supported file system
+        EntryType type;
+        bool hasStat;
+        bool hasDetails;
+        std::uint16_t kind;
+        std::uint32_t attributes;
+        std::uint64_t size;
+        std::int64_t mtime;
+    };
+    static_assert(sizeof(Record) == 40);
+
+    Row toRow(const Record& record) const noexcept;
+
+    std::vector<Record> records;
+    std::vector<std::uint32_t> tags; // Empty until a tag is set, then possibly shorter than records
+    fs::path::string_type names;
+    PathStore folders;
+
+    // Folder of the last appendPath, so runs of results from one folder skip
+    // interning
+    fs::path::string_type lastFolder;
+    PathStore::Handle lastFolderHandle = NoDirectory;
+};
+
+} // namespace ffe
@@ -0,0 +1,179 @@
+#include "engine/Executor.hpp"
+
+#include "engine/Trace.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <string>
+
+namespace ffe {
+
+namespace {
+
+// Identifies the executor (and slot) the current thread works for, so nested
+// submissions land on the worker's own deque without any lookup
+struct WorkerIdentity {
+    const Executor* owner = nullptr;
+    std::size_t index = Executor::NoWorker;
+};
+
+thread_local WorkerIdentity t_worker;
+
+} // namespace
+
+void Executor::TaskDeque::pushBack(Task task) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (count == ring.size()) {
+        // Grow by unrolling the ring into a buffer twice the size
+        std::vector<Task> grown(ring.size() * 2);
+        for (std::size_t i = 0; i < count; ++i) {
+            grown[i] = std::move(ring[(head + i) & (ring.size() - 1)]);
+        }
+        ring = std::move(grown);
+        head = 0;
+    }
+    ring[(head + count) & (ring.size() - 1)] = std::move(task);
+    ++count;
+}
+
+bool Executor::TaskDeque::popBack(Task& task) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (count == 0) {
+        return false;
+    }
+    --count;
+    task = std::move(ring[(head + count) & (ring.size() - 1)]);
+    return true;
+}
+
+bool Executor::TaskDeque::popFront(Task& task) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (count == 0) {
+        return false;
+    }
+    task = std::move(ring[head]);
+    head = (head + 1) & (ring.size() - 1);
+    --count;
+    return true;
+}
+
+std::size_t Executor::DefaultThreadCount() {
+    return std::max<std::size_t>(1, std::thread::hardware_concurrency());
+}
+
+Executor::Executor(std::size_t threads) {
+    threads = std::max<std::size_t>(1, threads);
+    workers.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    // Start threads only once every deque exists, since workers steal from all of them
+    for (std::size_t i = 0; i < threads; ++i) {
+        workers[i]->thread = std::thread([this, i] { workerLoop(i); });
+    }
+}
+
+Executor::~Executor() {
+    stopping.store(true);
+    epoch.fetch_add(1);
+    epoch.notify_all();
+    for (auto& worker : workers) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+}
+
+std::size_t Executor::currentWorker() const noexcept {
+    return t_worker.owner == this ? t_worker.index : NoWorker;
+}
+
+bool Executor::InWorker() noexcept {
+    return t_worker.owner != nullptr;
+}
+
+void Executor::submit(Task task) {
+    if (!task) {
+        return;
+    }
+
+    queued.fetch_add(1, std::memory_order_relaxed);
+    std::size_t index = currentWorker();
+    if (index != NoWorker) {
+        workers[index]->tasks.pushBack(std::move(task));
+    } else {
+        injected.pushBack(std::move(task));
+    }
+    wakeOne();
+}
+
+void Executor::wakeOne() {
+    // Bumping the epoch makes a worker that is about to park notice the new
+    // task; the notify is only needed when someone is already parked
+    epoch.fetch_add(1);
+    if (sleepers.load() > 0) {
+        epoch.notify_one();
+    }
+}
+
+bool Executor::findTask(std::size_t index, Task& task) {
+    if (workers[index]->tasks.popBack(task)) {
+        return true;
+    }
+    if (injected.popFront(task)) {
+        return true;
+    }
+
+    // Steal, starting with the next worker so thieves spread over victims
+    const std::size_t count = workers.size();
+    for (std::size_t offset = 1; offset < count; ++offset) {
+        if (workers[(index + offset) % count]->tasks.popFront(task)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Executor::run(Task& task) noexcept {
+    queued.fetch_sub(1, std::memory_order_relaxed);
+    try {
+        if (!discarding.load(std::memory_order_relaxed)) {
+            task();
+        }
+    }
+    catch (...) {
+        // A failing task must not take the worker thread down with it
+        failed.fetch_add(1, std::memory_order_relaxed);
+    }
+    task.reset();
+}
+
+void Executor::workerLoop(std::size_t index) {
+    t_worker = {this, index};
+    Trace::SetThreadName("worker " + std::to_string(index));
+
+    Task task;
+    while (true) {
+        if (findTask(index, task)) {
+            run(task);
+            continue;
+        }
+
+        // Read the epoch before the final scan: a submission racing with the
+        // scan changes it, and the wait below then returns immediately
+        const std::uint32_t observed = epoch.load();
+        if (findTask(index, task)) {
+            run(task);
+            continue;
+        }
+        if (stopping.load()) {
+            return;
+        }
+
+        sleepers.fetch_add(1);
+        epoch.wait(observed);
+        sleepers.fetch_sub(1);
+    }
+}
+
+} // namespace ffe
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "engine/Task.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ffe {
+
+// Work-stealing executor used by every parallel operation in the explorer.
+//
+// Each worker owns a deque: tasks submitted from a worker go to the back of
+// its own deque and are popped LIFO (the subdirectory just discovered is the
+// one whose entries are hot in cache), while idle workers steal FIFO from the
+// front of other deques. Tasks submitted from outside the pool go through a
+// shared injection queue. Idle workers park on an atomic epoch instead of
+// polling, and submissions only wake a worker when one is actually parked.
+//
+// Whatever a task throws is swallowed and counted in failedTasks(); tasks
+// that others wait on must report their own failures.
+class Executor {
+public:
+    static constexpr std::size_t NoWorker = static_cast<std::size_t>(-1);
+
+    explicit Executor(std::size_t threads = DefaultThreadCount());
+
+    // Runs every task that is still queued, unless discardQueued() was
+    // called, then joins the workers
+    ~Executor();
+
+    Executor(const Executor&) = delete;
+    Executor& operator=(const Executor&) = delete;
+
+    void submit(Task task);
+
+    template<class F>
+    void submit(F&& f) {
+        submit(Task(std::forward<F>(f)));
+    }
+
+    std::size_t threadCount() const noexcept {
+        return workers.size();
+    }
+
+    // Drops the tasks queued from now on instead of running them, so a
+    // shutdown does not wait for background work; tasks already running
+    // finish. Nothing waiting for a dropped task is woken, so call it only
+    // once nobody waits for the executor's work.
+    void discardQueued() noexcept {
+        discarding.store(true, std::memory_order_relaxed);
+    }
+
+    // Index of the calling thread within this executor, or NoWorker
+    std::size_t currentWorker() const noexcept;
+
+    // Whether the calling thread is a worker of any executor
+    static bool InWorker() noexcept;
+
+    // Tasks queued but not yet started, across all deques
+    std::size_t queuedTasks() const noexcept {
+        return queued.load(std::memory_order_relaxed);
+    }
+
+    // Tasks that ended with an exception
+    std::size_t failedTasks() const noexcept {
+        return failed.load(std::memory_order_relaxed);
+    }
+
+    static std::size_t DefaultThreadCount();
+
+private:
+    // Ring buffer of tasks guarded by its own lock. Only the owning worker
+    // pushes/pops at the back, so the lock is uncontended unless a thief is
+    // stealing from the front at the same moment.
+    class TaskDeque {
+    public:
+        void pushBack(Task task);
+        bool popBack(Task& task);
+        bool popFront(Task& task);
+
+    private:
+        std::mutex mutex;
+        std::vector<Task> ring = std::vector<Task>(64);
+        std::size_t head = 0;
+        std::size_t count = 0;
+    };
+
+    struct alignas(64) Worker {
+        TaskDeque tasks;
+        std::thread thread;
+    };
+
+    void workerLoop(std::size_t index);
+    bool findTask(std::size_t index, Task& task);
+    void run(Task& task) noexcept;
+    void wakeOne();
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    TaskDeque injected;
+
+    alignas(64) std::atomic<std::uint32_t> epoch{0};
+    std::atomic<std::size_t> sleepers{0};
+    std::atomic<std::size_t> queued{0};
+    std::atomic<std::size_t> failed{0};
+    std::atomic<bool> stopping{false};
+    std::atomic<bool> discarding{false};
+};
+
+} // namespace ffe
@@ -0,0 +1,453 @@
+#include "engine/FileIndex.hpp"
+
+#include "engine/DirectoryReader.hpp"
+#include "engine/TreeWalker.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <cwctype>
+#include <fstream>
+#include <unordered_map>
+
+namespace ffe {
+
+namespace {
+
+constexpr char INDEX_MAGIC[8] = {'F', 'F', 'E', 'I', 'N', 'D', 'E', 'X'};
+constexpr std::uint32_t INDEX_VERSION = 1;
+
+struct IndexHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t charSize;
+    std::uint64_t entryCount;
+    std::uint64_t nameChars;
+    std::uint64_t rootChars;
+    std::int64_t builtAt;
+    std::int64_t rootMtime;
+};
+
+// Byte offsets of the sections following the header, each 8-byte aligned
+struct IndexLayout {
+    std::size_t root;
+    std::size_t parents;
+    std::size_t firstChildren;
+    std::size_t nameOffsets;
+    std::size_t types;
+    std::size_t sizes;
+    std::size_t mtimes;
+    std::size_t names;
+    std::size_t total;
+};
+
+std::size_t AlignUp(std::size_t value) {
+    return (value + 7) & ~std::size_t(7);
+}
+
+IndexLayout ComputeLayout(const IndexHeader& header) {
+    const std::size_t n = header.entryCount;
+    IndexLayout layout = {};
+    layout.root = AlignUp(sizeof(IndexHeader));
+    layout.parents = AlignUp(layout.root + header.rootChars * sizeof(NativeChar));
+    layout.firstChildren = AlignUp(layout.parents + n * sizeof(std::uint32_t));
+    layout.nameOffsets = AlignUp(layout.firstChildren + n * sizeof(std::uint32_t));
+    layout.types = AlignUp(layout.nameOffsets + (n + 1) * sizeof(std::uint32_t));
+    layout.sizes = AlignUp(layout.types + n * sizeof(EntryType));
+    layout.mtimes = AlignUp(layout.sizes + n * sizeof(std::uint64_t));
+    layout.names = AlignUp(layout.mtimes + n * sizeof(std::int64_t));
+    layout.total = layout.names + header.nameChars * sizeof(NativeChar);
+    return layout;
+}
+
+// Names compare the way the platform's file system does
+bool SameName(NameView a, NameView b) {
+#ifdef _WIN32
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        if (a[i] != b[i] && std::towlower(a[i]) != std::towlower(b[i])) {
+            return false;
+        }
+    }
+    return true;
+#else
+    return a == b;
+#endif
+}
+
+std::int64_t NowUnixNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+std::int64_t RootMtime(const fs::path& root) {
+    std::error_code ec;
+    const auto mtime = fs::last_write_time(root, ec);
+    return ec ? 0 : ToUnixNanos(mtime);
+}
+
+template<class T>
+void WriteSection(std::ofstream& out, std::size_t offset, const T* data, std::size_t count) {
+    static constexpr char padding[8] = {};
+    const auto position = static_cast<std::size_t>(out.tellp());
+    out.write(padding, static_cast<std::streamsize>(offset - position));
+    out.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(count * sizeof(T)));
+}
+
+} // namespace
+
+std::uint32_t IndexData::add(std::uint32_t parent, NameView name, EntryType type,
+                             std::uint64_t size, std::int64_t mtime) {
+    const auto entry = static_cast<std::uint32_t>(parents.size());
+    parents.push_back(parent);
+    firstChildren.push_back(NoEntry);
+    types.push_back(type);
+    sizes.push_back(size);
+    mtimes.push_back(mtime);
+    names.insert(names.end(), name.begin(), name.end());
+    nameOffsets.push_back(static_cast<std::uint32_t>(names.size()));
+    return entry;
+}
+
+fs::path NormalizeRoot(const fs::path& path) {
+    std::error_code ec;
+    fs::path normal = fs::absolute(path, ec).lexically_normal();
+    if (ec) {
+        normal = path.lexically_normal();
+    }
+    // "C:\foo\" and "C:\foo" are the same root; "C:\" stays as it is
+    if (!normal.has_filename() && normal != normal.root_path()) {
+        normal = normal.parent_path();
+    }
+    return normal;
+}
+
+IndexData BuildIndex(const fs::path& root, Executor& executor) {
+    struct Chunk {
+        fs::path dir;
+        std::vector<DirEntry> entries;
+    };
+
+    IndexData data;
+    data.root = NormalizeRoot(root);
+    data.rootMtime = RootMtime(data.root);
+    data.builtAt = NowUnixNanos();
+
+    // Each worker appends to its own list, so the walk needs no lock
+    std::vector<std::vector<Chunk>> chunksByWorker(executor.threadCount());
+    TreeWalker walker(executor);
+    WalkOptions options;
+    options.stat = true;
+    walker.walk(data.root, [&chunksByWorker](const WalkDirectory& dir) {
+        Chunk& chunk = chunksByWorker[dir.worker].emplace_back();
+        chunk.dir = dir.path;
+        chunk.entries.assign(dir.entries.begin(), dir.entries.end());
+    }, options).wait();
+
+    std::unordered_map<fs::path::string_type, Chunk*> chunksByPath;
+    for (auto& chunks : chunksByWorker) {
+        for (Chunk& chunk : chunks) {
+            chunksByPath.emplace(chunk.dir.native(), &chunk);
+        }
+    }
+
+    // Lay the directories out depth-first, each directory's children contiguous
+    data.add(IndexData::NoEntry, {}, EntryType::Directory, 0, data.rootMtime);
+    std::vector<std::pair<const Chunk*, std::uint32_t>> pending;
+    if (auto it = chunksByPath.find(data.root.native()); it != chunksByPath.end()) {
+        pending.emplace_back(it->second, 0);
+    }
+
+    while (!pending.empty()) {
+        auto [chunk, directory] = pending.back();
+        pending.pop_back();
+
+        for (const DirEntry& entry : chunk->entries) {
+            const std::uint32_t index = data.add(directory, entry.name, entry.type, entry.size, entry.mtime);
+            if (data.firstChildren[directory] == IndexData::NoEntry) {
+                data.firstChildren[directory] = index;
+            }
+            if (entry.isDirectory()) {
+                auto it = chunksByPath.find((chunk->dir / entry.name).native());
+                if (it != chunksByPath.end()) {
+                    pending.emplace_back(it->second, index);
+                }
+            }
+        }
+    }
+    return data;
+}
+
+bool WriteIndex(const IndexData& data, const fs::path& file, std::error_code& ec) {
+    ec.clear();
+
+    IndexHeader header = {};
+    std::memcpy(header.magic, INDEX_MAGIC, sizeof(header.magic));
+    header.version = INDEX_VERSION;
+    header.charSize = sizeof(NativeChar);
+    header.entryCount = data.size();
+    header.nameChars = data.names.size();
+    header.rootChars = data.root.native().size();
+    header.builtAt = data.builtAt;
+    header.rootMtime = data.rootMtime;
+    const IndexLayout layout = ComputeLayout(header);
+
+    fs::create_directories(file.parent_path(), ec);
+    if (ec) {
+        return false;
+    }
+
+    fs::path temporary = file;
+    temporary += ".tmp";
+    // A failed write leaves no partial file behind
+    const auto fail = [&temporary, &ec](std::error_code error) {
+        ec = error;
+        std::error_code ignored;
+        fs::remove(temporary, ignored);
+        return false;
+    };
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            return fail(std::make_error_code(std::errc::permission_denied));
+        }
+
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        WriteSection(out, layout.root, data.root.native().data(), data.root.native().size());
+        WriteSection(out, layout.parents, data.parents.data(), data.parents.size());
+        WriteSection(out, layout.firstChildren, data.firstChildren.data(), data.firstChildren.size());
+        WriteSection(out, layout.nameOffsets, data.nameOffsets.data(), data.nameOffsets.size());
+        WriteSection(out, layout.types, data.types.data(), data.types.size());
+        WriteSection(out, layout.sizes, data.sizes.data(), data.sizes.size());
+        WriteSection(out, layout.mtimes, data.mtimes.data(), data.mtimes.size());
+        WriteSection(out, layout.names, data.names.data(), data.names.size());
+
+        if (!out.flush()) {
+            out.close();
+            return fail(std::make_error_code(std::errc::io_error));
+        }
+    }
+
+    std::error_code renameError;
+    fs::rename(temporary, file, renameError);
+    if (renameError) {
+        return fail(renameError);
+    }
+    return true;
+}
+
+bool IndexSnapshot::open(const fs::path& file, std::error_code& ec) {
+    close();
+    if (!mapping.open(file, ec)) {
+        return false;
+    }
+
+    const auto bytes = mapping.bytes();
+    IndexHeader header = {};
+    if (bytes.size() >= sizeof(header)) {
+        std::memcpy(&header, bytes.data(), sizeof(header));
+    }
+
+    // Counts are bounded by the file size before the layout is computed, so
+    // it cannot overflow
+    const std::size_t maxChars = bytes.size() / sizeof(NativeChar);
+    const bool valid = bytes.size() >= sizeof(header) &&
+                       std::memcmp(header.magic, INDEX_MAGIC, sizeof(header.magic)) == 0 &&
+                       header.version == INDEX_VERSION &&
+                       header.charSize == sizeof(NativeChar) &&
+                       header.entryCount > 0 && header.entryCount < IndexData::NoEntry &&
+                       header.nameChars <= maxChars && header.rootChars <= maxChars &&
+                       ComputeLayout(header).total <= bytes.size();
+    if (!valid) {
+        ec = std::make_error_code(std::errc::invalid_argument);
+        close();
+        return false;
+    }
+
+    const IndexLayout layout = ComputeLayout(header);
+    const std::byte* base = bytes.data();
+    count = static_cast<std::uint32_t>(header.entryCount);
+    built = header.builtAt;
+    rootMtime = header.rootMtime;
+    rootPath = fs::path::string_type(reinterpret_cast<const NativeChar*>(base + layout.root), header.rootChars);
+    parents = reinterpret_cast<const std::uint32_t*>(base + layout.parents);
+    firstChildren = reinterpret_cast<const std::uint32_t*>(base + layout.firstChildren);
+    nameOffsets = reinterpret_cast<const std::uint32_t*>(base + layout.nameOffsets);
+    types = reinterpret_cast<const EntryType*>(base + layout.types);
+    sizes = reinterpret_cast<const std::uint64_t*>(base + layout.sizes);
+    mtimes = reinterpret_cast<const std::int64_t*>(base + layout.mtimes);
+    names = reinterpret_cast<const NativeChar*>(base + layout.names);
+
+    if (!validate(header.nameChars)) {
+        ec = std::make_error_code(std::errc::invalid_argument);
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool IndexSnapshot::validate(std::uint64_t nameChars) const noexcept {
+    if (parents[0] != NoEntry || nameOffsets[0] != 0 || nameOffsets[count] != nameChars) {
+        return false;
+    }
+    for (std::uint32_t entry = 0; entry < count; ++entry) {
+        // Parents come first, so walking up always ends at the root;
+        // children come after their folder
+        if ((entry != 0 && parents[entry] >= entry) || nameOffsets[entry] > nameOffsets[entry + 1] ||
+            static_cast<std::uint8_t>(types[entry]) > static_cast<std::uint8_t>(EntryType::Other) ||
+            (firstChildren[entry] != NoEntry && (firstChildren[entry] <= entry || firstChildren[entry] >= count))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void IndexSnapshot::close() noexcept {
+    mapping.close();
+    rootPath.clear();
+    count = 0;
+}
+
+std::chrono::system_clock::time_point IndexSnapshot::builtAt() const {
+    return std::chrono::system_clock::time_point(
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(built)));
+}
+
+fs::path IndexSnapshot::path(std::uint32_t entry) const {
+    std::vector<NameView> components;
+    for (; entry != 0 && entry != NoEntry; entry = parents[entry]) {
+        components.push_back(name(entry));
+    }
+
+    fs::path result = rootPath;
+    for (auto it = components.rbegin(); it != components.rend(); ++it) {
+        result /= *it;
+    }
+    return result;
+}
+
+std::optional<std::uint32_t> IndexSnapshot::find(const fs::path& path) const {
+    const fs::path relative = NormalizeRoot(path).lexically_relative(rootPath);
+    if (relative.empty()) {
+        return std::nullopt;
+    }
+
+    std::uint32_t directory = 0;
+    for (const fs::path& component : relative) {
+        if (component == ".") {
+            continue;
+        }
+        if (component == "..") {
+            return std::nullopt;
+        }
+
+        std::uint32_t found = NoEntry;
+        for (std::uint32_t child = firstChildren[directory]; child != NoEntry && child < count &&
+             parents[child] == directory; ++child) {
+            if (SameName(name(child), component.native())) {
+                found = child;
+                break;
+            }
+        }
+        if (found == NoEntry) {
+            return std::nullopt;
+        }
+        directory = found;
+    }
+    return directory;
+}
+
+bool IndexSnapshot::isWithin(std::uint32_t entry, std::uint32_t ancestor) const noexcept {
+    for (entry = parents[entry]; entry != NoEntry; entry = parents[entry]) {
+        if (entry == ancestor) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool IndexSnapshot::isStale(std::chrono::seconds maxAge, std::uint32_t scope) const {
+    if (std::chrono::system_clock::now() - builtAt() > maxAge) {
+        return true;
+    }
+    if (RootMtime(rootPath) != rootMtime) {
+        return true;
+    }
+    return scope != 0 && scope < count && RootMtime(path(scope)) != mtimes[scope];
+}
+
+IndexData IndexSnapshot::toData() const {
+    IndexData data;
+    data.root = rootPath;
+    data.rootMtime = rootMtime;
+    data.builtAt = built;
+    data.parents.assign(parents, parents + count);
+    data.firstChildren.assign(firstChildren, firstChildren + count);
+    data.nameOffsets.assign(nameOffsets, nameOffsets + count + 1);
+    data.types.assign(types, types + count);
+    data.sizes.assign(sizes, sizes + count);
+    data.mtimes.assign(mtimes, mtimes + count);
+    data.names.assign(names, names + nameOffsets[count]);
+    return data;
+}
+
+fs::path IndexStore::DefaultDirectory() {
+#ifdef _WIN32
+    if (const wchar_t* localAppData = _wgetenv(L"LOCALAPPDATA")) {
+        return fs::path(localAppData) / L"FastFileExplorer" / L"Index";
+    }
+#else
+    if (const char* cache = std::getenv("XDG_CACHE_HOME"); cache && *cache) {
+        return fs::path(cache) / "fastfileexplorer" / "index";
+    }
+    if (const char* home = std::getenv("HOME"); home && *home) {
+        return fs::path(home) / ".cache" / "fastfileexplorer" / "index";
+    }
+#endif
+    return fs::temp_directory_path() / "fastfileexplorer-index";
+}
+
+fs::path IndexStore::fileFor(const fs::path& root) const {
+    // FNV-1a over the normalized root (case-folded where names are case-insensitive)
+    const fs::path normal = NormalizeRoot(root);
+    std::uint64_t hash = 14695981039346656037ull;
+    for (NativeChar c : normal.native()) {
+#ifdef _WIN32
+        c = static_cast<NativeChar>(std::towlower(c));
+#endif
+        hash = (hash ^ static_cast<std::uint64_t>(c)) * 1099511628211ull;
+    }
+
+    char name[32];
+    static constexpr char digits[] = "0123456789abcdef";
+    for (int i = 0; i < 16; ++i) {
+        name[i] = digits[(hash >> (60 - 4 * i)) & 0xF];
+    }
+    std::memcpy(name + 16, ".ffindex", 9);
+    return directory / name;
+}
+
+std::optional<std::size_t> IndexStore::build(const fs::path& root, Executor& executor, std::error_code& ec) const {
+    IndexData data = BuildIndex(root, executor);
+    if (!WriteIndex(data, fileFor(data.root), ec)) {
+        return std::nullopt;
+    }
+    return data.size();
+}
+
+bool IndexStore::openCovering(const fs::path& path, IndexSnapshot& snapshot) const {
+    for (fs::path candidate = NormalizeRoot(path);; candidate = candidate.parent_path()) {
+        std::error_code ec;
+        const fs::path file = fileFor(candidate);
+        if (fs::exists(file, ec) && snapshot.open(file, ec) && snapshot.find(path)) {
+            return true;
+        }
+        if (candidate == candidate.root_path() || !candidate.has_relative_path()) {
+            snapshot.close();
+            return false;
+        }
+    }
+}
+
+} // namespace ffe
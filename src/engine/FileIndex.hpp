@@ -0,0 +1,162 @@
+#pragma once
+
+#include "engine/DirEntry.hpp"
+#include "engine/Executor.hpp"
+#include "engine/MappedFile.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace ffe {
+
+// Snapshot of a directory tree: one record per entry, stored column-wise so
+// a name query only touches the name offsets and the name characters.
+// Entry 0 is the root itself (empty name). Children of a directory are
+// stored contiguously starting at firstChild.
+struct IndexData {
+    static constexpr std::uint32_t NoEntry = 0xFFFFFFFFu;
+
+    fs::path root;
+    std::int64_t rootMtime = 0; // Unix nanoseconds, see ToUnixNanos
+    std::int64_t builtAt = 0;   // Unix nanoseconds
+
+    std::vector<std::uint32_t> parents;
+    std::vector<std::uint32_t> firstChildren;
+    std::vector<std::uint32_t> nameOffsets{0}; // entryCount + 1 offsets into names
+    std::vector<EntryType> types;
+    std::vector<std::uint64_t> sizes;
+    std::vector<std::int64_t> mtimes;
+    std::vector<NativeChar> names;
+
+    std::size_t size() const noexcept {
+        return parents.size();
+    }
+
+    std::uint32_t add(std::uint32_t parent, NameView name, EntryType type, std::uint64_t size, std::int64_t mtime);
+};
+
+// Walks root in parallel and returns its snapshot
+IndexData BuildIndex(const fs::path& root, Executor& executor);
+
+// Writes the snapshot to file atomically (temporary file plus rename)
+bool WriteIndex(const IndexData& data, const fs::path& file, std::error_code& ec);
+
+// Read-only view of an index file, memory-mapped so opening and querying
+// cost no more than paging in the columns a query touches. Opening checks
+// every column once, so a corrupt or truncated file is refused rather than
+// read out of bounds.
+class IndexSnapshot {
+public:
+    static constexpr std::uint32_t NoEntry = IndexData::NoEntry;
+
+    bool open(const fs::path& file, std::error_code& ec);
+    void close() noexcept;
+
+    bool isOpen() const noexcept {
+        return mapping.isOpen() && count != 0;
+    }
+
+    std::uint32_t size() const noexcept {
+        return count;
+    }
+
+    const fs::path& root() const noexcept {
+        return rootPath;
+    }
+
+    std::chrono::system_clock::time_point builtAt() const;
+
+    NameView name(std::uint32_t entry) const noexcept {
+        return NameView(names + nameOffsets[entry], nameOffsets[entry + 1] - nameOffsets[entry]);
+    }
+
+    std::uint32_t parent(std::uint32_t entry) const noexcept {
+        return parents[entry];
+    }
+
+    EntryType type(std::uint32_t entry) const noexcept {
+        return types[entry];
+    }
+
+    std::uint64_t fileSize(std::uint32_t entry) const noexcept {
+        return sizes[entry];
+    }
+
+    std::int64_t mtime(std::uint32_t entry) const noexcept {
+        return mtimes[entry];
+    }
+
+    // Full path of an entry, rebuilt from the parent links
+    fs::path path(std::uint32_t entry) const;
+
+    // Entry for a path at or below the root, if the snapshot contains it
+    std::optional<std::uint32_t> find(const fs::path& path) const;
+
+    bool isWithin(std::uint32_t entry, std::uint32_t ancestor) const noexcept;
+
+    // A snapshot is stale once it is older than maxAge, or the root or the
+    // folder at entry scope changed since it was built. Changes deeper down
+    // are not seen, so without a LiveIndexer keeping the index current,
+    // results below scope may be up to maxAge old.
+    bool isStale(std::chrono::seconds maxAge, std::uint32_t scope = 0) const;
+
+    // Copies the mapped columns into a mutable snapshot
+    IndexData toData() const;
+
+    // Calls emit(entry) for every entry below (not including) scope whose
+    // name satisfies match(NameView)
+    template<class Match, class Emit>
+    void forEachMatch(std::uint32_t scope, Match&& match, Emit&& emit) const {
+        for (std::uint32_t entry = 1; entry < count; ++entry) {
+            if (match(name(entry)) && (scope == 0 || isWithin(entry, scope))) {
+                emit(entry);
+            }
+        }
+    }
+
+private:
+    // Whether the mapped columns link up: parents before children, names
+    // within the name characters
+    bool validate(std::uint64_t nameChars) const noexcept;
+
+    MappedFile mapping;
+    fs::path rootPath;
+    std::int64_t built = 0;
+    std::int64_t rootMtime = 0;
+    std::uint32_t count = 0;
+
+    const std::uint32_t* parents = nullptr;
+    const std::uint32_t* firstChildren = nullptr;
+    const std::uint32_t* nameOffsets = nullptr;
+    const EntryType* types = nullptr;
+    const std::uint64_t* sizes = nullptr;
+    const std::int64_t* mtimes = nullptr;
+    const NativeChar* names = nullptr;
+};
+
+// Per-root index files kept in a cache directory
+class IndexStore {
+public:
+    explicit IndexStore(fs::path directory = DefaultDirectory()) : directory(std::move(directory)) {}
+
+    // %LOCALAPPDATA%\FastFileExplorer\Index, or $XDG_CACHE_HOME/fastfileexplorer/index
+    static fs::path DefaultDirectory();
+
+    fs::path fileFor(const fs::path& root) const;
+
+    // Builds and saves the index of root; returns the number of entries
+    std::optional<std::size_t> build(const fs::path& root, Executor& executor, std::error_code& ec) const;
+
+    // Opens the index of path or of its closest indexed ancestor
+    bool openCovering(const fs::path& path, IndexSnapshot& snapshot) const;
+
+private:
+    fs::path directory;
+};
+
+// Absolute, lexically normal form used as the identity of an index root
+fs::path NormalizeRoot(const fs::path& path);
+
+} // namespace ffe
@@ -0,0 +1,367 @@
+#include "engine/FolderSizer.hpp"
+
+#include "engine/DirectoryReader.hpp"
+#include "engine/LruCache.hpp"
+#include "engine/ResultChannel.hpp"
+#include "engine/StatEngine.hpp"
+#include "engine/SubtreeWalk.hpp"
+#include "engine/Trace.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <iterator>
+#include <mutex>
+
+namespace ffe {
+
+namespace {
+
+// A file with several names, kept by identity so that it counts once in
+// every folder whose subtree holds one of its names
+struct LinkedFile {
+    std::uint64_t device;
+    std::uint64_t file;
+    std::uint64_t size;
+    std::uint64_t allocated;
+
+    bool operator<(const LinkedFile& other) const noexcept {
+        return device != other.device ? device < other.device : file < other.file;
+    }
+};
+
+// What one folder holds directly
+struct Listing {
+    std::int64_t mtime = 0; // Of the folder, taken before it was read
+    bool racy = false;      // Read within RacyWindow of mtime
+    FolderSize files;       // Its files with one name, and its subfolders
+    std::vector<LinkedFile> links; // Its files with several names, sorted
+    std::vector<fs::path::string_type> folders;
+
+    std::size_t bytes() const noexcept {
+        std::size_t total = sizeof(Listing) + links.size() * sizeof(LinkedFile);
+        for (const auto& name : folders) {
+            total += sizeof(name) + name.size() * sizeof(fs::path::value_type);
+        }
+        return total;
+    }
+};
+
+// What lies below a folder, added up while nothing below was seen to change
+struct Subtree {
+    std::int64_t mtime = 0; // Of the folder, taken before it was read
+    FolderSize size;        // Files with one name and folders below it
+    std::vector<LinkedFile> links;
+
+    std::size_t bytes() const noexcept {
+        return sizeof(Subtree) + links.size() * sizeof(LinkedFile);
+    }
+};
+
+// Adds the sorted links of from to the sorted links of into, once each
+void MergeLinks(std::vector<LinkedFile>& into, const std::vector<LinkedFile>& from) {
+    if (from.empty()) {
+        return;
+    }
+    std::vector<LinkedFile> merged;
+    merged.reserve(into.size() + from.size());
+    std::set_union(into.begin(), into.end(), from.begin(), from.end(), std::back_inserter(merged));
+    into.swap(merged);
+}
+
+// A folder being measured, and then everything below it
+struct Folder {
+    std::uint32_t id = 0;          // Of the request, for a requested folder
+    std::int64_t mtime = 0;
+    bool memoized = false;         // Its totals came from the cache
+    bool racy = false;             // It or a folder below was read within RacyWindow
+    FolderSize size;               // Files with one name, subfolders and errors so far
+    std::vector<LinkedFile> links; // Files with several names so far, sorted
+};
+
+// Reads what dir holds directly; null when it cannot be read
+std::shared_ptr<const Listing> ReadListing(const fs::path& dir, std::int64_t mtime, bool racy) {
+    TraceSpan span("FolderSizer::ReadListing");
+
+    // Entry buffers are reused across folders read by the same thread
+    thread_local std::vector<DirEntry> entries;
+    thread_local std::vector<FileIdentity> identities;
+    std::error_code ec;
+    if (!ReadDirectory(dir, entries, ec)) {
+        return nullptr;
+    }
+    identities.assign(entries.size(), FileIdentity{});
+    StatEntries(dir, entries, identities);
+    span.arg("entries", static_cast<std::int64_t>(entries.size()));
+
+    auto listing = std::make_shared<Listing>();
+    listing->mtime = mtime;
+    listing->racy = racy;
+    for (std::size_t index = 0; index < entries.size(); ++index) {
+        const DirEntry& entry = entries[index];
+        const FileIdentity& identity = identities[index];
+        if (entry.isDirectory()) {
+            listing->files.directories++;
+            listing->folders.push_back(entry.name);
+        } else if (entry.isFile() && entry.hasStat) {
+            // Without an identity the allocation is taken to be the size
+            const std::uint64_t allocated = identity.known() ? identity.allocated : entry.size;
+            if (identity.links > 1) {
+                listing->links.push_back({identity.device, identity.file, entry.size, allocated});
+            } else {
+                listing->files.bytes += entry.size;
+                listing->files.allocated += allocated;
+                listing->files.files++;
+            }
+        }
+    }
+    std::sort(listing->links.begin(), listing->links.end());
+    listing->links.erase(std::unique(listing->links.begin(), listing->links.end(),
+                                     [](const LinkedFile& a, const LinkedFile& b) {
+                                         return a.device == b.device && a.file == b.file;
+                                     }),
+                         listing->links.end());
+    return listing;
+}
+
+} // namespace
+
+// Listings and subtree totals by folder, each evicted least recently used
+// first past its share of capacityBytes
+struct FolderSizer::Cache {
+    explicit Cache(std::size_t capacityBytes)
+        : listings(capacityBytes - capacityBytes / 4), subtrees(capacityBytes / 4) {}
+
+    std::shared_ptr<const Listing> lookup(const fs::path& dir, std::int64_t mtime) {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto* listing = listings.find(dir.native());
+        if (!listing) {
+            return nullptr;
+        }
+        if ((*listing)->racy || (*listing)->mtime != mtime) {
+            listings.erase(dir.native());
+            return nullptr;
+        }
+        return *listing;
+    }
+
+    void insert(const fs::path& dir, std::shared_ptr<const Listing> listing) {
+        const std::size_t size = listing->bytes() + dir.native().size() * sizeof(fs::path::value_type);
+        std::lock_guard<std::mutex> lock(mutex);
+        listings.insert(dir.native(), std::move(listing), size);
+    }
+
+    std::shared_ptr<const Subtree> lookupSubtree(const fs::path& dir, std::int64_t mtime) {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto* subtree = subtrees.find(dir.native());
+        if (!subtree) {
+            return nullptr;
+        }
+        if ((*subtree)->mtime != mtime) {
+            subtrees.erase(dir.native());
+            return nullptr;
+        }
+        return *subtree;
+    }
+
+    void insertSubtree(const fs::path& dir, std::shared_ptr<const Subtree> subtree) {
+        const std::size_t size = subtree->bytes() + dir.native().size() * sizeof(fs::path::value_type);
+        std::lock_guard<std::mutex> lock(mutex);
+        subtrees.insert(dir.native(), std::move(subtree), size);
+    }
+
+    // Drops the totals of the folders above dir, which hold dir's old total
+    void invalidateAbove(const fs::path& dir) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (fs::path above = dir.parent_path(); !above.empty(); above = above.parent_path()) {
+            subtrees.erase(above.native());
+            if (above == above.parent_path()) {
+                break;
+            }
+        }
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        listings.clear();
+        subtrees.clear();
+    }
+
+    mutable std::mutex mutex;
+    LruCache<fs::path::string_type, std::shared_ptr<const Listing>> listings; // Costs are bytes
+    LruCache<fs::path::string_type, std::shared_ptr<const Subtree>> subtrees; // Costs are bytes
+    std::atomic<std::uint64_t> read{0};
+    std::atomic<std::uint64_t> reused{0};
+    std::atomic<std::uint64_t> subtreesReused{0};
+};
+
+// The requests of one measure() call. Running tasks keep their generation
+// alive, so a new one never waits for them.
+struct FolderSizer::Generation {
+    using Data = Folder;
+
+    Generation(Executor& executor, std::shared_ptr<Cache> cache, const std::function<void()>& onReady,
+               std::size_t requests)
+        : executor(executor), cache(std::move(cache)), remaining(requests),
+          results([this, onReady] {
+              if (onReady && !cancelled.load(std::memory_order_relaxed)) {
+                  onReady();
+              }
+          }) {}
+
+    Executor& executor;
+    const std::shared_ptr<Cache> cache;
+    std::atomic<bool> cancelled{false};
+
+    std::mutex mutex;
+    std::condition_variable finished;
+    std::size_t remaining; // Requests without a result yet
+
+    ResultChannel<FolderSizeResult> results;
+
+    void cancel() {
+        cancelled = true;
+        std::lock_guard<std::mutex> lock(mutex);
+        finished.notify_all();
+    }
+
+    void visit(const fs::path& dir, Folder& folder, std::vector<fs::path::string_type>& subfolders);
+    void finish(const fs::path& dir, Folder& folder, bool requested);
+
+    void merge(Folder& into, const Folder& from) {
+        into.size.add(from.size);
+        MergeLinks(into.links, from.links);
+        into.racy = into.racy || from.racy;
+    }
+
+    void failed(Folder& folder) {
+        folder.size.errors++;
+    }
+};
+
+FolderSizer::FolderSizer(Executor& executor, std::function<void()> onReady, std::size_t cacheBytes)
+    : executor(executor), onReady(std::move(onReady)), cache(std::make_shared<Cache>(cacheBytes)),
+      current(std::make_shared<Generation>(executor, cache, this->onReady, 0)) {
+}
+
+FolderSizer::~FolderSizer() {
+    current->cancel();
+}
+
+void FolderSizer::measure(std::vector<FolderSizeRequest> requests) {
+    current->cancel();
+    current = std::make_shared<Generation>(executor, cache, onReady, requests.size());
+    for (FolderSizeRequest& request : requests) {
+        Folder folder;
+        folder.id = request.id;
+        SubtreeWalk<Generation>::Start(current, std::move(request.path), std::move(folder));
+    }
+}
+
+void FolderSizer::cancel() {
+    current->cancel();
+    current = std::make_shared<Generation>(executor, cache, onReady, 0);
+}
+
+std::size_t FolderSizer::drain(std::vector<FolderSizeResult>& out) {
+    return current->results.drain(out);
+}
+
+void FolderSizer::wait() {
+    Generation& generation = *current;
+    std::unique_lock<std::mutex> lock(generation.mutex);
+    generation.finished.wait(lock, [&generation] {
+        return generation.remaining == 0 || generation.cancelled.load(std::memory_order_relaxed);
+    });
+}
+
+void FolderSizer::clear() {
+    cache->clear();
+}
+
+FolderSizer::Stats FolderSizer::stats() const {
+    Stats stats;
+    stats.listingsRead = cache->read.load(std::memory_order_relaxed);
+    stats.listingsReused = cache->reused.load(std::memory_order_relaxed);
+    stats.subtreesReused = cache->subtreesReused.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(cache->mutex);
+    stats.cached = cache->listings.size();
+    stats.cachedSubtrees = cache->subtrees.size();
+    stats.cachedBytes = cache->listings.cost() + cache->subtrees.cost();
+    return stats;
+}
+
+// Takes the folder's subtree total from the cache while its mtime is
+// unchanged; otherwise takes what it holds directly, from the cache on the
+// same terms, and names its subfolders
+void FolderSizer::Generation::visit(const fs::path& dir, Folder& folder,
+                                    std::vector<fs::path::string_type>& subfolders) {
+    std::error_code ec;
+    const auto now = fs::file_time_type::clock::now();
+    const auto modified = fs::last_write_time(dir, ec);
+    if (ec) {
+        folder.size.errors++;
+        return;
+    }
+    folder.mtime = ToUnixNanos(modified);
+    if (auto subtree = cache->lookupSubtree(dir, folder.mtime)) {
+        cache->subtreesReused.fetch_add(1, std::memory_order_relaxed);
+        folder.size = subtree->size;
+        folder.links = subtree->links;
+        folder.memoized = true;
+        return;
+    }
+
+    std::shared_ptr<const Listing> listing = cache->lookup(dir, folder.mtime);
+    if (listing) {
+        cache->reused.fetch_add(1, std::memory_order_relaxed);
+    } else if ((listing = ReadListing(dir, folder.mtime, now - modified < RacyWindow))) {
+        cache->read.fetch_add(1, std::memory_order_relaxed);
+        cache->insert(dir, listing);
+    } else {
+        folder.size.errors++;
+        return;
+    }
+
+    folder.size.add(listing->files);
+    folder.links = listing->links;
+    folder.racy = listing->racy;
+    subfolders = listing->folders;
+}
+
+// Keeps the folder's total for later, and publishes it for a requested one
+void FolderSizer::Generation::finish(const fs::path& dir, Folder& folder, bool requested) {
+    // A total may be reused once no folder below had an error or was racy
+    if (!folder.memoized && !folder.racy && folder.size.errors == 0) {
+        auto subtree = std::make_shared<Subtree>();
+        subtree->mtime = folder.mtime;
+        subtree->size = folder.size;
+        subtree->links = folder.links;
+        cache->insertSubtree(dir, std::move(subtree));
+    }
+    if (!requested) {
+        return;
+    }
+
+    // Whatever made the total be added up again may have changed the
+    // folders above too
+    if (!folder.memoized) {
+        cache->invalidateAbove(dir);
+    }
+
+    FolderSizeResult result{folder.id, folder.size};
+    for (const LinkedFile& link : folder.links) {
+        result.size.bytes += link.size;
+        result.size.allocated += link.allocated;
+        result.size.files++;
+    }
+    if (!cancelled.load(std::memory_order_relaxed)) {
+        results.publish({result});
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (--remaining == 0) {
+        finished.notify_all();
+    }
+}
+
+} // namespace ffe
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "engine/DirEntry.hpp"
+#include "engine/Executor.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace ffe {
+
+// Space taken below a folder. A file with several names below the folder
+// counts once.
+struct FolderSize {
+    std::uint64_t bytes = 0;       // Apparent: what the files hold
+    std::uint64_t allocated = 0;   // On disk: less for sparse and compressed files,
+                                   // more for the slack of the last cluster
+    std::uint64_t files = 0;
+    std::uint64_t directories = 0; // Below the folder, itself not included
+    std::uint64_t errors = 0;      // Folders that could not be read, left out of the sizes
+
+    void add(const FolderSize& other) noexcept {
+        bytes += other.bytes;
+        allocated += other.allocated;
+        files += other.files;
+        directories += other.directories;
+        errors += other.errors;
+    }
+};
+
+struct FolderSizeRequest {
+    std::uint32_t id; // Chosen by the caller, such as a row; given back with the result
+    fs::path path;
+};
+
+struct FolderSizeResult {
+    std::uint32_t id;
+    FolderSize size;
+};
+
+// Adds up what lies below folders in the background, in a SubtreeWalk: a
+// requested folder's result is published the moment its subtree is done,
+// so rows fill in smallest subtree first without waiting for the rest.
+//
+// What each folder holds directly (the sums of its files and the names of
+// its subfolders) is kept per folder and reused while the folder's mtime
+// is unchanged, the way ListingCache keeps listings. So is the total of
+// each folder's whole subtree, reused on the same terms without going
+// below the folder: measuring a folder again costs one stat, and measuring
+// the parent of folders measured before one stat per subfolder.
+//
+// A folder's mtime does not move when something deeper changes, so such a
+// change shows once the changed folder itself is measured, as a row of its
+// parent say; that drops the totals of every folder above it. Files that
+// change size in place show once their folder changes or the cache is
+// cleared.
+//
+// measure() starts a new generation like MetadataPipeline::reset(): the
+// results of earlier requests that have not finished are dropped, though
+// what their folders hold stays cached.
+class FolderSizer {
+public:
+    static constexpr std::size_t DefaultCacheBytes = 32u << 20;
+    static constexpr std::chrono::seconds RacyWindow{2};
+
+    struct Stats {
+        std::uint64_t listingsRead = 0;   // Folders read and their files stat'ed
+        std::uint64_t listingsReused = 0; // Folders answered from the cache after one stat
+        std::uint64_t subtreesReused = 0; // Subtrees answered from the cache after one stat
+        std::size_t cached = 0;           // Folders whose listing is in the cache
+        std::size_t cachedSubtrees = 0;   // Folders whose subtree total is in the cache
+        std::size_t cachedBytes = 0;
+    };
+
+    // onReady runs on a worker when results arrive after the last drain()
+    explicit FolderSizer(Executor& executor, std::function<void()> onReady = {},
+                         std::size_t cacheBytes = DefaultCacheBytes);
+    ~FolderSizer();
+
+    FolderSizer(const FolderSizer&) = delete;
+    FolderSizer& operator=(const FolderSizer&) = delete;
+
+    void measure(std::vector<FolderSizeRequest> requests);
+
+    // Drops the results of the current requests that are not published yet
+    void cancel();
+
+    // Appends the results published since the last call, returns the count
+    std::size_t drain(std::vector<FolderSizeResult>& out);
+
+    // Blocks until every current request has its result or they are
+    // cancelled; not to be called from one of the executor's workers
+    void wait();
+
+    // Forgets every cached folder and subtree total
+    void clear();
+
+    Stats stats() const;
+
+private:
+    struct Cache;
+    struct Generation;
+
+    Executor& executor;
+    std::function<void()> onReady;
+    std::shared_ptr<Cache> cache;
+    std::shared_ptr<Generation> current;
+};
+
+} // namespace ffe
@@ -0,0 +1,43 @@
+#include "engine/FramePacer.hpp"
+
+#include <algorithm>
+
+namespace ffe {
+
+namespace {
+
+// Weight of the newest measurement in the per-item cost average
+constexpr double CostSmoothing = 0.25;
+
+} // namespace
+
+FramePacer::FramePacer(Clock::duration frame, Clock::duration budget)
+    : frameLength(frame), budgetLength(std::min(budget, frame)) {}
+
+FramePacer::Clock::duration FramePacer::wait(Clock::time_point now) const noexcept {
+    return now >= nextStart ? Clock::duration::zero() : nextStart - now;
+}
+
+std::size_t FramePacer::itemBudget() const noexcept {
+    if (nanosPerItem <= 0) {
+        return InitialItems;
+    }
+    const double budgetNanos = static_cast<double>(std::chrono::nanoseconds(budgetLength).count());
+    return std::max(MinItems, static_cast<std::size_t>(budgetNanos / nanosPerItem));
+}
+
+void FramePacer::record(Clock::time_point start, Clock::time_point end, std::size_t items) noexcept {
+    if (items != 0 && end > start) {
+        const double cost =
+            static_cast<double>(std::chrono::nanoseconds(end - start).count()) / static_cast<double>(items);
+        nanosPerItem = nanosPerItem <= 0 ? cost : nanosPerItem + CostSmoothing * (cost - nanosPerItem);
+    }
+    nextStart = std::max(start + frameLength, end + (frameLength - budgetLength));
+}
+
+void FramePacer::reset() noexcept {
+    nextStart = {};
+    nanosPerItem = 0;
+}
+
+} // namespace ffe
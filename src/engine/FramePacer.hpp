@@ -0,0 +1,54 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+namespace ffe {
+
+// Paces incremental view refreshes to a frame budget instead of a result
+// count. At most one refresh starts per frame, a refresh handles only as
+// many items as fit in budget (estimated from the measured cost of earlier
+// refreshes), and after a refresh that overran the thread still gets
+// frame - budget to itself for input and painting.
+//
+// All times are passed in, so the pacing decisions can be replayed
+// against a simulated clock.
+class FramePacer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr std::size_t InitialItems = 256; // Budget before any refresh was measured
+    static constexpr std::size_t MinItems = 16;      // Always make some progress
+
+    explicit FramePacer(Clock::duration frame = std::chrono::milliseconds(16),
+                        Clock::duration budget = std::chrono::milliseconds(8));
+
+    // Time to wait before the next refresh may start; zero when it may
+    // start now
+    Clock::duration wait(Clock::time_point now) const noexcept;
+
+    // Items a refresh should handle to stay within the budget
+    std::size_t itemBudget() const noexcept;
+
+    // Records a refresh that ran from start to end and handled items items
+    void record(Clock::time_point start, Clock::time_point end, std::size_t items) noexcept;
+
+    // Forgets the measurements, for a new stream of results
+    void reset() noexcept;
+
+    Clock::duration frame() const noexcept {
+        return frameLength;
+    }
+
+    Clock::duration budget() const noexcept {
+        return budgetLength;
+    }
+
+private:
+    Clock::duration frameLength;
+    Clock::duration budgetLength;
+    Clock::time_point nextStart{};
+    double nanosPerItem = 0; // Moving average, 0 until measured
+};
+
+} // namespace ffe
@@ -0,0 +1,222 @@
+#include "engine/FuzzyMatcher.hpp"
+
+#include "engine/NameMatcherKernels.hpp"
+#include "engine/Unicode.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace ffe {
+
+namespace {
+
+// Scores follow fzf: a matched character is worth ScoreMatch plus the bonus
+// of its position, the first pattern character counts its bonus twice, and a
+// gap costs GapStart for its first skipped character and GapExtension for
+// every further one
+constexpr std::int32_t ScoreMatch = 16;
+constexpr std::int32_t GapStart = -3;
+constexpr std::int32_t GapExtension = -1;
+constexpr std::int32_t BonusBoundary = 8;
+constexpr std::int32_t BonusCamel = 7;
+constexpr std::int32_t BonusConsecutive = 4;
+constexpr std::int32_t FirstCharMultiplier = 2;
+constexpr std::int32_t NoScore = INT32_MIN / 4;
+
+// Names up to this many code units are scored without allocating
+constexpr std::size_t MaxStackName = 512;
+
+enum class CharClass : std::uint8_t {
+    Delimiter,
+    Lower,
+    Upper,
+    Digit,
+    Letter, // Non-ASCII without case, or already lower case
+    Other,
+};
+
+CharClass ClassOf(char32_t c) {
+    if (c >= 'a' && c <= 'z') {
+        return CharClass::Lower;
+    }
+    if (c >= 'A' && c <= 'Z') {
+        return CharClass::Upper;
+    }
+    if (c >= '0' && c <= '9') {
+        return CharClass::Digit;
+    }
+    switch (c) {
+    case ' ':
+    case '_':
+    case '-':
+    case '.':
+    case ',':
+    case '+':
+    case '(':
+    case ')':
+    case '[':
+    case ']':
+    case '/':
+    case '\\':
+        return CharClass::Delimiter;
+    default:
+        break;
+    }
+    if (c >= 0x80) {
+        return FoldCodePoint(c) != c ? CharClass::Upper : CharClass::Letter;
+    }
+    return CharClass::Other;
+}
+
+std::int32_t BonusAt(CharClass previous, CharClass current) {
+    if (current == CharClass::Delimiter) {
+        return 0;
+    }
+    if (previous == CharClass::Delimiter || previous == CharClass::Other) {
+        return BonusBoundary;
+    }
+    if ((previous == CharClass::Lower || previous == CharClass::Letter) && current == CharClass::Upper) {
+        return BonusCamel;
+    }
+    if (previous != CharClass::Digit && current == CharClass::Digit) {
+        return BonusCamel;
+    }
+    return 0;
+}
+
+// Decodes and folds name into folded, with the bonus of each position;
+// both must hold name.size() entries. Returns the number of code points.
+std::size_t Prepare(NameView name, char32_t* folded, std::int8_t* bonus) {
+    std::size_t count = 0;
+    CharClass previous = CharClass::Delimiter;
+    for (std::size_t i = 0; i < name.size(); ++count) {
+        const char32_t c = DecodeNext(name, i);
+        const CharClass current = ClassOf(c);
+        folded[count] = FoldCodePoint(c);
+        bonus[count] = static_cast<std::int8_t>(BonusAt(previous, current));
+        previous = current;
+    }
+    return count;
+}
+
+// Best alignment of pattern in folded, by dynamic programming over pattern
+// characters (rows) and name positions (columns). row[j] is the best score
+// of the pattern prefix so far with its last character at j. Gaps are
+// affine, so the best predecessor across a gap is carried along each row.
+std::int32_t Align(const std::u32string& pattern, const char32_t* folded, const std::int8_t* bonus,
+                   std::size_t count, std::int32_t* previous, std::int32_t* row) {
+    for (std::size_t i = 0; i < pattern.size(); ++i) {
+        std::int32_t gap = NoScore;
+        for (std::size_t j = 0; j < count; ++j) {
+            if (i > 0 && j >= 2) {
+                gap = std::max(gap + GapExtension, previous[j - 2] + GapStart);
+            }
+            if (folded[j] != pattern[i]) {
+                row[j] = NoScore;
+                continue;
+            }
+
+            std::int32_t best;
+            if (i == 0) {
+                best = bonus[j] * FirstCharMultiplier;
+            } else {
+                const std::int32_t consecutive =
+                    j >= 1 ? previous[j - 1] + std::max<std::int32_t>(bonus[j], BonusConsecutive) : NoScore;
+                best = std::max(gap + bonus[j], consecutive);
+            }
+            row[j] = best <= NoScore / 2 ? NoScore : ScoreMatch + best;
+        }
+        std::swap(previous, row);
+    }
+    return *std::max_element(previous, previous + count);
+}
+
+} // namespace
+
+FuzzyMatcher::FuzzyMatcher(NameView pattern, NameMatcher::SimdLevel level)
+    : level(std::min(level, NameMatcher::BestSimdLevel())) {
+    for (std::size_t i = 0; i < pattern.size() && foldedPattern.size() < MaxPattern;) {
+        foldedPattern.push_back(FoldCodePoint(DecodeNext(pattern, i)));
+    }
+
+    asciiOnly = std::all_of(foldedPattern.begin(), foldedPattern.end(), [](char32_t c) { return c < 0x80; });
+    if (asciiOnly) {
+        asciiPattern.assign(foldedPattern.begin(), foldedPattern.end());
+    }
+}
+
+bool FuzzyMatcher::matches(NameView name) const noexcept {
+    if (foldedPattern.empty()) {
+        return true;
+    }
+    if (name.size() < foldedPattern.size()) {
+        return false;
+    }
+
+    if (asciiOnly) {
+        AsciiScan result;
+        switch (level) {
+#ifdef FFE_MATCHER_X86
+        case NameMatcher::SimdLevel::Avx2:
+            result = SubsequenceAsciiAvx2(name.data(), name.size(), asciiPattern.data(), asciiPattern.size());
+            break;
+        case NameMatcher::SimdLevel::Sse2:
+            result = SubsequenceAsciiSse2(name.data(), name.size(), asciiPattern.data(), asciiPattern.size());
+            break;
+#endif
+        default:
+            result = SubsequenceAsciiScalar(name.data(), name.size(), asciiPattern.data(), asciiPattern.size());
+            break;
+        }
+        if (result != AsciiScan::NonAscii) {
+            return result == AsciiScan::Match;
+        }
+    }
+
+    // Decode and fold one code point at a time, so no buffer is needed
+    std::size_t k = 0;
+    for (std::size_t i = 0; i < name.size() && k < foldedPattern.size();) {
+        if (FoldCodePoint(DecodeNext(name, i)) == foldedPattern[k]) {
+            ++k;
+        }
+    }
+    return k == foldedPattern.size();
+}
+
+std::optional<std::int32_t> FuzzyMatcher::score(NameView name, std::uint32_t depth) const noexcept {
+    const std::int32_t depthCost = static_cast<std::int32_t>(std::min<std::uint32_t>(depth, 1000)) * DepthPenalty;
+    if (foldedPattern.empty()) {
+        return -depthCost;
+    }
+    if (!matches(name)) {
+        return std::nullopt;
+    }
+
+    std::int32_t best = NoScore;
+    if (name.size() <= MaxStackName) {
+        char32_t folded[MaxStackName];
+        std::int8_t bonus[MaxStackName];
+        std::int32_t previous[MaxStackName];
+        std::int32_t row[MaxStackName];
+        const std::size_t count = Prepare(name, folded, bonus);
+        best = Align(foldedPattern, folded, bonus, count, previous, row);
+    } else {
+        try {
+            std::vector<char32_t> folded(name.size());
+            std::vector<std::int8_t> bonus(name.size());
+            std::vector<std::int32_t> previous(name.size());
+            std::vector<std::int32_t> row(name.size());
+            const std::size_t count = Prepare(name, folded.data(), bonus.data());
+            best = Align(foldedPattern, folded.data(), bonus.data(), count, previous.data(), row.data());
+        } catch (const std::bad_alloc&) {
+            return std::nullopt;
+        }
+    }
+
+    if (best <= NoScore / 2) {
+        return std::nullopt;
+    }
+    return best - depthCost;
+}
+
+} // namespace ffe
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "engine/NameMatcher.hpp"
+
+#include <optional>
+
+namespace ffe {
+
+// fzf-style fuzzy matching. A name matches when the pattern's characters
+// appear in it in order, ignoring case. Matching names are ranked by how
+// the characters line up: matches at word starts (after a delimiter, at a
+// camelCase hump or where digits begin) and runs of consecutive characters
+// score higher, gaps cost a little, and every directory level below the
+// search root costs DepthPenalty.
+//
+// The subsequence test runs first and is vectorized like NameMatcher; only
+// names that pass it are scored, which takes one pass per pattern character.
+class FuzzyMatcher {
+public:
+    static constexpr std::size_t MaxPattern = 64; // Longer patterns are cut off
+    static constexpr std::int32_t DepthPenalty = 2;
+
+    explicit FuzzyMatcher(NameView pattern,
+                          NameMatcher::SimdLevel level = NameMatcher::BestSimdLevel());
+
+    // Subsequence test only
+    bool matches(NameView name) const noexcept;
+
+    // Rank of name found depth levels below the search root, higher is
+    // better; nothing when name does not match
+    std::optional<std::int32_t> score(NameView name, std::uint32_t depth = 0) const noexcept;
+
+    bool empty() const noexcept {
+        return foldedPattern.empty();
+    }
+
+private:
+    std::u32string foldedPattern;
+    fs::path::string_type asciiPattern; // Folded code units, when foldedPattern is all ASCII
+    bool asciiOnly = true;
+    NameMatcher::SimdLevel level = NameMatcher::SimdLevel::Scalar;
+};
+
+} // namespace ffe
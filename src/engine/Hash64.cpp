@@ -0,0 +1,127 @@
+#include "engine/Hash64.hpp"
+
+#include <bit>
+#include <cstring>
+
+namespace ffe {
+
+namespace {
+
+constexpr std::uint64_t Prime1 = 0x9E3779B185EBCA87ull;
+constexpr std::uint64_t Prime2 = 0xC2B2AE3D27D4EB4Full;
+constexpr std::uint64_t Prime3 = 0x165667B19E3779F9ull;
+constexpr std::uint64_t Prime4 = 0x85EBCA77C2B2AE63ull;
+constexpr std::uint64_t Prime5 = 0x27D4EB2F165667C5ull;
+
+// Little-endian loads, as the reference reads input on every platform
+std::uint64_t Read64(const unsigned char* p) noexcept {
+    std::uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    if constexpr (std::endian::native == std::endian::big) {
+        value = std::byteswap(value);
+    }
+    return value;
+}
+
+std::uint32_t Read32(const unsigned char* p) noexcept {
+    std::uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    if constexpr (std::endian::native == std::endian::big) {
+        value = std::byteswap(value);
+    }
+    return value;
+}
+
+std::uint64_t Round(std::uint64_t lane, std::uint64_t input) noexcept {
+    lane += input * Prime2;
+    return std::rotl(lane, 31) * Prime1;
+}
+
+std::uint64_t MergeRound(std::uint64_t hash, std::uint64_t lane) noexcept {
+    hash ^= Round(0, lane);
+    return hash * Prime1 + Prime4;
+}
+
+// Feeds whole 32-byte stripes to the four lanes; returns where it stopped
+const unsigned char* Stripes(std::uint64_t (&lanes)[4], const unsigned char* p, const unsigned char* end) noexcept {
+    while (end - p >= 32) {
+        lanes[0] = Round(lanes[0], Read64(p));
+        lanes[1] = Round(lanes[1], Read64(p + 8));
+        lanes[2] = Round(lanes[2], Read64(p + 16));
+        lanes[3] = Round(lanes[3], Read64(p + 24));
+        p += 32;
+    }
+    return p;
+}
+
+} // namespace
+
+Hasher64::Hasher64(std::uint64_t seed) noexcept
+    : lanes{seed + Prime1 + Prime2, seed + Prime2, seed, seed - Prime1}, seed(seed) {
+}
+
+void Hasher64::update(const void* data, std::size_t size) noexcept {
+    auto p = static_cast<const unsigned char*>(data);
+    const unsigned char* const end = p + size;
+    total += size;
+
+    if (buffered + size < sizeof(buffer)) {
+        std::memcpy(buffer + buffered, p, size);
+        buffered += size;
+        return;
+    }
+    if (buffered > 0) {
+        const std::size_t fill = sizeof(buffer) - buffered;
+        std::memcpy(buffer + buffered, p, fill);
+        Stripes(lanes, buffer, buffer + sizeof(buffer));
+        p += fill;
+        buffered = 0;
+    }
+    p = Stripes(lanes, p, end);
+    buffered = static_cast<std::size_t>(end - p);
+    std::memcpy(buffer, p, buffered);
+}
+
+std::uint64_t Hasher64::digest() const noexcept {
+    std::uint64_t hash;
+    if (total >= 32) {
+        hash = std::rotl(lanes[0], 1) + std::rotl(lanes[1], 7) + std::rotl(lanes[2], 12) + std::rotl(lanes[3], 18);
+        for (std::uint64_t lane : lanes) {
+            hash = MergeRound(hash, lane);
+        }
+    } else {
+        hash = seed + Prime5;
+    }
+    hash += total;
+
+    const unsigned char* p = buffer;
+    const unsigned char* const end = buffer + buffered;
+    for (; end - p >= 8; p += 8) {
+        hash ^= Round(0, Read64(p));
+        hash = std::rotl(hash, 27) * Prime1 + Prime4;
+    }
+    if (end - p >= 4) {
+        hash ^= Read32(p) * Prime1;
+        hash = std::rotl(hash, 23) * Prime2 + Prime3;
+        p += 4;
+    }
+    for (; p < end; ++p) {
+        hash ^= *p * Prime5;
+        hash = std::rotl(hash, 11) * Prime1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= Prime2;
+    hash ^= hash >> 29;
+    hash *= Prime3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+std::uint64_t Hash64(const void* data, std::size_t size, std::uint64_t seed) noexcept {
+    Hasher64 hasher(seed);
+    hasher.update(data, size);
+    return hasher.digest();
+}
+
+} // namespace ffe
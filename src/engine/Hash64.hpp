@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+namespace ffe {
+
+// XXH64 of byte streams, for telling file contents apart: several GB/s per
+// core, so hashing runs at the speed of the disk rather than of the CPU.
+// Not cryptographic; equal hashes are taken as equal contents, which at 64
+// bits is safe against accident but not against crafted files. Output
+// matches the reference implementation for the same seed.
+class Hasher64 {
+public:
+    explicit Hasher64(std::uint64_t seed = 0) noexcept;
+
+    void update(const void* data, std::size_t size) noexcept;
+
+    void update(std::string_view bytes) noexcept {
+        update(bytes.data(), bytes.size());
+    }
+
+    // Hash of everything added so far; more can still be added after
+    std::uint64_t digest() const noexcept;
+
+private:
+    std::uint64_t lanes[4];
+    std::uint64_t seed;
+    std::uint64_t total = 0;
+    unsigned char buffer[32];
+    std::size_t buffered = 0;
+};
+
+// One-shot Hasher64
+std::uint64_t Hash64(const void* data, std::size_t size, std::uint64_t seed = 0) noexcept;
+
+inline std::uint64_t Hash64(std::string_view bytes, std::uint64_t seed = 0) noexcept {
+    return Hash64(bytes.data(), bytes.size(), seed);
+}
+
+} // namespace ffe
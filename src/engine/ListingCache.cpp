@@ -0,0 +1,128 @@
+#include "engine/ListingCache.hpp"
+
+#include "engine/DirectoryReader.hpp"
+#include "engine/StatEngine.hpp"
+#include "engine/Trace.hpp"
+
+#include <vector>
+
+namespace ffe {
+
+bool ListingCache::Fetch(const fs::path& dir, Fetched& fetched, std::error_code& ec) {
+    TraceSpan span("ListingCache::Fetch");
+    ec.clear();
+    fetched.dir = dir;
+    auto entries = std::make_shared<Listing>();
+    fetched.entries = entries;
+
+    const auto now = fs::file_time_type::clock::now();
+    const auto modified = fs::last_write_time(dir, ec);
+    if (ec) {
+        return false;
+    }
+    fetched.mtime = ToUnixNanos(modified);
+    fetched.racy = now - modified < RacyWindow;
+    if (!ReadDirectory(dir, *entries, ec)) {
+        return false;
+    }
+    // Listings are shown with sizes; where enumeration has none, batch them
+    StatEntries(dir, *entries);
+    span.arg("entries", static_cast<std::int64_t>(entries->size()));
+    return true;
+}
+
+std::shared_ptr<const ListingCache::Listing> ListingCache::read(const fs::path& dir, std::error_code& ec) {
+    ec.clear();
+    if (auto entries = lookup(dir)) {
+        return entries;
+    }
+
+    Fetched fetched;
+    if (!Fetch(dir, fetched, ec)) {
+        return fetched.entries;
+    }
+    auto entries = fetched.entries;
+    insert(std::move(fetched));
+    return entries;
+}
+
+std::shared_ptr<const ListingCache::Listing> ListingCache::lookup(const fs::path& dir) {
+    if (Cached* entry = cached.find(dir.native())) {
+        std::error_code ec;
+        const auto now = fs::file_time_type::clock::now();
+        const auto modified = fs::last_write_time(dir, ec);
+        bool valid = !ec && entry->mtime == ToUnixNanos(modified);
+        if (valid && entry->racy) {
+            valid = Unchanged(dir, *entry->entries);
+            if (valid) {
+                rechecks++;
+                // Changes after this check would move the mtime
+                entry->racy = now - modified < RacyWindow;
+            }
+        }
+        if (valid) {
+            hits++;
+            if (entry->prefetched) {
+                prefetchHits++;
+            }
+            return entry->entries;
+        }
+        stale++;
+        cached.erase(dir.native());
+    }
+    misses++;
+    return nullptr;
+}
+
+void ListingCache::insert(Fetched fetched, bool prefetched) {
+    const std::size_t size = ListingBytes(*fetched.entries);
+    Cached entry{std::move(fetched.entries), fetched.mtime, fetched.racy, prefetched};
+    if (cached.insert(fetched.dir.native(), std::move(entry), size) && prefetched) {
+        this->prefetched++;
+    }
+}
+
+bool ListingCache::contains(const fs::path& dir) const {
+    return cached.contains(dir.native());
+}
+
+void ListingCache::invalidate(const fs::path& dir) {
+    cached.erase(dir.native());
+}
+
+void ListingCache::clear() {
+    cached.clear();
+}
+
+ListingCache::Stats ListingCache::stats() const noexcept {
+    return {hits, misses, stale, cached.evictions(), cached.size(), cached.cost(), prefetched, prefetchHits, rechecks};
+}
+
+std::size_t ListingCache::ListingBytes(const Listing& entries) noexcept {
+    std::size_t size = sizeof(Cached) + entries.capacity() * sizeof(DirEntry);
+    for (const DirEntry& entry : entries) {
+        // Short names live inside the string itself
+        if (entry.name.capacity() > fs::path::string_type().capacity()) {
+            size += (entry.name.capacity() + 1) * sizeof(NativeChar);
+        }
+    }
+    return size;
+}
+
+bool ListingCache::Unchanged(const fs::path& dir, const Listing& entries) {
+    TraceSpan span("ListingCache::Unchanged");
+    std::vector<DirEntry> current;
+    std::error_code ec;
+    if (!ReadDirectory(dir, current, ec) || current.size() != entries.size()) {
+        return false;
+    }
+    // Enumeration order is stable while a folder is unchanged
+    for (std::size_t index = 0; index < current.size(); ++index) {
+        if (current[index].name != entries[index].name || current[index].type != entries[index].type) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace ffe
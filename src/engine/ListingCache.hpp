@@ -0,0 +1,108 @@
+#pragma once
+
+#include "engine/DirEntry.hpp"
+#include "engine/LruCache.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <system_error>
+#include <vector>
+
+namespace ffe {
+
+// Recently read directory listings, so going back to a folder shows it from
+// memory. A cached listing is used only while the folder's mtime is what it
+// was when the listing was read, which costs one stat instead of a full
+// enumeration; adding, removing or renaming an entry changes it. Changes to
+// the files themselves do not, so sizes and times of cached entries may lag
+// until their metadata is looked up again.
+//
+// A folder changed within RacyWindow before it was read may change again
+// without its mtime moving (FAT keeps two-second times), so such a listing
+// is kept but served only after reading the folder's names again, without
+// the stat calls of a full read; it counts as a hit when they are the same
+// and as stale otherwise. Once a check is made past the window the listing
+// is trusted like any other.
+//
+// Listings are evicted least recently used first once they hold more than
+// capacityBytes. Not thread safe.
+class ListingCache {
+public:
+    using Listing = std::vector<DirEntry>;
+
+    static constexpr std::size_t DefaultCapacityBytes = 64u << 20;
+    static constexpr std::chrono::seconds RacyWindow{2};
+
+    struct Stats {
+        std::size_t hits = 0;
+        std::size_t misses = 0; // Not cached, or cached and stale
+        std::size_t stale = 0;
+        std::size_t evictions = 0;
+        std::size_t listings = 0;
+        std::size_t bytes = 0;
+        std::size_t prefetched = 0;    // Listings inserted ahead of time
+        std::size_t prefetchHits = 0;  // Hits on them
+        std::size_t rechecks = 0;      // Hits that read a racy folder's names again
+    };
+
+    // A listing as read from disk, with what is needed to validate it later
+    struct Fetched {
+        fs::path dir;
+        std::shared_ptr<const Listing> entries;
+        std::int64_t mtime = 0; // Of dir, taken before it was read
+        bool racy = false;      // Read within RacyWindow of mtime
+    };
+
+    explicit ListingCache(std::size_t capacityBytes = DefaultCapacityBytes) : cached(capacityBytes) {}
+
+    // Reads dir for insert(); touches no cache, so any thread may call it.
+    // fetched.entries is never null; on error it holds the entries read
+    // before it.
+    static bool Fetch(const fs::path& dir, Fetched& fetched, std::error_code& ec);
+
+    // Listing of dir, from the cache when still valid and from Fetch
+    // otherwise. Never null; on error ec is set and the entries read before
+    // it are returned without being cached.
+    std::shared_ptr<const Listing> read(const fs::path& dir, std::error_code& ec);
+
+    // Cached listing of dir if it is still valid, null otherwise
+    std::shared_ptr<const Listing> lookup(const fs::path& dir);
+
+    // Caches a listing fetched elsewhere, say ahead of time; prefetched
+    // listings are counted apart so their hits can be told from the rest
+    void insert(Fetched fetched, bool prefetched = false);
+
+    bool contains(const fs::path& dir) const;
+
+    // Drops the listing of dir, for changes the mtime does not show
+    void invalidate(const fs::path& dir);
+    void clear();
+
+    Stats stats() const noexcept;
+
+    // Bytes a listing is counted as when cached
+    static std::size_t ListingBytes(const Listing& entries) noexcept;
+
+private:
+    struct Cached {
+        std::shared_ptr<const Listing> entries;
+        std::int64_t mtime;
+        bool racy;
+        bool prefetched;
+    };
+
+    // Whether dir still holds the names and types of a racy listing
+    static bool Unchanged(const fs::path& dir, const Listing& entries);
+
+    LruCache<fs::path::string_type, Cached> cached; // Costs are ListingBytes
+    std::size_t hits = 0;
+    std::size_t misses = 0;
+    std::size_t stale = 0;
+    std::size_t prefetched = 0;
+    std::size_t prefetchHits = 0;
+    std::size_t rechecks = 0;
+};
+
+} // namespace ffe
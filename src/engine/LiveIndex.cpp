@@ -0,0 +1,560 @@
+#include "engine/LiveIndex.hpp"
+
+#include "engine/DirectoryReader.hpp"
+
+#include <cwctype>
+
+namespace ffe {
+
+namespace {
+
+// Name hashing and equality follow the platform's file system: exact on
+// Linux, case-insensitive on Windows
+NativeChar FoldForLookup(NativeChar c) {
+#ifdef _WIN32
+    return static_cast<NativeChar>(std::towlower(c));
+#else
+    return c;
+#endif
+}
+
+std::size_t HashName(NameView name) {
+    std::uint64_t hash = 14695981039346656037ull;
+    for (NativeChar c : name) {
+        hash = (hash ^ static_cast<std::uint64_t>(FoldForLookup(c))) * 1099511628211ull;
+    }
+    return static_cast<std::size_t>(hash);
+}
+
+bool EqualNames(NameView a, NameView b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        if (a[i] != b[i] && FoldForLookup(a[i]) != FoldForLookup(b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+struct NameHash {
+    std::size_t operator()(NameView name) const noexcept {
+        return HashName(name);
+    }
+};
+
+struct NameEqual {
+    bool operator()(NameView a, NameView b) const noexcept {
+        return EqualNames(a, b);
+    }
+};
+
+std::int64_t DirectoryMtime(const fs::path& path) {
+    std::error_code ec;
+    const auto mtime = fs::last_write_time(path, ec);
+    return ec ? 0 : ToUnixNanos(mtime);
+}
+
+} // namespace
+
+std::size_t LiveIndex::ChildKeyHash::operator()(const ChildKey& key) const noexcept {
+    return HashName(key.name) ^ (static_cast<std::size_t>(key.parent) * 0x9E3779B97F4A7C15ull);
+}
+
+bool LiveIndex::ChildKeyEqual::operator()(const ChildKey& a, const ChildKey& b) const noexcept {
+    return a.parent == b.parent && EqualNames(a.name, b.name);
+}
+
+LiveIndex::LiveIndex(const IndexData& data) : rootPath(data.root) {
+    children.reserve(data.size());
+    for (std::size_t i = 0; i < data.size(); ++i) {
+        const NameView name(data.names.data() + data.nameOffsets[i], data.nameOffsets[i + 1] - data.nameOffsets[i]);
+        const std::uint32_t parent = i == 0 ? NoNode : data.parents[i];
+        addNode(parent, name, data.types[i], data.sizes[i], data.mtimes[i]);
+    }
+    if (nodes.empty()) {
+        addNode(NoNode, {}, EntryType::Directory, 0, DirectoryMtime(rootPath));
+    }
+}
+
+std::uint32_t LiveIndex::child(std::uint32_t parent, NameView name) const {
+    auto it = children.find(ChildKey{parent, name});
+    return it == children.end() ? NoNode : it->second;
+}
+
+std::uint32_t LiveIndex::addNode(std::uint32_t parent, NameView name, EntryType type,
+                                 std::uint64_t size, std::int64_t mtime) {
+    std::uint32_t id;
+    if (!freeNodes.empty()) {
+        id = freeNodes.back();
+        freeNodes.pop_back();
+        nodes[id] = Node{};
+    } else {
+        id = static_cast<std::uint32_t>(nodes.size());
+        nodes.emplace_back();
+    }
+
+    Node& node = nodes[id];
+    node.name.assign(name);
+    node.parent = parent;
+    node.type = type;
+    node.size = size;
+    node.mtime = mtime;
+
+    if (parent != NoNode) {
+        Node& owner = nodes[parent];
+        node.nextSibling = owner.firstChild;
+        if (owner.firstChild != NoNode) {
+            nodes[owner.firstChild].prevSibling = id;
+        }
+        owner.firstChild = id;
+        children.emplace(ChildKey{parent, node.name}, id);
+    }
+    return id;
+}
+
+void LiveIndex::removeNode(std::uint32_t id) {
+    if (id == 0 || id == NoNode) {
+        return;
+    }
+
+    // Unlink the subtree from its parent, then free it node by node
+    Node& node = nodes[id];
+    if (node.prevSibling != NoNode) {
+        nodes[node.prevSibling].nextSibling = node.nextSibling;
+    } else {
+        nodes[node.parent].firstChild = node.nextSibling;
+    }
+    if (node.nextSibling != NoNode) {
+        nodes[node.nextSibling].prevSibling = node.prevSibling;
+    }
+
+    std::vector<std::uint32_t> pending{id};
+    while (!pending.empty()) {
+        const std::uint32_t current = pending.back();
+        pending.pop_back();
+
+        Node& doomed = nodes[current];
+        for (std::uint32_t c = doomed.firstChild; c != NoNode; c = nodes[c].nextSibling) {
+            pending.push_back(c);
+        }
+        children.erase(ChildKey{doomed.parent, doomed.name});
+        doomed = Node{};
+        freeNodes.push_back(current);
+    }
+}
+
+fs::path LiveIndex::pathOf(std::uint32_t id) const {
+    std::vector<NameView> components;
+    for (; id != 0 && id != NoNode; id = nodes[id].parent) {
+        components.push_back(nodes[id].name);
+    }
+
+    fs::path result = rootPath;
+    for (auto it = components.rbegin(); it != components.rend(); ++it) {
+        result /= *it;
+    }
+    return result;
+}
+
+std::uint32_t LiveIndex::find(const fs::path& path) const {
+    const fs::path relative = NormalizeRoot(path).lexically_relative(rootPath);
+    if (relative.empty()) {
+        return NoNode;
+    }
+
+    std::uint32_t node = 0;
+    for (const fs::path& component : relative) {
+        if (component == ".") {
+            continue;
+        }
+        if (component == "..") {
+            return NoNode;
+        }
+        node = child(node, component.native());
+        if (node == NoNode) {
+            return NoNode;
+        }
+    }
+    return node;
+}
+
+void LiveIndex::graft(std::uint32_t parent, const IndexData& data) {
+    // BuildIndex stores every directory before its children, so parents are
+    // always mapped by the time their children are added
+    std::vector<std::uint32_t> ids(data.size(), NoNode);
+    ids[0] = parent;
+    nodes[parent].mtime = data.mtimes[0];
+    for (std::size_t i = 1; i < data.size(); ++i) {
+        const NameView name(data.names.data() + data.nameOffsets[i], data.nameOffsets[i + 1] - data.nameOffsets[i]);
+        ids[i] = addNode(ids[data.parents[i]], name, data.types[i], data.sizes[i], data.mtimes[i]);
+    }
+}
+
+void LiveIndex::addEntry(std::uint32_t parent, const fs::path& path, const DirEntry& entry, Executor& executor) {
+    const std::uint32_t id = addNode(parent, entry.name, entry.type, entry.size, entry.mtime);
+    if (entry.isDirectory()) {
+        graft(id, BuildIndex(path, executor));
+    }
+}
+
+void LiveIndex::refreshPath(const fs::path& path, Executor& executor) {
+    const fs::path normal = NormalizeRoot(path);
+    if (normal == rootPath) {
+        refreshDirectory(normal, executor);
+        return;
+    }
+    const fs::path relative = normal.lexically_relative(rootPath);
+    if (relative.empty() || *relative.begin() == "..") {
+        return;
+    }
+
+    std::error_code ec;
+    const fs::file_status status = fs::symlink_status(normal, ec);
+    std::uint32_t existing = find(normal);
+    if (ec || !fs::exists(status)) {
+        removeNode(existing);
+        return;
+    }
+
+    const fs::path parentPath = normal.parent_path();
+    const std::uint32_t parent = find(parentPath);
+    if (parent == NoNode) {
+        // The parent is new as well; indexing it picks this entry up
+        refreshPath(parentPath, executor);
+        return;
+    }
+
+    DirEntry entry;
+    entry.name = normal.filename().native();
+    entry.type = ToEntryType(status);
+    StatEntry(parentPath, entry);
+
+    if (existing != NoNode && nodes[existing].type != entry.type) {
+        removeNode(existing);
+        existing = NoNode;
+    }
+    if (existing == NoNode) {
+        addEntry(parent, normal, entry, executor);
+        return;
+    }
+    nodes[existing].size = entry.size;
+    nodes[existing].mtime = entry.mtime;
+}
+
+void LiveIndex::refreshDirectory(const fs::path& path, Executor& executor) {
+    const fs::path normal = NormalizeRoot(path);
+    const std::uint32_t dir = find(normal);
+    if (dir == NoNode || nodes[dir].type != EntryType::Directory) {
+        refreshPath(normal, executor);
+        return;
+    }
+
+    std::vector<DirEntry> entries;
+    std::error_code ec;
+    if (!ReadDirectory(normal, entries, ec) && entries.empty()) {
+        if (!fs::exists(normal, ec)) {
+            removeNode(dir);
+        }
+        return;
+    }
+
+    // Drop children that are no longer listed
+    std::unordered_set<NameView, NameHash, NameEqual> listed;
+    for (const DirEntry& entry : entries) {
+        listed.insert(entry.name);
+    }
+    std::vector<std::uint32_t> gone;
+    for (std::uint32_t c = nodes[dir].firstChild; c != NoNode; c = nodes[c].nextSibling) {
+        if (!listed.contains(nodes[c].name)) {
+            gone.push_back(c);
+        }
+    }
+    for (std::uint32_t c : gone) {
+        removeNode(c);
+    }
+
+    for (DirEntry& entry : entries) {
+        StatEntry(normal, entry);
+        std::uint32_t existing = child(dir, entry.name);
+        if (existing != NoNode && nodes[existing].type != entry.type) {
+            removeNode(existing);
+            existing = NoNode;
+        }
+        if (existing == NoNode) {
+            addEntry(dir, normal / entry.name, entry, executor);
+        } else {
+            nodes[existing].size = entry.size;
+            nodes[existing].mtime = entry.mtime;
+        }
+    }
+    nodes[dir].mtime = DirectoryMtime(normal);
+}
+
+std::size_t LiveIndex::revalidate(Executor& executor) {
+    // Collect first: re-listing reshapes the tree being iterated
+    std::vector<std::pair<fs::path, std::int64_t>> directories;
+    std::vector<std::pair<std::uint32_t, fs::path>> pending{{0, rootPath}};
+    while (!pending.empty()) {
+        auto [id, path] = std::move(pending.back());
+        pending.pop_back();
+        directories.emplace_back(path, nodes[id].mtime);
+        for (std::uint32_t c = nodes[id].firstChild; c != NoNode; c = nodes[c].nextSibling) {
+            if (nodes[c].type == EntryType::Directory) {
+                pending.emplace_back(c, path / nodes[c].name);
+            }
+        }
+    }
+
+    std::size_t relisted = 0;
+    for (const auto& [path, mtime] : directories) {
+        if (DirectoryMtime(path) != mtime) {
+            refreshDirectory(path, executor);
+            ++relisted;
+        }
+    }
+    return relisted;
+}
+
+IndexData LiveIndex::toData() const {
+    IndexData data;
+    data.root = rootPath;
+    data.rootMtime = DirectoryMtime(rootPath);
+    data.builtAt = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    data.add(IndexData::NoEntry, {}, EntryType::Directory, 0, nodes[0].mtime);
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> pending{{0, 0}};
+    while (!pending.empty()) {
+        auto [id, entry] = pending.back();
+        pending.pop_back();
+        for (std::uint32_t c = nodes[id].firstChild; c != NoNode; c = nodes[c].nextSibling) {
+            const Node& node = nodes[c];
+            const std::uint32_t index = data.add(entry, node.name, node.type, node.size, node.mtime);
+            if (data.firstChildren[entry] == IndexData::NoEntry) {
+                data.firstChildren[entry] = index;
+            }
+            if (node.type == EntryType::Directory) {
+                pending.emplace_back(c, index);
+            }
+        }
+    }
+    return data;
+}
+
+void ChangeCoalescer::add(std::span<const ChangeEvent> events) {
+    const auto now = std::chrono::steady_clock::now();
+    if (eventCount == 0) {
+        firstEvent = now;
+    }
+    lastEvent = now;
+    eventCount += events.size();
+
+    for (const ChangeEvent& event : events) {
+        if (event.kind == ChangeKind::Overflow) {
+            overflow = true;
+            continue;
+        }
+
+        DirectoryChanges& changes = byDirectory[event.path.parent_path().native()];
+        if (changes.relist) {
+            continue;
+        }
+        changes.names.insert(event.path.filename().native());
+        if (changes.names.size() > relistThreshold) {
+            changes.relist = true;
+            changes.names.clear();
+        }
+    }
+}
+
+std::chrono::steady_clock::time_point ChangeCoalescer::readyAt(std::chrono::milliseconds quiet,
+                                                               std::chrono::milliseconds maxDelay) const {
+    return std::min(lastEvent + quiet, firstEvent + maxDelay);
+}
+
+ChangeSet ChangeCoalescer::take() {
+    ChangeSet changes;
+    changes.overflow = overflow;
+    changes.events = eventCount;
+    changes.firstEvent = firstEvent;
+    for (auto& [directory, entry] : byDirectory) {
+        const fs::path parent(directory);
+        if (entry.relist) {
+            changes.directories.push_back(parent);
+            continue;
+        }
+        for (const auto& name : entry.names) {
+            changes.paths.push_back(parent / name);
+        }
+    }
+
+    byDirectory.clear();
+    overflow = false;
+    eventCount = 0;
+    return changes;
+}
+
+LiveIndexer::~LiveIndexer() {
+    stop();
+}
+
+bool LiveIndexer::start(const fs::path& root, bool rebuild, std::error_code& ec) {
+    stop();
+    rootPath = NormalizeRoot(root);
+
+    // Watch first, so nothing that changes while the index loads is missed
+    bool watching = watcher.start(rootPath, [this](std::vector<ChangeEvent>&& events) {
+        std::lock_guard<std::mutex> lock(mutex);
+        counters.events += events.size();
+        coalescer.add(events);
+        wake.notify_one();
+    }, ec);
+    if (!watching) {
+        return false;
+    }
+
+    std::unique_ptr<LiveIndex> loaded;
+    IndexSnapshot snapshot;
+    std::error_code openError;
+    if (!rebuild && snapshot.open(store.fileFor(rootPath), openError) && snapshot.root() == rootPath) {
+        // Catch up with whatever changed while nobody was watching
+        loaded = std::make_unique<LiveIndex>(snapshot.toData());
+        snapshot.close();
+        loaded->revalidate(executor);
+    } else {
+        loaded = std::make_unique<LiveIndex>(BuildIndex(rootPath, executor));
+    }
+
+    {
+        std::lock_guard<std::mutex> indexLock(indexMutex);
+        index = std::move(loaded);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = false;
+        dirty = true;
+        lastSave = {};
+        counters.entries = index->size();
+    }
+    thread = std::thread([this] { run(); });
+    return true;
+}
+
+void LiveIndexer::stop() {
+    watcher.stop();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (thread.joinable()) {
+        thread.join();
+    }
+
+    if (index) {
+        flush();
+        std::lock_guard<std::mutex> indexLock(indexMutex);
+        index.reset();
+    }
+}
+
+LiveIndexStats LiveIndexer::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return counters;
+}
+
+void LiveIndexer::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping) {
+        const auto now = std::chrono::steady_clock::now();
+        if (coalescer.pending()) {
+            const auto ready = coalescer.readyAt(QuietPeriod, MaxDelay);
+            if (now < ready) {
+                wake.wait_until(lock, ready);
+                continue;
+            }
+            ChangeSet changes = coalescer.take();
+            lock.unlock();
+            apply(std::move(changes));
+            lock.lock();
+        } else if (dirty) {
+            const auto due = lastSave + SaveInterval;
+            if (now < due) {
+                wake.wait_until(lock, due);
+                continue;
+            }
+            lock.unlock();
+            save();
+            lock.lock();
+        } else {
+            wake.wait(lock);
+        }
+    }
+}
+
+void LiveIndexer::apply(ChangeSet changes) {
+    const auto started = std::chrono::steady_clock::now();
+    std::size_t entries = 0;
+    {
+        std::lock_guard<std::mutex> indexLock(indexMutex);
+        if (changes.overflow) {
+            index->revalidate(executor);
+        }
+        for (const fs::path& directory : changes.directories) {
+            index->refreshDirectory(directory, executor);
+        }
+        for (const fs::path& path : changes.paths) {
+            index->refreshPath(path, executor);
+        }
+        entries = index->size();
+    }
+    const auto finished = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    counters.batches++;
+    counters.overflows += changes.overflow ? 1 : 0;
+    counters.entries = entries;
+    counters.lastApply = finished - started;
+    counters.lastLatency = finished - changes.firstEvent;
+    dirty = true;
+}
+
+void LiveIndexer::save() {
+    IndexData data;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        dirty = false;
+    }
+    {
+        std::lock_guard<std::mutex> indexLock(indexMutex);
+        data = index->toData();
+    }
+
+    std::error_code ec;
+    const bool saved = WriteIndex(data, store.fileFor(rootPath), ec);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    lastSave = std::chrono::steady_clock::now();
+    if (saved) {
+        counters.saves++;
+    } else {
+        // Retried after the next interval (the file may be mapped by a reader on Windows)
+        dirty = true;
+    }
+}
+
+void LiveIndexer::flush() {
+    ChangeSet changes;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        changes = coalescer.take();
+    }
+    if (!changes.empty()) {
+        apply(std::move(changes));
+    }
+    save();
+}
+
+} // namespace ffe
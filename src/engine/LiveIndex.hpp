@@ -0,0 +1,201 @@
+#pragma once
+
+#include "engine/ChangeWatcher.hpp"
+#include "engine/FileIndex.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace ffe {
+
+// Mutable form of an index snapshot that can be patched entry by entry.
+// Updates always re-read the disk for the paths they are given, so applying
+// the same change twice, or a change that was already undone, is harmless.
+class LiveIndex {
+public:
+    static constexpr std::uint32_t NoNode = IndexData::NoEntry;
+
+    explicit LiveIndex(const IndexData& data);
+
+    const fs::path& root() const noexcept {
+        return rootPath;
+    }
+
+    // Live entries, the root included
+    std::size_t size() const noexcept {
+        return nodes.size() - freeNodes.size();
+    }
+
+    std::uint32_t find(const fs::path& path) const;
+
+    // Adds, updates or removes the entry for path to match the disk. A new
+    // directory is indexed together with everything below it.
+    void refreshPath(const fs::path& path, Executor& executor);
+
+    // Reconciles the direct children of a directory with its listing
+    void refreshDirectory(const fs::path& path, Executor& executor);
+
+    // Recovers from lost notifications: re-lists every directory whose mtime
+    // no longer matches. Returns the number of directories re-listed.
+    std::size_t revalidate(Executor& executor);
+
+    // Compacted snapshot, ready for WriteIndex
+    IndexData toData() const;
+
+private:
+    struct Node {
+        fs::path::string_type name;
+        std::uint32_t parent = NoNode;
+        std::uint32_t firstChild = NoNode;
+        std::uint32_t nextSibling = NoNode;
+        std::uint32_t prevSibling = NoNode;
+        EntryType type = EntryType::Unknown;
+        std::uint64_t size = 0;
+        std::int64_t mtime = 0;
+    };
+
+    // Child lookup key; name points into the child's node, which never moves
+    struct ChildKey {
+        std::uint32_t parent;
+        NameView name;
+    };
+
+    struct ChildKeyHash {
+        std::size_t operator()(const ChildKey& key) const noexcept;
+    };
+
+    struct ChildKeyEqual {
+        bool operator()(const ChildKey& a, const ChildKey& b) const noexcept;
+    };
+
+    std::uint32_t child(std::uint32_t parent, NameView name) const;
+    std::uint32_t addNode(std::uint32_t parent, NameView name, EntryType type, std::uint64_t size, std::int64_t mtime);
+    void removeNode(std::uint32_t node);
+    void addEntry(std::uint32_t parent, const fs::path& path, const DirEntry& entry, Executor& executor);
+    void graft(std::uint32_t parent, const IndexData& data);
+    fs::path pathOf(std::uint32_t node) const;
+
+    fs::path rootPath;
+    std::deque<Node> nodes; // A deque so nodes (and their names) never relocate
+    std::vector<std::uint32_t> freeNodes;
+    std::unordered_map<ChildKey, std::uint32_t, ChildKeyHash, ChildKeyEqual> children;
+};
+
+// Changes folded together between two index updates
+struct ChangeSet {
+    std::vector<fs::path> paths;       // Entries to re-read
+    std::vector<fs::path> directories; // Directories to re-list as a whole
+    bool overflow = false;             // Notifications were lost, revalidate everything
+    std::size_t events = 0;            // Raw events folded into this set
+    std::chrono::steady_clock::time_point firstEvent;
+
+    bool empty() const noexcept {
+        return paths.empty() && directories.empty() && !overflow;
+    }
+};
+
+// Folds an event storm into a set of distinct paths. Repeated events for the
+// same path collapse into one, and once a single directory receives more
+// than relistThreshold distinct changes (an archive being extracted into it,
+// say) the whole directory is re-listed once instead.
+class ChangeCoalescer {
+public:
+    explicit ChangeCoalescer(std::size_t relistThreshold = 256) : relistThreshold(relistThreshold) {}
+
+    void add(std::span<const ChangeEvent> events);
+
+    bool pending() const noexcept {
+        return eventCount != 0;
+    }
+
+    // When the accumulated changes should be applied: after quiet without new
+    // events, but no later than maxDelay after the first one
+    std::chrono::steady_clock::time_point readyAt(std::chrono::milliseconds quiet,
+                                                  std::chrono::milliseconds maxDelay) const;
+
+    ChangeSet take();
+
+private:
+    struct DirectoryChanges {
+        std::unordered_set<fs::path::string_type> names;
+        bool relist = false;
+    };
+
+    std::size_t relistThreshold;
+    std::unordered_map<fs::path::string_type, DirectoryChanges> byDirectory;
+    bool overflow = false;
+    std::size_t eventCount = 0;
+    std::chrono::steady_clock::time_point firstEvent;
+    std::chrono::steady_clock::time_point lastEvent;
+};
+
+struct LiveIndexStats {
+    std::uint64_t events = 0;              // Notifications received
+    std::uint64_t batches = 0;             // Change sets applied
+    std::uint64_t overflows = 0;           // Change sets that needed a revalidation
+    std::uint64_t saves = 0;               // Snapshots written
+    std::size_t entries = 0;               // Current index size
+    std::chrono::nanoseconds lastApply{0}; // Time spent applying the last change set
+    std::chrono::nanoseconds lastLatency{0}; // First event of the last set until it was applied
+};
+
+// Keeps the persisted index of one root current: watches the root, folds
+// notifications, patches a LiveIndex and rewrites the snapshot file so
+// searches going through IndexStore see the changes.
+class LiveIndexer {
+public:
+    static constexpr auto QuietPeriod = std::chrono::milliseconds(100);
+    static constexpr auto MaxDelay = std::chrono::milliseconds(1000);
+    static constexpr auto SaveInterval = std::chrono::seconds(2);
+
+    LiveIndexer(IndexStore store, Executor& executor) : store(std::move(store)), executor(executor) {}
+    ~LiveIndexer();
+
+    LiveIndexer(const LiveIndexer&) = delete;
+    LiveIndexer& operator=(const LiveIndexer&) = delete;
+
+    // Starts watching root. The index is rebuilt when rebuild is set or no
+    // usable index exists; otherwise the stored one is loaded and revalidated.
+    bool start(const fs::path& root, bool rebuild, std::error_code& ec);
+    void stop();
+
+    const fs::path& root() const noexcept {
+        return rootPath;
+    }
+
+    LiveIndexStats stats() const;
+
+    // Applies every pending change and saves, without waiting for the quiet period
+    void flush();
+
+private:
+    void run();
+    void apply(ChangeSet changes);
+    void save();
+
+    IndexStore store;
+    Executor& executor;
+    fs::path rootPath;
+    ChangeWatcher watcher;
+
+    mutable std::mutex mutex; // Guards coalescer, stats and the flags below
+    std::condition_variable wake;
+    ChangeCoalescer coalescer;
+    LiveIndexStats counters;
+    bool stopping = false;
+    bool dirty = false;
+    std::chrono::steady_clock::time_point lastSave;
+
+    std::mutex indexMutex; // Guards index; held while a change set is applied
+    std::unique_ptr<LiveIndex> index;
+    std::thread thread;
+};
+
+} // namespace ffe
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace ffe {
+
+// Values by key, evicted least recently used first once their costs add up
+// to more than capacity. A cost is whatever the owner budgets: bytes held,
+// or 1 to bound the number of entries. Not thread safe; owners lock.
+template<class Key, class Value, class Hash = std::hash<Key>>
+class LruCache {
+public:
+    explicit LruCache(std::size_t capacity) : limit(capacity) {}
+
+    std::size_t capacity() const noexcept {
+        return limit;
+    }
+
+    std::size_t size() const noexcept {
+        return entries.size();
+    }
+
+    // Sum of the costs of the values held
+    std::size_t cost() const noexcept {
+        return total;
+    }
+
+    // Entries dropped to make room, not counting erase() and replacements
+    std::size_t evictions() const noexcept {
+        return evicted;
+    }
+
+    std::size_t bucketCount() const noexcept {
+        return entries.bucket_count();
+    }
+
+    bool contains(const Key& key) const {
+        return entries.contains(key);
+    }
+
+    // Value of key, made the most recently used; null when absent
+    Value* find(const Key& key) {
+        auto it = entries.find(key);
+        if (it == entries.end()) {
+            return nullptr;
+        }
+        recent.splice(recent.begin(), recent, it->second);
+        return &it->second->value;
+    }
+
+    // Stores value under key, replacing what was there, then evicts until
+    // the costs fit, passing each evicted key and value to dropped. A value
+    // costing more than capacity is not kept; returns whether it was.
+    template<class Dropped>
+    bool insert(Key key, Value value, std::size_t cost, Dropped&& dropped) {
+        erase(key);
+        if (cost > limit) {
+            return false;
+        }
+        recent.push_front({std::move(key), std::move(value), cost});
+        entries.emplace(recent.front().key, recent.begin());
+        total += cost;
+        while (total > limit) {
+            Entry& oldest = recent.back();
+            dropped(oldest.key, oldest.value);
+            remove(std::prev(recent.end()));
+            evicted++;
+        }
+        return true;
+    }
+
+    bool insert(Key key, Value value, std::size_t cost) {
+        return insert(std::move(key), std::move(value), cost, [](const Key&, Value&) {});
+    }
+
+    bool erase(const Key& key) {
+        auto it = entries.find(key);
+        if (it == entries.end()) {
+            return false;
+        }
+        remove(it->second);
+        return true;
+    }
+
+    void clear() noexcept {
+        entries.clear();
+        recent.clear();
+        total = 0;
+    }
+
+    // Calls visit(key, value) for every entry, most recently used first
+    template<class Visit>
+    void forEach(Visit&& visit) const {
+        for (const Entry& entry : recent) {
+            visit(entry.key, entry.value);
+        }
+    }
+
+private:
+    struct Entry {
+        Key key;
+        Value value;
+        std::size_t cost;
+    };
+
+    void remove(typename std::list<Entry>::iterator it) {
+        total -= it->cost;
+        entries.erase(it->key);
+        recent.erase(it);
+    }
+
+    const std::size_t limit;
+    std::list<Entry> recent; // Most recently used first
+    std::unordered_map<Key, typename std::list<Entry>::iterator, Hash> entries;
+    std::size_t total = 0;
+    std::size_t evicted = 0;
+};
+
+} // namespace ffe
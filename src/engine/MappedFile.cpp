@@ -0,0 +1,142 @@
+#include "engine/MappedFile.hpp"
+
+#include <cerrno>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ffe {
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data(std::exchange(other.data, nullptr)),
+      length(std::exchange(other.length, 0)),
+      opened(std::exchange(other.opened, false)) {
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        data = std::exchange(other.data, nullptr);
+        length = std::exchange(other.length, 0);
+        opened = std::exchange(other.opened, false);
+    }
+    return *this;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const fs::path& path, std::error_code& ec) {
+    close();
+    ec.clear();
+
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        ec.assign(static_cast<int>(GetLastError()), std::system_category());
+        return false;
+    }
+
+    LARGE_INTEGER fileSize = {};
+    if (!GetFileSizeEx(file, &fileSize)) {
+        ec.assign(static_cast<int>(GetLastError()), std::system_category());
+        CloseHandle(file);
+        return false;
+    }
+
+    if (fileSize.QuadPart > 0) {
+        // The view keeps the file referenced, so both handles can be closed right away
+        HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping) {
+            data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);
+        }
+        if (!data) {
+            ec.assign(static_cast<int>(GetLastError()), std::system_category());
+            CloseHandle(file);
+            return false;
+        }
+        length = static_cast<std::size_t>(fileSize.QuadPart);
+    }
+
+    CloseHandle(file);
+    opened = true;
+    return true;
+}
+
+void MappedFile::close() noexcept {
+    if (data) {
+        UnmapViewOfFile(data);
+    }
+    data = nullptr;
+    length = 0;
+    opened = false;
+}
+
+void MappedFile::adviseSequential() const noexcept {
+    // Views fault in clusters of pages; there is no per-view read-ahead hint
+}
+
+#else
+
+bool MappedFile::open(const fs::path& path, std::error_code& ec) {
+    close();
+    ec.clear();
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        ec.assign(errno, std::system_category());
+        return false;
+    }
+
+    struct stat st = {};
+    if (::fstat(fd, &st) != 0) {
+        ec.assign(errno, std::system_category());
+        ::close(fd);
+        return false;
+    }
+
+    if (st.st_size > 0) {
+        void* view = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        if (view == MAP_FAILED) {
+            ec.assign(errno, std::system_category());
+            ::close(fd);
+            return false;
+        }
+        data = view;
+        length = static_cast<std::size_t>(st.st_size);
+    }
+
+    ::close(fd);
+    opened = true;
+    return true;
+}
+
+void MappedFile::close() noexcept {
+    if (data) {
+        ::munmap(const_cast<void*>(data), length);
+    }
+    data = nullptr;
+    length = 0;
+    opened = false;
+}
+
+void MappedFile::adviseSequential() const noexcept {
+    if (data) {
+        ::madvise(const_cast<void*>(data), length, MADV_SEQUENTIAL);
+    }
+}
+
+#endif
+
+} // namespace ffe
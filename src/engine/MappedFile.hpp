@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+#include <system_error>
+
+namespace ffe {
+
+namespace fs = std::filesystem;
+
+// Read-only memory mapping of a whole file
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Maps path, replacing any current mapping. Empty files map to an empty span.
+    bool open(const fs::path& path, std::error_code& ec);
+    void close() noexcept;
+
+    // Hints that the mapping will be read once, front to back, so the
+    // system reads ahead further and can drop pages already read
+    void adviseSequential() const noexcept;
+
+    bool isOpen() const noexcept {
+        return opened;
+    }
+
+    std::span<const std::byte> bytes() const noexcept {
+        return {static_cast<const std::byte*>(data), length};
+    }
+
+    std::size_t size() const noexcept {
+        return length;
+    }
+
+private:
+    const void* data = nullptr;
+    std::size_t length = 0;
+    bool opened = false;
+};
+
+} // namespace ffe
@@ -0,0 +1,176 @@
+#include "engine/MetadataPipeline.hpp"
+
+#include "engine/DirectoryReader.hpp"
+#include "engine/ResultChannel.hpp"
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace ffe {
+
+bool FetchMetadata(const fs::path& path, EntryMetadata& metadata) {
+    std::error_code ec;
+    const fs::file_status status = fs::symlink_status(path, ec);
+    if (ec) {
+        return false;
+    }
+    metadata.type = ToEntryType(status);
+    metadata.attributes = static_cast<std::uint32_t>(status.permissions());
+
+    const auto mtime = fs::last_write_time(path, ec);
+    metadata.mtime = ec ? 0 : ToUnixNanos(mtime);
+    if (metadata.type == EntryType::File) {
+        metadata.size = fs::file_size(path, ec);
+        if (ec) {
+            metadata.size = 0;
+        }
+    }
+    return true;
+}
+
+// Everything belonging to one generation of requests. Running batches keep
+// their generation alive, so a reset never waits for them.
+struct MetadataPipeline::Generation {
+    enum class Slot : std::uint8_t {
+        Background,
+        Visible,
+        Taken,
+    };
+
+    Generation(Fetch fetch, std::function<void()> onReady)
+        : fetch(std::move(fetch)), results([this, onReady = std::move(onReady)] {
+              if (onReady && !cancelled.load(std::memory_order_relaxed)) {
+                  onReady();
+              }
+          }) {}
+
+    const Fetch fetch;
+    std::atomic<bool> cancelled{false};
+
+    std::mutex mutex;
+    std::deque<MetadataRequest> visible;
+    std::deque<MetadataRequest> background;
+    std::unordered_map<std::uint32_t, Slot> slots; // Every row requested in this generation
+    std::size_t running = 0;                       // Batch loops submitted and not finished
+
+    ResultChannel<EntryMetadata> results;
+};
+
+MetadataPipeline::MetadataPipeline(Executor& executor, Fetch fetch, std::function<void()> onReady,
+                                   std::size_t maxInFlight)
+    : executor(executor), fetch(std::move(fetch)), onReady(std::move(onReady)),
+      maxInFlight(maxInFlight != 0 ? maxInFlight : std::max<std::size_t>(1, executor.threadCount())),
+      current(std::make_shared<Generation>(this->fetch, this->onReady)) {}
+
+MetadataPipeline::~MetadataPipeline() {
+    current->cancelled = true;
+}
+
+void MetadataPipeline::reset() {
+    current->cancelled = true;
+    current = std::make_shared<Generation>(fetch, onReady);
+}
+
+void MetadataPipeline::prioritize(std::vector<MetadataRequest> requests) {
+    Generation& generation = *current;
+    {
+        std::lock_guard<std::mutex> lock(generation.mutex);
+
+        // What is left of the previous visible set is still wanted, just
+        // less than what is on screen now
+        while (!generation.visible.empty()) {
+            MetadataRequest& request = generation.visible.back();
+            auto& slot = generation.slots[request.row];
+            if (slot == Generation::Slot::Visible) {
+                slot = Generation::Slot::Background;
+                generation.background.push_front(std::move(request));
+            }
+            generation.visible.pop_back();
+        }
+
+        for (MetadataRequest& request : requests) {
+            auto [it, added] = generation.slots.try_emplace(request.row, Generation::Slot::Visible);
+            if (added || it->second == Generation::Slot::Background) {
+                // A stale copy left in the background queue is skipped when popped
+                it->second = Generation::Slot::Visible;
+                generation.visible.push_back(std::move(request));
+            }
+        }
+    }
+    start(current);
+}
+
+void MetadataPipeline::enqueue(std::vector<MetadataRequest> requests) {
+    Generation& generation = *current;
+    {
+        std::lock_guard<std::mutex> lock(generation.mutex);
+        for (MetadataRequest& request : requests) {
+            if (generation.slots.try_emplace(request.row, Generation::Slot::Background).second) {
+                generation.background.push_back(std::move(request));
+            }
+        }
+    }
+    start(current);
+}
+
+std::size_t MetadataPipeline::drain(std::vector<EntryMetadata>& out) {
+    return current->results.drain(out);
+}
+
+void MetadataPipeline::start(const std::shared_ptr<Generation>& generation) {
+    std::size_t loops;
+    {
+        std::lock_guard<std::mutex> lock(generation->mutex);
+        const std::size_t queued = generation->visible.size() + generation->background.size();
+        const std::size_t wanted = std::min(maxInFlight, (queued + BatchSize - 1) / BatchSize);
+        loops = wanted > generation->running ? wanted - generation->running : 0;
+        generation->running += loops;
+    }
+    for (std::size_t i = 0; i < loops; ++i) {
+        executor.submit([generation] { RunBatches(*generation); });
+    }
+}
+
+void MetadataPipeline::RunBatches(Generation& generation) {
+    std::vector<MetadataRequest> batch;
+    batch.reserve(BatchSize);
+    while (true) {
+        batch.clear();
+        {
+            std::lock_guard<std::mutex> lock(generation.mutex);
+            const auto take = [&](std::deque<MetadataRequest>& queue, Generation::Slot wanted) {
+                while (batch.size() < BatchSize && !queue.empty()) {
+                    auto& slot = generation.slots[queue.front().row];
+                    if (slot == wanted) {
+                        slot = Generation::Slot::Taken;
+                        batch.push_back(std::move(queue.front()));
+                    }
+                    queue.pop_front();
+                }
+            };
+            if (!generation.cancelled.load(std::memory_order_relaxed)) {
+                take(generation.visible, Generation::Slot::Visible);
+                take(generation.background, Generation::Slot::Background);
+            }
+            if (batch.empty()) {
+                generation.running--;
+                return;
+            }
+        }
+
+        ResultChannel<EntryMetadata>::Batch results(generation.results, BatchSize);
+        for (const MetadataRequest& request : batch) {
+            if (generation.cancelled.load(std::memory_order_relaxed)) {
+                break;
+            }
+            EntryMetadata metadata;
+            metadata.row = request.row;
+            metadata.found = generation.fetch(request.path, metadata);
+            results.add(std::move(metadata));
+        }
+    }
+}
+
+} // namespace ffe
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "engine/DirEntry.hpp"
+#include "engine/Executor.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace ffe {
+
+// Details of one list row, looked up in the background
+struct EntryMetadata {
+    std::uint32_t row = 0;
+    bool found = false; // False when the entry vanished or could not be read
+    EntryType type = EntryType::Unknown;
+    std::uint64_t size = 0;
+    std::int64_t mtime = 0;
+    std::uint32_t attributes = 0;     // FILE_ATTRIBUTE_* on Windows, permission bits elsewhere
+    fs::path::string_type typeName;   // Filled by fetchers that describe file types
+    std::int32_t icon = -1;           // Frontend image index, -1 when not looked up
+};
+
+struct MetadataRequest {
+    std::uint32_t row;
+    fs::path path;
+};
+
+// Portable fetcher: type, size, mtime and permissions from the file system
+bool FetchMetadata(const fs::path& path, EntryMetadata& metadata);
+
+// Looks up row metadata on the executor so rows can be shown from
+// enumeration alone. Requests for the rows on screen go to the front:
+// prioritize() replaces the visible set and demotes what is left of the
+// previous one, enqueue() adds lower-priority rows such as the ones just
+// off screen. A row is fetched at most once per generation, however often
+// it is requested.
+//
+// Workers take requests in batches and publish results in batches; the
+// onReady callback runs at most once per drain(), so the frontend gets one
+// coalesced update however many batches finish in between. reset() starts a
+// new generation: queued requests are dropped, running batches stop after
+// the request in hand, and nothing they fetched is ever drained.
+class MetadataPipeline {
+public:
+    using Fetch = std::function<bool(const fs::path& path, EntryMetadata& metadata)>;
+
+    // Small enough that one screen of rows spreads over several workers and
+    // that workers look for newly visible rows often
+    static constexpr std::size_t BatchSize = 4;
+
+    // maxInFlight of 0 allows one batch per executor thread
+    MetadataPipeline(Executor& executor, Fetch fetch, std::function<void()> onReady = {},
+                     std::size_t maxInFlight = 0);
+    ~MetadataPipeline();
+
+    MetadataPipeline(const MetadataPipeline&) = delete;
+    MetadataPipeline& operator=(const MetadataPipeline&) = delete;
+
+    void reset();
+
+    void prioritize(std::vector<MetadataRequest> requests);
+    void enqueue(std::vector<MetadataRequest> requests);
+
+    // Appends the metadata fetched since the last call, returns the count
+    std::size_t drain(std::vector<EntryMetadata>& out);
+
+private:
+    struct Generation;
+
+    void start(const std::shared_ptr<Generation>& generation);
+    static void RunBatches(Generation& generation);
+
+    Executor& executor;
+    Fetch fetch;
+    std::function<void()> onReady;
+    std::size_t maxInFlight;
+    std::shared_ptr<Generation> current;
+};
+
+} // namespace ffe
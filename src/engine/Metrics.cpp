@@ -0,0 +1,88 @@
+#include "engine/Metrics.hpp"
+
+#include "engine/Trace.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace ffe {
+
+std::uint64_t ShardedCounter::value() const noexcept {
+    std::uint64_t total = 0;
+    for (const Shard& shard : shards) {
+        total += shard.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+void ShardedCounter::reset() noexcept {
+    for (Shard& shard : shards) {
+        shard.value.store(0, std::memory_order_relaxed);
+    }
+}
+
+void Metrics::start() {
+    entries.reset();
+    directories.reset();
+    matches.reset();
+    bytes.reset();
+    queueDepth = nullptr;
+    bytesAllocated = nullptr;
+    firstResult.store(0, std::memory_order_relaxed);
+    started = Clock::now();
+}
+
+void Metrics::noteFirstResult() noexcept {
+    const Clock::rep after = std::max<Clock::rep>(1, (Clock::now() - started).count());
+    Clock::rep none = 0;
+    firstResult.compare_exchange_strong(none, after, std::memory_order_relaxed);
+}
+
+MetricsSnapshot Metrics::snapshot() const {
+    MetricsSnapshot snapshot;
+    snapshot.entries = entries.value();
+    snapshot.directories = directories.value();
+    snapshot.matches = matches.value();
+    snapshot.bytes = bytes.value();
+    snapshot.queueDepth = queueDepth ? queueDepth() : 0;
+    snapshot.bytesAllocated = bytesAllocated ? bytesAllocated() : 0;
+    snapshot.seconds = std::chrono::duration<double>(Clock::now() - started).count();
+    if (const Clock::rep first = firstResult.load(std::memory_order_relaxed)) {
+        snapshot.firstResultSeconds = std::chrono::duration<double>(Clock::duration(first)).count();
+    }
+    return snapshot;
+}
+
+void AppendMetricsJson(const MetricsSnapshot& snapshot, std::string& out) {
+    char json[512];
+    std::snprintf(json, sizeof(json),
+                  "{\"entries\":%llu,\"directories\":%llu,\"matches\":%llu,\"bytes\":%llu,\"queueDepth\":%llu,"
+                  "\"bytesAllocated\":%llu,\"ms\":%.3f,\"firstResultMs\":%.3f,\"entriesPerSecond\":%.0f,"
+                  "\"directoriesPerSecond\":%.0f,\"bytesPerSecond\":%.0f}",
+                  static_cast<unsigned long long>(snapshot.entries),
+                  static_cast<unsigned long long>(snapshot.directories),
+                  static_cast<unsigned long long>(snapshot.matches),
+                  static_cast<unsigned long long>(snapshot.bytes),
+                  static_cast<unsigned long long>(snapshot.queueDepth),
+                  static_cast<unsigned long long>(snapshot.bytesAllocated), snapshot.seconds * 1000.0,
+                  snapshot.firstResultSeconds < 0 ? -1.0 : snapshot.firstResultSeconds * 1000.0,
+                  snapshot.entriesPerSecond(), snapshot.directoriesPerSecond(), snapshot.bytesPerSecond());
+    out += json;
+}
+
+void TraceMetrics(const MetricsSnapshot& snapshot) {
+    if (!Trace::Enabled()) {
+        return;
+    }
+    Trace::Counter("entries", static_cast<std::int64_t>(snapshot.entries));
+    Trace::Counter("matches", static_cast<std::int64_t>(snapshot.matches));
+    Trace::Counter("entries/s", static_cast<std::int64_t>(snapshot.entriesPerSecond()));
+    Trace::Counter("directories/s", static_cast<std::int64_t>(snapshot.directoriesPerSecond()));
+    if (snapshot.bytes > 0) {
+        Trace::Counter("bytes/s", static_cast<std::int64_t>(snapshot.bytesPerSecond()));
+    }
+    Trace::Counter("queue depth", static_cast<std::int64_t>(snapshot.queueDepth));
+    Trace::Counter("bytes allocated", static_cast<std::int64_t>(snapshot.bytesAllocated));
+}
+
+} // namespace ffe
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+
+namespace ffe {
+
+// A 64-bit counter for hot paths that many threads bump at once. Each
+// thread adds to its own cache line, so workers never contend for one;
+// reading sums the shards, which is only exact once the writers are done.
+class ShardedCounter {
+public:
+    static constexpr std::size_t Shards = 16;
+
+    void add(std::uint64_t n = 1) noexcept {
+        shards[ThreadShard()].value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    std::uint64_t value() const noexcept;
+
+    void reset() noexcept;
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<std::uint64_t> value{0};
+    };
+
+    // Threads take shards in turn, so up to Shards threads have one each
+    static std::size_t ThreadShard() noexcept {
+        thread_local const std::size_t shard = nextShard.fetch_add(1, std::memory_order_relaxed) % Shards;
+        return shard;
+    }
+
+    static inline std::atomic<std::size_t> nextShard{0};
+    std::array<Shard, Shards> shards;
+};
+
+// What an operation has done so far, with the rates derived from it
+struct MetricsSnapshot {
+    std::uint64_t entries = 0;        // Entries examined
+    std::uint64_t directories = 0;    // Directories enumerated
+    std::uint64_t matches = 0;        // Results found
+    std::uint64_t bytes = 0;          // File contents read, by a content search
+    std::uint64_t queueDepth = 0;     // Directories waiting to be visited
+    std::uint64_t bytesAllocated = 0; // Memory held by the results
+    double seconds = 0;               // Since the operation started
+    double firstResultSeconds = -1;   // Negative until there is a result
+
+    double entriesPerSecond() const noexcept {
+        return seconds > 0 ? entries / seconds : 0;
+    }
+
+    double directoriesPerSecond() const noexcept {
+        return seconds > 0 ? directories / seconds : 0;
+    }
+
+    double bytesPerSecond() const noexcept {
+        return seconds > 0 ? bytes / seconds : 0;
+    }
+};
+
+// Live counters of one operation, such as a search: workers add to them,
+// and whoever shows progress (a status bar, a trace, a headless dump) takes
+// snapshots. Queue depth and memory come from gauges that the operation's
+// owner sets, read by the thread taking the snapshot.
+class Metrics {
+public:
+    using Gauge = std::function<std::uint64_t()>;
+
+    ShardedCounter entries;
+    ShardedCounter directories;
+    ShardedCounter matches;
+    ShardedCounter bytes;
+
+    // Zeroes the counters, drops the gauges and restarts the clock; call
+    // before the operation's workers start
+    void start();
+
+    // Call on every result; only the time of the first one is kept
+    void resultFound() noexcept {
+        if (firstResult.load(std::memory_order_relaxed) == 0) {
+            noteFirstResult();
+        }
+    }
+
+    void setQueueDepth(Gauge gauge) {
+        queueDepth = std::move(gauge);
+    }
+
+    void setBytesAllocated(Gauge gauge) {
+        bytesAllocated = std::move(gauge);
+    }
+
+    MetricsSnapshot snapshot() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    void noteFirstResult() noexcept;
+
+    Clock::time_point started = Clock::now();
+    std::atomic<Clock::rep> firstResult{0}; // Time after start, at least 1; 0 for none yet
+    Gauge queueDepth;
+    Gauge bytesAllocated;
+};
+
+// Appends the snapshot as a JSON object
+void AppendMetricsJson(const MetricsSnapshot& snapshot, std::string& out);
+
+// Records the snapshot as counter tracks when tracing is on
+void TraceMetrics(const MetricsSnapshot& snapshot);
+
+} // namespace ffe
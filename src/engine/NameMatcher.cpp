@@ -0,0 +1,165 @@
+#include "engine/NameMatcher.hpp"
+
+#include "engine/NameMatcherKernels.hpp"
+#include "engine/Unicode.hpp"
+
+#include <algorithm>
+#include <string_view>
+
+#if defined(FFE_MATCHER_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace ffe {
+
+namespace {
+
+// Longest name folded on the stack; file names are far shorter (255 units
+// on NTFS and ext4), longer input takes a heap buffer
+constexpr std::size_t MaxStackName = 512;
+
+// Folds name into out, which must hold name.size() code points; returns the count
+std::size_t FoldName(NameView name, char32_t* out) {
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < name.size();) {
+        out[count++] = FoldCodePoint(DecodeNext(name, i));
+    }
+    return count;
+}
+
+bool IsAsciiName(NameView name) {
+    return std::all_of(name.begin(), name.end(), [](NativeChar c) { return IsAsciiUnit(c); });
+}
+
+#ifdef FFE_MATCHER_X86
+bool CpuSupportsAvx2() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    // AVX needs OS support for the YMM state (OSXSAVE plus XCR0 bits 1 and 2)
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+} // namespace
+
+AsciiScan FindAsciiScalar(const NativeChar* name, std::size_t length, const NativeChar* pattern,
+                          std::size_t patternLength) noexcept {
+    return ScanAscii(name, 0, length - patternLength, pattern, patternLength);
+}
+
+AsciiScan SubsequenceAsciiScalar(const NativeChar* name, std::size_t length, const NativeChar* pattern,
+                                 std::size_t patternLength) noexcept {
+    return ScanSubsequence(name, length, pattern, patternLength);
+}
+
+std::size_t FindBytesScalar(const char* text, std::size_t length, const char* needle, std::size_t needleLength,
+                            bool fold) noexcept {
+    if (!fold) {
+        // The C library's search is already vectorized where it matters
+        const std::string_view haystack(text, length);
+        const std::size_t at = haystack.find(std::string_view(needle, needleLength));
+        return at == std::string_view::npos ? NoBytesFound : at;
+    }
+    return ScanBytes<true>(text, 0, length - needleLength, needle, needleLength);
+}
+
+#ifdef FFE_MATCHER_X86
+AsciiScan FindAsciiSse2(const NativeChar* name, std::size_t length, const NativeChar* pattern,
+                        std::size_t patternLength) noexcept {
+    return FindAsciiBlocks<Sse2Lanes<sizeof(NativeChar)>>(name, length, pattern, patternLength);
+}
+
+AsciiScan SubsequenceAsciiSse2(const NativeChar* name, std::size_t length, const NativeChar* pattern,
+                               std::size_t patternLength) noexcept {
+    return SubsequenceBlocks<Sse2Lanes<sizeof(NativeChar)>>(name, length, pattern, patternLength);
+}
+
+std::size_t FindBytesSse2(const char* text, std::size_t length, const char* needle, std::size_t needleLength,
+                          bool fold) noexcept {
+    return fold ? FindBytesBlocks<Sse2Lanes<1>, true>(text, length, needle, needleLength)
+                : FindBytesBlocks<Sse2Lanes<1>, false>(text, length, needle, needleLength);
+}
+#endif
+
+NameMatcher::SimdLevel NameMatcher::BestSimdLevel() noexcept {
+#ifdef FFE_MATCHER_X86
+    static const SimdLevel best = CpuSupportsAvx2() ? SimdLevel::Avx2 : SimdLevel::Sse2;
+    return best;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+NameMatcher::NameMatcher(NameView pattern, SimdLevel level) : level(std::min(level, BestSimdLevel())) {
+    foldedPattern.resize(pattern.size());
+    foldedPattern.resize(FoldName(pattern, foldedPattern.data()));
+
+    asciiOnly = std::all_of(foldedPattern.begin(), foldedPattern.end(), [](char32_t c) { return c < 0x80; });
+    if (asciiOnly) {
+        asciiPattern.assign(foldedPattern.begin(), foldedPattern.end());
+    }
+}
+
+bool NameMatcher::matches(NameView name) const noexcept {
+    if (foldedPattern.empty()) {
+        return true;
+    }
+    // Every code point takes at least one code unit
+    if (name.size() < foldedPattern.size()) {
+        return false;
+    }
+
+    if (!asciiOnly) {
+        // An ASCII name folds to ASCII and cannot contain this pattern
+        return !IsAsciiName(name) && matchesFolded(name);
+    }
+
+    AsciiScan result;
+    switch (level) {
+#ifdef FFE_MATCHER_X86
+    case SimdLevel::Avx2:
+        result = FindAsciiAvx2(name.data(), name.size(), asciiPattern.data(), asciiPattern.size());
+        break;
+    case SimdLevel::Sse2:
+        result = FindAsciiSse2(name.data(), name.size(), asciiPattern.data(), asciiPattern.size());
+        break;
+#endif
+    default:
+        result = FindAsciiScalar(name.data(), name.size(), asciiPattern.data(), asciiPattern.size());
+        break;
+    }
+    return result == AsciiScan::NonAscii ? matchesFolded(name) : result == AsciiScan::Match;
+}
+
+bool NameMatcher::matchesFolded(NameView name) const noexcept {
+    const std::u32string_view pattern(foldedPattern);
+    if (name.size() <= MaxStackName) {
+        char32_t buffer[MaxStackName];
+        const std::size_t count = FoldName(name, buffer);
+        return std::u32string_view(buffer, count).find(pattern) != std::u32string_view::npos;
+    }
+
+    try {
+        std::u32string folded(name.size(), U'\0');
+        folded.resize(FoldName(name, folded.data()));
+        return folded.find(pattern) != std::u32string::npos;
+    } catch (const std::bad_alloc&) {
+        return false;
+    }
+}
+
+} // namespace ffe
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "engine/DirEntry.hpp"
+
+#include <string>
+
+namespace ffe {
+
+// Case-insensitive substring matcher for file names. The pattern is folded
+// once when the matcher is built, so matching a name allocates nothing.
+// Names made of ASCII only are scanned with SSE2 or AVX2, comparing the
+// first and last pattern characters across a whole vector of candidate
+// positions at once. Any other name is decoded (UTF-16 on Windows, UTF-8
+// on Linux) and compared code point by code point after case folding.
+class NameMatcher {
+public:
+    enum class SimdLevel : std::uint8_t {
+        Scalar,
+        Sse2,
+        Avx2,
+    };
+
+    // Highest level the running CPU supports
+    static SimdLevel BestSimdLevel() noexcept;
+
+    // level is clamped to what the CPU supports
+    explicit NameMatcher(NameView pattern, SimdLevel level = BestSimdLevel());
+
+    // True if pattern occurs in name, ignoring case. An empty pattern matches every name.
+    bool matches(NameView name) const noexcept;
+
+    bool empty() const noexcept {
+        return foldedPattern.empty();
+    }
+
+    SimdLevel simdLevel() const noexcept {
+        return level;
+    }
+
+private:
+    bool matchesFolded(NameView name) const noexcept;
+
+    std::u32string foldedPattern;      // Case-folded code points
+    fs::path::string_type asciiPattern; // Folded code units, when foldedPattern is all ASCII
+    bool asciiOnly = true;
+    SimdLevel level = SimdLevel::Scalar;
+};
+
+} // namespace ffe
@@ -0,0 +1,28 @@
+// Built with AVX2 code generation enabled (see CMakeLists.txt); only called
+// after NameMatcher or ContentMatcher has checked that the CPU supports it.
+
+#include "engine/NameMatcherKernels.hpp"
+
+namespace ffe {
+
+#ifdef FFE_MATCHER_X86
+
+AsciiScan FindAsciiAvx2(const NativeChar* name, std::size_t length, const NativeChar* pattern,
+                        std::size_t patternLength) noexcept {
+    return FindAsciiBlocks<Avx2Lanes<sizeof(NativeChar)>>(name, length, pattern, patternLength);
+}
+
+AsciiScan SubsequenceAsciiAvx2(const NativeChar* name, std::size_t length, const NativeChar* pattern,
+                               std::size_t patternLength) noexcept {
+    return SubsequenceBlocks<Avx2Lanes<sizeof(NativeChar)>>(name, length, pattern, patternLength);
+}
+
+std::size_t FindBytesAvx2(const char* text, std::size_t length, const char* needle, std::size_t needleLength,
+                          bool fold) noexcept {
+    return fold ? FindBytesBlocks<Avx2Lanes<1>, true>(text, length, needle, needleLength)
+                : FindBytesBlocks<Avx2Lanes<1>, false>(text, length, needle, needleLength);
+}
+
+#endif
+
+} // namespace ffe
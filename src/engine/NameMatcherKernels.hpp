@@ -0,0 +1,446 @@
+#pragma once
+
+// ASCII search kernels behind NameMatcher, FuzzyMatcher and ContentMatcher.
+// This header is included by translation units compiled for different
+// instruction sets, so everything defined here has internal linkage: the
+// linker must never be able to pick an AVX2-compiled copy of a helper for
+// the SSE2 path.
+
+#include "engine/DirEntry.hpp"
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define FFE_MATCHER_X86 1
+#include <immintrin.h>
+#endif
+
+namespace ffe {
+
+enum class AsciiScan : std::uint8_t {
+    NoMatch,
+    Match,
+    NonAscii, // The name holds a non-ASCII unit where it matters; use the full fold
+};
+
+// Each kernel looks for the ASCII-folded pattern in name. patternLength is
+// at least 1 and at most length.
+AsciiScan FindAsciiScalar(const NativeChar* name, std::size_t length, const NativeChar* pattern,
+                          std::size_t patternLength) noexcept;
+#ifdef FFE_MATCHER_X86
+AsciiScan FindAsciiSse2(const NativeChar* name, std::size_t length, const NativeChar* pattern,
+                        std::size_t patternLength) noexcept;
+AsciiScan FindAsciiAvx2(const NativeChar* name, std::size_t length, const NativeChar* pattern,
+                        std::size_t patternLength) noexcept;
+#endif
+
+// Each kernel checks whether the ASCII-folded pattern is a subsequence of
+// name. patternLength is at least 1.
+AsciiScan SubsequenceAsciiScalar(const NativeChar* name, std::size_t length, const NativeChar* pattern,
+                                 std::size_t patternLength) noexcept;
+#ifdef FFE_MATCHER_X86
+AsciiScan SubsequenceAsciiSse2(const NativeChar* name, std::size_t length, const NativeChar* pattern,
+                               std::size_t patternLength) noexcept;
+AsciiScan SubsequenceAsciiAvx2(const NativeChar* name, std::size_t length, const NativeChar* pattern,
+                               std::size_t patternLength) noexcept;
+#endif
+
+// Returned by the byte kernels when the needle does not occur
+constexpr std::size_t NoBytesFound = static_cast<std::size_t>(-1);
+
+// Each kernel returns the first position of needle in the bytes of text,
+// or NoBytesFound. With fold set, ASCII letters of text are compared
+// lowercased; the needle is folded already. needleLength is at least 1 and
+// at most length.
+std::size_t FindBytesScalar(const char* text, std::size_t length, const char* needle, std::size_t needleLength,
+                            bool fold) noexcept;
+#ifdef FFE_MATCHER_X86
+std::size_t FindBytesSse2(const char* text, std::size_t length, const char* needle, std::size_t needleLength,
+                          bool fold) noexcept;
+std::size_t FindBytesAvx2(const char* text, std::size_t length, const char* needle, std::size_t needleLength,
+                          bool fold) noexcept;
+#endif
+
+namespace {
+
+template<class Char>
+inline bool IsAsciiUnit(Char c) noexcept {
+    return static_cast<std::make_unsigned_t<Char>>(c) < 0x80;
+}
+
+template<class Char>
+inline Char FoldAsciiUnit(Char c) noexcept {
+    return c >= 'A' && c <= 'Z' ? static_cast<Char>(c | 0x20) : c;
+}
+
+// Compares count units of name against the folded pattern
+template<class Char>
+inline AsciiScan CompareAscii(const Char* name, const Char* pattern, std::size_t count) noexcept {
+    for (std::size_t i = 0; i < count; ++i) {
+        if (!IsAsciiUnit(name[i])) {
+            return AsciiScan::NonAscii;
+        }
+        if (FoldAsciiUnit(name[i]) != pattern[i]) {
+            return AsciiScan::NoMatch;
+        }
+    }
+    return AsciiScan::Match;
+}
+
+// Tries the start positions from..last one at a time. A non-ASCII unit can
+// only hide a match (U+212A KELVIN SIGN folds to 'k', say) if it sits at a
+// position the scan compares, so only those units are checked.
+template<class Char>
+inline AsciiScan ScanAscii(const Char* name, std::size_t from, std::size_t last, const Char* pattern,
+                           std::size_t patternLength) noexcept {
+    const std::size_t inner = patternLength < 2 ? 0 : patternLength - 2;
+    for (std::size_t i = from; i <= last; ++i) {
+        const Char first = name[i];
+        const Char end = name[i + patternLength - 1];
+        if (!IsAsciiUnit(first) || !IsAsciiUnit(end)) {
+            return AsciiScan::NonAscii;
+        }
+        if (FoldAsciiUnit(first) == pattern[0] && FoldAsciiUnit(end) == pattern[patternLength - 1]) {
+            const AsciiScan result = CompareAscii(name + i + 1, pattern + 1, inner);
+            if (result != AsciiScan::NoMatch) {
+                return result;
+            }
+        }
+    }
+    return AsciiScan::NoMatch;
+}
+
+// Checks the candidate start positions of one block, lowest first.
+// Candidate masks have one bit per byte, so a lane wider than a byte sets
+// several bits.
+template<class Char>
+inline AsciiScan CompareCandidates(const Char* block, std::uint32_t candidates, const Char* pattern,
+                                   std::size_t inner) noexcept {
+    while (candidates != 0) {
+        const std::size_t at = static_cast<std::size_t>(std::countr_zero(candidates)) / sizeof(Char);
+        for (std::size_t bit = 0; bit < sizeof(Char); ++bit) {
+            candidates &= candidates - 1;
+        }
+        const AsciiScan result = CompareAscii(block + at + 1, pattern + 1, inner);
+        if (result != AsciiScan::NoMatch) {
+            return result;
+        }
+    }
+    return AsciiScan::NoMatch;
+}
+
+// Vector scan: each step loads the units at Width consecutive start
+// positions and at the matching end positions, folds both and keeps the
+// positions where the first and last pattern units agree. Only those are
+// compared in full. Most file names are shorter than two vectors, so the
+// start positions left over at the end are scanned once more from a
+// zero-padded copy instead of one at a time; nothing is read past the name.
+template<class Lanes, class Char>
+inline AsciiScan FindAsciiBlocks(const Char* name, std::size_t length, const Char* pattern,
+                                 std::size_t patternLength) noexcept {
+    const std::size_t last = length - patternLength;
+    const std::size_t inner = patternLength < 2 ? 0 : patternLength - 2;
+    const auto first = Lanes::broadcast(pattern[0]);
+    const auto end = Lanes::broadcast(pattern[patternLength - 1]);
+
+    std::size_t i = 0;
+    for (; i + Lanes::Width <= last + 1; i += Lanes::Width) {
+        const auto starts = Lanes::load(name + i);
+        const auto ends = Lanes::load(name + i + patternLength - 1);
+        if (Lanes::anyNonAscii(starts, ends)) {
+            return AsciiScan::NonAscii;
+        }
+        const AsciiScan result =
+            CompareCandidates(name + i, Lanes::candidates(starts, ends, first, end), pattern, inner);
+        if (result != AsciiScan::NoMatch) {
+            return result;
+        }
+    }
+    if (i > last) {
+        return AsciiScan::NoMatch;
+    }
+    if (patternLength > Lanes::Width) {
+        return ScanAscii(name, i, last, pattern, patternLength);
+    }
+
+    // Fewer than Width start positions remain, spanning less than 2 * Width units
+    Char block[2 * Lanes::Width] = {};
+    for (std::size_t k = i; k < length; ++k) {
+        block[k - i] = name[k];
+    }
+    const auto starts = Lanes::load(block);
+    const auto ends = Lanes::load(block + patternLength - 1);
+    if (Lanes::anyNonAscii(starts, ends)) {
+        return AsciiScan::NonAscii;
+    }
+    const std::uint32_t valid = (std::uint32_t(1) << ((last + 1 - i) * sizeof(Char))) - 1;
+    return CompareCandidates(block, Lanes::candidates(starts, ends, first, end) & valid, pattern, inner);
+}
+
+// Consumes pattern units one at a time, each at the first later position
+// of the name holding it
+template<class Char>
+inline AsciiScan ScanSubsequence(const Char* name, std::size_t length, const Char* pattern,
+                                 std::size_t patternLength) noexcept {
+    std::size_t k = 0;
+    for (std::size_t i = 0; i < length; ++i) {
+        if (!IsAsciiUnit(name[i])) {
+            return AsciiScan::NonAscii;
+        }
+        if (FoldAsciiUnit(name[i]) == pattern[k] && ++k == patternLength) {
+            return AsciiScan::Match;
+        }
+    }
+    return AsciiScan::NoMatch;
+}
+
+// Vector form of ScanSubsequence: each block of the name is folded once,
+// then every pattern unit it can supply costs one compare against it. The
+// allowed mask drops the positions at and before the last unit consumed.
+template<class Lanes, class Char>
+inline AsciiScan SubsequenceBlocks(const Char* name, std::size_t length, const Char* pattern,
+                                   std::size_t patternLength) noexcept {
+    std::size_t k = 0;
+    for (std::size_t i = 0; i < length; i += Lanes::Width) {
+        Char padded[Lanes::Width] = {};
+        const Char* block = name + i;
+        if (i + Lanes::Width > length) {
+            for (std::size_t j = i; j < length; ++j) {
+                padded[j - i] = name[j];
+            }
+            block = padded;
+        }
+
+        const auto units = Lanes::load(block);
+        if (Lanes::anyNonAscii(units, units)) {
+            return AsciiScan::NonAscii;
+        }
+        const auto folded = Lanes::fold(units);
+        std::uint64_t allowed = 0xFFFFFFFFu;
+        while (true) {
+            const std::uint32_t hits = Lanes::equal(folded, Lanes::broadcast(pattern[k])) &
+                                       static_cast<std::uint32_t>(allowed);
+            if (hits == 0) {
+                break;
+            }
+            if (++k == patternLength) {
+                return AsciiScan::Match;
+            }
+            const unsigned next = static_cast<unsigned>(std::countr_zero(hits)) + sizeof(Char);
+            allowed &= ~((std::uint64_t(1) << next) - 1);
+        }
+    }
+    return AsciiScan::NoMatch;
+}
+
+template<bool Fold>
+inline bool EqualBytes(const char* text, const char* needle, std::size_t count) noexcept {
+    for (std::size_t i = 0; i < count; ++i) {
+        if ((Fold ? FoldAsciiUnit(text[i]) : text[i]) != needle[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Tries the start positions from..last one at a time
+template<bool Fold>
+inline std::size_t ScanBytes(const char* text, std::size_t from, std::size_t last, const char* needle,
+                             std::size_t needleLength) noexcept {
+    for (std::size_t i = from; i <= last; ++i) {
+        if (EqualBytes<Fold>(text + i, needle, needleLength)) {
+            return i;
+        }
+    }
+    return NoBytesFound;
+}
+
+// Vector scan over file contents, as FindAsciiBlocks does for names: the
+// first and last needle bytes are compared at Width start positions per
+// step and only the positions where both agree are compared in full. Bytes
+// outside ASCII are compared as they are, so UTF-8 text needs no decoding.
+// Contents are long, so the few start positions left at the end are simply
+// tried one at a time.
+template<class Lanes, bool Fold>
+inline std::size_t FindBytesBlocks(const char* text, std::size_t length, const char* needle,
+                                   std::size_t needleLength) noexcept {
+    const std::size_t last = length - needleLength;
+    const std::size_t inner = needleLength < 2 ? 0 : needleLength - 2;
+    const auto first = Lanes::broadcast(needle[0]);
+    const auto end = Lanes::broadcast(needle[needleLength - 1]);
+
+    std::size_t i = 0;
+    for (; i + Lanes::Width <= last + 1; i += Lanes::Width) {
+        auto starts = Lanes::load(text + i);
+        auto ends = Lanes::load(text + i + needleLength - 1);
+        if constexpr (Fold) {
+            starts = Lanes::fold(starts);
+            ends = Lanes::fold(ends);
+        }
+        std::uint32_t candidates = Lanes::equal(starts, first) & Lanes::equal(ends, end);
+        while (candidates != 0) {
+            const std::size_t at = i + static_cast<std::size_t>(std::countr_zero(candidates));
+            candidates &= candidates - 1;
+            if (EqualBytes<Fold>(text + at + 1, needle + 1, inner)) {
+                return at;
+            }
+        }
+    }
+    return i > last ? NoBytesFound : ScanBytes<Fold>(text, i, last, needle, needleLength);
+}
+
+#ifdef FFE_MATCHER_X86
+
+template<std::size_t CharSize>
+struct Sse2Lanes;
+
+template<>
+struct Sse2Lanes<1> {
+    static constexpr std::size_t Width = 16;
+
+    static __m128i load(const void* p) noexcept {
+        return _mm_loadu_si128(static_cast<const __m128i*>(p));
+    }
+
+    static __m128i broadcast(char c) noexcept {
+        return _mm_set1_epi8(c);
+    }
+
+    // Bytes 0x80 and up are negative as signed bytes, so never in 'A'..'Z'
+    static __m128i fold(__m128i v) noexcept {
+        const __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('A' - 1)),
+                                            _mm_cmplt_epi8(v, _mm_set1_epi8('Z' + 1)));
+        return _mm_or_si128(v, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+    }
+
+    static bool anyNonAscii(__m128i a, __m128i b) noexcept {
+        return _mm_movemask_epi8(_mm_or_si128(a, b)) != 0;
+    }
+
+    static std::uint32_t equal(__m128i a, __m128i b) noexcept {
+        return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)));
+    }
+
+    static std::uint32_t candidates(__m128i starts, __m128i ends, __m128i first, __m128i end) noexcept {
+        const __m128i hits = _mm_and_si128(_mm_cmpeq_epi8(fold(starts), first), _mm_cmpeq_epi8(fold(ends), end));
+        return static_cast<std::uint32_t>(_mm_movemask_epi8(hits));
+    }
+};
+
+template<>
+struct Sse2Lanes<2> {
+    static constexpr std::size_t Width = 8;
+
+    static __m128i load(const void* p) noexcept {
+        return _mm_loadu_si128(static_cast<const __m128i*>(p));
+    }
+
+    static __m128i broadcast(wchar_t c) noexcept {
+        return _mm_set1_epi16(static_cast<short>(c));
+    }
+
+    static __m128i fold(__m128i v) noexcept {
+        const __m128i upper = _mm_and_si128(_mm_cmpgt_epi16(v, _mm_set1_epi16('A' - 1)),
+                                            _mm_cmplt_epi16(v, _mm_set1_epi16('Z' + 1)));
+        return _mm_or_si128(v, _mm_and_si128(upper, _mm_set1_epi16(0x20)));
+    }
+
+    static bool anyNonAscii(__m128i a, __m128i b) noexcept {
+        const __m128i high = _mm_and_si128(_mm_or_si128(a, b), _mm_set1_epi16(static_cast<short>(0xFF80)));
+        return _mm_movemask_epi8(_mm_cmpeq_epi16(high, _mm_setzero_si128())) != 0xFFFF;
+    }
+
+    static std::uint32_t equal(__m128i a, __m128i b) noexcept {
+        return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi16(a, b)));
+    }
+
+    static std::uint32_t candidates(__m128i starts, __m128i ends, __m128i first, __m128i end) noexcept {
+        const __m128i hits = _mm_and_si128(_mm_cmpeq_epi16(fold(starts), first), _mm_cmpeq_epi16(fold(ends), end));
+        return static_cast<std::uint32_t>(_mm_movemask_epi8(hits));
+    }
+};
+
+// Only usable in translation units compiled with AVX2 enabled
+#if defined(__AVX2__) || defined(_MSC_VER)
+
+template<std::size_t CharSize>
+struct Avx2Lanes;
+
+template<>
+struct Avx2Lanes<1> {
+    static constexpr std::size_t Width = 32;
+
+    static __m256i load(const void* p) noexcept {
+        return _mm256_loadu_si256(static_cast<const __m256i*>(p));
+    }
+
+    static __m256i broadcast(char c) noexcept {
+        return _mm256_set1_epi8(c);
+    }
+
+    static __m256i fold(__m256i v) noexcept {
+        const __m256i upper = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('A' - 1)),
+                                               _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), v));
+        return _mm256_or_si256(v, _mm256_and_si256(upper, _mm256_set1_epi8(0x20)));
+    }
+
+    static bool anyNonAscii(__m256i a, __m256i b) noexcept {
+        return _mm256_movemask_epi8(_mm256_or_si256(a, b)) != 0;
+    }
+
+    static std::uint32_t equal(__m256i a, __m256i b) noexcept {
+        return static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)));
+    }
+
+    static std::uint32_t candidates(__m256i starts, __m256i ends, __m256i first, __m256i end) noexcept {
+        const __m256i hits = _mm256_and_si256(_mm256_cmpeq_epi8(fold(starts), first),
+                                              _mm256_cmpeq_epi8(fold(ends), end));
+        return static_cast<std::uint32_t>(_mm256_movemask_epi8(hits));
+    }
+};
+
+template<>
+struct Avx2Lanes<2> {
+    static constexpr std::size_t Width = 16;
+
+    static __m256i load(const void* p) noexcept {
+        return _mm256_loadu_si256(static_cast<const __m256i*>(p));
+    }
+
+    static __m256i broadcast(wchar_t c) noexcept {
+        return _mm256_set1_epi16(static_cast<short>(c));
+    }
+
+    static __m256i fold(__m256i v) noexcept {
+        const __m256i upper = _mm256_and_si256(_mm256_cmpgt_epi16(v, _mm256_set1_epi16('A' - 1)),
+                                               _mm256_cmpgt_epi16(_mm256_set1_epi16('Z' + 1), v));
+        return _mm256_or_si256(v, _mm256_and_si256(upper, _mm256_set1_epi16(0x20)));
+    }
+
+    static bool anyNonAscii(__m256i a, __m256i b) noexcept {
+        const __m256i high = _mm256_and_si256(_mm256_or_si256(a, b),
+                                              _mm256_set1_epi16(static_cast<short>(0xFF80)));
+        return _mm256_movemask_epi8(_mm256_cmpeq_epi16(high, _mm256_setzero_si256())) != -1;
+    }
+
+    static std::uint32_t equal(__m256i a, __m256i b) noexcept {
+        return static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi16(a, b)));
+    }
+
+    static std::uint32_t candidates(__m256i starts, __m256i ends, __m256i first, __m256i end) noexcept {
+        const __m256i hits = _mm256_and_si256(_mm256_cmpeq_epi16(fold(starts), first),
+                                              _mm256_cmpeq_epi16(fold(ends), end));
+        return static_cast<std::uint32_t>(_mm256_movemask_epi8(hits));
+    }
+};
+
+#endif
+
+#endif
+
+} // namespace
+
+} // namespace ffe
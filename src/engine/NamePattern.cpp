@@ -0,0 +1,745 @@
+#include "engine/NamePattern.hpp"
+
+#include "engine/Unicode.hpp"
+
+#include <algorithm>
+#include <map>
+
+namespace ffe {
+
+namespace {
+
+constexpr std::size_t MaxNfaStates = 20000;
+constexpr std::size_t MaxDfaStates = 4096;
+constexpr std::uint32_t MaxRepeat = 100;
+constexpr std::uint32_t Unbounded = 0xFFFFFFFFu;
+constexpr std::uint32_t NoSet = 0xFFFFFFFFu;
+
+// Sorted, disjoint, non-adjacent closed intervals of code points
+using Interval = std::pair<char32_t, char32_t>;
+using CharSet = std::vector<Interval>;
+
+CharSet Normalize(CharSet set) {
+    std::sort(set.begin(), set.end());
+    CharSet merged;
+    for (const Interval& interval : set) {
+        if (!merged.empty() && interval.first <= merged.back().second + 1) {
+            merged.back().second = std::max(merged.back().second, interval.second);
+        } else {
+            merged.push_back(interval);
+        }
+    }
+    return merged;
+}
+
+CharSet Complement(const CharSet& set) {
+    CharSet result;
+    char32_t next = 0;
+    for (const Interval& interval : set) {
+        if (interval.first > next) {
+            result.emplace_back(next, interval.first - 1);
+        }
+        next = interval.second + 1;
+    }
+    if (next <= MaxCodePoint) {
+        result.emplace_back(next, MaxCodePoint);
+    }
+    return result;
+}
+
+// Maps every member through FoldCodePoint, the form names are compared in.
+// Members of huge ranges past the first 64K are kept as they are.
+CharSet FoldSet(const CharSet& set) {
+    CharSet folded;
+    for (const auto& [low, high] : set) {
+        const char32_t enumerated = high - low > 0xFFFF ? low + 0xFFFF : high;
+        for (char32_t c = low;; ++c) {
+            const char32_t f = FoldCodePoint(c);
+            if (!folded.empty() && folded.back().second + 1 == f) {
+                folded.back().second = f;
+            } else {
+                folded.emplace_back(f, f);
+            }
+            if (c == enumerated) {
+                break;
+            }
+        }
+        if (enumerated != high) {
+            folded.emplace_back(enumerated + 1, high);
+        }
+    }
+    return Normalize(std::move(folded));
+}
+
+CharSet AnySet() {
+    return {{0, MaxCodePoint}};
+}
+
+// Syntax tree shared by both pattern syntaxes
+struct Node {
+    enum class Kind : std::uint8_t {
+        Empty,
+        Set,
+        Concat,
+        Alternate,
+        Repeat,
+    };
+
+    Kind kind = Kind::Empty;
+    std::uint32_t set = NoSet;
+    std::vector<std::uint32_t> children;
+    std::uint32_t min = 0;
+    std::uint32_t max = 0;
+};
+
+struct Ast {
+    std::vector<Node> nodes;
+    std::vector<CharSet> sets; // Already folded
+
+    std::uint32_t add(Node node) {
+        nodes.push_back(std::move(node));
+        return static_cast<std::uint32_t>(nodes.size() - 1);
+    }
+
+    std::uint32_t addSet(CharSet set) {
+        sets.push_back(std::move(set));
+        Node node;
+        node.kind = Node::Kind::Set;
+        node.set = static_cast<std::uint32_t>(sets.size() - 1);
+        return add(std::move(node));
+    }
+
+    std::uint32_t addLiteral(char32_t c) {
+        const char32_t f = FoldCodePoint(c);
+        return addSet({{f, f}});
+    }
+
+    std::uint32_t addList(Node::Kind kind, std::vector<std::uint32_t> children) {
+        if (children.size() == 1) {
+            return children[0];
+        }
+        Node node;
+        node.kind = children.empty() ? Node::Kind::Empty : kind;
+        node.children = std::move(children);
+        return add(std::move(node));
+    }
+
+    std::uint32_t addRepeat(std::uint32_t child, std::uint32_t min, std::uint32_t max) {
+        Node node;
+        node.kind = Node::Kind::Repeat;
+        node.children = {child};
+        node.min = min;
+        node.max = max;
+        return add(std::move(node));
+    }
+};
+
+// Parses the body of a [...] class; i is just past the '['. Returns false
+// when the class is never closed.
+bool ParseClass(const std::u32string& p, std::size_t& i, bool regex, CharSet& members, bool& negated) {
+    std::size_t at = i;
+    negated = at < p.size() && (p[at] == '^' || (!regex && p[at] == '!'));
+    if (negated) {
+        ++at;
+    }
+
+    CharSet raw;
+    bool first = true;
+    while (at < p.size() && (p[at] != ']' || first)) {
+        first = false;
+        char32_t low = p[at++];
+        if (regex && low == '\\' && at < p.size()) {
+            const char32_t escaped = p[at++];
+            switch (escaped) {
+            case 'd':
+                raw.emplace_back('0', '9');
+                continue;
+            case 'w':
+                raw.insert(raw.end(), {{'0', '9'}, {'A', 'Z'}, {'_', '_'}, {'a', 'z'}});
+                continue;
+            case 's':
+                raw.insert(raw.end(), {{'\t', '\r'}, {' ', ' '}});
+                continue;
+            case 't':
+                low = '\t';
+                break;
+            default:
+                low = escaped;
+                break;
+            }
+        }
+        char32_t high = low;
+        if (at + 1 < p.size() && p[at] == '-' && p[at + 1] != ']') {
+            high = p[at + 1];
+            at += 2;
+            if (high < low) {
+                std::swap(low, high);
+            }
+        }
+        raw.emplace_back(low, high);
+    }
+    if (at >= p.size()) {
+        return false;
+    }
+
+    i = at + 1;
+    members = Normalize(std::move(raw));
+    return true;
+}
+
+// Adds a class; a negated class is complemented after folding so [^a] rejects A as well
+std::uint32_t AddClass(Ast& ast, const CharSet& members, bool negated) {
+    CharSet folded = FoldSet(members);
+    return ast.addSet(negated ? Complement(folded) : std::move(folded));
+}
+
+std::uint32_t ParseGlob(const std::u32string& p, Ast& ast) {
+    std::vector<std::uint32_t> sequence;
+    for (std::size_t i = 0; i < p.size();) {
+        const char32_t c = p[i++];
+        if (c == '*') {
+            // Consecutive stars mean the same as one
+            while (i < p.size() && p[i] == '*') {
+                ++i;
+            }
+            sequence.push_back(ast.addRepeat(ast.addSet(AnySet()), 0, Unbounded));
+        } else if (c == '?') {
+            sequence.push_back(ast.addSet(AnySet()));
+        } else if (c == '[') {
+            std::size_t at = i;
+            CharSet members;
+            bool negated = false;
+            if (ParseClass(p, at, false, members, negated)) {
+                sequence.push_back(AddClass(ast, members, negated));
+                i = at;
+            } else {
+                sequence.push_back(ast.addLiteral(c));
+            }
+        } else {
+            sequence.push_back(ast.addLiteral(c));
+        }
+    }
+    return ast.addList(Node::Kind::Concat, std::move(sequence));
+}
+
+class RegexParser {
+public:
+    RegexParser(const std::u32string& pattern, Ast& ast) : p(pattern), ast(ast) {}
+
+    bool parse(std::uint32_t& root, std::string& error) {
+        root = alternation();
+        if (failure.empty() && at < p.size()) {
+            fail("unmatched )");
+        }
+        error = failure;
+        return failure.empty();
+    }
+
+private:
+    std::uint32_t fail(const char* message) {
+        if (failure.empty()) {
+            failure = message;
+        }
+        at = p.size();
+        return ast.addList(Node::Kind::Concat, {});
+    }
+
+    std::uint32_t alternation() {
+        std::vector<std::uint32_t> options{sequence()};
+        while (at < p.size() && p[at] == '|') {
+            ++at;
+            options.push_back(sequence());
+        }
+        return ast.addList(Node::Kind::Alternate, std::move(options));
+    }
+
+    std::uint32_t sequence() {
+        std::vector<std::uint32_t> items;
+        while (at < p.size() && p[at] != '|' && p[at] != ')') {
+            items.push_back(quantified());
+        }
+        return ast.addList(Node::Kind::Concat, std::move(items));
+    }
+
+    std::uint32_t quantified() {
+        std::uint32_t node = atom();
+        while (at < p.size()) {
+            std::uint32_t min = 0;
+            std::uint32_t max = 0;
+            const char32_t c = p[at];
+            if (c == '*') {
+                max = Unbounded;
+            } else if (c == '+') {
+                min = 1;
+                max = Unbounded;
+            } else if (c == '?') {
+                max = 1;
+            } else if (c == '{') {
+                if (!bounds(min, max)) {
+                    return node;
+                }
+            } else {
+                break;
+            }
+            ++at;
+            if (at < p.size() && (p[at] == '?' || p[at] == '+')) {
+                // Lazy and possessive forms match the same names
+                ++at;
+            }
+            node = ast.addRepeat(node, min, max);
+        }
+        return node;
+    }
+
+    // Parses {m}, {m,} or {m,n} at the current position, leaving at on the '}'
+    bool bounds(std::uint32_t& min, std::uint32_t& max) {
+        std::size_t i = at + 1;
+        const auto number = [&](std::uint32_t& value) {
+            const std::size_t begin = i;
+            value = 0;
+            while (i < p.size() && p[i] >= '0' && p[i] <= '9' && value <= MaxRepeat) {
+                value = value * 10 + (p[i++] - '0');
+            }
+            return i != begin;
+        };
+
+        if (!number(min)) {
+            fail("expected a number after {");
+            return false;
+        }
+        max = min;
+        if (i < p.size() && p[i] == ',') {
+            ++i;
+            if (!number(max)) {
+                max = Unbounded;
+            }
+        }
+        if (i >= p.size() || p[i] != '}') {
+            fail("unterminated {");
+            return false;
+        }
+        if (min > MaxRepeat || (max != Unbounded && max > MaxRepeat)) {
+            fail("repetition count too large");
+            return false;
+        }
+        if (min > max) {
+            fail("repetition bounds out of order");
+            return false;
+        }
+        at = i;
+        return true;
+    }
+
+    std::uint32_t atom() {
+        const char32_t c = p[at++];
+        switch (c) {
+        case '(': {
+            if (at < p.size() && p[at] == '?') {
+                // Non-capturing groups are fine, lookaround is not
+                if (at + 1 < p.size() && p[at + 1] == ':') {
+                    at += 2;
+                } else {
+                    return fail("lookaround and group flags are not supported");
+                }
+            }
+            const std::uint32_t inner = alternation();
+            if (at >= p.size() || p[at] != ')') {
+                return fail("missing )");
+            }
+            ++at;
+            return inner;
+        }
+        case '[': {
+            CharSet members;
+            bool negated = false;
+            if (!ParseClass(p, at, true, members, negated)) {
+                return fail("missing ]");
+            }
+            return AddClass(ast, members, negated);
+        }
+        case '.':
+            return ast.addSet(AnySet());
+        case '*':
+        case '+':
+        case '?':
+        case '{':
+            return fail("nothing to repeat");
+        case '^':
+        case '$':
+            return fail("^ and $ are only supported at the start and end of the pattern");
+        case '\\':
+            return escape();
+        default:
+            return ast.addLiteral(c);
+        }
+    }
+
+    std::uint32_t escape() {
+        if (at >= p.size()) {
+            return fail("trailing backslash");
+        }
+        const char32_t c = p[at++];
+        if (c >= '1' && c <= '9') {
+            return fail("back-references are not supported");
+        }
+
+        CharSet members;
+        switch (c) {
+        case 'd':
+        case 'D':
+            members = {{'0', '9'}};
+            break;
+        case 'w':
+        case 'W':
+            members = {{'0', '9'}, {'A', 'Z'}, {'_', '_'}, {'a', 'z'}};
+            break;
+        case 's':
+        case 'S':
+            members = {{'\t', '\r'}, {' ', ' '}};
+            break;
+        case 't':
+            return ast.addLiteral('\t');
+        default:
+            return ast.addLiteral(c);
+        }
+        return AddClass(ast, Normalize(std::move(members)), c == 'D' || c == 'W' || c == 'S');
+    }
+
+    const std::u32string& p;
+    Ast& ast;
+    std::size_t at = 0;
+    std::string failure;
+};
+
+// Thompson construction: each state either has epsilon edges or consumes
+// one character of a set and moves to next
+struct NfaState {
+    std::vector<std::uint32_t> epsilon;
+    std::uint32_t set = NoSet;
+    std::uint32_t next = 0;
+};
+
+class NfaBuilder {
+public:
+    explicit NfaBuilder(const Ast& ast) : ast(ast) {}
+
+    struct Fragment {
+        std::uint32_t start;
+        std::uint32_t end;
+    };
+
+    std::vector<NfaState> states;
+    bool overflow = false;
+
+    Fragment build(std::uint32_t index) {
+        const Node& node = ast.nodes[index];
+        switch (node.kind) {
+        case Node::Kind::Set: {
+            const std::uint32_t start = add();
+            const std::uint32_t end = add();
+            states[start].set = node.set;
+            states[start].next = end;
+            return {start, end};
+        }
+        case Node::Kind::Concat: {
+            Fragment whole = build(node.children[0]);
+            for (std::size_t i = 1; i < node.children.size(); ++i) {
+                const Fragment part = build(node.children[i]);
+                link(whole.end, part.start);
+                whole.end = part.end;
+            }
+            return whole;
+        }
+        case Node::Kind::Alternate: {
+            const std::uint32_t start = add();
+            const std::uint32_t end = add();
+            for (std::uint32_t child : node.children) {
+                const Fragment option = build(child);
+                link(start, option.start);
+                link(option.end, end);
+            }
+            return {start, end};
+        }
+        case Node::Kind::Repeat: {
+            const std::uint32_t start = add();
+            std::uint32_t current = start;
+            for (std::uint32_t i = 0; i < node.min && !overflow; ++i) {
+                const Fragment copy = build(node.children[0]);
+                link(current, copy.start);
+                current = copy.end;
+            }
+            if (node.max == Unbounded) {
+                const std::uint32_t loop = add();
+                const Fragment copy = build(node.children[0]);
+                link(current, loop);
+                link(loop, copy.start);
+                link(copy.end, loop);
+                return {start, loop};
+            }
+            const std::uint32_t end = add();
+            for (std::uint32_t i = node.min; i < node.max && !overflow; ++i) {
+                const Fragment copy = build(node.children[0]);
+                link(current, end);
+                link(current, copy.start);
+                current = copy.end;
+            }
+            link(current, end);
+            return {start, end};
+        }
+        case Node::Kind::Empty:
+            break;
+        }
+        const std::uint32_t state = add();
+        return {state, state};
+    }
+
+private:
+    std::uint32_t add() {
+        if (states.size() >= MaxNfaStates) {
+            // Keep building on a scratch state; the caller reports the overflow
+            overflow = true;
+            return 0;
+        }
+        states.emplace_back();
+        return static_cast<std::uint32_t>(states.size() - 1);
+    }
+
+    void link(std::uint32_t from, std::uint32_t to) {
+        if (!overflow) {
+            states[from].epsilon.push_back(to);
+        }
+    }
+
+    const Ast& ast;
+};
+
+// Epsilon closure of a set of NFA states, returned sorted
+std::vector<std::uint32_t> Closure(const std::vector<NfaState>& nfa, std::vector<std::uint32_t> states,
+                                   std::vector<std::uint8_t>& seen) {
+    std::vector<std::uint32_t> result;
+    for (std::uint32_t s : states) {
+        seen[s] = 1;
+    }
+    while (!states.empty()) {
+        const std::uint32_t s = states.back();
+        states.pop_back();
+        result.push_back(s);
+        for (std::uint32_t next : nfa[s].epsilon) {
+            if (!seen[next]) {
+                seen[next] = 1;
+                states.push_back(next);
+            }
+        }
+    }
+    for (std::uint32_t s : result) {
+        seen[s] = 0;
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+} // namespace
+
+bool NamePattern::compile(NameView pattern, Syntax syntax, std::string& error) {
+    *this = NamePattern();
+    error.clear();
+
+    std::u32string p;
+    for (std::size_t i = 0; i < pattern.size();) {
+        p.push_back(DecodeNext(pattern, i));
+    }
+
+    // Parse into a syntax tree; searches that are not anchored at the start
+    // get a leading .* so the DFA finds matches anywhere in the name
+    Ast ast;
+    bool anchoredStart = true;
+    std::uint32_t root = 0;
+    if (syntax == Syntax::Glob) {
+        anchoredEnd = true;
+        root = ParseGlob(p, ast);
+    } else {
+        if (!p.empty() && p.front() == '^') {
+            p.erase(0, 1);
+        } else {
+            anchoredStart = false;
+        }
+        if (!p.empty() && p.back() == '$') {
+            std::size_t backslashes = 0;
+            for (std::size_t i = p.size() - 1; i > 0 && p[i - 1] == '\\'; --i) {
+                ++backslashes;
+            }
+            if (backslashes % 2 == 0) {
+                p.pop_back();
+                anchoredEnd = true;
+            }
+        }
+        if (!RegexParser(p, ast).parse(root, error)) {
+            return false;
+        }
+    }
+    if (!anchoredStart) {
+        root = ast.addList(Node::Kind::Concat, {ast.addRepeat(ast.addSet(AnySet()), 0, Unbounded), root});
+    }
+
+    NfaBuilder builder(ast);
+    const NfaBuilder::Fragment whole = builder.build(root);
+    if (builder.overflow) {
+        error = "pattern too large";
+        return false;
+    }
+    const std::vector<NfaState>& nfa = builder.states;
+
+    // Split the code points into classes: the boundaries of every set cut
+    // the range into pieces, and pieces inside the same sets share a class
+    std::vector<char32_t> cuts{0};
+    for (const CharSet& set : ast.sets) {
+        for (const auto& [low, high] : set) {
+            cuts.push_back(low);
+            if (high < MaxCodePoint) {
+                cuts.push_back(high + 1);
+            }
+        }
+    }
+    std::sort(cuts.begin(), cuts.end());
+    cuts.erase(std::unique(cuts.begin(), cuts.end()), cuts.end());
+
+    std::map<std::vector<std::uint32_t>, std::uint32_t> signatures;
+    std::vector<std::vector<std::uint32_t>> classSets; // Sets each class belongs to
+    std::vector<std::uint32_t> pieceClasses;
+    for (char32_t cut : cuts) {
+        std::vector<std::uint32_t> signature;
+        for (std::uint32_t set = 0; set < ast.sets.size(); ++set) {
+            const CharSet& members = ast.sets[set];
+            auto it = std::upper_bound(members.begin(), members.end(), Interval{cut, MaxCodePoint});
+            if (it != members.begin() && std::prev(it)->second >= cut) {
+                signature.push_back(set);
+            }
+        }
+        auto [entry, inserted] = signatures.emplace(signature, static_cast<std::uint32_t>(classSets.size()));
+        if (inserted) {
+            classSets.push_back(std::move(signature));
+        }
+        pieceClasses.push_back(entry->second);
+    }
+    classCount = static_cast<std::uint32_t>(classSets.size());
+
+    const auto pieceOf = [&](char32_t c) {
+        return static_cast<std::size_t>(std::upper_bound(cuts.begin(), cuts.end(), c) - cuts.begin() - 1);
+    };
+    // Names are folded before lookup, so the ASCII table folds for them
+    for (char32_t c = 0; c < 128; ++c) {
+        asciiClasses[c] = pieceClasses[pieceOf(FoldCodePoint(c))];
+    }
+    for (std::size_t piece = pieceOf(0x80); piece < cuts.size(); ++piece) {
+        rangeStarts.push_back(std::max<char32_t>(cuts[piece], 0x80));
+        rangeClasses.push_back(pieceClasses[piece]);
+    }
+
+    std::vector<std::vector<std::uint8_t>> inSet(ast.sets.size(), std::vector<std::uint8_t>(classCount, 0));
+    for (std::uint32_t cls = 0; cls < classCount; ++cls) {
+        for (std::uint32_t set : classSets[cls]) {
+            inSet[set][cls] = 1;
+        }
+    }
+
+    // Subset construction
+    std::vector<std::uint8_t> seen(nfa.size(), 0);
+    std::map<std::vector<std::uint32_t>, std::uint32_t> dfaStates;
+    std::vector<std::vector<std::uint32_t>> pending;
+    const auto stateFor = [&](std::vector<std::uint32_t> nfaStates) -> std::uint32_t {
+        auto [entry, inserted] = dfaStates.emplace(nfaStates, static_cast<std::uint32_t>(accepting.size()));
+        if (inserted) {
+            accepting.push_back(std::binary_search(nfaStates.begin(), nfaStates.end(), whole.end) ? 1 : 0);
+            transitions.resize(transitions.size() + classCount, 0);
+            pending.push_back(std::move(nfaStates));
+        }
+        return entry->second;
+    };
+
+    start = stateFor(Closure(nfa, {whole.start}, seen));
+    for (std::uint32_t state = 0; state < pending.size(); ++state) {
+        if (pending.size() > MaxDfaStates) {
+            *this = NamePattern();
+            error = "pattern too complex";
+            return false;
+        }
+        for (std::uint32_t cls = 0; cls < classCount; ++cls) {
+            std::vector<std::uint32_t> moved;
+            for (std::uint32_t s : pending[state]) {
+                if (nfa[s].set != NoSet && inSet[nfa[s].set][cls]) {
+                    moved.push_back(nfa[s].next);
+                }
+            }
+            transitions[static_cast<std::size_t>(state) * classCount + cls] =
+                stateFor(Closure(nfa, std::move(moved), seen));
+        }
+    }
+
+    // States that cannot reach an accepting state end the scan early
+    const std::size_t stateTotal = accepting.size();
+    std::vector<std::vector<std::uint32_t>> predecessors(stateTotal);
+    for (std::uint32_t state = 0; state < stateTotal; ++state) {
+        for (std::uint32_t cls = 0; cls < classCount; ++cls) {
+            predecessors[transitions[static_cast<std::size_t>(state) * classCount + cls]].push_back(state);
+        }
+    }
+    dead.assign(stateTotal, 1);
+    std::vector<std::uint32_t> live;
+    for (std::uint32_t state = 0; state < stateTotal; ++state) {
+        if (accepting[state]) {
+            dead[state] = 0;
+            live.push_back(state);
+        }
+    }
+    while (!live.empty()) {
+        const std::uint32_t state = live.back();
+        live.pop_back();
+        for (std::uint32_t previous : predecessors[state]) {
+            if (dead[previous]) {
+                dead[previous] = 0;
+                live.push_back(previous);
+            }
+        }
+    }
+    return true;
+}
+
+std::uint32_t NamePattern::classOf(char32_t c) const noexcept {
+    if (c < 0x80) {
+        return asciiClasses[c];
+    }
+    auto it = std::upper_bound(rangeStarts.begin(), rangeStarts.end(), c);
+    return rangeClasses[static_cast<std::size_t>(it - rangeStarts.begin()) - 1];
+}
+
+bool NamePattern::matches(NameView name) const noexcept {
+    if (!isCompiled()) {
+        return false;
+    }
+
+    std::uint32_t state = start;
+    if (!anchoredEnd && accepting[state]) {
+        return true;
+    }
+    for (std::size_t i = 0; i < name.size();) {
+        const NativeChar unit = name[i];
+        std::uint32_t cls;
+        if (static_cast<std::make_unsigned_t<NativeChar>>(unit) < 0x80) {
+            cls = asciiClasses[static_cast<std::size_t>(unit)];
+            ++i;
+        } else {
+            cls = classOf(FoldCodePoint(DecodeNext(name, i)));
+        }
+
+        state = transitions[static_cast<std::size_t>(state) * classCount + cls];
+        if (dead[state]) {
+            return false;
+        }
+        if (!anchoredEnd && accepting[state]) {
+            return true;
+        }
+    }
+    return accepting[state] != 0;
+}
+
+} // namespace ffe
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "engine/DirEntry.hpp"
+
+#include <string>
+#include <vector>
+
+namespace ffe {
+
+// Glob or regular expression compiled to a DFA over case-folded code
+// points. Matching a name is a single pass with one table lookup per
+// character, without backtracking or allocation, so a query costs time
+// linear in the name whatever the pattern.
+//
+// Globs match the whole name: * any run of characters, ? one character,
+// [abc] [a-z] [!abc] character classes. An unclosed [ is a literal.
+//
+// Regular expressions search the name unless anchored and support literals,
+// ., [...] classes with ranges and negation, \d \w \s and their negations,
+// groups, |, the quantifiers * + ? {m} {m,} {m,n}, and ^ and $ at the very
+// start and end of the pattern. Back-references and lookaround need
+// backtracking and are rejected.
+class NamePattern {
+public:
+    enum class Syntax : std::uint8_t {
+        Glob,
+        Regex,
+    };
+
+    // Compiles pattern; on failure returns false and describes the problem in error
+    bool compile(NameView pattern, Syntax syntax, std::string& error);
+
+    bool isCompiled() const noexcept {
+        return !transitions.empty();
+    }
+
+    bool matches(NameView name) const noexcept;
+
+    std::size_t stateCount() const noexcept {
+        return accepting.size();
+    }
+
+private:
+    // Folded code points are mapped to classes of characters no pattern
+    // element tells apart; ASCII through a table, the rest by binary search
+    std::uint32_t classOf(char32_t c) const noexcept;
+
+    std::uint32_t asciiClasses[128] = {};
+    std::vector<char32_t> rangeStarts;          // Start of each non-ASCII range, sorted
+    std::vector<std::uint32_t> rangeClasses;    // Class of each range
+    std::uint32_t classCount = 0;
+
+    std::vector<std::uint32_t> transitions;     // state * classCount + class -> state
+    std::vector<std::uint8_t> accepting;
+    std::vector<std::uint8_t> dead;             // No accepting state is reachable
+    std::uint32_t start = 0;
+    bool anchoredEnd = false;                   // Must accept at the end, not anywhere
+};
+
+} // namespace ffe
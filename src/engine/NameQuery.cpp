@@ -0,0 +1,43 @@
+#include "engine/NameQuery.hpp"
+
+#include <algorithm>
+
+namespace ffe {
+
+bool NameQuery::parse(NameView text, std::string& error) {
+    error.clear();
+    pattern = NamePattern();
+    substring = NameMatcher(NameView());
+    fuzzy = FuzzyMatcher(NameView());
+
+    if (text.size() >= 3 && text[0] == 'r' && text[1] == 'e' && text[2] == ':') {
+        queryMode = Mode::Regex;
+        return pattern.compile(text.substr(3), NamePattern::Syntax::Regex, error);
+    }
+    if (!text.empty() && text[0] == '~') {
+        queryMode = Mode::Fuzzy;
+        fuzzy = FuzzyMatcher(text.substr(1));
+        return true;
+    }
+    if (std::any_of(text.begin(), text.end(), [](NativeChar c) { return c == '*' || c == '?' || c == '['; })) {
+        queryMode = Mode::Glob;
+        return pattern.compile(text, NamePattern::Syntax::Glob, error);
+    }
+
+    queryMode = Mode::Substring;
+    substring = NameMatcher(text);
+    return true;
+}
+
+bool NameQuery::matches(NameView name) const noexcept {
+    switch (queryMode) {
+    case Mode::Substring:
+        return substring.matches(name);
+    case Mode::Fuzzy:
+        return fuzzy.matches(name);
+    default:
+        return pattern.matches(name);
+    }
+}
+
+} // namespace ffe
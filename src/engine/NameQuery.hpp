@@ -0,0 +1,48 @@
+#pragma once
+
+#include "engine/FuzzyMatcher.hpp"
+#include "engine/NameMatcher.hpp"
+#include "engine/NamePattern.hpp"
+
+namespace ffe {
+
+// A search box query. Text starting with "re:" is a regular expression,
+// text starting with ~ is a fuzzy query whose hits are ranked, text
+// containing * ? or [ is a glob over the whole name, and anything else is a
+// case-insensitive substring. Built once per search and shared by all
+// search threads.
+class NameQuery {
+public:
+    enum class Mode : std::uint8_t {
+        Substring,
+        Glob,
+        Regex,
+        Fuzzy,
+    };
+
+    // Returns false and describes the problem in error when the pattern does not compile
+    bool parse(NameView text, std::string& error);
+
+    bool matches(NameView name) const noexcept;
+
+    Mode mode() const noexcept {
+        return queryMode;
+    }
+
+    // Fuzzy hits are ranked by score rather than listed by name
+    bool isRanked() const noexcept {
+        return queryMode == Mode::Fuzzy;
+    }
+
+    const FuzzyMatcher& fuzzyMatcher() const noexcept {
+        return fuzzy;
+    }
+
+private:
+    Mode queryMode = Mode::Substring;
+    NameMatcher substring{NameView()};
+    NamePattern pattern;
+    FuzzyMatcher fuzzy{NameView()};
+};
+
+} // namespace ffe
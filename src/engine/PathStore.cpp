@@ -0,0 +1,106 @@
+#include "engine/PathStore.hpp"
+
+namespace ffe {
+
+namespace {
+
+bool IsSeparator(NativeChar c) noexcept {
+    return c == '/' || c == fs::path::preferred_separator;
+}
+
+} // namespace
+
+PathStore::PathStore() {
+    clear();
+}
+
+std::size_t PathStore::Hash(Handle parent, NameView name) noexcept {
+    std::uint64_t hash = 14695981039346656037ull ^ parent;
+    for (NativeChar c : name) {
+        hash = (hash ^ static_cast<std::uint64_t>(c)) * 1099511628211ull;
+    }
+    return static_cast<std::size_t>(hash ^ (hash >> 29));
+}
+
+PathStore::Handle PathStore::intern(const fs::path& path) {
+    Handle handle = Empty;
+    for (const fs::path& component : path) {
+        handle = child(handle, component.native());
+    }
+    return handle;
+}
+
+PathStore::Handle PathStore::child(Handle parent, NameView name) {
+    const std::size_t mask = slots.size() - 1;
+    std::size_t slot = Hash(parent, name) & mask;
+    for (; slots[slot] != NoSlot; slot = (slot + 1) & mask) {
+        const Handle candidate = slots[slot];
+        if (nodes[candidate].parent == parent && this->name(candidate) == name) {
+            return candidate;
+        }
+    }
+
+    const auto handle = static_cast<Handle>(nodes.size());
+    nodes.push_back({parent, static_cast<std::uint32_t>(names.size()), static_cast<std::uint32_t>(name.size())});
+    names.append(name);
+    slots[slot] = handle;
+
+    // Keep the table at most half full so probe runs stay short
+    if (nodes.size() * 2 > slots.size()) {
+        grow();
+    }
+    return handle;
+}
+
+fs::path PathStore::path(Handle handle) const {
+    std::vector<Handle> chain;
+    std::size_t units = 0;
+    for (; handle != Empty; handle = nodes[handle].parent) {
+        chain.push_back(handle);
+        units += nodes[handle].nameLength + 1;
+    }
+    if (chain.empty()) {
+        return {};
+    }
+
+    // Joined from the root down the way operator/= would, without parsing
+    // the path again at every step: a separator between components, except
+    // after one that ends in a separator or after a root name ("C:foo")
+    fs::path::string_type text;
+    text.reserve(units);
+    text.append(name(chain.back()));
+    const bool rootName = fs::path(text).has_root_name();
+    for (auto it = chain.rbegin() + 1; it != chain.rend(); ++it) {
+        const bool afterRootName = rootName && it == chain.rbegin() + 1;
+        if (!afterRootName && !IsSeparator(text.back())) {
+            text += fs::path::preferred_separator;
+        }
+        text.append(name(*it));
+    }
+    return fs::path(std::move(text));
+}
+
+void PathStore::clear() {
+    nodes.assign(1, Node{Empty, 0, 0});
+    names.clear();
+    slots.assign(64, NoSlot);
+}
+
+std::size_t PathStore::memoryUsage() const noexcept {
+    return nodes.capacity() * sizeof(Node) + names.capacity() * sizeof(NativeChar) + slots.capacity() * sizeof(Handle);
+}
+
+void PathStore::grow() {
+    std::vector<Handle> larger(slots.size() * 2, NoSlot);
+    const std::size_t mask = larger.size() - 1;
+    for (Handle handle = 1; handle < nodes.size(); ++handle) {
+        std::size_t slot = Hash(nodes[handle].parent, name(handle)) & mask;
+        while (larger[slot] != NoSlot) {
+            slot = (slot + 1) & mask;
+        }
+        larger[slot] = handle;
+    }
+    slots.swap(larger);
+}
+
+} // namespace ffe
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "engine/DirEntry.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ffe {
+
+// Interned paths kept as a tree: every distinct path is one node holding
+// its parent's handle and its last component, with all components in one
+// shared buffer. A million search hits below a few thousand folders cost
+// a few thousand folder nodes plus one node per hit, instead of a million
+// full path strings. Full paths are put together only when asked for.
+//
+// Handles are stable indexes and never change while the store lives; the
+// empty path is handle Empty. Interning is exact (no case folding), as
+// paths produced by one enumeration spell a folder the same way each time.
+// Not thread safe.
+class PathStore {
+public:
+    using Handle = std::uint32_t;
+
+    static constexpr Handle Empty = 0;
+
+    PathStore();
+
+    // Handle of path, adding its missing ancestors
+    Handle intern(const fs::path& path);
+
+    // Handle of the path name below parent, one component
+    Handle child(Handle parent, NameView name);
+
+    Handle parent(Handle handle) const noexcept {
+        return nodes[handle].parent;
+    }
+
+    // Last component of a path ("" for Empty)
+    NameView name(Handle handle) const noexcept {
+        const Node& node = nodes[handle];
+        return NameView(names).substr(node.nameOffset, node.nameLength);
+    }
+
+    fs::path path(Handle handle) const;
+
+    // Paths interned, Empty included
+    std::size_t size() const noexcept {
+        return nodes.size();
+    }
+
+    void clear();
+
+    // Bytes held for nodes, names and the lookup table
+    std::size_t memoryUsage() const noexcept;
+
+private:
+    struct Node {
+        Handle parent;
+        std::uint32_t nameOffset;
+        std::uint32_t nameLength;
+    };
+
+    static constexpr Handle NoSlot = 0xffffffffu;
+
+    static std::size_t Hash(Handle parent, NameView name) noexcept;
+    void grow();
+
+    std::vector<Node> nodes;
+    fs::path::string_type names;
+    std::vector<Handle> slots; // Open addressing table of nodes by (parent, name)
+};
+
+} // namespace ffe
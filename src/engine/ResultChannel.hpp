@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace ffe {
+
+// Multi-producer, single-consumer hand-off of results in batches. Producers
+// publish whole batches with one compare-and-swap on a lock-free stack; the
+// consumer takes everything published so far with one exchange and gets it
+// back in publication order. Neither side ever waits for the other.
+//
+// The onReady callback runs on the producer thread whose batch finds the
+// channel empty, i.e. at most once per drain, so the consumer can be woken
+// with a single message however many batches pile up in between.
+template<class T>
+class ResultChannel {
+public:
+    explicit ResultChannel(std::function<void()> onReady = {}) : onReady(std::move(onReady)) {}
+
+    ResultChannel(const ResultChannel&) = delete;
+    ResultChannel& operator=(const ResultChannel&) = delete;
+
+    ~ResultChannel() {
+        Node* node = head.exchange(nullptr, std::memory_order_acquire);
+        while (node) {
+            Node* next = node->next;
+            delete node;
+            node = next;
+        }
+    }
+
+    // Collects one producer's results and publishes them together, when
+    // capacity results have accumulated and when the batch is destroyed
+    class Batch {
+    public:
+        static constexpr std::size_t DefaultCapacity = 256;
+
+        explicit Batch(ResultChannel& channel, std::size_t capacity = DefaultCapacity)
+            : channel(channel), capacity(capacity) {}
+
+        Batch(const Batch&) = delete;
+        Batch& operator=(const Batch&) = delete;
+
+        ~Batch() {
+            flush();
+        }
+
+        void add(T item) {
+            items.push_back(std::move(item));
+            if (items.size() >= capacity) {
+                flush();
+            }
+        }
+
+        void flush() {
+            if (!items.empty()) {
+                channel.publish(std::move(items));
+                items.clear();
+            }
+        }
+
+    private:
+        ResultChannel& channel;
+        std::size_t capacity;
+        std::vector<T> items;
+    };
+
+    // Safe to call from any number of threads at once
+    void publish(std::vector<T> items) {
+        if (items.empty()) {
+            return;
+        }
+        Node* node = new Node{std::move(items), head.load(std::memory_order_relaxed)};
+        while (!head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {
+        }
+        if (!node->next && onReady) {
+            onReady();
+        }
+    }
+
+    // Appends everything published so far to out, oldest batch first, and
+    // returns the number of results added. Consumer thread only.
+    std::size_t drain(std::vector<T>& out) {
+        // The stack holds the newest batch first; reverse it
+        Node* node = head.exchange(nullptr, std::memory_order_acquire);
+        Node* oldest = nullptr;
+        while (node) {
+            Node* next = node->next;
+            node->next = oldest;
+            oldest = node;
+            node = next;
+        }
+
+        std::size_t count = 0;
+        while (oldest) {
+            count += oldest->items.size();
+            out.insert(out.end(), std::make_move_iterator(oldest->items.begin()),
+                       std::make_move_iterator(oldest->items.end()));
+            Node* next = oldest->next;
+            delete oldest;
+            oldest = next;
+        }
+        return count;
+    }
+
+    bool empty() const noexcept {
+        return head.load(std::memory_order_acquire) == nullptr;
+    }
+
+private:
+    struct Node {
+        std::vector<T> items;
+        Node* next;
+    };
+
+    std::atomic<Node*> head{nullptr};
+    std::function<void()> onReady;
+};
+
+} // namespace ffe
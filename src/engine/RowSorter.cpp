@@ -0,0 +1,326 @@
+#include "engine/RowSorter.hpp"
+
+#include "engine/Collation.hpp"
+#include "engine/Trace.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <latch>
+#include <mutex>
+
+namespace ffe {
+
+namespace {
+
+// Fewer rows than this are sorted on the calling thread
+constexpr std::size_t ParallelRows = 1 << 16;
+
+// Bytes from start of a key as a big-endian number, zero padded
+std::uint64_t KeyWord(const char* key, std::size_t length, std::size_t start) noexcept {
+    std::uint64_t word = 0;
+    for (std::size_t i = start; i < start + sizeof(word); ++i) {
+        word = (word << 8) | (i < length ? static_cast<unsigned char>(key[i]) : 0);
+    }
+    return word;
+}
+
+template<class T>
+int Compare(T a, T b) noexcept {
+    return a < b ? -1 : b < a ? 1 : 0;
+}
+
+int CompareBytes(const char* a, std::size_t aLength, const char* b, std::size_t bLength) noexcept {
+    const int result = std::memcmp(a, b, std::min(aLength, bLength));
+    return result != 0 ? result : Compare(aLength, bLength);
+}
+
+// Runs body(0) .. body(count - 1) on the executor and waits for all of
+// them; the first exception a part throws is rethrown here
+template<class Body>
+void RunParallel(Executor& executor, std::size_t count, const Body& body) {
+    std::latch done(static_cast<std::ptrdiff_t>(count));
+    std::mutex failureMutex;
+    std::exception_ptr failure;
+    for (std::size_t part = 0; part < count; ++part) {
+        try {
+            executor.submit([&body, &done, &failureMutex, &failure, part] {
+                // However the part ends, it counts as done, so the wait ends
+                struct CountDown {
+                    std::latch& done;
+                    ~CountDown() {
+                        done.count_down();
+                    }
+                } countDown{done};
+
+                try {
+                    body(part);
+                }
+                catch (...) {
+                    std::lock_guard<std::mutex> lock(failureMutex);
+                    if (!failure) {
+                        failure = std::current_exception();
+                    }
+                }
+            });
+        }
+        catch (...) {
+            // The parts already submitted refer to this frame: wait for them
+            done.count_down(static_cast<std::ptrdiff_t>(count - part));
+            done.wait();
+            throw;
+        }
+    }
+    done.wait();
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
+
+// Elements of a among the first t of merge(a, b)
+template<class T, class Less>
+std::size_t CoRank(std::size_t t, const T* a, std::size_t aSize, const T* b, std::size_t bSize, const Less& less) {
+    std::size_t low = t > bSize ? t - bSize : 0;
+    std::size_t high = std::min(t, aSize);
+    while (low < high) {
+        const std::size_t i = (low + high + 1) / 2;
+        if (less(a[i - 1], b[t - i])) {
+            low = i;
+        } else {
+            high = i - 1;
+        }
+    }
+    return low;
+}
+
+// Sorts parts of items concurrently, then merges them pairwise through
+// scratch. A round with fewer merges than parts splits each merge at
+// co-ranks so it still runs on every worker.
+template<class T, class Less>
+void ParallelSort(Executor& executor, std::size_t parts, std::vector<T>& items, const Less& less) {
+    const std::size_t count = items.size();
+    std::vector<std::size_t> bounds(parts + 1);
+    for (std::size_t part = 0; part <= parts; ++part) {
+        bounds[part] = count * part / parts;
+    }
+    RunParallel(executor, parts, [&](std::size_t part) {
+        std::sort(items.begin() + bounds[part], items.begin() + bounds[part + 1], less);
+    });
+
+    std::vector<T> scratch(count);
+    while (bounds.size() > 2) {
+        const std::size_t merges = (bounds.size() - 1) / 2;
+        const std::size_t splits = std::max<std::size_t>(1, parts / merges);
+        std::vector<std::size_t> merged;
+        for (std::size_t k = 0; k + 2 < bounds.size(); k += 2) {
+            merged.push_back(bounds[k]);
+        }
+        RunParallel(executor, merges * splits, [&](std::size_t task) {
+            const std::size_t first = bounds[task / splits * 2];
+            const std::size_t middle = bounds[task / splits * 2 + 1];
+            const std::size_t last = bounds[task / splits * 2 + 2];
+            const T* a = items.data() + first;
+            const T* b = items.data() + middle;
+            const std::size_t aSize = middle - first;
+            const std::size_t bSize = last - middle;
+            const std::size_t piece = task % splits;
+            const std::size_t from = (aSize + bSize) * piece / splits;
+            const std::size_t to = (aSize + bSize) * (piece + 1) / splits;
+            const std::size_t aFrom = CoRank(from, a, aSize, b, bSize, less);
+            const std::size_t aTo = CoRank(to, a, aSize, b, bSize, less);
+            std::merge(a + aFrom, a + aTo, b + (from - aFrom), b + (to - aTo), scratch.data() + first + from, less);
+        });
+        // An odd run out keeps its place
+        if ((bounds.size() - 1) % 2 == 1) {
+            const std::size_t first = bounds[bounds.size() - 2];
+            std::copy(items.begin() + first, items.end(), scratch.begin() + first);
+            merged.push_back(first);
+        }
+        merged.push_back(count);
+        items.swap(scratch);
+        bounds.swap(merged);
+    }
+}
+
+} // namespace
+
+SortOrder SortOrder::reversed() const {
+    SortOrder flipped = *this;
+    for (SortKey& key : flipped.keys) {
+        key.descending = !key.descending;
+    }
+    return flipped;
+}
+
+void RowSorter::sort(EntryModel& model, const SortOrder& order) {
+    TraceSpan span("RowSorter::sort");
+    span.arg("rows", static_cast<std::int64_t>(model.size()));
+    if (keys.size() > model.size()) {
+        clear();
+    }
+    addKeys(model);
+
+    // Sizes and times may have arrived since the last sort, so only orders
+    // that do not look at them can be flipped by reversing
+    const bool needsStat = std::any_of(order.keys.begin(), order.keys.end(), [](const SortKey& key) {
+        return key.column == SortColumn::Size || key.column == SortColumn::Modified;
+    });
+    if (sorted && !needsStat && order == current.reversed()) {
+        std::reverse(keys.begin(), keys.end());
+    } else {
+        if (needsStat) {
+            model.forEachRow(0, model.size(), [this](std::size_t index, const EntryModel::Row& row) {
+                keys[index].size = row.hasStat ? row.size : 0;
+                keys[index].mtime = row.hasStat ? row.mtime : 0;
+            });
+        }
+
+        const char* bytes = keyBytes.data();
+        const auto compareName = [bytes](const RowKey& a, const RowKey& b) {
+            if (a.prefix[0] != b.prefix[0]) {
+                return Compare(a.prefix[0], b.prefix[0]);
+            }
+            if (a.prefix[1] != b.prefix[1]) {
+                return Compare(a.prefix[1], b.prefix[1]);
+            }
+            if (a.nameLength <= sizeof(a.prefix) && b.nameLength <= sizeof(b.prefix)) {
+                return 0; // Keys have no zero bytes, so equal padded prefixes are equal keys
+            }
+            return CompareBytes(bytes + a.offset, a.nameLength, bytes + b.offset, b.nameLength);
+        };
+        const auto compareColumn = [bytes, &compareName](SortColumn column, const RowKey& a, const RowKey& b) {
+            switch (column) {
+            case SortColumn::Type:
+                if (a.typePrefix != b.typePrefix) {
+                    return Compare(a.typePrefix, b.typePrefix);
+                }
+                if (a.typeLength <= sizeof(a.typePrefix) && b.typeLength <= sizeof(b.typePrefix)) {
+                    return 0;
+                }
+                return CompareBytes(bytes + a.offset + a.nameLength, a.typeLength, bytes + b.offset + b.nameLength,
+                                    b.typeLength);
+            case SortColumn::Size:
+                return Compare(a.size, b.size);
+            case SortColumn::Modified:
+                return Compare(a.mtime, b.mtime);
+            case SortColumn::Name:
+                break;
+            }
+            return compareName(a, b);
+        };
+
+        const bool descending = !order.keys.empty() && order.keys.front().descending;
+        const auto less = [&order, descending, &compareName, &compareColumn](const RowKey& a, const RowKey& b) {
+            if (order.foldersFirst && a.directory != b.directory) {
+                return a.directory != descending;
+            }
+            for (const SortKey& key : order.keys) {
+                if (const int result = compareColumn(key.column, a, b); result != 0) {
+                    return key.descending ? result > 0 : result < 0;
+                }
+            }
+            if (const int result = compareName(a, b); result != 0) {
+                return descending ? result > 0 : result < 0;
+            }
+            return a.row < b.row;
+        };
+
+        const bool onWorker = executor && executor->currentWorker() != Executor::NoWorker;
+        if (executor && !onWorker && executor->threadCount() > 1 && keys.size() >= ParallelRows) {
+            ParallelSort(*executor, executor->threadCount(), keys, less);
+        } else {
+            std::sort(keys.begin(), keys.end(), less);
+        }
+    }
+
+    std::vector<std::uint32_t> moved(keys.size());
+    for (std::size_t index = 0; index < keys.size(); ++index) {
+        moved[index] = keys[index].row;
+        keys[index].row = static_cast<std::uint32_t>(index);
+    }
+    model.reorder(moved);
+    current = order;
+    sorted = true;
+}
+
+void RowSorter::clear() noexcept {
+    keys.clear();
+    keyBytes.clear();
+    sorted = false;
+}
+
+std::size_t RowSorter::memoryUsage() const noexcept {
+    return keys.capacity() * sizeof(RowKey) + keyBytes.capacity();
+}
+
+void RowSorter::addKeys(const EntryModel& model) {
+    const std::size_t first = keys.size();
+    const std::size_t count = model.size() - first;
+    if (count == 0) {
+        return;
+    }
+
+    // Parts key their rows into buffers of their own, joined afterwards
+    struct Part {
+        std::vector<RowKey> keys;
+        std::string bytes;
+    };
+    const bool parallel = executor && executor->currentWorker() == Executor::NoWorker &&
+                          executor->threadCount() > 1 && count >= ParallelRows;
+    std::vector<Part> parts(parallel ? executor->threadCount() : 1);
+    const auto keyPart = [&](std::size_t part) {
+        Part& out = parts[part];
+        const std::size_t from = first + count * part / parts.size();
+        const std::size_t to = first + count * (part + 1) / parts.size();
+        out.keys.reserve(to - from);
+        out.bytes.reserve((to - from) * 32);
+        model.forEachRow(from, to, [&out](std::size_t index, const EntryModel::Row& row) {
+            const std::size_t offset = out.bytes.size();
+            AppendCollationKey(row.name, out.bytes);
+            const std::size_t nameLength = out.bytes.size() - offset;
+            if (!row.isDirectory()) {
+                AppendCollationKey(FileExtension(row.name), out.bytes);
+            }
+            // Extensions longer than a byte can count are compared by their start
+            const std::size_t typeLength = std::min<std::size_t>(out.bytes.size() - offset - nameLength, 0xFF);
+            out.bytes.resize(offset + nameLength + typeLength);
+
+            RowKey key;
+            key.prefix[0] = KeyWord(out.bytes.data() + offset, nameLength, 0);
+            key.prefix[1] = KeyWord(out.bytes.data() + offset, nameLength, sizeof(std::uint64_t));
+            key.typePrefix = KeyWord(out.bytes.data() + offset + nameLength, typeLength, 0);
+            key.offset = offset;
+            key.size = row.hasStat ? row.size : 0;
+            key.mtime = row.hasStat ? row.mtime : 0;
+            key.row = static_cast<std::uint32_t>(index);
+            key.nameLength = static_cast<std::uint16_t>(nameLength);
+            key.typeLength = static_cast<std::uint8_t>(typeLength);
+            key.directory = row.isDirectory();
+            out.keys.push_back(key);
+        });
+    };
+    if (parallel) {
+        RunParallel(*executor, parts.size(), keyPart);
+    } else {
+        keyPart(0);
+    }
+
+    if (keys.empty() && parts.size() == 1) {
+        keys = std::move(parts.front().keys);
+        keyBytes = std::move(parts.front().bytes);
+    } else {
+        keys.reserve(model.size());
+        for (Part& part : parts) {
+            const std::size_t base = keyBytes.size();
+            keyBytes.append(part.bytes);
+            for (RowKey& key : part.keys) {
+                key.offset += base;
+                keys.push_back(key);
+            }
+        }
+    }
+    // New rows are not in order yet
+    sorted = false;
+}
+
+} // namespace ffe
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "engine/EntryModel.hpp"
+#include "engine/Executor.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ffe {
+
+enum class SortColumn : std::uint8_t {
+    Name,
+    Type, // By extension
+    Size,
+    Modified,
+};
+
+struct SortKey {
+    SortColumn column = SortColumn::Name;
+    bool descending = false;
+
+    bool operator==(const SortKey&) const = default;
+};
+
+// Columns compared in turn; rows equal on all of them are compared by name
+// in the direction of the first column. Folders are grouped ahead of files
+// in that direction too, so a descending sort shows them last, as Explorer
+// does.
+struct SortOrder {
+    std::vector<SortKey> keys = {SortKey{}};
+    bool foldersFirst = true;
+
+    bool operator==(const SortOrder&) const = default;
+
+    // The same columns with every direction flipped
+    SortOrder reversed() const;
+};
+
+// Sorts the rows of an EntryModel by collation keys computed once per row.
+//
+// Keys (name and extension, see AppendCollationKey) are kept across sorts
+// and follow the rows as they move, so sorting again by another column only
+// compares what is already there; rows appended since the last sort get
+// their keys then, and flipping the direction of the same columns just
+// reverses the rows. Sorting splits the rows over the executor, sorts the
+// parts and merges them pairwise, the last merges split again by binary
+// search so every worker stays busy.
+//
+// The sorter assumes the rows it keyed are still the model's first rows in
+// the order it left them: call clear() whenever the model is cleared or
+// reordered elsewhere. Size and mtime are read again at every sort that
+// needs them, since metadata arrives after the rows do.
+class RowSorter {
+public:
+    explicit RowSorter(Executor* executor = nullptr) : executor(executor) {}
+
+    void sort(EntryModel& model, const SortOrder& order);
+
+    // Order of the last sort
+    const SortOrder& order() const noexcept {
+        return current;
+    }
+
+    // Forgets every key, for a model that was cleared
+    void clear() noexcept;
+
+    // Bytes held for keys
+    std::size_t memoryUsage() const noexcept;
+
+private:
+    struct RowKey {
+        // Start of the name and extension keys, big-endian and zero padded,
+        // so most comparisons never reach keyBytes
+        std::uint64_t prefix[2];
+        std::uint64_t typePrefix;
+        std::uint64_t offset; // Name key, then extension key, in keyBytes
+        std::uint64_t size;
+        std::int64_t mtime;
+        std::uint32_t row; // Index of the row in the model
+        std::uint16_t nameLength;
+        std::uint8_t typeLength;
+        bool directory;
+    };
+    static_assert(sizeof(RowKey) == 56);
+
+    void addKeys(const EntryModel& model);
+
+    Executor* executor;
+    std::vector<RowKey> keys;
+    std::string keyBytes;
+    SortOrder current;
+    bool sorted = false; // keys and the model are in current order
+};
+
+} // namespace ffe
@@ -0,0 +1,354 @@
+#include "engine/SpaceAnalyzer.hpp"
+
+#include "engine/DirectoryReader.hpp"
+#include "engine/StatEngine.hpp"
+#include "engine/SubtreeWalk.hpp"
+#include "engine/TopK.hpp"
+#include "engine/Trace.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <condition_variable>
+#include <span>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace ffe {
+
+namespace {
+
+// Files with several names are remembered over this many locks
+constexpr std::size_t Stripes = 64;
+
+// Longer extensions are mostly not extensions but dotted names, such as
+// hashes or versions, and are tallied with the rest
+constexpr std::size_t MaxExtensionLength = 16;
+
+// (device, file) of a file with several names
+struct LinkKey {
+    std::uint64_t device;
+    std::uint64_t file;
+
+    bool operator==(const LinkKey&) const = default;
+};
+
+struct LinkKeyHash {
+    std::size_t operator()(const LinkKey& key) const noexcept {
+        std::uint64_t value = key.file ^ std::rotl(key.device, 29);
+        value ^= value >> 33;
+        value *= 0xFF51AFD7ED558CCDull;
+        value ^= value >> 33;
+        return static_cast<std::size_t>(value);
+    }
+};
+
+struct alignas(64) LinkStripe {
+    std::mutex mutex;
+    std::unordered_set<LinkKey, LinkKeyHash> seen;
+};
+
+// What one worker has ranked and tallied; only the snapshot takes its lock
+// from another thread
+struct alignas(64) Shard {
+    explicit Shard(const SpaceOptions& options) : files(options.topFiles), folders(options.topFolders) {}
+
+    std::mutex mutex;
+    TopK<SpaceItem> files;
+    TopK<SpaceItem> folders;
+    std::unordered_map<fs::path::string_type, ExtensionSpace> extensions;
+    ExtensionSpace other{{}, true};
+    FolderSize total;
+};
+
+void AddTo(ExtensionSpace& into, const ExtensionSpace& from) {
+    into.bytes += from.bytes;
+    into.allocated += from.allocated;
+    into.files += from.files;
+}
+
+// Sets key to the lowercased extension of name; false when it is too long
+// to be one
+bool ExtensionOf(const fs::path::string_type& name, fs::path::string_type& key) {
+    key.clear();
+    const auto dot = name.rfind(NativeChar('.'));
+    if (dot == fs::path::string_type::npos || dot == 0) {
+        return true;
+    }
+    if (name.size() - dot - 1 > MaxExtensionLength) {
+        return false;
+    }
+    key.assign(name, dot + 1);
+    for (NativeChar& c : key) {
+        if (c >= NativeChar('A') && c <= NativeChar('Z')) {
+            c = static_cast<NativeChar>(c - NativeChar('A') + NativeChar('a'));
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+struct SpaceAnalyzer::Scan {
+    Scan(Executor& executor, const SpaceOptions& options, std::size_t roots)
+        : executor(executor), options(options), remaining(roots) {
+        // One shard per worker, and one for callers outside the pool
+        for (std::size_t index = 0; index <= executor.threadCount(); ++index) {
+            shards.push_back(std::make_unique<Shard>(options));
+        }
+    }
+
+    Executor& executor;
+    const SpaceOptions options;
+    std::atomic<bool> cancelled{false};
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    std::array<LinkStripe, Stripes> links;
+
+    std::atomic<std::uint64_t> pending{0}; // Folders created and not finished
+    std::atomic<std::uint64_t> peak{0};
+
+    std::mutex mutex;
+    std::condition_variable finished;
+    std::size_t remaining; // Roots not finished
+
+    Shard& shard() {
+        return *shards[std::min(executor.currentWorker(), shards.size() - 1)];
+    }
+
+    // Whether this is the first name of a file with several names the walk
+    // has met
+    bool firstName(const FileIdentity& identity) {
+        const LinkKey key{identity.device, identity.file};
+        LinkStripe& stripe = links[LinkKeyHash()(key) % Stripes];
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        return stripe.seen.insert(key).second;
+    }
+
+    void added() {
+        const std::uint64_t now = pending.fetch_add(1, std::memory_order_relaxed) + 1;
+        std::uint64_t high = peak.load(std::memory_order_relaxed);
+        while (now > high && !peak.compare_exchange_weak(high, now, std::memory_order_relaxed)) {
+        }
+    }
+
+    void cancel() {
+        cancelled = true;
+        std::lock_guard<std::mutex> lock(mutex);
+        finished.notify_all();
+    }
+
+    using Data = FolderSize;
+
+    void visit(const fs::path& dir, FolderSize& own, std::vector<fs::path::string_type>& subfolders);
+    void finish(const fs::path& dir, FolderSize& size, bool root);
+
+    void merge(FolderSize& into, const FolderSize& from) {
+        into.add(from);
+    }
+
+    void failed(FolderSize& size) {
+        size.errors++;
+    }
+};
+
+SpaceAnalyzer::SpaceAnalyzer(Executor& executor, SpaceOptions options)
+    : executor(executor), options(std::move(options)) {
+}
+
+SpaceAnalyzer::~SpaceAnalyzer() {
+    cancel();
+}
+
+void SpaceAnalyzer::scan(std::vector<fs::path> roots) {
+    auto scan = std::make_shared<Scan>(executor, options, roots.size());
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (current) {
+            current->cancel();
+        }
+        current = scan;
+    }
+    for (fs::path& root : roots) {
+        scan->added();
+        SubtreeWalk<Scan>::Start(scan, std::move(root));
+    }
+}
+
+void SpaceAnalyzer::cancel() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (current) {
+        current->cancel();
+    }
+}
+
+void SpaceAnalyzer::wait() {
+    std::shared_ptr<Scan> scan;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        scan = current;
+    }
+    if (!scan) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(scan->mutex);
+    scan->finished.wait(lock, [&scan] {
+        return scan->remaining == 0 || scan->cancelled.load(std::memory_order_relaxed);
+    });
+}
+
+SpaceReport SpaceAnalyzer::snapshot() const {
+    TraceSpan span("SpaceAnalyzer::snapshot");
+    std::shared_ptr<Scan> scan;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        scan = current;
+    }
+    SpaceReport report;
+    if (!scan) {
+        report.done = true;
+        return report;
+    }
+
+    TopK<SpaceItem> files(options.topFiles);
+    TopK<SpaceItem> folders(options.topFolders);
+    std::unordered_map<fs::path::string_type, ExtensionSpace> extensions;
+    ExtensionSpace other{{}, true};
+    for (const auto& shard : scan->shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        files.merge(shard->files);
+        folders.merge(shard->folders);
+        for (const auto& [extension, space] : shard->extensions) {
+            auto [it, inserted] = extensions.try_emplace(extension, ExtensionSpace{extension});
+            AddTo(it->second, space);
+        }
+        AddTo(other, shard->other);
+        report.total.add(shard->total);
+    }
+    report.files = files.sorted();
+    report.folders = folders.sorted();
+
+    // Workers may each have tallied different extensions; past the limit
+    // the smallest join the rest
+    report.extensions.reserve(extensions.size() + 1);
+    for (auto& [extension, space] : extensions) {
+        report.extensions.push_back(std::move(space));
+    }
+    const auto larger = [](const ExtensionSpace& a, const ExtensionSpace& b) {
+        return a.allocated != b.allocated ? a.allocated > b.allocated : a.bytes > b.bytes;
+    };
+    std::sort(report.extensions.begin(), report.extensions.end(), larger);
+    while (report.extensions.size() > options.maxExtensions) {
+        AddTo(other, report.extensions.back());
+        report.extensions.pop_back();
+    }
+    if (other.files > 0) {
+        report.extensions.insert(std::upper_bound(report.extensions.begin(), report.extensions.end(), other, larger),
+                                 std::move(other));
+    }
+
+    report.pendingFolders = scan->pending.load(std::memory_order_relaxed);
+    report.peakPendingFolders = scan->peak.load(std::memory_order_relaxed);
+    report.cancelled = scan->cancelled.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(scan->mutex);
+    report.done = scan->remaining == 0;
+    return report;
+}
+
+// Tallies the files of a folder and names its subfolders
+void SpaceAnalyzer::Scan::visit(const fs::path& dir, FolderSize& own,
+                                std::vector<fs::path::string_type>& subfolders) {
+    TraceSpan span("SpaceAnalyzer::Visit");
+
+    // Entry buffers are reused across folders read by the same thread
+    thread_local std::vector<DirEntry> entries;
+    thread_local std::vector<FileIdentity> identities;
+    thread_local fs::path::string_type extension;
+
+    std::error_code ec;
+    if (!ReadDirectory(dir, entries, ec)) {
+        own.errors++;
+        entries.clear();
+    }
+    std::span<FileIdentity> identitySpan;
+    if (options.identities) {
+        identities.assign(entries.size(), FileIdentity{});
+        identitySpan = identities;
+    }
+    StatEntries(dir, entries, identitySpan);
+    span.arg("entries", static_cast<std::int64_t>(entries.size()));
+
+    Shard& shard = this->shard();
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    for (std::size_t index = 0; index < entries.size(); ++index) {
+        const DirEntry& entry = entries[index];
+        if (entry.isDirectory()) {
+            own.directories++;
+            subfolders.push_back(entry.name);
+            added();
+            continue;
+        }
+        if (!entry.isFile() || !entry.hasStat) {
+            continue;
+        }
+
+        // Without an identity the allocation is taken to be the size
+        const FileIdentity* identity = identitySpan.empty() ? nullptr : &identitySpan[index];
+        if (identity && identity->links > 1 && !firstName(*identity)) {
+            continue;
+        }
+        SpaceItem file;
+        file.bytes = entry.size;
+        file.allocated = identity && identity->known() ? identity->allocated : entry.size;
+        file.files = 1;
+        own.bytes += file.bytes;
+        own.allocated += file.allocated;
+        own.files++;
+
+        ExtensionSpace* tally = &shard.other;
+        if (ExtensionOf(entry.name, extension)) {
+            if (auto it = shard.extensions.find(extension); it != shard.extensions.end()) {
+                tally = &it->second;
+            } else if (shard.extensions.size() < options.maxExtensions) {
+                tally = &shard.extensions.emplace(extension, ExtensionSpace{extension}).first->second;
+            }
+        }
+        tally->bytes += file.bytes;
+        tally->allocated += file.allocated;
+        tally->files++;
+
+        // The path is only built for files that make it into the heap
+        if (shard.files.accepts(file)) {
+            file.path = dir / entry.name;
+            shard.files.push(std::move(file));
+        }
+    }
+    shard.total.add(own);
+}
+
+// Ranks a finished folder below the roots; a finished root ends its part
+// of the scan
+void SpaceAnalyzer::Scan::finish(const fs::path& dir, FolderSize& size, bool root) {
+    pending.fetch_sub(1, std::memory_order_relaxed);
+    if (root) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--remaining == 0) {
+            finished.notify_all();
+        }
+        return;
+    }
+
+    SpaceItem folder;
+    folder.bytes = size.bytes;
+    folder.allocated = size.allocated;
+    folder.files = size.files;
+    Shard& shard = this->shard();
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (shard.folders.accepts(folder)) {
+        folder.path = dir;
+        shard.folders.push(std::move(folder));
+    }
+}
+
+} // namespace ffe
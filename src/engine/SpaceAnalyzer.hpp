@@ -0,0 +1,111 @@
+#pragma once
+
+#include "engine/DirEntry.hpp"
+#include "engine/Executor.hpp"
+#include "engine/FolderSizer.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ffe {
+
+struct SpaceOptions {
+    // Whether looking up identities costs nothing beyond the stat a file
+    // gets anyway. On Linux statx returns them with the size; on Windows
+    // enumeration has the size but not the link count, so an identity
+    // means opening every file.
+#if defined(_WIN32)
+    static constexpr bool CheapIdentities = false;
+#else
+    static constexpr bool CheapIdentities = true;
+#endif
+
+    std::size_t topFiles = 100;      // Largest files kept
+    std::size_t topFolders = 100;    // Largest folders kept, by everything below them
+    std::size_t maxExtensions = 512; // Extensions tallied apart; the rest are added up as one
+
+    // Stat every file for its identity: hard links count once and allocation
+    // is exact. Without, every name counts and allocation is taken to be the
+    // size.
+    bool identities = CheapIdentities;
+};
+
+// A file, or a folder with everything below it. Ranked by allocated bytes,
+// the space it takes on disk.
+struct SpaceItem {
+    fs::path path;
+    std::uint64_t bytes = 0;
+    std::uint64_t allocated = 0;
+    std::uint64_t files = 0; // Below a folder; 1 for a file
+
+    bool operator<(const SpaceItem& other) const noexcept {
+        return allocated != other.allocated ? allocated < other.allocated : bytes < other.bytes;
+    }
+};
+
+// The files of one extension, lowercased and without the dot: empty for
+// files without one
+struct ExtensionSpace {
+    fs::path::string_type extension;
+    bool other = false; // The extensions past maxExtensions, and overly long ones
+    std::uint64_t bytes = 0;
+    std::uint64_t allocated = 0;
+    std::uint64_t files = 0;
+};
+
+// Where the space below the roots goes, as far as the scan has come
+struct SpaceReport {
+    std::vector<SpaceItem> files;           // Largest first
+    std::vector<SpaceItem> folders;         // Largest first, finished folders only; roots left out
+    std::vector<ExtensionSpace> extensions; // Most allocated first
+    FolderSize total;                       // Everything counted so far, over all roots
+    std::uint64_t pendingFolders = 0;       // Folders whose subtree is not finished yet
+    std::uint64_t peakPendingFolders = 0;
+    bool done = false;
+    bool cancelled = false;
+};
+
+// Finds where the space of whole drives goes in one walk: the largest
+// files, the largest folders with everything below them, and the bytes per
+// extension. Folder totals flow up in a SubtreeWalk, as in FolderSizer, a
+// folder being ranked the moment its subtree is done.
+//
+// Each worker ranks into its own bounded TopK heaps and extension table,
+// merged when a snapshot is taken, so memory stays the same however large
+// the tree: the heaps, the tables and the folders being walked at once.
+// Only files with several names are remembered, by identity, so that they
+// count once, in the folder where the walk meets them first.
+class SpaceAnalyzer {
+public:
+    explicit SpaceAnalyzer(Executor& executor, SpaceOptions options = {});
+    ~SpaceAnalyzer();
+
+    SpaceAnalyzer(const SpaceAnalyzer&) = delete;
+    SpaceAnalyzer& operator=(const SpaceAnalyzer&) = delete;
+
+    // Starts walking the roots in the background, replacing a scan still
+    // running
+    void scan(std::vector<fs::path> roots);
+
+    void cancel();
+
+    // Blocks until the scan is done or cancelled; not to be called from one
+    // of the executor's workers
+    void wait();
+
+    // The rankings so far; cheap enough to take every few hundred ms
+    SpaceReport snapshot() const;
+
+private:
+    struct Scan;
+
+    Executor& executor;
+    SpaceOptions options;
+    mutable std::mutex mutex; // Guards current
+    std::shared_ptr<Scan> current;
+};
+
+} // namespace ffe
@@ -0,0 +1,374 @@
+#include "engine/StatEngine.hpp"
+
+#include "engine/DirectoryReader.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <latch>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace ffe {
+
+namespace {
+
+// Directories smaller than this are not worth splitting over the executor
+constexpr std::size_t ParallelChunk = 256;
+
+#if defined(__linux__)
+
+constexpr unsigned StatxMask = STATX_TYPE | STATX_SIZE | STATX_MTIME;
+constexpr unsigned IdentityMask = STATX_INO | STATX_NLINK | STATX_BLOCKS;
+
+void FillFromStatx(DirEntry& entry, const struct statx& status) {
+    if (entry.type == EntryType::Unknown) {
+        entry.type = S_ISREG(status.stx_mode)   ? EntryType::File
+                     : S_ISDIR(status.stx_mode) ? EntryType::Directory
+                     : S_ISLNK(status.stx_mode) ? EntryType::Symlink
+                                                : EntryType::Other;
+    }
+    entry.size = entry.isFile() ? status.stx_size : 0;
+    entry.mtime = status.stx_mtime.tv_sec * 1000000000LL + status.stx_mtime.tv_nsec;
+    entry.hasStat = true;
+}
+
+void FillIdentity(FileIdentity& identity, const struct statx& status) {
+    identity.device = (static_cast<std::uint64_t>(status.stx_dev_major) << 32) | status.stx_dev_minor;
+    identity.file = status.stx_ino;
+    identity.links = std::max<std::uint32_t>(status.stx_nlink, 1);
+    identity.allocated = status.stx_blocks * 512;
+}
+
+// Minimal io_uring: a submission and a completion ring mapped from the
+// kernel, driven with the raw system calls
+class Ring {
+public:
+    ~Ring() {
+        if (sqes) {
+            ::munmap(sqes, sqesSize);
+        }
+        if (cqMap && cqMap != sqMap) {
+            ::munmap(cqMap, cqMapSize);
+        }
+        if (sqMap) {
+            ::munmap(sqMap, sqMapSize);
+        }
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+    bool open(unsigned entries) {
+        io_uring_params params = {};
+        fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+        if (fd < 0) {
+            return false;
+        }
+
+        sqMapSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqMapSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single) {
+            sqMapSize = cqMapSize = std::max(sqMapSize, cqMapSize);
+        }
+
+        sqMap = Map(sqMapSize, IORING_OFF_SQ_RING);
+        cqMap = single ? sqMap : Map(cqMapSize, IORING_OFF_CQ_RING);
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe*>(Map(sqesSize, IORING_OFF_SQES));
+        if (!sqMap || !cqMap || !sqes) {
+            return false;
+        }
+
+        char* sq = static_cast<char*>(sqMap);
+        sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        char* cq = static_cast<char*>(cqMap);
+        cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        capacity = params.sq_entries;
+        return true;
+    }
+
+    unsigned entries() const noexcept {
+        return capacity;
+    }
+
+    // The caller keeps no more than entries() requests in flight, so a slot
+    // is always free
+    void queueStatx(int dirfd, const char* name, unsigned mask, struct statx* status, std::uint64_t userData) {
+        const unsigned tail = *sqTail;
+        const unsigned index = tail & sqMask;
+        io_uring_sqe& sqe = sqes[index];
+        sqe = {};
+        sqe.opcode = IORING_OP_STATX;
+        sqe.fd = dirfd;
+        sqe.addr = reinterpret_cast<std::uint64_t>(name);
+        sqe.len = mask;
+        sqe.off = reinterpret_cast<std::uint64_t>(status);
+        sqe.statx_flags = AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT;
+        sqe.user_data = userData;
+        sqArray[index] = index;
+        std::atomic_ref<unsigned>(*sqTail).store(tail + 1, std::memory_order_release);
+        unsubmitted++;
+    }
+
+    // Submits what was queued and waits for at least one completion
+    bool submitAndWait() {
+        while (true) {
+            const long result = ::syscall(__NR_io_uring_enter, fd, unsubmitted, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (result >= 0) {
+                unsubmitted -= static_cast<unsigned>(result);
+                return true;
+            }
+            if (errno != EINTR) {
+                return false;
+            }
+        }
+    }
+
+    // Calls complete(userData, result) for every completion available
+    template<class Complete>
+    unsigned reap(Complete&& complete) {
+        unsigned head = *cqHead;
+        const unsigned tail = std::atomic_ref<unsigned>(*cqTail).load(std::memory_order_acquire);
+        unsigned reaped = 0;
+        for (; head != tail; ++head, ++reaped) {
+            const io_uring_cqe& cqe = cqes[head & cqMask];
+            complete(cqe.user_data, cqe.res);
+        }
+        std::atomic_ref<unsigned>(*cqHead).store(head, std::memory_order_release);
+        return reaped;
+    }
+
+private:
+    void* Map(std::size_t size, off_t offset) const {
+        void* map = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+        return map == MAP_FAILED ? nullptr : map;
+    }
+
+    int fd = -1;
+    void* sqMap = nullptr;
+    void* cqMap = nullptr;
+    std::size_t sqMapSize = 0;
+    std::size_t cqMapSize = 0;
+    io_uring_sqe* sqes = nullptr;
+    std::size_t sqesSize = 0;
+    unsigned* sqTail = nullptr;
+    unsigned* sqArray = nullptr;
+    unsigned sqMask = 0;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned cqMask = 0;
+    io_uring_cqe* cqes = nullptr;
+    unsigned capacity = 0;
+    unsigned unsubmitted = 0;
+};
+
+bool ProbeStatx() {
+    Ring ring;
+    if (!ring.open(4)) {
+        return false;
+    }
+    // A statx of the current directory tells whether the opcode works,
+    // including under filters that allow the ring but not the operation
+    struct statx status;
+    ring.queueStatx(AT_FDCWD, ".", StatxMask, &status, 0);
+    int result = -1;
+    if (!ring.submitAndWait()) {
+        return false;
+    }
+    ring.reap([&result](std::uint64_t, int res) { result = res; });
+    return result == 0;
+}
+
+thread_local std::unique_ptr<Ring> t_ring;
+thread_local bool t_ringTried = false;
+
+// The calling thread's ring, opened on first use; null when io_uring
+// cannot be used from this thread
+Ring* ThreadRing() {
+    if (!t_ringTried) {
+        t_ringTried = true;
+        auto opened = std::make_unique<Ring>();
+        if (opened->open(StatEngine::MaxQueueDepth)) {
+            t_ring = std::move(opened);
+        }
+    }
+    return t_ring.get();
+}
+
+// Returns the number of entries filled in, or nothing when the ring failed
+// and the caller should fall back
+std::optional<std::size_t> StatWithRing(Ring& ring, int dirfd, std::span<DirEntry> entries,
+                                        std::span<FileIdentity> identities, unsigned depth) {
+    const unsigned mask = identities.empty() ? StatxMask : StatxMask | IdentityMask;
+    depth = std::min(depth, ring.entries());
+    auto resultBuffer = std::make_unique<std::vector<struct statx>>(std::min<std::size_t>(depth, entries.size()));
+    auto& results = *resultBuffer;
+    std::vector<std::uint32_t> freeSlots(results.size());
+    for (std::uint32_t slot = 0; slot < freeSlots.size(); ++slot) {
+        freeSlots[slot] = static_cast<std::uint32_t>(freeSlots.size() - 1 - slot);
+    }
+
+    std::size_t next = 0;
+    std::size_t inFlight = 0;
+    std::size_t filled = 0;
+    while (true) {
+        for (; next < entries.size() && !freeSlots.empty(); ++next) {
+            if (entries[next].hasStat && identities.empty()) {
+                continue;
+            }
+            const std::uint32_t slot = freeSlots.back();
+            freeSlots.pop_back();
+            // user_data carries the entry index and the result slot
+            ring.queueStatx(dirfd, entries[next].name.c_str(), mask, &results[slot],
+                            (std::uint64_t(next) << 32) | slot);
+            inFlight++;
+        }
+        if (inFlight == 0) {
+            return filled;
+        }
+        if (!ring.submitAndWait()) {
+            // Requests still in the ring may complete at any time and write
+            // into results, so the ring and the buffer are abandoned (not
+            // freed) and this thread stops using io_uring
+            resultBuffer.release();
+            t_ring.release();
+            return std::nullopt;
+        }
+        inFlight -= ring.reap([&](std::uint64_t userData, int result) {
+            const auto slot = static_cast<std::uint32_t>(userData);
+            if (result == 0) {
+                const std::size_t index = userData >> 32;
+                FillFromStatx(entries[index], results[slot]);
+                if (!identities.empty()) {
+                    FillIdentity(identities[index], results[slot]);
+                }
+                filled++;
+            }
+            freeSlots.push_back(slot);
+        });
+    }
+}
+
+#endif
+
+} // namespace
+
+bool StatEngine::IoUringAvailable() {
+#if defined(__linux__)
+    static const bool available = ProbeStatx();
+    return available;
+#else
+    return false;
+#endif
+}
+
+StatEngine::StatEngine(Executor* executor, Backend backend, unsigned queueDepth)
+    : executor(executor), selected(backend), queueDepth(std::clamp(queueDepth, 1u, MaxQueueDepth)) {}
+
+std::size_t StatEngine::statEntries(const fs::path& dir, std::span<DirEntry> entries,
+                                    std::span<FileIdentity> identities) const {
+    if (identities.empty() &&
+        std::all_of(entries.begin(), entries.end(), [](const DirEntry& entry) { return entry.hasStat; })) {
+        return 0;
+    }
+
+    if (Executor::InWorker()) {
+        return statInline(dir, entries, identities);
+    }
+
+#if defined(__linux__)
+    if (selected == Backend::IoUring) {
+        if (Ring* ring = ThreadRing()) {
+            const int dirfd = ::open(dir.c_str(), O_PATH | O_DIRECTORY | O_CLOEXEC);
+            if (dirfd < 0) {
+                return 0;
+            }
+            const auto filled = StatWithRing(*ring, dirfd, entries, identities, queueDepth);
+            ::close(dirfd);
+            if (filled) {
+                return *filled;
+            }
+        }
+    }
+#endif
+
+    if (!executor || entries.size() <= ParallelChunk) {
+        return statInline(dir, entries, identities);
+    }
+
+    const std::size_t chunks = (entries.size() + ParallelChunk - 1) / ParallelChunk;
+    std::latch done(static_cast<std::ptrdiff_t>(chunks));
+    std::atomic<std::size_t> filled{0};
+    for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+        const std::size_t first = chunk * ParallelChunk;
+        const std::size_t count = std::min(ParallelChunk, entries.size() - first);
+        const auto part = entries.subspan(first, count);
+        const auto partIdentities = identities.empty() ? identities : identities.subspan(first, count);
+        executor->submit([this, &dir, part, partIdentities, &done, &filled] {
+            filled.fetch_add(statInline(dir, part, partIdentities), std::memory_order_relaxed);
+            done.count_down();
+        });
+    }
+    done.wait();
+    return filled.load();
+}
+
+std::size_t StatEngine::statInline(const fs::path& dir, std::span<DirEntry> entries,
+                                   std::span<FileIdentity> identities) const {
+    std::size_t filled = 0;
+#if defined(__linux__)
+    const int dirfd = ::open(dir.c_str(), O_PATH | O_DIRECTORY | O_CLOEXEC);
+    if (dirfd < 0) {
+        return 0;
+    }
+    const unsigned mask = identities.empty() ? StatxMask : StatxMask | IdentityMask;
+    for (std::size_t index = 0; index < entries.size(); ++index) {
+        DirEntry& entry = entries[index];
+        struct statx status;
+        if ((!entry.hasStat || !identities.empty()) &&
+            ::statx(dirfd, entry.name.c_str(), AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT, mask, &status) == 0) {
+            FillFromStatx(entry, status);
+            if (!identities.empty()) {
+                FillIdentity(identities[index], status);
+            }
+            filled++;
+        }
+    }
+    ::close(dirfd);
+#else
+    for (std::size_t index = 0; index < entries.size(); ++index) {
+        DirEntry& entry = entries[index];
+        const bool stated = StatEntry(dir, entry);
+        if (!identities.empty() && stated) {
+            StatIdentity(dir, entry, identities[index]);
+        }
+        filled += stated ? 1 : 0;
+    }
+#endif
+    return filled;
+}
+
+std::size_t StatEntries(const fs::path& dir, std::span<DirEntry> entries, std::span<FileIdentity> identities) {
+    static Executor pool;
+    static const StatEngine engine(&pool);
+    return engine.statEntries(dir, entries, identities);
+}
+
+} // namespace ffe
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "engine/DirEntry.hpp"
+#include "engine/Executor.hpp"
+
+#include <cstddef>
+#include <span>
+
+namespace ffe {
+
+// Fills in size and mtime of directory entries that enumeration left
+// without them, many entries at a time.
+//
+// The thread backend, the default, stats inline (statx relative to the
+// directory on Linux); calls from threads outside an executor split large
+// directories over the executor. Calls from the workers of an executor
+// always stat inline: walks already spread directories over the pool.
+//
+// On Linux the io_uring backend is opt-in: it queues one statx per entry
+// and keeps up to queueDepth of them in flight, the kernel running them on
+// its own workers, one ring per calling thread. The statx benchmark has it
+// slower than inline statx on warm and on cold caches alike, so nothing
+// uses it by default; it is kept for devices where overlapping many
+// metadata reads from one thread pays (see ffe-bench statx).
+class StatEngine {
+public:
+    enum class Backend {
+        Threads,
+        IoUring,
+    };
+
+    static constexpr unsigned DefaultQueueDepth = 64;
+    static constexpr unsigned MaxQueueDepth = 256;
+
+    // Whether the kernel offers statx through io_uring
+    static bool IoUringAvailable();
+
+    explicit StatEngine(Executor* executor = nullptr, Backend backend = Backend::Threads,
+                        unsigned queueDepth = DefaultQueueDepth);
+
+    Backend backend() const noexcept {
+        return selected;
+    }
+
+    // Stats every entry of dir without hasStat; entries that vanished keep
+    // hasStat false. Returns the number of entries filled in. When
+    // identities is not empty it parallels entries and every entry is
+    // stat'ed for its identity as well; vanished ones stay unknown.
+    std::size_t statEntries(const fs::path& dir, std::span<DirEntry> entries,
+                            std::span<FileIdentity> identities = {}) const;
+
+private:
+    std::size_t statInline(const fs::path& dir, std::span<DirEntry> entries,
+                           std::span<FileIdentity> identities) const;
+
+    Executor* executor;
+    Backend selected;
+    unsigned queueDepth;
+};
+
+// statEntries on a shared engine with the thread backend; large
+// directories stat'ed from outside an executor are split over a pool of its
+// own, started on first use
+std::size_t StatEntries(const fs::path& dir, std::span<DirEntry> entries, std::span<FileIdentity> identities = {});
+
+} // namespace ffe
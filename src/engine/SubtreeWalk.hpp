@@ -0,0 +1,121 @@
+#pragma once
+
+#include "engine/DirEntry.hpp"
+#include "engine/Executor.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ffe {
+
+// Walks folder trees whose totals flow up. Every folder becomes a task on
+// the executor, as in a TreeWalker walk; a folder is finished once its own
+// entries and all of its subfolders are, and the last of them hands the
+// folder's totals to its parent, so each subtree is done the moment its
+// last folder is. FolderSizer and SpaceAnalyzer differ only in what they
+// add up.
+//
+// Run is the state of one walk, shared by its tasks. It provides
+//   Executor& executor and std::atomic<bool> cancelled;
+//   Data, what a folder adds up;
+//   visit(path, data, subfolders), which adds up what the folder holds
+//     directly and appends the names of its subfolders; data is not shared
+//     yet;
+//   merge(into, from), which adds a finished subfolder to its parent, under
+//     the parent's lock;
+//   failed(data), which counts an exception thrown by a visit, under the
+//     folder's lock;
+//   finish(path, data, root), called once data is final; root is true for
+//     the folder the walk started from.
+// Once the run is cancelled no folder is visited, and the folders left
+// unfinished never reach finish().
+template<class Run>
+class SubtreeWalk {
+public:
+    using Data = typename Run::Data;
+
+    // Queues a walk of root; its data starts out as given, say with the id
+    // of a request
+    static void Start(const std::shared_ptr<Run>& run, fs::path root, Data data = {}) {
+        auto node = std::make_shared<Node>();
+        node->path = std::move(root);
+        node->data = std::move(data);
+        run->executor.submit([run, node] { Visit(run, node); });
+    }
+
+private:
+    // A folder being walked; its subfolders point to it
+    struct Node {
+        std::shared_ptr<Node> parent; // Null for a root
+        fs::path path;
+
+        std::atomic<std::size_t> pending{1}; // Its own entries, then its unfinished subfolders
+
+        std::mutex mutex; // Guards data while subfolders finish
+        Data data;
+    };
+
+    static void Visit(const std::shared_ptr<Run>& run, const std::shared_ptr<Node>& node) {
+        if (run->cancelled.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        // However the visit ends, the folder completes exactly once, so the
+        // walk always finishes
+        struct Completion {
+            const std::shared_ptr<Run>& run;
+            const std::shared_ptr<Node>& node;
+            ~Completion() {
+                Complete(run, node);
+            }
+        } completion{run, node};
+
+        try {
+            std::vector<fs::path::string_type> subfolders;
+            run->visit(node->path, node->data, subfolders);
+            for (const auto& name : subfolders) {
+                auto child = std::make_shared<Node>();
+                child->parent = node;
+                child->path = node->path / name;
+
+                // Count the child before submitting it; this visit's own
+                // count keeps the folder pending should the submission fail
+                node->pending.fetch_add(1, std::memory_order_relaxed);
+                try {
+                    run->executor.submit([run, child] { Visit(run, child); });
+                }
+                catch (...) {
+                    node->pending.fetch_sub(1, std::memory_order_relaxed);
+                    throw;
+                }
+            }
+        }
+        catch (...) {
+            // Subfolders already submitted may be adding to the data
+            std::lock_guard<std::mutex> lock(node->mutex);
+            run->failed(node->data);
+        }
+    }
+
+    // Counts one part of a folder as done; the last one hands its totals up
+    static void Complete(const std::shared_ptr<Run>& run, const std::shared_ptr<Node>& node) {
+        if (node->pending.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+            return;
+        }
+
+        const std::shared_ptr<Node>& parent = node->parent;
+        run->finish(node->path, node->data, !parent);
+        if (parent) {
+            {
+                std::lock_guard<std::mutex> lock(parent->mutex);
+                run->merge(parent->data, node->data);
+            }
+            Complete(run, parent);
+        }
+    }
+};
+
+} // namespace ffe
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace ffe {
+
+// Move-only void() callable with inline storage for small captures.
+// Directory tasks capture a path (40 bytes on libstdc++) and a couple of
+// pointers, which fit in the inline buffer, so submitting work does not
+// touch the heap the way std::function<void()> does. Larger callables fall
+// back to one allocation.
+class Task {
+public:
+    static constexpr std::size_t InlineSize = 64;
+
+    // Whether a callable is stored without an allocation, for hot callers
+    // to static_assert on
+    template<class Fn>
+    static constexpr bool FitsInline = sizeof(Fn) <= InlineSize &&
+                                       alignof(Fn) <= alignof(std::max_align_t) &&
+                                       std::is_nothrow_move_constructible_v<Fn>;
+
+    Task() noexcept = default;
+
+    template<class F, class Fn = std::decay_t<F>,
+             class = std::enable_if_t<!std::is_same_v<Fn, Task> && std::is_invocable_v<Fn&>>>
+    Task(F&& f) {
+        if constexpr (FitsInline<Fn>) {
+            ::new (static_cast<void*>(storage)) Fn(std::forward<F>(f));
+            ops = &InlineOps<Fn>;
+        } else {
+            ::new (static_cast<void*>(storage)) Fn*(new Fn(std::forward<F>(f)));
+            ops = &HeapOps<Fn>;
+        }
+    }
+
+    Task(Task&& other) noexcept {
+        moveFrom(other);
+    }
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            reset();
+            moveFrom(other);
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() {
+        reset();
+    }
+
+    explicit operator bool() const noexcept {
+        return ops != nullptr;
+    }
+
+    void operator()() {
+        ops->invoke(storage);
+    }
+
+    void reset() noexcept {
+        if (ops) {
+            ops->destroy(storage);
+            ops = nullptr;
+        }
+    }
+
+private:
+    struct Ops {
+        void (*invoke)(void* self);
+        void (*move)(void* dst, void* src) noexcept;
+        void (*destroy)(void* self) noexcept;
+    };
+
+    template<class Fn>
+    static constexpr Ops InlineOps = {
+        [](void* self) { (*static_cast<Fn*>(self))(); },
+        [](void* dst, void* src) noexcept {
+            ::new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+            static_cast<Fn*>(src)->~Fn();
+        },
+        [](void* self) noexcept { static_cast<Fn*>(self)->~Fn(); },
+    };
+
+    template<class Fn>
+    static constexpr Ops HeapOps = {
+        [](void* self) { (**static_cast<Fn**>(self))(); },
+        [](void* dst, void* src) noexcept {
+            ::new (dst) Fn*(*static_cast<Fn**>(src));
+        },
+        [](void* self) noexcept { delete *static_cast<Fn**>(self); },
+    };
+
+    void moveFrom(Task& other) noexcept {
+        if (other.ops) {
+            other.ops->move(storage, other.storage);
+            ops = other.ops;
+            other.ops = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char storage[InlineSize];
+    const Ops* ops = nullptr;
+};
+
+} // namespace ffe
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace ffe {
+
+// The capacity best items offered so far, where better means greater under
+// Compare. A min-heap keeps the worst kept item on top, so each offer costs
+// O(log capacity) and memory stays bounded however many items arrive.
+template<class T, class Compare = std::less<T>>
+class TopK {
+public:
+    explicit TopK(std::size_t capacity, Compare compare = Compare())
+        : limit(capacity), compare(std::move(compare)) {
+        items.reserve(capacity);
+    }
+
+    std::size_t capacity() const noexcept {
+        return limit;
+    }
+
+    std::size_t size() const noexcept {
+        return items.size();
+    }
+
+    bool full() const noexcept {
+        return items.size() >= limit;
+    }
+
+    // Worst item kept; only valid when not empty
+    const T& worst() const noexcept {
+        return items.front();
+    }
+
+    // Whether an item would be kept, to skip building items that would not be
+    bool accepts(const T& item) const {
+        return limit != 0 && (!full() || compare(worst(), item));
+    }
+
+    void push(T item) {
+        if (!accepts(item)) {
+            return;
+        }
+        if (full()) {
+            std::pop_heap(items.begin(), items.end(), heapOrder());
+            items.back() = std::move(item);
+        } else {
+            items.push_back(std::move(item));
+        }
+        std::push_heap(items.begin(), items.end(), heapOrder());
+    }
+
+    void merge(const TopK& other) {
+        for (const T& item : other.items) {
+            push(item);
+        }
+    }
+
+    void clear() noexcept {
+        items.clear();
+    }
+
+    // Kept items, best first
+    std::vector<T> sorted() const {
+        std::vector<T> result = items;
+        std::sort(result.begin(), result.end(), [this](const T& a, const T& b) { return compare(b, a); });
+        return result;
+    }
+
+private:
+    // std heap functions keep the greatest on top; invert for a min-heap
+    auto heapOrder() const {
+        return [this](const T& a, const T& b) { return compare(b, a); };
+    }
+
+    std::size_t limit;
+    Compare compare;
+    std::vector<T> items;
+};
+
+} // namespace ffe
@@ -0,0 +1,302 @@
+#include "engine/Trace.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ffe {
+
+namespace {
+
+struct Span {
+    const char* name;
+    const char* argName; // The counter's value for a sample
+    std::int64_t arg;
+    std::int64_t start;
+    std::int64_t end;
+    char phase;          // 'X' for a span, 'C' for a counter sample
+};
+
+// Span arrays kept for reuse by threads that start recording later
+constexpr std::size_t PooledSpans = 8;
+
+// Buffers of exited threads kept for their spans until they are cleared;
+// beyond this the oldest are dropped
+constexpr std::size_t KeptExitedBuffers = 64;
+
+// Written by its thread only. written counts every span ever recorded;
+// the span numbered n is in slot n % ThreadCapacity. The spans are
+// allocated by the first one recorded, so threads that are only named
+// cost nothing while tracing is off.
+struct ThreadBuffer {
+    std::unique_ptr<Span[]> spans;
+    std::atomic<std::uint64_t> written{0};
+    std::atomic<std::uint64_t> first{0}; // Spans before this one were cleared
+    std::uint32_t id = 0;
+    std::string name;    // Guarded by the registry mutex
+    bool exited = false; // Guarded by the registry mutex
+
+    ThreadBuffer() = default;
+    ThreadBuffer(const ThreadBuffer&) = delete;
+    ThreadBuffer& operator=(const ThreadBuffer&) = delete;
+    ~ThreadBuffer();
+
+    bool hasSpans() const {
+        return spans && first.load(std::memory_order_relaxed) != written.load(std::memory_order_acquire);
+    }
+};
+
+// Buffers outlive their threads, so spans of finished work can still be
+// written out. Never destroyed, so threads may exit after main returns.
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers; // In order of id
+    std::uint32_t nextId = 1;
+
+    std::mutex poolMutex; // Taken after mutex, never before
+    std::vector<std::unique_ptr<Span[]>> pool;
+};
+
+Registry& Buffers() {
+    static Registry& registry = *new Registry;
+    return registry;
+}
+
+// The last reference to a buffer returns its spans to the pool, which an
+// export still reading them may hold
+ThreadBuffer::~ThreadBuffer() {
+    if (spans) {
+        Registry& registry = Buffers();
+        std::lock_guard<std::mutex> lock(registry.poolMutex);
+        if (registry.pool.size() < PooledSpans) {
+            registry.pool.push_back(std::move(spans));
+        }
+    }
+}
+
+std::unique_ptr<Span[]> AllocateSpans() {
+    Registry& registry = Buffers();
+    {
+        std::lock_guard<std::mutex> lock(registry.poolMutex);
+        if (!registry.pool.empty()) {
+            auto spans = std::move(registry.pool.back());
+            registry.pool.pop_back();
+            return spans;
+        }
+    }
+    return std::unique_ptr<Span[]>(new Span[Trace::ThreadCapacity]);
+}
+
+// Called with the registry mutex held
+void DropExited(Registry& registry, std::size_t keep) {
+    std::size_t exited = 0;
+    for (const auto& buffer : registry.buffers) {
+        exited += buffer->exited;
+    }
+    for (auto it = registry.buffers.begin(); exited > keep;) {
+        if ((*it)->exited) {
+            it = registry.buffers.erase(it);
+            --exited;
+        } else {
+            ++it;
+        }
+    }
+}
+
+// Unregisters the buffer of an exiting thread, unless its spans are still
+// to be written out
+void Release(const std::shared_ptr<ThreadBuffer>& buffer) {
+    Registry& registry = Buffers();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    buffer->exited = true;
+    if (!buffer->hasSpans()) {
+        std::erase(registry.buffers, buffer);
+    } else {
+        DropExited(registry, KeptExitedBuffers);
+    }
+}
+
+struct LocalHolder {
+    std::shared_ptr<ThreadBuffer> buffer;
+
+    ~LocalHolder() {
+        if (buffer) {
+            Release(buffer);
+        }
+    }
+};
+
+ThreadBuffer& LocalBuffer() {
+    thread_local LocalHolder local;
+    if (!local.buffer) {
+        auto buffer = std::make_shared<ThreadBuffer>();
+        Registry& registry = Buffers();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        buffer->id = registry.nextId++;
+        registry.buffers.push_back(buffer);
+        local.buffer = std::move(buffer);
+    }
+    return *local.buffer;
+}
+
+const std::chrono::steady_clock::time_point Epoch = std::chrono::steady_clock::now();
+
+void AppendJsonString(std::string& out, const char* text) {
+    out += '"';
+    for (; *text; ++text) {
+        const char c = *text;
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escape[8];
+            std::snprintf(escape, sizeof(escape), "\\u%04x", static_cast<unsigned>(c));
+            out += escape;
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+// Chrome trace times are microseconds
+void AppendMicroseconds(std::string& out, std::int64_t nanoseconds) {
+    char number[32];
+    std::snprintf(number, sizeof(number), "%.3f", nanoseconds / 1000.0);
+    out += number;
+}
+
+} // namespace
+
+void Trace::Enable(bool on) noexcept {
+    enabled.store(on, std::memory_order_relaxed);
+}
+
+void Trace::SetThreadName(std::string name) {
+    ThreadBuffer& buffer = LocalBuffer();
+    std::lock_guard<std::mutex> lock(Buffers().mutex);
+    buffer.name = std::move(name);
+}
+
+void Trace::Clear() {
+    Registry& registry = Buffers();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (const auto& buffer : registry.buffers) {
+        buffer->first.store(buffer->written.load(std::memory_order_acquire), std::memory_order_relaxed);
+    }
+    DropExited(registry, 0);
+}
+
+std::int64_t Trace::Now() noexcept {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - Epoch).count();
+}
+
+namespace {
+
+void Append(const Span& span) {
+    ThreadBuffer& buffer = LocalBuffer();
+    if (!buffer.spans) {
+        buffer.spans = AllocateSpans();
+    }
+    const std::uint64_t index = buffer.written.load(std::memory_order_relaxed);
+    buffer.spans[index % Trace::ThreadCapacity] = span;
+    buffer.written.store(index + 1, std::memory_order_release);
+}
+
+} // namespace
+
+void Trace::Record(const char* name, std::int64_t start, std::int64_t end, const char* argName, std::int64_t arg) {
+    Append(Span{name, argName, arg, start, end, 'X'});
+}
+
+void Trace::Counter(const char* name, std::int64_t value) {
+    const std::int64_t now = Now();
+    Append(Span{name, "value", value, now, now, 'C'});
+}
+
+void Trace::AppendChromeJson(std::string& out) {
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    std::vector<std::string> names;
+    {
+        Registry& registry = Buffers();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        buffers = registry.buffers;
+        for (const auto& buffer : buffers) {
+            names.push_back(buffer->name);
+        }
+    }
+
+    out += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool firstEvent = true;
+    const auto separate = [&] {
+        out += firstEvent ? "\n" : ",\n";
+        firstEvent = false;
+    };
+
+    std::vector<Span> copied;
+    for (std::size_t b = 0; b < buffers.size(); ++b) {
+        ThreadBuffer& buffer = *buffers[b];
+        const std::string tid = std::to_string(buffer.id);
+        if (!names[b].empty()) {
+            separate();
+            out += "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" + tid + ",\"args\":{\"name\":";
+            AppendJsonString(out, names[b].c_str());
+            out += "}}";
+        }
+
+        // Copy the newest spans, then drop the ones the thread may have
+        // overwritten while they were copied, or be writing now
+        const std::uint64_t end = buffer.written.load(std::memory_order_acquire);
+        const std::uint64_t begin = std::max(buffer.first.load(std::memory_order_relaxed),
+                                             end > ThreadCapacity ? end - ThreadCapacity : 0);
+        copied.clear();
+        for (std::uint64_t index = begin; index < end; ++index) {
+            copied.push_back(buffer.spans[index % ThreadCapacity]);
+        }
+        const std::uint64_t after = buffer.written.load(std::memory_order_acquire);
+        const std::uint64_t reused = after + 1 > ThreadCapacity ? after + 1 - ThreadCapacity : 0;
+        const std::size_t torn = reused > begin ? static_cast<std::size_t>(std::min(reused - begin, end - begin)) : 0;
+
+        for (std::size_t i = torn; i < copied.size(); ++i) {
+            const Span& span = copied[i];
+            separate();
+            out += "{\"ph\":\"";
+            out += span.phase;
+            out += "\",\"cat\":\"ffe\",\"name\":";
+            AppendJsonString(out, span.name);
+            out += ",\"pid\":1,\"tid\":" + tid + ",\"ts\":";
+            AppendMicroseconds(out, span.start);
+            if (span.phase == 'X') {
+                out += ",\"dur\":";
+                AppendMicroseconds(out, span.end - span.start);
+            }
+            if (span.argName) {
+                out += ",\"args\":{";
+                AppendJsonString(out, span.argName);
+                out += ':' + std::to_string(span.arg) + '}';
+            }
+            out += '}';
+        }
+    }
+    out += "\n]}\n";
+}
+
+bool Trace::WriteChromeJson(const fs::path& file, std::error_code& ec) {
+    std::string json;
+    AppendChromeJson(json);
+    std::ofstream stream(file, std::ios::binary);
+    stream.write(json.data(), static_cast<std::streamsize>(json.size()));
+    stream.close();
+    if (!stream) {
+        ec = std::make_error_code(std::errc::io_error);
+        return false;
+    }
+    ec.clear();
+    return true;
+}
+
+} // namespace ffe
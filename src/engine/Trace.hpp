@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <system_error>
+
+namespace ffe {
+
+namespace fs = std::filesystem;
+
+// Process-wide tracing of timed spans, for finding where a slow navigation
+// or search spends its time. Each thread records into its own ring buffer
+// of the most recent spans, so recording takes no lock; while tracing is
+// off a span costs one relaxed load. The spans recorded so far can be
+// written as Chrome trace JSON, which chrome://tracing and Perfetto open.
+// The buffer of a thread that exits is kept only while it holds spans, and
+// its memory is reused by threads started later.
+class Trace {
+public:
+    // Spans kept per thread; older ones are overwritten
+    static constexpr std::size_t ThreadCapacity = 32 * 1024;
+
+    static bool Enabled() noexcept {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    // Starts or stops recording; spans already recorded are kept
+    static void Enable(bool on) noexcept;
+
+    // Names the calling thread in the trace
+    static void SetThreadName(std::string name);
+
+    // Drops every span recorded so far, and the buffers of exited threads
+    static void Clear();
+
+    // Nanoseconds on the trace clock
+    static std::int64_t Now() noexcept;
+
+    // Records a span of the calling thread. name and argName must outlive
+    // the trace: string literals. argName null means no argument.
+    static void Record(const char* name, std::int64_t start, std::int64_t end, const char* argName = nullptr,
+                       std::int64_t arg = 0);
+
+    // Records a sample of a counter track, such as a rate or a queue depth;
+    // name must be a string literal
+    static void Counter(const char* name, std::int64_t value);
+
+    // Appends the recorded spans and samples as a Chrome trace JSON object.
+    // Threads keep recording meanwhile; spans they overwrite while being
+    // read are left out.
+    static void AppendChromeJson(std::string& out);
+
+    static bool WriteChromeJson(const fs::path& file, std::error_code& ec);
+
+private:
+    static inline std::atomic<bool> enabled{false};
+};
+
+// Times the enclosing scope, when tracing is on at its start
+class TraceSpan {
+public:
+    explicit TraceSpan(const char* name) noexcept
+        : name(Trace::Enabled() ? name : nullptr), start(this->name ? Trace::Now() : 0) {}
+
+    ~TraceSpan() {
+        end();
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+    // A number shown with the span, such as the entries it handled
+    void arg(const char* key, std::int64_t value) noexcept {
+        argName = key;
+        argValue = value;
+    }
+
+    // Ends the span before the scope does
+    void end() {
+        if (name) {
+            Trace::Record(name, start, Trace::Now(), argName, argValue);
+            name = nullptr;
+        }
+    }
+
+private:
+    const char* name;
+    std::int64_t start;
+    const char* argName = nullptr;
+    std::int64_t argValue = 0;
+};
+
+} // namespace ffe
@@ -0,0 +1,181 @@
+#include "engine/TreeWalker.hpp"
+
+#include "engine/DirectoryReader.hpp"
+#include "engine/Metrics.hpp"
+#include "engine/StatEngine.hpp"
+#include "engine/Trace.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <vector>
+
+namespace ffe {
+
+struct TreeWalk::State {
+    Executor* executor = nullptr;
+    TreeWalker::Visitor visitor;
+    WalkOptions options;
+
+    // Directory tasks submitted but not finished; the walk ends when it drops to zero
+    std::atomic<std::uint64_t> outstanding{1};
+    std::atomic<bool> cancelled{false};
+
+    // Bumped by every worker for every directory, so sharded
+    ShardedCounter directories;
+    ShardedCounter entries;
+    ShardedCounter errors;
+
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+    std::atomic<std::chrono::steady_clock::rep> finishedAfter{0};
+
+    std::promise<WalkStats> promise;
+    std::shared_future<WalkStats> future = promise.get_future().share();
+
+    // Keeps the state alive while tasks hold raw pointers to it, which keeps
+    // each directory task small enough for Task's inline storage
+    std::shared_ptr<State> self;
+
+    WalkStats snapshot() const {
+        WalkStats stats;
+        stats.directories = directories.value();
+        stats.entries = entries.value();
+        stats.errors = errors.value();
+        stats.pending = outstanding.load(std::memory_order_relaxed);
+        stats.cancelled = cancelled.load(std::memory_order_relaxed);
+
+        const auto finished = finishedAfter.load(std::memory_order_acquire);
+        stats.elapsed = finished != 0 ? std::chrono::steady_clock::duration(finished)
+                                      : std::chrono::steady_clock::now() - started;
+        return stats;
+    }
+};
+
+std::shared_future<WalkStats> TreeWalk::completion() const {
+    return state->future;
+}
+
+WalkStats TreeWalk::wait() const {
+    return state->future.get();
+}
+
+bool TreeWalk::done() const {
+    return state->future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+void TreeWalk::cancel() {
+    state->cancelled.store(true, std::memory_order_relaxed);
+}
+
+WalkStats TreeWalk::progress() const {
+    return state->snapshot();
+}
+
+TreeWalk TreeWalker::walk(fs::path root, Visitor visitor, WalkOptions options) {
+    auto state = std::make_shared<TreeWalk::State>();
+    state->executor = &executor;
+    state->visitor = std::move(visitor);
+    state->options = std::move(options);
+    state->self = state;
+
+    TreeWalk::State* raw = state.get();
+    executor.submit([raw, root = std::move(root)] { visitDirectory(raw, root, 0); });
+    return TreeWalk(std::move(state));
+}
+
+void TreeWalker::visitDirectory(TreeWalk::State* state, const fs::path& path, std::uint32_t depth) {
+    // However the visit ends, the directory finishes exactly once, so the
+    // walk always completes
+    struct Finish {
+        TreeWalk::State* state;
+        ~Finish() {
+            finishDirectory(state);
+        }
+    } finish{state};
+
+    if (state->cancelled.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    try {
+        // Entry buffers are reused across directories visited by the same thread
+        thread_local std::vector<DirEntry> entries;
+        thread_local std::vector<FileIdentity> identities;
+        std::error_code ec;
+        TraceSpan read("ReadDirectory");
+        const bool listed = ReadDirectory(path, entries, ec);
+        read.arg("entries", static_cast<std::int64_t>(entries.size()));
+        read.end();
+        if (!listed) {
+            state->errors.add();
+            if (entries.empty()) {
+                return;
+            }
+        }
+
+        state->directories.add();
+        state->entries.add(entries.size());
+        identities.clear();
+        if (state->options.identities) {
+            TraceSpan stat("StatEntries");
+            identities.resize(entries.size());
+            StatEntries(path, entries, identities);
+        } else if (state->options.stat) {
+            TraceSpan stat("StatEntries");
+            StatEntries(path, entries);
+        }
+
+        try {
+            TraceSpan visit("WalkVisitor");
+            state->visitor(WalkDirectory{path, entries, depth, state->executor->currentWorker(), identities});
+        }
+        catch (...) {
+            state->errors.add();
+        }
+
+        if (depth < state->options.maxDepth) {
+            for (const DirEntry& entry : entries) {
+                if (!entry.isDirectory() || state->cancelled.load(std::memory_order_relaxed)) {
+                    continue;
+                }
+                if (state->options.descend && !state->options.descend(path, entry)) {
+                    continue;
+                }
+
+                auto task = [state, child = path / entry.name, depth] { visitDirectory(state, child, depth + 1); };
+                static_assert(Task::FitsInline<decltype(task)>, "directory tasks must not allocate");
+
+                // Count the child before submitting so the total can never
+                // reach zero early; this directory's own count keeps it above
+                // zero should the submission fail
+                state->outstanding.fetch_add(1, std::memory_order_relaxed);
+                try {
+                    state->executor->submit(std::move(task));
+                }
+                catch (...) {
+                    state->outstanding.fetch_sub(1, std::memory_order_relaxed);
+                    throw;
+                }
+            }
+        }
+    }
+    catch (...) {
+        // A descend filter, a path or a submission that failed; the
+        // subfolders not yet queued are skipped
+        state->errors.add();
+    }
+}
+
+void TreeWalker::finishDirectory(TreeWalk::State* state) {
+    if (state->outstanding.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+
+    // Last directory of the walk: publish the final stats and release the state
+    const auto elapsed = std::chrono::steady_clock::now() - state->started;
+    state->finishedAfter.store(std::max<std::chrono::steady_clock::rep>(1, elapsed.count()),
+                               std::memory_order_release);
+    std::shared_ptr<TreeWalk::State> keepAlive = std::move(state->self);
+    state->promise.set_value(state->snapshot());
+}
+
+} // namespace ffe
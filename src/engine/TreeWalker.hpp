@@ -0,0 +1,107 @@
+#pragma once
+
+#include "engine/DirEntry.hpp"
+#include "engine/Executor.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <limits>
+#include <memory>
+#include <span>
+
+namespace ffe {
+
+// Counters for one walk; a snapshot while running, final once complete
+struct WalkStats {
+    std::uint64_t directories = 0; // Directories enumerated
+    std::uint64_t entries = 0;     // Entries seen in those directories
+    std::uint64_t errors = 0;      // Directories that could not be read, visitor failures
+    std::uint64_t pending = 0;     // Directories queued or being visited, the walk's queue depth
+    bool cancelled = false;
+    std::chrono::steady_clock::duration elapsed{};
+};
+
+// A directory handed to the visitor together with all of its entries
+struct WalkDirectory {
+    const fs::path& path;
+    std::span<const DirEntry> entries;
+    std::uint32_t depth;    // 0 for the walk root
+    std::size_t worker;     // Executor worker index, for per-thread visitor state
+    std::span<const FileIdentity> identities = {}; // Parallel to entries with WalkOptions::identities
+};
+
+struct WalkOptions {
+    std::uint32_t maxDepth = std::numeric_limits<std::uint32_t>::max();
+
+    // Optional filter deciding whether a subdirectory is descended into
+    std::function<bool(const fs::path& parent, const DirEntry& entry)> descend;
+
+    // Fill in size and mtime of every entry (StatEntries) before the visitor
+    // sees it, for visitors that filter or record by size or date
+    bool stat = false;
+
+    // Look up the FileIdentity of every entry as well (implies stat), for
+    // visitors that must not count hard links twice
+    bool identities = false;
+};
+
+class TreeWalker;
+
+// Handle to a running walk. Walks keep running when the handle is dropped;
+// the completion future becomes ready exactly once, after the last queued
+// directory has been visited (or skipped because of cancellation).
+class TreeWalk {
+public:
+    TreeWalk() = default;
+
+    // False for a default-constructed handle that never started a walk
+    bool valid() const noexcept {
+        return state != nullptr;
+    }
+
+    std::shared_future<WalkStats> completion() const;
+
+    // Blocks until the walk has finished and returns the final stats
+    WalkStats wait() const;
+
+    bool done() const;
+
+    // Stops descending; directories already being visited still complete
+    void cancel();
+
+    WalkStats progress() const;
+
+private:
+    friend class TreeWalker;
+    struct State;
+
+    explicit TreeWalk(std::shared_ptr<State> state) : state(std::move(state)) {}
+
+    std::shared_ptr<State> state;
+};
+
+// Parallel directory traversal on a shared executor. Every directory becomes
+// one task: it is enumerated, passed to the visitor, and its subdirectories
+// are submitted as new tasks. The walk tracks how many directory tasks are
+// outstanding, so completion is known exactly rather than guessed from the
+// root being done.
+class TreeWalker {
+public:
+    using Visitor = std::function<void(const WalkDirectory&)>;
+
+    explicit TreeWalker(Executor& executor) : executor(executor) {}
+
+    // The visitor is called concurrently from executor workers
+    TreeWalk walk(fs::path root, Visitor visitor, WalkOptions options = {});
+
+private:
+    static void visitDirectory(TreeWalk::State* state, const fs::path& path, std::uint32_t depth);
+    static void finishDirectory(TreeWalk::State* state);
+
+    Executor& executor;
+};
+
+} // namespace ffe
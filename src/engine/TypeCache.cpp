@@ -0,0 +1,223 @@
+#include "engine/TypeCache.hpp"
+
+#include <algorithm>
+#include <string_view>
+
+namespace ffe {
+
+namespace {
+
+struct MimeMapping {
+    std::string_view extension;
+    std::string_view mimeType;
+};
+
+// Sorted by extension
+constexpr MimeMapping MimeTypes[] = {
+    {".7z", "application/x-7z-compressed"},
+    {".avi", "video/x-msvideo"},
+    {".bat", "application/x-bat"},
+    {".bmp", "image/bmp"},
+    {".c", "text/x-c"},
+    {".cc", "text/x-c++"},
+    {".cpp", "text/x-c++"},
+    {".css", "text/css"},
+    {".csv", "text/csv"},
+    {".desktop", "application/x-desktop"},
+    {".dll", "application/x-msdownload"},
+    {".doc", "application/msword"},
+    {".docx", "application/vnd.openxmlformats-officedocument.wordprocessingml.document"},
+    {".exe", "application/x-msdownload"},
+    {".flac", "audio/flac"},
+    {".gif", "image/gif"},
+    {".gz", "application/gzip"},
+    {".h", "text/x-c"},
+    {".hpp", "text/x-c++"},
+    {".htm", "text/html"},
+    {".html", "text/html"},
+    {".ico", "image/vnd.microsoft.icon"},
+    {".ini", "text/plain"},
+    {".iso", "application/x-iso9660-image"},
+    {".java", "text/x-java"},
+    {".jpeg", "image/jpeg"},
+    {".jpg", "image/jpeg"},
+    {".js", "text/javascript"},
+    {".json", "application/json"},
+    {".lnk", "application/x-ms-shortcut"},
+    {".log", "text/plain"},
+    {".md", "text/markdown"},
+    {".mkv", "video/x-matroska"},
+    {".mov", "video/quicktime"},
+    {".mp3", "audio/mpeg"},
+    {".mp4", "video/mp4"},
+    {".msi", "application/x-msi"},
+    {".ogg", "audio/ogg"},
+    {".pdf", "application/pdf"},
+    {".png", "image/png"},
+    {".ppt", "application/vnd.ms-powerpoint"},
+    {".pptx", "application/vnd.openxmlformats-officedocument.presentationml.presentation"},
+    {".py", "text/x-python"},
+    {".rar", "application/vnd.rar"},
+    {".rs", "text/rust"},
+    {".sh", "application/x-shellscript"},
+    {".svg", "image/svg+xml"},
+    {".tar", "application/x-tar"},
+    {".tif", "image/tiff"},
+    {".tiff", "image/tiff"},
+    {".ts", "text/x-typescript"},
+    {".txt", "text/plain"},
+    {".wav", "audio/wav"},
+    {".webp", "image/webp"},
+    {".xls", "application/vnd.ms-excel"},
+    {".xlsx", "application/vnd.openxmlformats-officedocument.spreadsheetml.sheet"},
+    {".xml", "application/xml"},
+    {".yaml", "application/yaml"},
+    {".yml", "application/yaml"},
+    {".zip", "application/zip"},
+};
+
+fs::path::string_type Native(std::string_view ascii) {
+    return fs::path::string_type(ascii.begin(), ascii.end());
+}
+
+// Extension of a file name with ASCII letters lowered; extensions that
+// differ only outside ASCII are rare enough to be cached separately
+fs::path::string_type FoldedExtension(const fs::path& path) {
+    fs::path::string_type extension = path.extension().native();
+    for (auto& c : extension) {
+        if (c >= 'A' && c <= 'Z') {
+            c = static_cast<NativeChar>(c - 'A' + 'a');
+        }
+    }
+    return extension;
+}
+
+} // namespace
+
+FileType MimeFileType(const fs::path& path, EntryType type) {
+    switch (type) {
+    case EntryType::Directory:
+        return {Native("inode/directory")};
+    case EntryType::Symlink:
+        return {Native("inode/symlink")};
+    case EntryType::File:
+    case EntryType::Unknown:
+        break;
+    default:
+        return {Native("inode/x-special")};
+    }
+
+    const fs::path::string_type extension = FoldedExtension(path);
+    const auto it = std::lower_bound(std::begin(MimeTypes), std::end(MimeTypes), extension,
+                                     [](const MimeMapping& mapping, const fs::path::string_type& wanted) {
+                                         return std::lexicographical_compare(
+                                             mapping.extension.begin(), mapping.extension.end(), wanted.begin(),
+                                             wanted.end(), [](char a, NativeChar b) {
+                                                 return static_cast<NativeChar>(static_cast<unsigned char>(a)) < b;
+                                             });
+                                     });
+    if (it != std::end(MimeTypes) && Native(it->extension) == extension) {
+        return {Native(it->mimeType)};
+    }
+    return {Native("application/octet-stream")};
+}
+
+std::vector<fs::path::string_type> TypeCache::DefaultPerPathExtensions() {
+    std::vector<fs::path::string_type> extensions;
+    for (std::string_view extension : {".exe", ".lnk", ".ico", ".url", ".cur", ".ani", ".scr", ".cpl", ".desktop"}) {
+        extensions.push_back(Native(extension));
+    }
+    return extensions;
+}
+
+TypeCache::TypeCache(Resolve resolve, std::size_t capacity, std::vector<fs::path::string_type> perPathExtensions)
+    : resolve(std::move(resolve)), perPathExtensions(std::move(perPathExtensions)),
+      entries(std::max<std::size_t>(1, capacity)) {}
+
+std::shared_ptr<const FileType> TypeCache::lookup(const fs::path& path, EntryType type) {
+    // Keys start with a tag so extensions, entry types and paths never collide
+    Key key;
+    bool generic = true;
+    switch (type) {
+    case EntryType::Directory:
+        key = Native("d");
+        break;
+    case EntryType::Symlink:
+        key = Native("l");
+        break;
+    case EntryType::File:
+    case EntryType::Unknown: {
+        Key extension = FoldedExtension(path);
+        generic = std::find(perPathExtensions.begin(), perPathExtensions.end(), extension) == perPathExtensions.end();
+        key = Native(generic ? "e" : "p") + (generic ? extension : path.native());
+        break;
+    }
+    default:
+        key = Native("o");
+        break;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (const auto* type = entries.find(key)) {
+            hits++;
+            return *type;
+        }
+        misses++;
+    }
+
+    FileType resolved = resolve(path, type, generic);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (const auto* type = entries.find(key)) {
+        // Another thread resolved it meanwhile
+        return *type;
+    }
+    auto shared = intern(std::move(resolved));
+    entries.insert(std::move(key), shared, 1,
+                   [this](const Key&, const std::shared_ptr<const FileType>& type) { release(*type); });
+    return shared;
+}
+
+std::shared_ptr<const FileType> TypeCache::intern(FileType type) {
+    TypeSlot& slot = types[{type.description, type.icon}];
+    if (!slot.type) {
+        slot.type = std::make_shared<const FileType>(std::move(type));
+    }
+    slot.keys++;
+    return slot.type;
+}
+
+// Called for each evicted key; callers may still hold their copy of the type
+void TypeCache::release(const FileType& type) {
+    auto it = types.find({type.description, type.icon});
+    if (--it->second.keys == 0) {
+        types.erase(it);
+    }
+}
+
+void TypeCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    types.clear();
+}
+
+TypeCache::Stats TypeCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return {hits, misses, entries.evictions(), entries.size(), types.size()};
+}
+
+std::size_t TypeCache::memoryUsage() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::size_t bytes = entries.bucketCount() * sizeof(void*);
+    entries.forEach([&bytes](const Key& key, const std::shared_ptr<const FileType>& type) {
+        // List node, hash node and the key stored in both
+        bytes += 2 * (sizeof(key) + sizeof(type) + 2 * sizeof(void*)) + 2 * key.capacity() * sizeof(NativeChar);
+    });
+    for (const auto& [key, type] : types) {
+        bytes += sizeof(FileType) + 2 * key.first.capacity() * sizeof(NativeChar) + 4 * sizeof(void*);
+    }
+    return bytes;
+}
+
+} // namespace ffe
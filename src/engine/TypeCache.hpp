@@ -0,0 +1,90 @@
+#pragma once
+
+#include "engine/DirEntry.hpp"
+#include "engine/LruCache.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ffe {
+
+// What a file list shows for a type: its description and icon
+struct FileType {
+    fs::path::string_type description; // "Text Document", or a MIME type
+    std::int32_t icon = -1;            // Frontend image index, -1 when there is none
+};
+
+// Description from a built-in extension to MIME type table, no icon; the
+// resolver used where there is no shell to ask
+FileType MimeFileType(const fs::path& path, EntryType type);
+
+// Remembers the type of a file by its extension, so asking the shell once
+// covers every file of that kind. Only extensions whose files carry their
+// own icon (programs, shortcuts) are looked up per path. Equal types are
+// stored once and shared, so icon slots are not duplicated however many
+// extensions map to them.
+//
+// At most capacity extensions and paths are kept; the least recently used
+// one goes first. lookup() may be called from any thread; the resolver runs
+// without the lock held, so a slow shell call does not hold up hits.
+class TypeCache {
+public:
+    // generic is true when only the extension and entry type matter, false
+    // when the file itself must be looked at
+    using Resolve = std::function<FileType(const fs::path& path, EntryType type, bool generic)>;
+
+    struct Stats {
+        std::size_t hits = 0;
+        std::size_t misses = 0;
+        std::size_t evictions = 0;
+        std::size_t keys = 0;  // Extensions and paths held
+        std::size_t types = 0; // Distinct types among them
+    };
+
+    static constexpr std::size_t DefaultCapacity = 4096;
+
+    // Lower-case extensions, with the dot, whose icon depends on the file
+    static std::vector<fs::path::string_type> DefaultPerPathExtensions();
+
+    explicit TypeCache(Resolve resolve, std::size_t capacity = DefaultCapacity,
+                       std::vector<fs::path::string_type> perPathExtensions = DefaultPerPathExtensions());
+
+    std::shared_ptr<const FileType> lookup(const fs::path& path, EntryType type);
+
+    void clear();
+
+    Stats stats() const;
+
+    // Bytes held for keys and types
+    std::size_t memoryUsage() const;
+
+private:
+    using Key = fs::path::string_type;
+
+    // A distinct type and the number of keys sharing it
+    struct TypeSlot {
+        std::shared_ptr<const FileType> type;
+        std::size_t keys = 0;
+    };
+
+    std::shared_ptr<const FileType> intern(FileType type);
+    void release(const FileType& type);
+
+    const Resolve resolve;
+    const std::vector<Key> perPathExtensions;
+
+    mutable std::mutex mutex;
+    LruCache<Key, std::shared_ptr<const FileType>> entries; // Each costs 1
+    std::map<std::pair<Key, std::int32_t>, TypeSlot> types;
+    std::size_t hits = 0;
+    std::size_t misses = 0;
+};
+
+} // namespace ffe
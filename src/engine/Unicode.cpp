@@ -0,0 +1,96 @@
+#include "engine/Unicode.hpp"
+
+#include <cwctype>
+
+namespace ffe {
+
+char32_t FoldCodePoint(char32_t c) {
+    if (c < 0x80) {
+        return c >= 'A' && c <= 'Z' ? c + 0x20 : c;
+    }
+    if (c >= 0xC0 && c <= 0xDE && c != 0xD7) {
+        return c + 0x20; // Latin-1 letters
+    }
+    if (c >= 0x100 && c <= 0x17F) {
+        // Latin Extended-A alternates upper and lower case, with the
+        // pairing shifting by one between U+0139 and U+0148 and after U+0178
+        if (c == 0x130 || c == 0x131 || c == 0x138 || c == 0x149) {
+            return c;
+        }
+        if (c == 0x178) {
+            return 0xFF;
+        }
+        if (c == 0x17F) {
+            return 's';
+        }
+        const bool oddUpper = (c >= 0x139 && c <= 0x148) || c >= 0x179;
+        return (c % 2 == 1) == oddUpper ? c + 1 : c;
+    }
+    if (c >= 0x391 && c <= 0x3A9 && c != 0x3A2) {
+        return c + 0x20; // Greek
+    }
+    if (c == 0x3C2) {
+        return 0x3C3; // Final sigma
+    }
+    if (c >= 0x410 && c <= 0x42F) {
+        return c + 0x20; // Cyrillic
+    }
+    if (c >= 0x400 && c <= 0x40F) {
+        return c + 0x50;
+    }
+    if (c == 0x212A) {
+        return 'k'; // Kelvin sign
+    }
+    if (c == 0x212B) {
+        return 0xE5; // Angstrom sign
+    }
+    if (c >= 0xFF21 && c <= 0xFF3A) {
+        return c + 0x20; // Fullwidth Latin
+    }
+    if (c <= 0xFFFF) {
+        return static_cast<char32_t>(std::towlower(static_cast<std::wint_t>(c)));
+    }
+    return c;
+}
+
+char32_t DecodeNext(NameView name, std::size_t& i) {
+#ifdef _WIN32
+    // UTF-16; an unpaired surrogate is kept as it is
+    const char32_t unit = static_cast<char16_t>(name[i++]);
+    if (unit >= 0xD800 && unit <= 0xDBFF && i < name.size()) {
+        const char32_t low = static_cast<char16_t>(name[i]);
+        if (low >= 0xDC00 && low <= 0xDFFF) {
+            ++i;
+            return 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+        }
+    }
+    return unit;
+#else
+    // UTF-8; a byte that does not start a valid sequence decodes to
+    // U+DC80..U+DCFF (like Python's surrogateescape) and only matches itself
+    const auto byte = [&](std::size_t at) { return static_cast<unsigned char>(name[at]); };
+    const unsigned char lead = byte(i);
+    const std::size_t length = lead < 0x80 ? 1 : lead >= 0xF0 && lead <= 0xF4 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC2 ? 2 : 0;
+    if (length == 1) {
+        ++i;
+        return lead;
+    }
+    if (length == 0 || i + length > name.size()) {
+        ++i;
+        return 0xDC00 + lead;
+    }
+
+    char32_t c = lead & (0x7F >> length);
+    for (std::size_t k = 1; k < length; ++k) {
+        if ((byte(i + k) & 0xC0) != 0x80) {
+            ++i;
+            return 0xDC00 + lead;
+        }
+        c = (c << 6) | (byte(i + k) & 0x3F);
+    }
+    i += length;
+    return c;
+#endif
+}
+
+} // namespace ffe
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "engine/DirEntry.hpp"
+
+namespace ffe {
+
+// Highest Unicode code point
+constexpr char32_t MaxCodePoint = 0x10FFFF;
+
+// Simple case folding. The scripts file names are most often written in are
+// handled directly so the result does not depend on the C locale; anything
+// else goes through towlower.
+char32_t FoldCodePoint(char32_t c);
+
+// Decodes the code point of a native name starting at name[i] and advances
+// i past it. Malformed input never stops decoding: an unpaired UTF-16
+// surrogate is returned as it is, and a byte that does not start a valid
+// UTF-8 sequence decodes to U+DC80..U+DCFF (like Python's surrogateescape)
+// so it only matches itself.
+char32_t DecodeNext(NameView name, std::size_t& i);
+
+} // namespace ffe
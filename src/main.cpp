@@ -11,11 +11,35 @@
 #include <deque>
 #include <functional>
 #include <mutex>
-#include <queue>
 #include <thread>
 #include <Uxtheme.h>
 #include <algorithm>
 #include <atomic>
+#include <map>
+#include <optional>
+#include <future>
+
+#include "engine/ContentSearch.hpp"
+#include "engine/DirectoryPrefetcher.hpp"
+#include "engine/DirectoryReader.hpp"
+#include "engine/DuplicateFinder.hpp"
+#include "engine/EntryModel.hpp"
+#include "engine/Executor.hpp"
+#include "engine/FileIndex.hpp"
+#include "engine/FolderSizer.hpp"
+#include "engine/FramePacer.hpp"
+#include "engine/ListingCache.hpp"
+#include "engine/LiveIndex.hpp"
+#include "engine/MetadataPipeline.hpp"
+#include "engine/Metrics.hpp"
+#include "engine/NameQuery.hpp"
+#include "engine/ResultChannel.hpp"
+#include "engine/RowSorter.hpp"
+#include "engine/SpaceAnalyzer.hpp"
+#include "engine/TopK.hpp"
+#include "engine/Trace.hpp"
+#include "engine/TreeWalker.hpp"
+#include "engine/TypeCache.hpp"
 
 // Link with required libraries
 #pragma comment(lib, "comctl32.lib")
@@ -39,6 +63,7 @@ constexpr int ID_GO_BUTTON = 104;
 constexpr int ID_SEARCH_BOX = 105;
 constexpr int ID_SEARCH_BUTTON = 106;
 constexpr int ID_STOP_SEARCH_BUTTON = 107;
+constexpr int ID_INDEX_BUTTON = 108;
 
 // UI constants
 constexpr int ICON_SIZE = 16; // Standard small icon size in Windows 11
@@ -50,6 +75,12 @@ constexpr int UI_PADDING = 10; // Standard padding between elements
 constexpr int WM_SEARCH_RESULT = WM_USER + 1;
 constexpr int WM_SEARCH_COMPLETE = WM_USER + 2;
 constexpr int WM_SEARCH_PROGRESS = WM_USER + 3;
+constexpr int WM_INDEX_COMPLETE = WM_USER + 4;
+constexpr int WM_METADATA_READY = WM_USER + 5;
+constexpr int WM_FOLDER_SIZES_READY = WM_USER + 6;
+
+// Timer that paces appending search results to the list
+constexpr UINT_PTR ID_RESULTS_TIMER = 1;
 
 // Colors
 constexpr COLORREF DARK_GRAY = RGB(64, 64, 64); // Dark gray color for button backgrounds
@@ -61,6 +92,15 @@ constexpr wchar_t THIS_PC_NAME[] = L"This PC";
 // Search thread pool size
 constexpr int MAX_SEARCH_THREADS = 8;
 
+// Rows above and below the visible ones whose metadata is fetched ahead
+constexpr int METADATA_PREFETCH_ROWS = 200;
+
+// Fuzzy searches keep only the best results
+constexpr size_t FUZZY_MAX_RESULTS = 500;
+
+// Name indexes older than this are ignored and the search walks the disk
+constexpr auto INDEX_MAX_AGE = std::chrono::hours(1);
+
 HICON g_hBackIcon = NULL;
 HICON g_hForwardIcon = NULL;
 HICON g_hSearchIcon = NULL;
@@ -80,6 +120,7 @@ HWND g_hwndSearchBox = NULL;
 HWND g_hwndSearchButton = NULL;
 HWND g_hwndStatusBar = NULL;
 HWND g_hwndStopSearchButton = NULL;
+HWND g_hwndIndexButton = NULL;
 HFONT g_hFont = NULL;
 fs::path g_currentPath;
 
@@ -96,148 +137,135 @@ bool g_navigatingHistory = false;
 
 // Search related variables
 std::atomic<bool> g_isSearching = false;
-std::atomic<int> g_filesSearched = 0;
-std::atomic<int> g_filesFound = 0;
-std::atomic<int> g_directoriesSearched = 0;
-std::vector<std::jthread> g_searchThreads;
-std::mutex g_resultsMutex;
-std::vector<fs::path> g_searchResults;
-std::string g_searchTerm;
-fs::path g_searchRootPath;
-std::condition_variable g_stopSearchCV;
-std::mutex g_stopSearchMutex;
-
-class OptimizedThreadPool {
-public:
-    OptimizedThreadPool(size_t threads) : stop(false) {
-        workers.reserve(threads);
-        for (size_t i = 0; i < threads; ++i) {
-            workers.emplace_back([this, i] {
-                // Each worker gets its own task queue to reduce lock contention
-                size_t workerIndex = i;
+std::atomic<WPARAM> g_searchGeneration = 0;
+ffe::TreeWalk g_searchWalk;
+bool g_searchFromIndex = false;
+bool g_searchRanked = false; // Results are ordered by fuzzy score, not by name
+bool g_searchContent = false; // Results are lines inside files, from a content: search
+bool g_searchDuplicates = false; // Results are groups of files with the same contents, from a dupes: search
+std::shared_ptr<ffe::DuplicateFinder> g_duplicateFinder; // Finder of the current dupes: search
+bool g_searchSpace = false; // Results are the largest folders and files, from a space: search
+std::shared_ptr<ffe::SpaceAnalyzer> g_spaceAnalyzer; // Analyzer of the current space: search
+
+// Prefix of the search box text that searches file contents instead of names
+constexpr std::wstring_view CONTENT_SEARCH_PREFIX = L"content:";
+
+// Prefix that finds files with the same contents instead, among the files
+// whose names match the query after it (dupes:*.jpg), or all of them
+constexpr std::wstring_view DUPLICATE_SEARCH_PREFIX = L"dupes:";
+
+// Prefix that ranks the largest folders and files below the current folder
+// instead, or below every fixed drive from This PC
+constexpr std::wstring_view SPACE_SEARCH_PREFIX = L"space:";
+
+// The group a result of a dupes: search belongs to; groups are numbered
+// from 1, most space wasted first
+struct DuplicateMark {
+    uint32_t group;
+    uint32_t copies;      // Copies in the group, hard links counted once
+    uint64_t reclaimable; // Bytes freed by keeping one copy
+    bool hardLink;        // Another name of the copy listed just before
+};
 
-                while (true) {
-                    std::function<void()> task;
-                    bool hasTask = false;
+// The rank of a result of a space: search; folders and files are ranked
+// apart, from 1, most space allocated first
+struct SpaceMark {
+    bool folder;
+    uint32_t rank;
+    uint64_t files; // Below a folder
+    double share;   // Of all the space allocated below the roots
+};
 
-                    {
-                        // First try to get a task from this worker's preferred queue
-                        std::unique_lock<std::mutex> lock(this->queue_mutex);
+// Totals of a finished dupes: search
+struct DuplicateTotals {
+    uint64_t groups = 0;
+    uint64_t duplicates = 0; // Copies beyond the first of each group
+    uint64_t reclaimable = 0;
+    ffe::DuplicateStats stats;
+};
 
-                        // Check if we should stop
-                        if (this->stop && this->global_tasks.empty()) {
-                            return;
-                        }
+// A result of a search: a file, and for a content search the line in it
+// or for a dupes: search its group
+struct SearchResult {
+    fs::path path;
+    std::optional<ffe::ContentHit> hit;
+    std::optional<DuplicateMark> duplicate;
+};
 
-                        // Try to get task from global queue
-                        if (!this->global_tasks.empty()) {
-                            task = std::move(this->global_tasks.front());
-                            this->global_tasks.pop();
-                            hasTask = true;
-                        }
-                    }
+// A fuzzy search hit; a hit is less than another when it ranks lower
+struct RankedHit {
+    int32_t score;
+    fs::path path;
 
-                    if (hasTask) {
-                        try {
-                            task();
-                        }
-                        catch (const std::exception& e) {
-                            // Log but don't crash
-                            OutputDebugStringA(("ThreadPool exception: " + std::string(e.what())).c_str());
-                        }
-                    } else {
-                        // If no tasks, sleep briefly to reduce CPU usage
-                        std::this_thread::sleep_for(std::chrono::milliseconds(1));
-                    }
-                }
-            });
+    bool operator<(const RankedHit& other) const {
+        if (score != other.score) {
+            return score < other.score;
         }
+        return path.native().size() > other.path.native().size();
     }
+};
 
-    template<class F>
-    void enqueue(F&& f) {
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex);
-            if (stop) return;
-            global_tasks.emplace(std::forward<F>(f));
-        }
-        condition.notify_one();
-    }
+// Best hits found by one search worker, merged by the search thread
+struct WorkerHits {
+    std::mutex mutex;
+    ffe::TopK<RankedHit> hits{FUZZY_MAX_RESULTS};
+};
 
-    ~OptimizedThreadPool() {
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex);
-            stop = true;
-        }
-        condition.notify_all();
-        for (auto& worker : workers) {
-            if (worker.joinable()) {
-                worker.join();
-            }
-        }
-    }
+// Name index related variables
+std::atomic<bool> g_isIndexing = false;
+std::jthread g_indexThread;
+std::unique_ptr<ffe::LiveIndexer> g_liveIndexer; // Keeps the index of the last indexed folder current
+ffe::Metrics g_searchMetrics; // Files searched (entries) and found (matches) by the current search
+std::vector<std::jthread> g_searchThreads;
+std::shared_ptr<ffe::ResultChannel<SearchResult>> g_resultChannel; // Matches of the current search
+std::vector<SearchResult> g_pendingResults; // Drained from the channel, not yet in the list (UI thread only)
+size_t g_pendingOffset = 0;             // First pending result not yet in the list
+ffe::FramePacer g_resultPacer;
+std::mutex g_resultsMutex;
+std::vector<fs::path> g_rankedResults; // Latest merged fuzzy ranking, best first
 
-private:
-    std::vector<std::thread> workers;
-    std::queue<std::function<void()>> global_tasks;
-    std::mutex queue_mutex;
-    std::condition_variable condition;
-    bool stop;
-};
+// Trace written when the window closes, from --trace on the command line
+fs::path g_traceFile;
 
-// ThreadPool class for search operations
-class ThreadPool {
-public:
-    ThreadPool(size_t threads) : stop(false) {
-        for (size_t i = 0; i < threads; ++i)
-            workers.emplace_back([this] {
-                while (true) {
-                    std::function<void()> task;
-                    {
-                        std::unique_lock<std::mutex> lock(this->queue_mutex);
-                        this->condition.wait(lock, [this] {
-                            return this->stop || !this->tasks.empty();
-                        });
+// Rows of the list view. The view is virtual (LVS_OWNERDATA): it asks for
+// the text of the rows it shows, so only those are ever formatted.
+ffe::EntryModel g_entryModel;
+bool g_showingSearchResults = false;
 
-                        if (this->stop && this->tasks.empty())
-                            return;
+// Folders listed recently, so Back and Forward do not enumerate them again
+ffe::ListingCache g_listingCache;
 
-                        task = std::move(this->tasks.front());
-                        this->tasks.pop();
-                    }
-                    task();
-                }
-            });
-    }
+// Type name and icon of rows whose metadata arrived; rows refer to them by
+// their index (EntryModel kind), so each distinct pair is stored once
+struct FileKind {
+    std::wstring typeName;
+    int icon;
+};
+std::vector<FileKind> g_fileKinds;
+std::map<std::pair<std::wstring, int>, uint16_t> g_fileKindIds;
+int g_defaultFileIcon = 0;   // Shown until a row's metadata arrives
+int g_defaultFolderIcon = 0;
 
-    template<class F>
-    void enqueue(F&& f) {
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex);
-            if (stop)
-                throw std::runtime_error("enqueue on stopped ThreadPool");
-            tasks.emplace(std::forward<F>(f));
-        }
-        condition.notify_one();
-    }
+// Lines found by a content search; rows refer to theirs by tag (index + 1)
+std::vector<ffe::ContentHit> g_contentHits;
 
-    ~ThreadPool() {
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex);
-            stop = true;
-        }
-        condition.notify_all();
-        for (std::thread &worker : workers)
-            worker.join();
-    }
+// Groups of the rows of a dupes: search, referred to by tag the same way
+std::vector<DuplicateMark> g_duplicateMarks;
+DuplicateTotals g_duplicateTotals; // Set by the search thread when done (g_resultsMutex)
 
-private:
-    std::vector<std::thread> workers;
-    std::queue<std::function<void()>> tasks;
-    std::mutex queue_mutex;
-    std::condition_variable condition;
-    bool stop;
-};
+// Rows of a space: search refer to their rank by tag the same way
+std::vector<SpaceMark> g_spaceMarks;
+ffe::SpaceReport g_spaceReport; // Latest snapshot of the analyzer (g_resultsMutex)
+
+// Sizes of the folders of a listing, referred to by tag the same way;
+// empty until a folder's subtree has been measured
+std::vector<std::optional<ffe::FolderSize>> g_folderSizes;
+bool g_showAllocatedSize = false; // Folder sizes show bytes on disk rather than apparent bytes (Ctrl+Shift+A)
+
+std::string g_searchTerm;
+fs::path g_searchRootPath;
+std::condition_variable g_stopSearchCV;
+std::mutex g_stopSearchMutex;
 
 // Function declarations
 LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
@@ -250,18 +278,45 @@ void NavigateTo(const fs::path& path, bool addToHistory = true);
 void NavigateBack();
 void NavigateForward();
 std::vector<fs::path> EnumerateDrives();
-std::wstring GetFileTypeDescription(const fs::path& path);
+bool FetchShellMetadata(const fs::path& path, ffe::EntryMetadata& metadata);
+ffe::MetadataPipeline& RowMetadata();
+ffe::FolderSizer& FolderSizes();
+ffe::DirectoryPrefetcher& Prefetcher();
+ffe::RowSorter& ListSorter();
+void SortListRows(const ffe::SortOrder& order);
+void SortByColumn(int column);
+void PrefetchFolders(std::vector<fs::path> folders);
+void PrefetchRow(int index);
 std::wstring FormatFileSize(uintmax_t size);
 void UpdateNavigationButtons();
 void ApplyFontToAllControls();
 void EnableWindowTheme(HWND hwnd, LPCWSTR classList, LPCWSTR subApp);
 HWND CreateCustomButton(HWND hwndParent, int x, int y, int width, int height, int id, HINSTANCE hInstance);
-void SearchFiles(const fs::path& rootPath, const std::wstring& searchTerm);
+void SearchFiles(const fs::path& rootPath, const ffe::NameQuery& query,
+                 std::shared_ptr<const ffe::ContentSearcher> content = nullptr);
+void SearchDuplicates(const fs::path& rootPath, const ffe::NameQuery& query);
+void AnalyzeSpace(std::vector<fs::path> roots);
+std::unique_lock<std::mutex> LockResults();
+void ToggleTracing();
+void ToggleAllocatedSize();
 void DisplaySearchResults();
+void DisplaySpaceRanking();
+std::wstring SpaceSummary(const ffe::SpaceReport& report);
 void ClearSearchResults();
+void ClearListItems();
+void SetListRowCount();
+void AppendSearchResults();
+void ScheduleResultAppend();
 LRESULT CALLBACK SearchBoxProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
-void SearchDirectoryRecursive(const fs::path& dirPath, const std::wstring& searchTerm,
-                             ThreadPool& pool, std::atomic<bool>& isSearching);
+void SearchDirectory(const ffe::WalkDirectory& dir, const ffe::NameQuery& query,
+                     ffe::ResultChannel<SearchResult>& results);
+void SearchContents(const ffe::WalkDirectory& dir, const ffe::ContentSearcher& searcher,
+                    ffe::ResultChannel<SearchResult>& results);
+void RankDirectory(const ffe::WalkDirectory& dir, const ffe::NameQuery& query, WorkerHits& worker);
+void SearchSnapshot(const ffe::IndexSnapshot& snapshot, uint32_t scope, const ffe::NameQuery& query,
+                    ffe::ResultChannel<SearchResult>& results);
+bool SearchIndex(const fs::path& rootPath, const ffe::NameQuery& query);
+void BuildSearchIndex();
 
 // Create a custom button with dark gray background
 HWND CreateCustomButton(HWND hwndParent, int x, int y, int width, int height, int id, HINSTANCE hInstance)
@@ -321,19 +376,6 @@ void CaseInsensitiveReplace(std::wstring& str, const std::wstring& from, const s
     }
 }
 
-// Check if a filename matches the search term
-bool MatchesSearchTerm(const std::wstring& filename, const std::wstring& searchTerm) {
-    if (searchTerm.empty()) {
-        return true;
-    }
-
-    std::wstring lowerFilename = ToLowerCase(filename);
-    std::wstring lowerSearchTerm = ToLowerCase(searchTerm);
-
-    // Check if the search term is found in the filename
-    return lowerFilename.find(lowerSearchTerm) != std::wstring::npos;
-}
-
 // Apply Segoe UI font to all controls
 void ApplyFontToAllControls()
 {
@@ -350,6 +392,7 @@ void ApplyFontToAllControls()
         SendMessageW(g_hwndSearchButton, WM_SETFONT, (WPARAM)g_hFont, TRUE);
         SendMessageW(g_hwndStatusBar, WM_SETFONT, (WPARAM)g_hFont, TRUE);
         SendMessageW(g_hwndStopSearchButton, WM_SETFONT, (WPARAM)g_hFont, TRUE);
+        SendMessageW(g_hwndIndexButton, WM_SETFONT, (WPARAM)g_hFont, TRUE);
     }
 }
 
@@ -377,16 +420,79 @@ std::vector<fs::path> EnumerateDrives()
     return drives;
 }
 
-// Get file type description
-std::wstring GetFileTypeDescription(const fs::path& path)
+// Ask the shell for the type description and icon of a file; generic
+// lookups only pass the extension, so the file itself is never opened
+ffe::FileType ResolveShellType(const fs::path& path, ffe::EntryType type, bool generic)
 {
     SHFILEINFOW sfi = {};
-    if (SHGetFileInfoW(path.wstring().c_str(), 0, &sfi, sizeof(sfi), SHGFI_TYPENAME))
+    UINT flags = SHGFI_TYPENAME | SHGFI_SYSICONINDEX | SHGFI_SMALLICON;
+    DWORD attributes = 0;
+    std::wstring name = path.wstring();
+    if (generic)
     {
-        return sfi.szTypeName;
+        flags |= SHGFI_USEFILEATTRIBUTES;
+        attributes = type == ffe::EntryType::Directory ? FILE_ATTRIBUTE_DIRECTORY : FILE_ATTRIBUTE_NORMAL;
+        name = L"file" + path.extension().wstring();
     }
 
-    return L"File";
+    ffe::FileType fileType;
+    ffe::TraceSpan span("SHGetFileInfoW");
+    if (SHGetFileInfoW(name.c_str(), attributes, &sfi, sizeof(sfi), flags))
+    {
+        fileType.description = sfi.szTypeName;
+        fileType.icon = sfi.iIcon;
+    }
+    return fileType;
+}
+
+// Types of files by extension, shared by every listing
+ffe::TypeCache& ShellTypes()
+{
+    static ffe::TypeCache cache(ResolveShellType);
+    return cache;
+}
+
+// Look up attributes, size, type description and icon of one row; runs on
+// background executor threads
+bool FetchShellMetadata(const fs::path& path, ffe::EntryMetadata& metadata)
+{
+    ffe::TraceSpan span("FetchShellMetadata");
+
+    // The shell needs COM on every thread that calls it
+    thread_local const HRESULT comInitialized = CoInitializeEx(NULL, COINIT_MULTITHREADED);
+    (void)comInitialized;
+
+    WIN32_FILE_ATTRIBUTE_DATA data = {};
+    if (!GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &data))
+    {
+        return false;
+    }
+    metadata.attributes = data.dwFileAttributes;
+    metadata.type = (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) ? ffe::EntryType::Directory : ffe::EntryType::File;
+    metadata.size = (static_cast<uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+
+    // FILETIME counts 100 ns intervals since 1601
+    const uint64_t ticks = (static_cast<uint64_t>(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime;
+    metadata.mtime = (static_cast<int64_t>(ticks) - 116444736000000000LL) * 100;
+
+    // Drives and folders customized through desktop.ini (marked read-only or
+    // system) have their own description or icon; everything else is
+    // described by its extension
+    const bool customFolder = metadata.type == ffe::EntryType::Directory &&
+                              (data.dwFileAttributes & (FILE_ATTRIBUTE_READONLY | FILE_ATTRIBUTE_SYSTEM));
+    if (customFolder || path == path.root_path())
+    {
+        const ffe::FileType fileType = ResolveShellType(path, metadata.type, false);
+        metadata.typeName = fileType.description;
+        metadata.icon = fileType.icon;
+    }
+    else
+    {
+        const auto fileType = ShellTypes().lookup(path, metadata.type);
+        metadata.typeName = fileType->description;
+        metadata.icon = fileType->icon;
+    }
+    return true;
 }
 
 // Format file size
@@ -430,6 +536,19 @@ void StopSearch() {
     // Set the flag to stop searching
     g_isSearching = false;
 
+    // Stop descending; directories already queued are skipped
+    if (g_searchWalk.valid()) {
+        g_searchWalk.cancel();
+    }
+
+    // Stop hashing; the finder returns the groups it confirmed so far
+    if (g_duplicateFinder) {
+        g_duplicateFinder->cancel();
+    }
+    if (g_spaceAnalyzer) {
+        g_spaceAnalyzer->cancel();
+    }
+
     // Notify threads to stop
     {
         std::lock_guard<std::mutex> lock(g_stopSearchMutex);
@@ -449,29 +568,78 @@ void StopSearch() {
     // Hide stop search button
     ShowWindow(g_hwndStopSearchButton, SW_HIDE);
 
-    // Update UI with final results
-    DisplaySearchResults();
+    // Show the final ranking, or the results still waiting to be appended
+    if (g_searchRanked) {
+        DisplaySearchResults();
+    } else {
+        ScheduleResultAppend();
+    }
 
     // Update status bar
-    std::wstring status = std::format(L"Search complete. Found {} files in {} directories. Searched {} files.",
-                                     g_filesFound.load(), g_directoriesSearched.load(), g_filesSearched.load());
+    const ffe::MetricsSnapshot metrics = g_searchMetrics.snapshot();
+    ffe::TraceMetrics(metrics);
+    std::wstring status;
+    if (g_searchFromIndex) {
+        status = std::format(L"Search complete (from index). Found {} files among {} indexed entries.",
+                             metrics.matches, metrics.entries);
+    } else if (g_searchDuplicates) {
+        DuplicateTotals totals;
+        {
+            auto lock = LockResults();
+            totals = g_duplicateTotals;
+        }
+        status = std::format(L"Search complete. Found {} duplicate files in {} groups, {} reclaimable. "
+                             L"Compared {} files, read {} in {:.1f} s.",
+                             totals.duplicates, totals.groups, FormatFileSize(totals.reclaimable),
+                             totals.stats.files, FormatFileSize(totals.stats.bytesRead), metrics.seconds);
+    } else if (g_searchSpace) {
+        ffe::SpaceReport report;
+        {
+            auto lock = LockResults();
+            report = g_spaceReport;
+        }
+        status = std::format(L"Analysis {}. {} Took {:.1f} s.", report.done ? L"complete" : L"stopped",
+                             SpaceSummary(report), metrics.seconds);
+    } else if (g_searchContent) {
+        status = std::format(L"Search complete. Found {} lines in {} files. Read {} in {:.1f} s ({}/s).",
+                             metrics.matches, metrics.entries, FormatFileSize(metrics.bytes), metrics.seconds,
+                             FormatFileSize(static_cast<uintmax_t>(metrics.bytesPerSecond())));
+    } else {
+        status = std::format(L"Search complete. Found {} files in {} directories. Searched {} files.",
+                             metrics.matches, metrics.directories, metrics.entries);
+    }
+    if (metrics.firstResultSeconds >= 0) {
+        status += std::format(L" First result after {:.0f} ms.", metrics.firstResultSeconds * 1000.0);
+    }
+    if (g_searchRanked && metrics.matches > FUZZY_MAX_RESULTS) {
+        status += std::format(L" Showing the best {}.", FUZZY_MAX_RESULTS);
+    }
     SendMessageW(g_hwndStatusBar, SB_SETTEXT, 0, (LPARAM)status.c_str());
-
-    // Post message to notify search complete
-    PostMessageW(g_hwndMain, WM_SEARCH_COMPLETE, 0, 0);
 }
 
 void InitializeSearch() {
-    // Reset counters
-    g_filesSearched = 0;
-    g_filesFound = 0;
-    g_directoriesSearched = 0;
-
-    // Clear results
-    {
-        std::lock_guard<std::mutex> lock(g_resultsMutex);
-        g_searchResults.clear();
-    }
+    // Reset counters; the list's memory counts as the search's allocations
+    g_searchMetrics.start();
+    g_searchMetrics.setBytesAllocated([]() {
+        return static_cast<uint64_t>(g_entryModel.memoryUsage() + ListSorter().memoryUsage());
+    });
+    g_searchFromIndex = false;
+    g_searchRanked = false;
+    g_searchContent = false;
+    g_searchDuplicates = false;
+    g_duplicateFinder.reset();
+    g_searchSpace = false;
+    g_spaceAnalyzer.reset();
+
+    // Results of the new search start from an empty list; the channel wakes
+    // the window when a batch arrives after the previous one was drained
+    ClearSearchResults();
+    ClearListItems();
+    g_showingSearchResults = true;
+    const WPARAM generation = ++g_searchGeneration;
+    g_resultChannel = std::make_shared<ffe::ResultChannel<SearchResult>>([generation]() {
+        PostMessageW(g_hwndMain, WM_SEARCH_RESULT, generation, 0);
+    });
 
     // Show stop search button
     ShowWindow(g_hwndStopSearchButton, SW_SHOW);
@@ -500,6 +668,60 @@ void StartFileSearch() {
         return;
     }
 
+    // content:<text> looks for text inside the files; the needle is
+    // matched as UTF-8, the encoding most text files use
+    std::shared_ptr<const ffe::ContentSearcher> content;
+    if (searchTerm.size() > CONTENT_SEARCH_PREFIX.size() &&
+        _wcsnicmp(searchTerm.c_str(), CONTENT_SEARCH_PREFIX.data(), CONTENT_SEARCH_PREFIX.size()) == 0) {
+        const std::wstring needle = searchTerm.substr(CONTENT_SEARCH_PREFIX.size());
+        const int length = WideCharToMultiByte(CP_UTF8, 0, needle.data(), static_cast<int>(needle.size()), NULL, 0, NULL, NULL);
+        std::string utf8(static_cast<size_t>(std::max(length, 0)), '\0');
+        WideCharToMultiByte(CP_UTF8, 0, needle.data(), static_cast<int>(needle.size()), utf8.data(), length, NULL, NULL);
+        content = std::make_shared<ffe::ContentSearcher>(utf8);
+    }
+
+    // dupes:<query> compares the contents of the files the query matches
+    bool duplicates = false;
+    if (!content && searchTerm.size() >= DUPLICATE_SEARCH_PREFIX.size() &&
+        _wcsnicmp(searchTerm.c_str(), DUPLICATE_SEARCH_PREFIX.data(), DUPLICATE_SEARCH_PREFIX.size()) == 0) {
+        duplicates = true;
+        searchTerm.erase(0, DUPLICATE_SEARCH_PREFIX.size());
+        if (searchTerm.empty()) {
+            searchTerm = L"*";
+        }
+    }
+
+    // space: needs no query, and runs from This PC too, over every fixed
+    // drive. A whole drive takes longer than the search timeout allows.
+    if (!content && !duplicates && searchTerm.size() >= SPACE_SEARCH_PREFIX.size() &&
+        _wcsnicmp(searchTerm.c_str(), SPACE_SEARCH_PREFIX.data(), SPACE_SEARCH_PREFIX.size()) == 0) {
+        std::vector<fs::path> roots;
+        if (g_currentPath.empty()) {
+            for (const auto& drive : EnumerateDrives()) {
+                if (GetDriveTypeW(drive.c_str()) == DRIVE_FIXED) {
+                    roots.push_back(drive);
+                }
+            }
+        } else {
+            roots.push_back(g_currentPath);
+        }
+        InitializeSearch();
+        g_searchRanked = true;
+        g_searchSpace = true;
+        AnalyzeSpace(std::move(roots));
+        return;
+    }
+
+    // Compile the query once: plain text, a glob such as *.log, re:<regex>
+    // or ~fuzzy. A content search looks at every file.
+    ffe::NameQuery query;
+    std::string queryError;
+    if (!query.parse(content ? std::wstring(L"*") : searchTerm, queryError)) {
+        std::wstring errorMsg = L"Invalid search pattern: " + std::wstring(queryError.begin(), queryError.end());
+        MessageBoxW(g_hwndMain, errorMsg.c_str(), L"Search", MB_ICONERROR);
+        return;
+    }
+
     // Determine the search root path
     fs::path rootPath;
     if (g_currentPath.empty()) {
@@ -519,9 +741,22 @@ void StartFileSearch() {
 
     // Initialize search state
     InitializeSearch();
+    g_searchRanked = query.isRanked() && !duplicates;
+    g_searchContent = content != nullptr;
+    g_searchDuplicates = duplicates;
+
+    // Answer from the name index when a fresh one covers this folder; it
+    // knows nothing of contents
+    if (!content && !duplicates && SearchIndex(rootPath, query)) {
+        return;
+    }
 
     // Start search
-    SearchFiles(rootPath, searchTerm);
+    if (duplicates) {
+        SearchDuplicates(rootPath, query);
+    } else {
+        SearchFiles(rootPath, query, std::move(content));
+    }
 
     // Start a timeout thread
     std::thread timeoutThread([rootPath]() {
@@ -545,92 +780,248 @@ void StartFileSearch() {
     timeoutThread.detach();
 }
 
-// Clear search results
+// Lock the shared search results; time spent waiting shows in traces
+std::unique_lock<std::mutex> LockResults() {
+    ffe::TraceSpan wait("wait g_resultsMutex");
+    return std::unique_lock<std::mutex>(g_resultsMutex);
+}
+
+// Drop the results of the current search that are not shown yet
 void ClearSearchResults() {
-    std::lock_guard<std::mutex> lock(g_resultsMutex);
-    g_searchResults.clear();
+    g_resultChannel.reset();
+    g_pendingResults.clear();
+    g_pendingOffset = 0;
+    g_resultPacer.reset();
+    KillTimer(g_hwndMain, ID_RESULTS_TIMER);
+
+    auto lock = LockResults();
+    g_rankedResults.clear();
 }
 
-// Display search results in the list view
-void DisplaySearchResults() {
-    // Clear list view and free previous items
-    int itemCount = ListView_GetItemCount(g_hwndListView);
-    for (int i = 0; i < itemCount; i++) {
-        LVITEMW lvItem = {};
-        lvItem.mask = LVIF_PARAM;
-        lvItem.iItem = i;
+// Empty the list view and the rows behind it; metadata still on its way
+// for the old rows is dropped, and so are kinds only the old rows used
+void ClearListItems() {
+    g_entryModel.clear();
+    ListSorter().clear();
+    RowMetadata().reset();
+    g_fileKinds.clear();
+    g_fileKindIds.clear();
+    g_contentHits.clear();
+    g_duplicateMarks.clear();
+    g_spaceMarks.clear();
+    g_folderSizes.clear();
+    FolderSizes().cancel();
+    ListView_SetItemCountEx(g_hwndListView, 0, 0);
+}
+
+// Tell the virtual list view how many rows the model holds now; rows
+// already shown keep their place
+void SetListRowCount() {
+    ListView_SetItemCountEx(g_hwndListView, static_cast<int>(g_entryModel.size()),
+                            LVSICF_NOINVALIDATEALL | LVSICF_NOSCROLL);
+}
+
+// Ask for the metadata of the rows about to be shown first, then of the
+// rows around them (LVN_ODCACHEHINT)
+void RequestRowMetadata(int from, int to) {
+    const int count = static_cast<int>(g_entryModel.size());
+    from = std::max(from, 0);
+    to = std::min(to, count - 1);
+    if (from > to) {
+        return;
+    }
 
-        if (ListView_GetItem(g_hwndListView, &lvItem) && lvItem.lParam) {
-            delete reinterpret_cast<fs::path*>(lvItem.lParam);
+    const auto collect = [](int first, int last) {
+        std::vector<ffe::MetadataRequest> requests;
+        for (int index = first; index <= last; index++) {
+            if (!g_entryModel.row(index).hasDetails) {
+                requests.push_back({static_cast<uint32_t>(index), g_entryModel.path(index)});
+            }
         }
+        return requests;
+    };
+    RowMetadata().prioritize(collect(from, to));
+
+    auto nearby = collect(to + 1, std::min(to + METADATA_PREFETCH_ROWS, count - 1));
+    auto above = collect(std::max(from - METADATA_PREFETCH_ROWS, 0), from - 1);
+    nearby.insert(nearby.end(), std::make_move_iterator(above.rbegin()), std::make_move_iterator(above.rend()));
+    RowMetadata().enqueue(std::move(nearby));
+}
+
+// Kind id of a type name and icon pair, added on first use
+std::optional<uint16_t> FileKindId(const std::wstring& typeName, int icon) {
+    auto key = std::make_pair(typeName, icon);
+    auto it = g_fileKindIds.find(key);
+    if (it != g_fileKindIds.end()) {
+        return it->second;
+    }
+    if (g_fileKinds.size() > UINT16_MAX) {
+        return std::nullopt;
     }
-    ListView_DeleteAllItems(g_hwndListView);
+    const auto id = static_cast<uint16_t>(g_fileKinds.size());
+    g_fileKinds.push_back({typeName, icon});
+    g_fileKindIds.emplace(std::move(key), id);
+    return id;
+}
 
-    // Copy search results to prevent locking during UI update
-    std::vector<fs::path> results;
-    {
-        std::lock_guard<std::mutex> lock(g_resultsMutex);
-        results = g_searchResults;
+// Size shown for the folder in a row of a listing, once measured
+std::optional<uint64_t> MeasuredFolderSize(size_t index) {
+    const uint32_t tag = g_showingSearchResults ? 0 : g_entryModel.tag(index);
+    if (tag == 0 || !g_folderSizes[tag - 1]) {
+        return std::nullopt;
     }
+    const ffe::FolderSize& size = *g_folderSizes[tag - 1];
+    return g_showAllocatedSize ? size.allocated : size.bytes;
+}
 
-    // Sort results alphabetically
-    std::sort(results.begin(), results.end(), [](const fs::path& a, const fs::path& b) {
-        return a.filename().wstring() < b.filename().wstring();
-    });
+// Measure the folders of a listing in the background; each row's size
+// arrives once its subtree is done (WM_FOLDER_SIZES_READY)
+void MeasureFolderRows() {
+    std::vector<ffe::FolderSizeRequest> requests;
+    for (size_t index = 0; index < g_entryModel.size() && g_folderSizes.size() < UINT32_MAX; index++) {
+        if (g_entryModel.row(index).isDirectory()) {
+            requests.push_back({static_cast<uint32_t>(g_folderSizes.size()), g_entryModel.path(index)});
+            g_folderSizes.emplace_back();
+            g_entryModel.setTag(index, static_cast<uint32_t>(g_folderSizes.size()));
+        }
+    }
+    if (!requests.empty()) {
+        FolderSizes().measure(std::move(requests));
+    }
+}
 
-    // Populate list view with search results
-    int index = 0;
-    for (const auto& path : results) {
-        LVITEMW lvItem = {};
-        lvItem.mask = LVIF_TEXT | LVIF_PARAM | LVIF_IMAGE;
-        lvItem.iItem = index++;
-        lvItem.iSubItem = 0;
-
-        // Store the path
-        fs::path* pathCopy = new fs::path(path);
-        lvItem.lParam = (LPARAM)pathCopy;
-
-        // Get file/folder name
-        std::wstring name = path.filename().wstring();
-        lvItem.pszText = const_cast<LPWSTR>(name.c_str());
-
-        // Add icon
-        SHFILEINFOW sfi = {};
-        SHGetFileInfoW(path.wstring().c_str(), 0, &sfi, sizeof(sfi), SHGFI_ICON | SHGFI_SMALLICON);
-        lvItem.iImage = ImageList_AddIcon(ListView_GetImageList(g_hwndListView, LVSIL_SMALL), sfi.hIcon);
-        DestroyIcon(sfi.hIcon);
-
-        // Insert item
-        int itemIndex = ListView_InsertItem(g_hwndListView, &lvItem);
-
-        // Set location (parent path)
-        std::wstring location = path.parent_path().wstring();
-        ListView_SetItemText(g_hwndListView, itemIndex, 1, const_cast<LPWSTR>(location.c_str()));
-
-        // Set type and size
-        if (fs::is_directory(path)) {
-            ListView_SetItemText(g_hwndListView, itemIndex, 2, const_cast<LPWSTR>(L"Folder"));
-            ListView_SetItemText(g_hwndListView, itemIndex, 3, const_cast<LPWSTR>(L""));
-        } else {
-            // Get file type
-            std::wstring typeDesc = GetFileTypeDescription(path);
-            ListView_SetItemText(g_hwndListView, itemIndex, 2, const_cast<LPWSTR>(typeDesc.c_str()));
-
-            // Get file size
-            uintmax_t size = 0;
-            try {
-                size = fs::file_size(path);
-            } catch (...) {
-                // Ignore errors
-            }
+// Copies the measured folder sizes into the rows in the unit shown and
+// repaints the list
+void UpdateFolderRowSizes() {
+    for (size_t index = 0; index < g_entryModel.size(); index++) {
+        if (const auto size = MeasuredFolderSize(index)) {
+            g_entryModel.setStat(index, *size, g_entryModel.row(index).mtime);
+        }
+    }
+    InvalidateRect(g_hwndListView, NULL, FALSE);
+}
+
+// Store the folder sizes measured since the last update in their rows, so
+// sorting by size orders folders too, and repaint them
+void ApplyFolderSizes() {
+    std::vector<ffe::FolderSizeResult> arrived;
+    FolderSizes().drain(arrived);
+    if (arrived.empty() || g_showingSearchResults) {
+        return;
+    }
+    for (const auto& result : arrived) {
+        if (result.id < g_folderSizes.size()) {
+            g_folderSizes[result.id] = result.size;
+        }
+    }
+    UpdateFolderRowSizes();
+}
+
+// Store the metadata that arrived since the last update and repaint the
+// rows it belongs to, all in one go (WM_METADATA_READY)
+void ApplyRowMetadata() {
+    std::vector<ffe::EntryMetadata> arrived;
+    RowMetadata().drain(arrived);
+
+    size_t first = SIZE_MAX;
+    size_t last = 0;
+    for (const auto& metadata : arrived) {
+        if (!metadata.found || metadata.row >= g_entryModel.size()) {
+            continue;
+        }
+        // Measured folders and the rows of a space: ranking keep the
+        // totals found for them; the shell knows neither folder sizes nor
+        // allocation
+        std::optional<uint64_t> size = MeasuredFolderSize(metadata.row);
+        if (g_showingSearchResults && g_searchSpace && g_entryModel.tag(metadata.row) != 0) {
+            size = g_entryModel.row(metadata.row).size;
+        }
+        g_entryModel.setStat(metadata.row, size ? *size : metadata.size, metadata.mtime);
+        if (auto kind = FileKindId(std::wstring(metadata.typeName), metadata.icon)) {
+            g_entryModel.setDetails(metadata.row, metadata.attributes, *kind);
+        }
+        first = std::min<size_t>(first, metadata.row);
+        last = std::max<size_t>(last, metadata.row);
+    }
+    if (first <= last) {
+        ListView_RedrawItems(g_hwndListView, static_cast<int>(first), static_cast<int>(last));
+    }
+}
 
-            std::wstring sizeStr = FormatFileSize(size);
-            ListView_SetItemText(g_hwndListView, itemIndex, 3, const_cast<LPWSTR>(sizeStr.c_str()));
+// Answer the list view's request for the text and icon of one row
+// (LVN_GETDISPINFO). Names show straight from enumeration; the other
+// columns fill in as metadata arrives.
+void FillListItem(LVITEMW& item) {
+    if (item.iItem < 0 || static_cast<size_t>(item.iItem) >= g_entryModel.size()) {
+        return;
+    }
+    const auto row = g_entryModel.row(static_cast<size_t>(item.iItem));
+    const FileKind* kind = row.hasDetails ? &g_fileKinds[row.kind] : nullptr;
+
+    if ((item.mask & LVIF_TEXT) && item.pszText && item.cchTextMax > 0) {
+        std::wstring text;
+        switch (item.iSubItem) {
+        case 0:
+            text = std::wstring(row.name);
+            break;
+        case 1:
+            // Set type
+            if (kind) {
+                text = kind->typeName;
+            } else if (!g_showingSearchResults && g_currentPath.empty()) {
+                text = L"Drive";
+            } else if (row.isDirectory()) {
+                text = L"Folder";
+            }
+            break;
+        case 2:
+            // Set size
+            if ((!row.isDirectory() || (g_showingSearchResults && g_searchSpace)) && row.hasStat) {
+                text = FormatFileSize(row.size);
+            } else if (const auto size = MeasuredFolderSize(static_cast<size_t>(item.iItem))) {
+                text = FormatFileSize(*size);
+            }
+            break;
+        case 3:
+            // Set location (parent path, for search results only)
+            if (g_showingSearchResults) {
+                text = g_entryModel.directoryPath(row.directory).native();
+            }
+            break;
+        case 4:
+            // Set the matching line of content search results, or the
+            // group of dupes: search results (listing rows tag folder sizes)
+            if (const uint32_t tag = g_showingSearchResults ? g_entryModel.tag(static_cast<size_t>(item.iItem)) : 0) {
+                if (g_searchDuplicates) {
+                    const DuplicateMark& mark = g_duplicateMarks[tag - 1];
+                    text = std::format(L"Group {}: {} copies, {} reclaimable{}", mark.group, mark.copies,
+                                       FormatFileSize(mark.reclaimable), mark.hardLink ? L" (hard link)" : L"");
+                } else if (g_searchSpace) {
+                    const SpaceMark& mark = g_spaceMarks[tag - 1];
+                    text = mark.folder
+                        ? std::format(L"Folder {}: {} files, {:.1f}% of the space", mark.rank, mark.files, mark.share * 100)
+                        : std::format(L"File {}: {:.1f}% of the space", mark.rank, mark.share * 100);
+                } else {
+                    const ffe::ContentHit& hit = g_contentHits[tag - 1];
+                    const int length = MultiByteToWideChar(CP_UTF8, 0, hit.text.data(), static_cast<int>(hit.text.size()), NULL, 0);
+                    std::wstring line(static_cast<size_t>(std::max(length, 0)), L'\0');
+                    MultiByteToWideChar(CP_UTF8, 0, hit.text.data(), static_cast<int>(hit.text.size()), line.data(), length);
+                    text = std::format(L"{}:{}  {}", hit.line, hit.column, line);
+                }
+            }
+            break;
         }
+        wcsncpy_s(item.pszText, item.cchTextMax, text.c_str(), _TRUNCATE);
     }
+    if (item.mask & LVIF_IMAGE) {
+        item.iImage = kind ? kind->icon : (row.isDirectory() ? g_defaultFolderIcon : g_defaultFileIcon);
+    }
+}
 
+// Show the number of results and the query in the title and address bar
+void UpdateSearchTitle() {
     // Update window title
-    std::wstring windowTitle = std::format(L"Fast File Explorer - Search Results ({} items)", results.size());
+    std::wstring windowTitle = std::format(L"Fast File Explorer - Search Results ({} items)", g_entryModel.size());
     SetWindowTextW(g_hwndMain, windowTitle.c_str());
 
     // Set search box text as address bar text
@@ -640,128 +1031,433 @@ void DisplaySearchResults() {
     SetWindowTextW(g_hwndAddressBar, addressText.c_str());
 }
 
+// Append the results that arrived since the last refresh, as many as fit in
+// one frame budget; the rest follow on later frames
+void AppendSearchResults() {
+    if (!g_resultChannel) {
+        return;
+    }
+
+    // Take everything published so far; the list only ever grows at the end
+    if (g_pendingOffset == g_pendingResults.size()) {
+        g_pendingResults.clear();
+        g_pendingOffset = 0;
+    }
+    g_resultChannel->drain(g_pendingResults);
+
+    const auto start = ffe::FramePacer::Clock::now();
+    const size_t count = std::min(g_pendingResults.size() - g_pendingOffset, g_resultPacer.itemBudget());
+    ffe::TraceSpan span("AppendSearchResults");
+    span.arg("rows", static_cast<int64_t>(count));
+    if (count > 0) {
+        for (size_t i = 0; i < count; i++) {
+            SearchResult& result = g_pendingResults[g_pendingOffset++];
+            g_entryModel.appendPath(result.path, ffe::EntryType::File);
+            if (result.hit && g_contentHits.size() < UINT32_MAX) {
+                g_contentHits.push_back(std::move(*result.hit));
+                g_entryModel.setTag(g_entryModel.size() - 1, static_cast<uint32_t>(g_contentHits.size()));
+            }
+            if (result.duplicate && g_duplicateMarks.size() < UINT32_MAX) {
+                g_duplicateMarks.push_back(*result.duplicate);
+                g_entryModel.setTag(g_entryModel.size() - 1, static_cast<uint32_t>(g_duplicateMarks.size()));
+            }
+        }
+        SetListRowCount();
+    }
+    span.end();
+    g_resultPacer.record(start, ffe::FramePacer::Clock::now(), count);
+
+    if (g_pendingOffset < g_pendingResults.size()) {
+        // More to show: continue on a later frame
+        ScheduleResultAppend();
+    } else if (!g_isSearching && g_resultChannel->empty() && !g_searchDuplicates) {
+        // Everything is in; sort once rather than on every refresh.
+        // Duplicates stay next to the other copies of their group.
+        SortListRows(ListSorter().order());
+    }
+    UpdateSearchTitle();
+}
+
+// Append new results now if the frame budget allows, or when it next does
+void ScheduleResultAppend() {
+    const auto wait = g_resultPacer.wait(ffe::FramePacer::Clock::now());
+    if (wait == ffe::FramePacer::Clock::duration::zero()) {
+        KillTimer(g_hwndMain, ID_RESULTS_TIMER);
+        AppendSearchResults();
+        return;
+    }
+    const auto delay = std::chrono::ceil<std::chrono::milliseconds>(wait).count();
+    SetTimer(g_hwndMain, ID_RESULTS_TIMER, static_cast<UINT>(std::max<long long>(delay, USER_TIMER_MINIMUM)), NULL);
+}
+
+// Replace the rows of a ranking with the ones fill() appends, in place:
+// the list keeps its scroll position, selected rows stay selected by path,
+// and metadata already fetched for paths still listed is kept rather than
+// asked for again. A ranking is at most a few hundred rows.
+template<class Fill>
+void ReplaceRankedRows(Fill&& fill) {
+    std::map<std::wstring, ffe::EntryModel::Row> kept;
+    std::map<std::wstring, UINT> states; // Selected and focused rows
+    for (size_t index = 0; index < g_entryModel.size(); index++) {
+        const ffe::EntryModel::Row row = g_entryModel.row(index);
+        const UINT state = ListView_GetItemState(g_hwndListView, static_cast<int>(index), LVIS_SELECTED | LVIS_FOCUSED);
+        if (row.hasDetails || state != 0) {
+            const std::wstring path = g_entryModel.path(index).native();
+            if (row.hasDetails) {
+                kept.emplace(path, row);
+            }
+            if (state != 0) {
+                states.emplace(path, state);
+            }
+        }
+    }
+
+    // Requests in flight and sort keys refer to the old rows
+    g_entryModel.clear();
+    ListSorter().clear();
+    RowMetadata().reset();
+    g_spaceMarks.clear();
+    fill();
+
+    ListView_SetItemState(g_hwndListView, -1, 0, LVIS_SELECTED | LVIS_FOCUSED);
+    for (size_t index = 0; index < g_entryModel.size() && (!kept.empty() || !states.empty()); index++) {
+        const std::wstring path = g_entryModel.path(index).native();
+        if (auto it = kept.find(path); it != kept.end()) {
+            // Rows of a space: ranking keep their totals, see ApplyRowMetadata
+            const ffe::EntryModel::Row& row = it->second;
+            const ffe::EntryModel::Row current = g_entryModel.row(index);
+            if (row.hasStat) {
+                g_entryModel.setStat(index, current.hasStat ? current.size : row.size, row.mtime);
+            }
+            g_entryModel.setDetails(index, row.attributes, row.kind);
+        }
+        if (auto it = states.find(path); it != states.end()) {
+            ListView_SetItemState(g_hwndListView, static_cast<int>(index), it->second, LVIS_SELECTED | LVIS_FOCUSED);
+        }
+    }
+    SetListRowCount();
+    InvalidateRect(g_hwndListView, NULL, FALSE);
+
+    UpdateSearchTitle();
+}
+
+// Display the latest fuzzy ranking in the list view, best first
+void DisplaySearchResults() {
+    ffe::TraceSpan span("DisplaySearchResults");
+    if (g_searchSpace) {
+        DisplaySpaceRanking();
+        return;
+    }
+
+    // Copy search results to prevent locking during UI update
+    std::vector<fs::path> results;
+    {
+        auto lock = LockResults();
+        results = g_rankedResults;
+    }
+
+    // The ranking holds at most FUZZY_MAX_RESULTS, so rebuilding is cheap
+    ReplaceRankedRows([&results]() {
+        for (const auto& path : results) {
+            g_entryModel.appendPath(path, ffe::EntryType::File);
+        }
+    });
+    span.arg("rows", static_cast<int64_t>(results.size()));
+}
+
+// Replace the rows with the latest ranking of a space: search, largest
+// folders first, then largest files
+void DisplaySpaceRanking() {
+    ffe::SpaceReport report;
+    {
+        auto lock = LockResults();
+        report = g_spaceReport;
+    }
+
+    const double total = static_cast<double>(std::max<uint64_t>(report.total.allocated, 1));
+    const auto append = [total](const ffe::SpaceItem& item, ffe::EntryType type, uint32_t rank) {
+        g_entryModel.appendPath(item.path, type);
+        const size_t index = g_entryModel.size() - 1;
+        g_entryModel.setStat(index, g_showAllocatedSize ? item.allocated : item.bytes, 0);
+        g_spaceMarks.push_back({type == ffe::EntryType::Directory, rank, item.files, item.allocated / total});
+        g_entryModel.setTag(index, static_cast<uint32_t>(g_spaceMarks.size()));
+    };
+    ReplaceRankedRows([&report, &append]() {
+        for (size_t index = 0; index < report.folders.size(); index++) {
+            append(report.folders[index], ffe::EntryType::Directory, static_cast<uint32_t>(index + 1));
+        }
+        for (size_t index = 0; index < report.files.size(); index++) {
+            append(report.files[index], ffe::EntryType::File, static_cast<uint32_t>(index + 1));
+        }
+    });
+}
+
+// Totals of a space: search and the extensions taking the most space
+std::wstring SpaceSummary(const ffe::SpaceReport& report) {
+    std::wstring summary = std::format(L"{} allocated by {} files in {} folders.",
+                                       FormatFileSize(report.total.allocated), report.total.files,
+                                       report.total.directories);
+    const size_t shown = std::min<size_t>(report.extensions.size(), 5);
+    for (size_t index = 0; index < shown; index++) {
+        const ffe::ExtensionSpace& extension = report.extensions[index];
+        const std::wstring name = extension.other ? L"other" : extension.extension.empty() ? L"none" : L"." + extension.extension;
+        summary += std::format(L"{}{} {}", index == 0 ? L" Largest types: " : L", ", name,
+                               FormatFileSize(extension.allocated));
+    }
+    if (shown > 0) {
+        summary += L".";
+    }
+    if (report.total.errors > 0) {
+        summary += std::format(L" {} folders could not be read.", report.total.errors);
+    }
+    return summary;
+}
+
 // Update search progress
 void UpdateSearchProgress() {
-    // Get current counts
-    int filesSearched = g_filesSearched.load();
-    int filesFound = g_filesFound.load();
-    int directoriesSearched = g_directoriesSearched.load();
+    // Get current counts, and record them in the trace
+    const ffe::MetricsSnapshot metrics = g_searchMetrics.snapshot();
+    ffe::TraceMetrics(metrics);
 
     // Update status bar
-    std::wstring status = std::format(L"Searching... Found {} files in {} directories. Searched {} files.",
-                                     filesFound, directoriesSearched, filesSearched);
+    std::wstring status;
+    if (g_searchSpace) {
+        ffe::SpaceReport report;
+        {
+            auto lock = LockResults();
+            report = g_spaceReport;
+        }
+        status = std::format(L"Analyzing space... {} {} folders pending.", SpaceSummary(report), report.pendingFolders);
+    } else if (g_searchDuplicates && g_duplicateFinder) {
+        const ffe::DuplicateStats progress = g_duplicateFinder->progress();
+        status = std::format(L"Finding duplicates... {} files in {} folders. Hashed the ends of {} and all of {}; read {}.",
+                             progress.files, progress.directories, progress.partialHashes, progress.fullHashes,
+                             FormatFileSize(progress.bytesRead));
+    } else if (g_searchContent) {
+        status = std::format(L"Searching contents... Found {} lines in {} files. Read {}, {}/s; {} folders queued.",
+                             metrics.matches, metrics.entries, FormatFileSize(metrics.bytes),
+                             FormatFileSize(static_cast<uintmax_t>(metrics.bytesPerSecond())), metrics.queueDepth);
+    } else {
+        status = std::format(
+            L"Searching... Found {} files in {} directories. Searched {} files, {:.0f} per second; {} folders queued.",
+            metrics.matches, metrics.directories, metrics.entries, metrics.entriesPerSecond(), metrics.queueDepth);
+    }
     SendMessageW(g_hwndStatusBar, SB_SETTEXT, 0, (LPARAM)status.c_str());
 }
 
-// Recursive file search function
-void SearchDirectoryRecursive(const fs::path& dirPath, const std::wstring& searchTerm,
-                             ThreadPool& pool, std::atomic<bool>& isSearching) {
-    if (!isSearching) {
-        return;
+// Match the files of one directory visited by the search walk
+void SearchDirectory(const ffe::WalkDirectory& dir, const ffe::NameQuery& query,
+                     ffe::ResultChannel<SearchResult>& results) {
+    ffe::TraceSpan span("SearchDirectory");
+    span.arg("entries", static_cast<int64_t>(dir.entries.size()));
+
+    // The directory's matches are published together when the visit ends
+    ffe::ResultChannel<SearchResult>::Batch batch(results);
+
+    // Counted per directory rather than per file, into this thread's shard
+    uint64_t searched = 0;
+    uint64_t found = 0;
+    for (const auto& entry : dir.entries) {
+        if (!entry.isFile()) {
+            continue;
+        }
+        searched++;
+
+        // Case-insensitive check, no copy of the name
+        if (query.matches(entry.name)) {
+            found++;
+
+            // Add to this directory's batch
+            batch.add({dir.path / entry.name});
+        }
     }
 
-    // Convert search term to lowercase once at the beginning of each thread
-    std::wstring lowerSearchTerm = ToLowerCase(searchTerm);
+    g_searchMetrics.directories.add();
+    g_searchMetrics.entries.add(searched);
+    if (found > 0) {
+        g_searchMetrics.matches.add(found);
+        g_searchMetrics.resultFound();
+    }
+}
 
-    try {
-        // Increment directories searched counter
-        g_directoriesSearched++;
+// Search inside the files of one directory visited by a content search;
+// every matching line is a result of its own
+void SearchContents(const ffe::WalkDirectory& dir, const ffe::ContentSearcher& searcher,
+                    ffe::ResultChannel<SearchResult>& results) {
+    ffe::TraceSpan span("SearchContents");
+    span.arg("entries", static_cast<int64_t>(dir.entries.size()));
+    g_searchMetrics.directories.add();
+
+    for (const auto& entry : dir.entries) {
+        // Files can be large, so a stop takes effect between them
+        if (!g_isSearching) {
+            return;
+        }
+        if (!entry.isFile()) {
+            continue;
+        }
 
-        // Check stopping condition only occasionally to avoid overhead
-        std::atomic<int> entryCounter{0};
+        // Each file's lines are published as soon as it is searched
+        ffe::ResultChannel<SearchResult>::Batch batch(results);
+        const fs::path path = dir.path / entry.name;
+        const ffe::ContentScan scan = searcher.searchFile(path, [&](const ffe::ContentHit& hit) {
+            batch.add({path, hit});
+            return g_isSearching.load(std::memory_order_relaxed);
+        });
+        g_searchMetrics.entries.add();
+        g_searchMetrics.bytes.add(scan.bytes);
+        if (scan.hits > 0) {
+            g_searchMetrics.matches.add(scan.hits);
+            g_searchMetrics.resultFound();
+        }
+    }
+}
 
-        // Use error_code to avoid exceptions for common file system errors
-        std::error_code ec;
-        auto dirOptions = fs::directory_options::skip_permission_denied;
-
-        // Use a try-block for the directory iteration to handle access errors
-        try {
-            for (const auto& entry : fs::directory_iterator(dirPath, dirOptions, ec)) {
-                // Check stopping condition periodically
-                if ((++entryCounter % 100) == 0 && !isSearching) {
-                    return;
-                }
+// Score the files of one directory for a fuzzy search, keeping the best in
+// the worker's own heap
+void RankDirectory(const ffe::WalkDirectory& dir, const ffe::NameQuery& query, WorkerHits& worker) {
+    ffe::TraceSpan span("RankDirectory");
+    span.arg("entries", static_cast<int64_t>(dir.entries.size()));
+    g_searchMetrics.directories.add();
 
-                try {
-                    if (fs::is_regular_file(entry, ec)) {
-                        // Get filename once
-                        const std::wstring filename = entry.path().filename().wstring();
-
-                        // Increment files searched counter
-                        g_filesSearched++;
-
-                        // Fast case-insensitive check
-                        std::wstring lowerFilename = ToLowerCase(filename);
-                        if (lowerFilename.find(lowerSearchTerm) != std::wstring::npos) {
-                            // Increment files found counter
-                            g_filesFound++;
-
-                            // Add to results
-                            {
-                                std::lock_guard<std::mutex> lock(g_resultsMutex);
-                                g_searchResults.push_back(entry.path());
-                            }
-
-                            // Only update UI periodically to reduce overhead
-                            if (g_filesFound % 20 == 0) {
-                                PostMessageW(g_hwndMain, WM_SEARCH_RESULT, 0, 0);
-                            }
-                        }
+    for (const auto& entry : dir.entries) {
+        if (!entry.isFile()) {
+            continue;
+        }
+        g_searchMetrics.entries.add();
 
-                        // Update progress less frequently
-                        if (g_filesSearched % 500 == 0) {
-                            PostMessageW(g_hwndMain, WM_SEARCH_PROGRESS, 0, 0);
-                        }
-                    }
-                    else if (fs::is_directory(entry, ec) && !fs::is_symlink(entry, ec)) {
-                        // Use thread-local counter to limit directory recursion
-                        thread_local int recursionDepth = 0;
-
-                        // Add directory to pool queue if we're not too deep in recursion
-                        if (recursionDepth < 50) {  // Limit recursion depth
-                            recursionDepth++;
-                            pool.enqueue([entry, searchTerm, &pool, &isSearching]() {
-                                SearchDirectoryRecursive(entry.path(), searchTerm, pool, isSearching);
-                            });
-                            recursionDepth--;
-                        } else {
-                            // Process directory directly for deep paths
-                            SearchDirectoryRecursive(entry.path(), searchTerm, pool, isSearching);
-                        }
-                    }
-                }
-                catch (const std::exception&) {
-                    // Skip files/directories that can't be accessed
-                    continue;
-                }
-            }
+        auto score = query.fuzzyMatcher().score(entry.name, dir.depth);
+        if (!score) {
+            continue;
         }
-        catch (const std::exception&) {
-            // Skip directories that can't be accessed
+        g_searchMetrics.matches.add();
+        g_searchMetrics.resultFound();
+
+        // Only build the path of hits that make the cut
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (worker.hits.full() && *score <= worker.hits.worst().score) {
+            continue;
         }
+        worker.hits.push({*score, dir.path / entry.name});
+    }
+}
+
+// Merge the workers' best hits into the displayed results, best first
+void PublishRankedResults(std::vector<WorkerHits>& workers) {
+    ffe::TraceSpan span("PublishRankedResults");
+    ffe::TopK<RankedHit> merged(FUZZY_MAX_RESULTS);
+    for (auto& worker : workers) {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        merged.merge(worker.hits);
     }
-    catch (const std::exception&) {
-        // Skip directories that can't be accessed
+
+    std::vector<fs::path> results;
+    for (auto& hit : merged.sorted()) {
+        results.push_back(std::move(hit.path));
     }
+
+    auto lock = LockResults();
+    g_rankedResults = std::move(results);
 }
 
-bool FastMatchesSearchTerm(const std::wstring& filename, const std::wstring& searchTerm) {
-    if (searchTerm.empty()) {
-        return true;
+// Executor shared by all background tree operations
+ffe::Executor& BackgroundExecutor() {
+    // Limit number of worker threads based on CPU cores
+    static ffe::Executor executor(std::min<size_t>(MAX_SEARCH_THREADS, ffe::Executor::DefaultThreadCount()));
+    return executor;
+}
+
+// Lists folders the user is likely to open next
+ffe::DirectoryPrefetcher& Prefetcher() {
+    static ffe::DirectoryPrefetcher prefetcher(BackgroundExecutor());
+    return prefetcher;
+}
+
+// Keeps the collation keys of the rows, so sorting again by another column
+// only compares them
+ffe::RowSorter& ListSorter() {
+    static ffe::RowSorter sorter(&BackgroundExecutor());
+    return sorter;
+}
+
+// Sorts the rows of the list view and marks the sorted column in the header
+void SortListRows(const ffe::SortOrder& order) {
+    ListSorter().sort(g_entryModel, order);
+    RowMetadata().reset(); // Requests in flight refer to the old row order
+
+    const ffe::SortKey& primary = order.keys.front();
+    HWND header = ListView_GetHeader(g_hwndListView);
+    for (int column = 0; column < Header_GetItemCount(header); column++) {
+        HDITEMW item = {};
+        item.mask = HDI_FORMAT;
+        Header_GetItem(header, column, &item);
+        item.fmt &= ~(HDF_SORTUP | HDF_SORTDOWN);
+        if (column == static_cast<int>(primary.column)) {
+            item.fmt |= primary.descending ? HDF_SORTDOWN : HDF_SORTUP;
+        }
+        Header_SetItem(header, column, &item);
+    }
+    InvalidateRect(g_hwndListView, NULL, FALSE);
+}
+
+// A click on a column header sorts by that column, or flips the direction
+// when it already is the sorted one (LVN_COLUMNCLICK)
+void SortByColumn(int column) {
+    // Name, Type and Size map onto sort columns directly; Location and Match do not sort
+    if (column < 0 || column > static_cast<int>(ffe::SortColumn::Size)) {
+        return;
+    }
+    const ffe::SortOrder& current = ListSorter().order();
+    ffe::SortOrder order;
+    if (static_cast<int>(current.keys.front().column) == column) {
+        order = current.reversed();
+    } else {
+        order.keys = {{static_cast<ffe::SortColumn>(column), false}};
+    }
+    SortListRows(order);
+}
+
+// Lists folders ahead of time, most likely first; folders already cached
+// are checked when opened instead
+void PrefetchFolders(std::vector<fs::path> folders) {
+    std::erase_if(folders, [](const fs::path& folder) {
+        return folder.empty() || g_listingCache.contains(folder);
+    });
+    if (!folders.empty()) {
+        Prefetcher().prefetch(std::move(folders));
+    }
+}
+
+// Prefetches the folder in a row of the list view
+void PrefetchRow(int index) {
+    if (index >= 0 && static_cast<size_t>(index) < g_entryModel.size() && g_entryModel.row(index).isDirectory()) {
+        PrefetchFolders({g_entryModel.path(index)});
     }
+}
 
-    // Convert to lowercase only once per call
-    std::wstring lowerFilename = ToLowerCase(filename);
-    std::wstring lowerSearchTerm = ToLowerCase(searchTerm);
+// Background lookups of the metadata of the rows on screen
+ffe::MetadataPipeline& RowMetadata() {
+    static ffe::MetadataPipeline pipeline(BackgroundExecutor(), FetchShellMetadata, []() {
+        PostMessageW(g_hwndMain, WM_METADATA_READY, 0, 0);
+    });
+    return pipeline;
+}
 
-    // Simple substring check
-    return lowerFilename.find(lowerSearchTerm) != std::wstring::npos;
+// Background measurement of the folders of the listing, sharing what
+// each folder holds across listings while it is unchanged
+ffe::FolderSizer& FolderSizes() {
+    static ffe::FolderSizer sizer(BackgroundExecutor(), []() {
+        PostMessageW(g_hwndMain, WM_FOLDER_SIZES_READY, 0, 0);
+    });
+    return sizer;
 }
 
 // Search files function
-void SearchFiles(const fs::path& rootPath, const std::wstring& searchTerm) {
+void SearchFiles(const fs::path& rootPath, const ffe::NameQuery& query,
+                 std::shared_ptr<const ffe::ContentSearcher> content) {
     // Set searching flag
     g_isSearching = true;
+    const WPARAM generation = g_searchGeneration;
 
     // Update UI
     SendMessageW(g_hwndStatusBar, SB_SETTEXT, 0, (LPARAM)L"Starting search...");
@@ -769,61 +1465,331 @@ void SearchFiles(const fs::path& rootPath, const std::wstring& searchTerm) {
     // Clear old search threads
     g_searchThreads.clear();
 
-    // Start search thread with a more efficient approach
-    std::jthread searchThread([rootPath, searchTerm]() {
-        try {
-            // Limit number of search threads based on CPU cores
-            int numCores = std::thread::hardware_concurrency();
-            int threadCount = std::max(2, std::min(MAX_SEARCH_THREADS, numCores));
-
-            // Create thread pool with optimal size for search operations
-            ThreadPool pool(threadCount);
-
-            // Add a timer to update UI periodically regardless of search progress
-            std::thread updateTimer([&]() {
-                while (g_isSearching) {
-                    // Update UI every half second
-                    PostMessageW(g_hwndMain, WM_SEARCH_PROGRESS, 0, 0);
-                    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    // A ranked search gives each worker its own bounded heap of best hits
+    std::shared_ptr<std::vector<WorkerHits>> ranked;
+    if (query.isRanked()) {
+        ranked = std::make_shared<std::vector<WorkerHits>>(BackgroundExecutor().threadCount());
+    }
+
+    // Every search thread shares the compiled query
+    ffe::TreeWalker walker(BackgroundExecutor());
+    g_searchWalk = walker.walk(rootPath, [query, ranked, content, results = g_resultChannel](const ffe::WalkDirectory& dir) {
+        if (content) {
+            SearchContents(dir, *content, *results);
+        } else if (ranked) {
+            RankDirectory(dir, query, (*ranked)[std::min(dir.worker, ranked->size() - 1)]);
+        } else {
+            SearchDirectory(dir, query, *results);
+        }
+    });
+    g_searchMetrics.setQueueDepth([walk = g_searchWalk]() { return walk.progress().pending; });
+
+    // The search thread reports progress until the walk has visited its
+    // last directory, then announces completion. Ranked results are merged
+    // and shown at the same pace, so the best hits so far stream in.
+    std::jthread searchThread([walk = g_searchWalk, generation, ranked]() {
+        auto completion = walk.completion();
+        while (completion.wait_for(500ms) != std::future_status::ready) {
+            if (ranked) {
+                PublishRankedResults(*ranked);
+                PostMessageW(g_hwndMain, WM_SEARCH_RESULT, generation, 0);
+            }
+
+            // Update UI every half second
+            PostMessageW(g_hwndMain, WM_SEARCH_PROGRESS, 0, 0);
+        }
+        if (ranked) {
+            PublishRankedResults(*ranked);
+        }
+
+        // Post message to update UI with final results
+        PostMessageW(g_hwndMain, WM_SEARCH_COMPLETE, generation, 0);
+    });
+
+    // Store the thread for proper management
+    g_searchThreads.push_back(std::move(searchThread));
+}
+
+// List the groups of a finished dupes: search, every name of every copy
+void PublishDuplicates(const ffe::DuplicateReport& report, ffe::ResultChannel<SearchResult>& results) {
+    ffe::TraceSpan span("PublishDuplicates");
+    span.arg("groups", static_cast<int64_t>(report.groups.size()));
+
+    uint64_t duplicates = 0;
+    {
+        ffe::ResultChannel<SearchResult>::Batch batch(results);
+        for (size_t index = 0; index < report.groups.size(); index++) {
+            const ffe::DuplicateGroup& group = report.groups[index];
+            DuplicateMark mark{static_cast<uint32_t>(index + 1), static_cast<uint32_t>(group.copies.size()),
+                               group.reclaimable(), false};
+            for (const auto& copy : group.copies) {
+                for (size_t name = 0; name < copy.paths.size(); name++) {
+                    mark.hardLink = name > 0;
+                    batch.add({copy.paths[name], std::nullopt, mark});
                 }
-            });
+            }
+            duplicates += group.copies.size() - 1;
+        }
+    }
+    if (duplicates > 0) {
+        g_searchMetrics.matches.add(duplicates);
+        g_searchMetrics.resultFound();
+    }
+
+    auto lock = LockResults();
+    g_duplicateTotals = {report.groups.size(), duplicates, report.reclaimable, report.stats};
+}
 
-            // Start the recursive search
-            SearchDirectoryRecursive(rootPath, searchTerm, pool, g_isSearching);
+// Find files with the same contents below rootPath. The finder runs its
+// stages on the background executor; the search thread waits for it,
+// reporting progress meanwhile, and lists the groups once all are known.
+void SearchDuplicates(const fs::path& rootPath, const ffe::NameQuery& query) {
+    // Set searching flag
+    g_isSearching = true;
+    const WPARAM generation = g_searchGeneration;
 
-            // Set searching to false to stop the update timer
-            g_isSearching = false;
+    // Update UI
+    SendMessageW(g_hwndStatusBar, SB_SETTEXT, 0, (LPARAM)L"Starting search...");
 
-            // Wait for update timer to complete
-            if (updateTimer.joinable()) {
-                updateTimer.join();
+    // Clear old search threads
+    g_searchThreads.clear();
+
+    ffe::DuplicateOptions options;
+    options.include = [query](const fs::path&, const ffe::DirEntry& entry) {
+        return query.matches(entry.name);
+    };
+    g_duplicateFinder = std::make_shared<ffe::DuplicateFinder>(BackgroundExecutor(), std::move(options));
+
+    // find() blocks until every stage is done, so it runs off the search
+    // thread, which keeps posting progress the way a walk's does
+    std::jthread searchThread([finder = g_duplicateFinder, rootPath, generation, results = g_resultChannel]() {
+        auto found = std::async(std::launch::async, [&finder, &rootPath]() { return finder->find(rootPath); });
+        while (found.wait_for(500ms) != std::future_status::ready) {
+            PostMessageW(g_hwndMain, WM_SEARCH_PROGRESS, 0, 0);
+        }
+        PublishDuplicates(found.get(), *results);
+
+        // Post message to update UI with final results
+        PostMessageW(g_hwndMain, WM_SEARCH_COMPLETE, generation, 0);
+    });
+
+    // Store the thread for proper management
+    g_searchThreads.push_back(std::move(searchThread));
+}
+
+// Rank the largest folders and files below the roots. The analyzer walks
+// on the background executor; the search thread takes a snapshot of its
+// rankings at the progress pace and has it replace the list.
+void AnalyzeSpace(std::vector<fs::path> roots) {
+    // Set searching flag
+    g_isSearching = true;
+    const WPARAM generation = g_searchGeneration;
+
+    // Update UI
+    SendMessageW(g_hwndStatusBar, SB_SETTEXT, 0, (LPARAM)L"Starting analysis...");
+
+    // Clear old search threads
+    g_searchThreads.clear();
+
+    g_spaceAnalyzer = std::make_shared<ffe::SpaceAnalyzer>(BackgroundExecutor());
+    g_spaceAnalyzer->scan(std::move(roots));
+
+    std::jthread searchThread([analyzer = g_spaceAnalyzer, generation]() {
+        while (true) {
+            ffe::SpaceReport report = analyzer->snapshot();
+            const bool finished = report.done || report.cancelled;
+            {
+                auto lock = LockResults();
+                g_spaceReport = std::move(report);
+            }
+            PostMessageW(g_hwndMain, WM_SEARCH_RESULT, generation, 0);
+            PostMessageW(g_hwndMain, WM_SEARCH_PROGRESS, 0, 0);
+            if (finished) {
+                break;
             }
+            std::unique_lock<std::mutex> lock(g_stopSearchMutex);
+            g_stopSearchCV.wait_for(lock, 500ms, []() { return !g_isSearching; });
+        }
+
+        // Post message to update UI with final results
+        PostMessageW(g_hwndMain, WM_SEARCH_COMPLETE, generation, 0);
+    });
+
+    // Store the thread for proper management
+    g_searchThreads.push_back(std::move(searchThread));
+}
 
-            // Post message to update UI with final results
-            PostMessageW(g_hwndMain, WM_SEARCH_COMPLETE, 0, 0);
+// Collect the files below scope that match query from the index, as a
+// walk would: ranked hits into the shown results, the others through results
+void SearchSnapshot(const ffe::IndexSnapshot& snapshot, uint32_t scope, const ffe::NameQuery& query,
+                    ffe::ResultChannel<SearchResult>& results) {
+    ffe::TraceSpan span("SearchSnapshot");
+    // A stopped search skips the rest of the index
+    const auto matches = [&query](std::wstring_view name) {
+        return g_isSearching.load(std::memory_order_relaxed) && query.matches(name);
+    };
+
+    std::vector<fs::path> found;
+    uint64_t matched = 0;
+    if (query.isRanked()) {
+        // Keep the best hits, scored with their depth below the search root
+        ffe::TopK<RankedHit> best(FUZZY_MAX_RESULTS);
+        snapshot.forEachMatch(scope, matches, [&](std::uint32_t entry) {
+            if (snapshot.type(entry) != ffe::EntryType::File) {
+                return;
+            }
+            uint32_t depth = 0;
+            for (uint32_t dir = snapshot.parent(entry); dir != scope && dir != 0; dir = snapshot.parent(dir)) {
+                depth++;
+            }
+            if (auto score = query.fuzzyMatcher().score(snapshot.name(entry), depth)) {
+                matched++;
+                if (!best.full() || *score > best.worst().score) {
+                    best.push({*score, snapshot.path(entry)});
+                }
+            }
+        });
+        for (auto& hit : best.sorted()) {
+            found.push_back(std::move(hit.path));
+        }
+    } else {
+        snapshot.forEachMatch(scope, matches, [&snapshot, &found](std::uint32_t entry) {
+            if (snapshot.type(entry) == ffe::EntryType::File) {
+                found.push_back(snapshot.path(entry));
+            }
+        });
+        matched = found.size();
+    }
+
+    g_searchMetrics.matches.add(matched);
+    g_searchMetrics.entries.add(snapshot.size());
+    if (matched > 0) {
+        g_searchMetrics.resultFound();
+    }
+    if (query.isRanked()) {
+        auto lock = LockResults();
+        g_rankedResults = std::move(found);
+    } else {
+        std::vector<SearchResult> plain;
+        plain.reserve(found.size());
+        for (auto& path : found) {
+            plain.push_back({std::move(path)});
         }
-        catch (const std::exception& e) {
-            // Log error or display in status bar
-            std::string errorMsg = "Search error: ";
-            errorMsg += e.what();
-            g_isSearching = false;
+        results.publish(std::move(plain));
+    }
+}
 
-            // Convert to wstring for Windows API
-            std::wstring wErrorMsg(errorMsg.begin(), errorMsg.end());
-            SendMessageW(g_hwndStatusBar, SB_SETTEXT, 0, (LPARAM)wErrorMsg.c_str());
+// Answer a search from the name index; false means the live walk is needed.
+// Only opening the index happens here: a broad query over a whole volume
+// takes a while, so the index is searched on the background executor.
+bool SearchIndex(const fs::path& rootPath, const ffe::NameQuery& query) {
+    auto snapshot = std::make_shared<ffe::IndexSnapshot>();
+    if (!ffe::IndexStore().openCovering(rootPath, *snapshot)) {
+        return false;
+    }
+    const auto scope = snapshot->find(rootPath);
+    if (!scope || snapshot->isStale(INDEX_MAX_AGE, *scope)) {
+        return false;
+    }
 
-            // Notify UI that search is complete (with error)
-            PostMessageW(g_hwndMain, WM_SEARCH_COMPLETE, 0, 0);
+    // Set searching flag
+    g_isSearching = true;
+    g_searchFromIndex = true;
+    const WPARAM generation = g_searchGeneration;
+    SendMessageW(g_hwndStatusBar, SB_SETTEXT, 0, (LPARAM)L"Searching the index...");
+
+    // Clear old search threads
+    g_searchThreads.clear();
+
+    std::promise<void> searched;
+    auto finished = searched.get_future();
+    BackgroundExecutor().submit([snapshot, scope = *scope, query, results = g_resultChannel,
+                                 searched = std::move(searched)]() mutable {
+        SearchSnapshot(*snapshot, scope, query, *results);
+        searched.set_value();
+    });
+
+    // The search thread reports progress until the index is searched, then
+    // finishes through the regular completion path
+    std::jthread searchThread([finished = std::move(finished), generation]() {
+        while (finished.wait_for(500ms) != std::future_status::ready) {
+            PostMessageW(g_hwndMain, WM_SEARCH_PROGRESS, 0, 0);
         }
+        PostMessageW(g_hwndMain, WM_SEARCH_COMPLETE, generation, 0);
     });
 
     // Store the thread for proper management
     g_searchThreads.push_back(std::move(searchThread));
+    return true;
+}
+
+// Build the name index of the current folder in the background
+void BuildSearchIndex() {
+    if (g_currentPath.empty()) {
+        MessageBoxW(g_hwndMain, L"Please navigate to a drive or folder to index.", L"Index", MB_ICONINFORMATION);
+        return;
+    }
+    if (g_isIndexing) {
+        return;
+    }
+
+    g_isIndexing = true;
+    std::wstring status = L"Indexing " + g_currentPath.wstring() + L"...";
+    SendMessageW(g_hwndStatusBar, SB_SETTEXT, 0, (LPARAM)status.c_str());
+
+    g_indexThread = std::jthread([root = g_currentPath]() {
+        // The window takes ownership of the indexer once it is running
+        auto indexer = std::make_unique<ffe::LiveIndexer>(ffe::IndexStore(), BackgroundExecutor());
+        std::error_code ec;
+        if (!indexer->start(root, true, ec)) {
+            PostMessageW(g_hwndMain, WM_INDEX_COMPLETE, 0, 0);
+            return;
+        }
+        const size_t entries = indexer->stats().entries;
+        if (PostMessageW(g_hwndMain, WM_INDEX_COMPLETE, entries, (LPARAM)indexer.get())) {
+            indexer.release();
+        }
+    });
+}
+
+// Start tracing, or stop it and save what was recorded to a file in the
+// temporary folder (Ctrl+Shift+T)
+void ToggleTracing() {
+    if (!ffe::Trace::Enabled()) {
+        ffe::Trace::Clear();
+        ffe::Trace::Enable(true);
+        SendMessageW(g_hwndStatusBar, SB_SETTEXT, 0, (LPARAM)L"Tracing. Press Ctrl+Shift+T again to save the trace.");
+        return;
+    }
+
+    ffe::Trace::Enable(false);
+    const auto now = std::chrono::floor<std::chrono::seconds>(std::chrono::system_clock::now());
+    const fs::path file = fs::temp_directory_path() / std::format(L"ffe-trace-{:%Y%m%d-%H%M%S}.json", now);
+    std::error_code ec;
+    std::wstring status = ffe::Trace::WriteChromeJson(file, ec)
+        ? L"Trace saved to " + file.wstring() + L" (open it in chrome://tracing or Perfetto)."
+        : L"Could not save the trace to " + file.wstring() + L".";
+    SendMessageW(g_hwndStatusBar, SB_SETTEXT, 0, (LPARAM)status.c_str());
+}
+
+// Switch folder sizes between apparent bytes and bytes allocated on disk
+// (Ctrl+Shift+A)
+void ToggleAllocatedSize() {
+    g_showAllocatedSize = !g_showAllocatedSize;
+    if (g_showingSearchResults && g_searchSpace) {
+        DisplaySearchResults();
+    } else {
+        UpdateFolderRowSizes();
+    }
+    SendMessageW(g_hwndStatusBar, SB_SETTEXT, 0,
+                 (LPARAM)(g_showAllocatedSize ? L"Folder sizes show the space allocated on disk."
+                                              : L"Folder sizes show the bytes the files hold."));
 }
 
 // Navigate to a path
 void NavigateTo(const fs::path& path, bool addToHistory)
 {
+    ffe::TraceSpan span("NavigateTo");
     try
     {
         fs::path newPath;
@@ -861,14 +1827,24 @@ void NavigateTo(const fs::path& path, bool addToHistory)
             }
         }
 
-        // Stop any ongoing search
+        // Stop any ongoing search and drop results not shown yet
         if (g_isSearching) {
             StopSearch();
         }
+        ClearSearchResults();
+
+        // Folders listed ahead are kept; whatever is still being listed
+        // would only slow this navigation down
+        Prefetcher().cancel();
+        Prefetcher().drainInto(g_listingCache);
 
         // Update current path and refresh view
         g_currentPath = newPath;
         PopulateListView(g_currentPath);
+
+        // Back and Forward are the likeliest ways out of here
+        PrefetchFolders({g_backHistory.empty() ? fs::path() : g_backHistory.front(),
+                         g_forwardHistory.empty() ? fs::path() : g_forwardHistory.front()});
     }
     catch (const std::exception& e)
     {
@@ -924,20 +1900,11 @@ void UpdateNavigationButtons()
 // Populate the list view with files and folders
 void PopulateListView(const fs::path& path)
 {
-    // Clear list view and free previous items
-    int itemCount = ListView_GetItemCount(g_hwndListView);
-    for (int i = 0; i < itemCount; i++)
-    {
-        LVITEMW lvItem = {};
-        lvItem.mask = LVIF_PARAM;
-        lvItem.iItem = i;
+    ffe::TraceSpan span("PopulateListView");
 
-        if (ListView_GetItem(g_hwndListView, &lvItem) && lvItem.lParam)
-        {
-            delete reinterpret_cast<fs::path*>(lvItem.lParam);
-        }
-    }
-    ListView_DeleteAllItems(g_hwndListView);
+    // Clear list view and free previous items
+    ClearListItems();
+    g_showingSearchResults = false;
 
     try
     {
@@ -945,40 +1912,14 @@ void PopulateListView(const fs::path& path)
         {
             // Special case: show drives
             auto drives = EnumerateDrives();
-            int index = 0;
+            const uint32_t noFolder = g_entryModel.addDirectory(fs::path());
 
             for (const auto& drive : drives)
             {
-                LVITEMW lvItem = {};
-                lvItem.mask = LVIF_TEXT | LVIF_PARAM | LVIF_IMAGE;
-                lvItem.iItem = index++;
-                lvItem.iSubItem = 0;
-
-                // Store the path
-                fs::path* drivePath = new fs::path(drive);
-                lvItem.lParam = (LPARAM)drivePath;
-
-                // Get drive label
-                std::wstring driveLabel = drive.wstring();
-                lvItem.pszText = const_cast<LPWSTR>(driveLabel.c_str());
-
-                // Add drive icon
-                SHFILEINFOW sfi = {};
-                SHGetFileInfoW(drive.wstring().c_str(), 0, &sfi, sizeof(sfi), SHGFI_ICON | SHGFI_SMALLICON);
-                lvItem.iImage = ImageList_AddIcon(ListView_GetImageList(g_hwndListView, LVSIL_SMALL), sfi.hIcon);
-                DestroyIcon(sfi.hIcon);
-
-                // Insert item
-                int itemIndex = ListView_InsertItem(g_hwndListView, &lvItem);
-
-                // Set type
-                ListView_SetItemText(g_hwndListView, itemIndex, 1, const_cast<LPWSTR>(L"Drive"));
-
-                // Set size (not applicable for drives)
-                ListView_SetItemText(g_hwndListView, itemIndex, 2, const_cast<LPWSTR>(L""));
-
-                // Set location (empty for drives)
-                ListView_SetItemText(g_hwndListView, itemIndex, 3, const_cast<LPWSTR>(L""));
+                ffe::DirEntry entry;
+                entry.name = drive.native();
+                entry.type = ffe::EntryType::Directory;
+                g_entryModel.append(noFolder, entry);
             }
 
             // Update address bar
@@ -997,69 +1938,20 @@ void PopulateListView(const fs::path& path)
             std::wstring windowTitle = L"Fast File Explorer - " + path.wstring();
             SetWindowTextW(g_hwndMain, windowTitle.c_str());
 
-            // Actual directory contents
-            int index = 0;
-
-            try
+            // Actual directory contents, from memory when the folder was
+            // listed recently and has not changed; rows are formatted when shown
+            std::error_code ec;
+            const auto entries = g_listingCache.read(path, ec);
+            if (ec)
             {
-                for (const auto& entry : fs::directory_iterator(path))
-                {
-                    LVITEMW lvItem = {};
-                    lvItem.mask = LVIF_TEXT | LVIF_PARAM | LVIF_IMAGE;
-                    lvItem.iItem = index++;
-                    lvItem.iSubItem = 0;
-
-                    // Store the path
-                    fs::path* entryPath = new fs::path(entry.path());
-                    lvItem.lParam = (LPARAM)entryPath;
-
-                    // Get file/folder name
-                    std::wstring name = entry.path().filename().wstring();
-                    lvItem.pszText = const_cast<LPWSTR>(name.c_str());
-
-                    // Add icon
-                    SHFILEINFOW sfi = {};
-                    SHGetFileInfoW(entry.path().wstring().c_str(), 0, &sfi, sizeof(sfi), SHGFI_ICON | SHGFI_SMALLICON);
-                    lvItem.iImage = ImageList_AddIcon(ListView_GetImageList(g_hwndListView, LVSIL_SMALL), sfi.hIcon);
-                    DestroyIcon(sfi.hIcon);
-
-                    // Insert item
-                    int itemIndex = ListView_InsertItem(g_hwndListView, &lvItem);
-
-                    // Set type
-                    if (fs::is_directory(entry.path()))
-                    {
-                        ListView_SetItemText(g_hwndListView, itemIndex, 1, const_cast<LPWSTR>(L"Folder"));
-                        ListView_SetItemText(g_hwndListView, itemIndex, 2, const_cast<LPWSTR>(L""));
-                    }
-                    else
-                    {
-                        // Get file type
-                        std::wstring typeDesc = GetFileTypeDescription(entry.path());
-                        ListView_SetItemText(g_hwndListView, itemIndex, 1, const_cast<LPWSTR>(typeDesc.c_str()));
-
-                        // Get file size
-                        uintmax_t size = 0;
-                        try
-                        {
-                            size = fs::file_size(entry.path());
-                        }
-                        catch (...)
-                        {
-                            // Ignore errors
-                        }
-
-                        std::wstring sizeStr = FormatFileSize(size);
-                        ListView_SetItemText(g_hwndListView, itemIndex, 2, const_cast<LPWSTR>(sizeStr.c_str()));
-                    }
-
-                    // Set location (parent path - empty for current directory)
-                    ListView_SetItemText(g_hwndListView, itemIndex, 3, const_cast<LPWSTR>(L""));
-                }
+                MessageBoxA(g_hwndMain, ec.message().c_str(), "Directory Error", MB_ICONERROR);
             }
-            catch (const fs::filesystem_error& e)
+
+            const uint32_t folder = g_entryModel.addDirectory(path);
+            g_entryModel.reserve(entries->size(), 0);
+            for (const auto& entry : *entries)
             {
-                MessageBoxA(g_hwndMain, e.what(), "Directory Error", MB_ICONERROR);
+                g_entryModel.append(folder, entry);
             }
         }
     }
@@ -1068,6 +1960,15 @@ void PopulateListView(const fs::path& path)
         MessageBoxA(g_hwndMain, e.what(), "Error", MB_ICONERROR);
     }
 
+    // Listings keep the order the user last picked
+    SortListRows(ListSorter().order());
+    SetListRowCount();
+    if (!path.empty())
+    {
+        MeasureFolderRows();
+    }
+    span.arg("rows", static_cast<int64_t>(g_entryModel.size()));
+
     // Update navigation buttons
     UpdateNavigationButtons();
 }
@@ -1080,7 +1981,7 @@ bool CreateListView(HWND hwndParent)
         WS_EX_CLIENTEDGE,
         WC_LISTVIEWW,
         L"",
-        WS_CHILD | WS_VISIBLE | LVS_REPORT | LVS_SHAREIMAGELISTS | LVS_SINGLESEL,
+        WS_CHILD | WS_VISIBLE | LVS_REPORT | LVS_OWNERDATA | LVS_SHAREIMAGELISTS | LVS_SINGLESEL,
         0, BUTTON_HEIGHT + 20, 0, 0, // Will be resized in WM_SIZE
         hwndParent,
         (HMENU)(INT_PTR)ID_FILE_LIST,
@@ -1128,10 +2029,25 @@ bool CreateListView(HWND hwndParent)
     lvc.fmt = LVCFMT_LEFT;
     ListView_InsertColumn(g_hwndListView, 3, &lvc);
 
-    // Create and set image list
-    HIMAGELIST hImageList = ImageList_Create(16, 16, ILC_COLOR32 | ILC_MASK, 32, 32);
+    // Match column (line and text for content search results, group for duplicates)
+    lvc.iSubItem = 4;
+    lvc.pszText = const_cast<LPWSTR>(L"Match");
+    lvc.cx = 400;
+    lvc.fmt = LVCFMT_LEFT;
+    ListView_InsertColumn(g_hwndListView, 4, &lvc);
+
+    // Use the system image list; rows refer to icons by index, and
+    // LVS_SHAREIMAGELISTS keeps the list view from destroying it
+    SHFILEINFOW sfi = {};
+    HIMAGELIST hImageList = (HIMAGELIST)SHGetFileInfoW(L"C:\\", 0, &sfi, sizeof(sfi), SHGFI_SYSICONINDEX | SHGFI_SMALLICON);
     ListView_SetImageList(g_hwndListView, hImageList, LVSIL_SMALL);
 
+    // Generic icons for rows whose metadata has not arrived yet
+    SHGetFileInfoW(L"file", FILE_ATTRIBUTE_NORMAL, &sfi, sizeof(sfi), SHGFI_SYSICONINDEX | SHGFI_SMALLICON | SHGFI_USEFILEATTRIBUTES);
+    g_defaultFileIcon = sfi.iIcon;
+    SHGetFileInfoW(L"folder", FILE_ATTRIBUTE_DIRECTORY, &sfi, sizeof(sfi), SHGFI_SYSICONINDEX | SHGFI_SMALLICON | SHGFI_USEFILEATTRIBUTES);
+    g_defaultFolderIcon = sfi.iIcon;
+
     // Apply font to list view
     if (g_hFont)
     {
@@ -1366,10 +2282,11 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 
             // Search box position (after Go button)
             int searchBoxX = addressBarX + addressBarWidth + 40;
-            int searchWidth = width - searchBoxX - 80;  // Reserve space for search button
+            int searchWidth = width - searchBoxX - 130;  // Reserve space for search and index buttons
             SetWindowPos(g_hwndSearchBox, NULL, searchBoxX, UI_PADDING + 5, searchWidth, 25, SWP_NOZORDER);
             SetWindowPos(g_hwndSearchButton, NULL, searchBoxX + searchWidth + 5, UI_PADDING + 5, 35, 25, SWP_NOZORDER);
             SetWindowPos(g_hwndStopSearchButton, NULL, searchBoxX + searchWidth + 45, UI_PADDING + 5, 35, 25, SWP_NOZORDER);
+            SetWindowPos(g_hwndIndexButton, NULL, searchBoxX + searchWidth + 85, UI_PADDING + 5, 45, 25, SWP_NOZORDER);
 
             // Add status bar
             int statusBarHeight = 25;
@@ -1430,6 +2347,12 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
                 StopSearch();
                 return 0;
             }
+            else if (ctrlId == ID_INDEX_BUTTON)
+            {
+                // Build the name index of the current folder
+                BuildSearchIndex();
+                return 0;
+            }
             break;
         }
 
@@ -1446,26 +2369,53 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
                         NMITEMACTIVATE* nmia = (NMITEMACTIVATE*)lParam;
                         int itemIndex = nmia->iItem;
 
-                        if (itemIndex >= 0)
+                        if (itemIndex >= 0 && static_cast<size_t>(itemIndex) < g_entryModel.size())
                         {
-                            LVITEMW lvItem = {};
-                            wchar_t buffer[MAX_PATH] = {};
-
-                            lvItem.mask = LVIF_TEXT | LVIF_PARAM;
-                            lvItem.iItem = itemIndex;
-                            lvItem.iSubItem = 0;
-                            lvItem.pszText = buffer;
-                            lvItem.cchTextMax = MAX_PATH;
-
-                            ListView_GetItem(g_hwndListView, &lvItem);
-
-                            fs::path* itemPath = (fs::path*)lvItem.lParam;
-                            if (itemPath)
-                            {
-                                // Create a copy of the path to use in NavigateTo
-                                fs::path pathCopy = *itemPath;
-                                NavigateTo(pathCopy);
-                            }
+                            // NavigateTo replaces the model, so take a copy of the path
+                            fs::path itemPath = g_entryModel.path(itemIndex);
+                            NavigateTo(itemPath);
+                        }
+                        return 0;
+                    }
+
+                case LVN_GETDISPINFOW:
+                    {
+                        // The virtual list view asks for the text of a row it shows
+                        NMLVDISPINFOW* info = (NMLVDISPINFOW*)lParam;
+                        FillListItem(info->item);
+                        return 0;
+                    }
+
+                case LVN_ODCACHEHINT:
+                    {
+                        // Rows about to be shown; fetch their metadata first
+                        NMLVCACHEHINT* hint = (NMLVCACHEHINT*)lParam;
+                        RequestRowMetadata(hint->iFrom, hint->iTo);
+                        return 0;
+                    }
+
+                case LVN_COLUMNCLICK:
+                    {
+                        NMLISTVIEW* nmlv = (NMLISTVIEW*)lParam;
+                        SortByColumn(nmlv->iSubItem);
+                        return 0;
+                    }
+
+                case LVN_HOTTRACK:
+                    {
+                        // The mouse is over a row; list it ahead if it is a folder
+                        NMLISTVIEW* nmlv = (NMLISTVIEW*)lParam;
+                        PrefetchRow(nmlv->iItem);
+                        return 0;
+                    }
+
+                case LVN_ITEMCHANGED:
+                    {
+                        // A selected folder is the likeliest one to be opened next
+                        NMLISTVIEW* nmlv = (NMLISTVIEW*)lParam;
+                        if ((nmlv->uChanged & LVIF_STATE) && (nmlv->uNewState & LVIS_SELECTED))
+                        {
+                            PrefetchRow(nmlv->iItem);
                         }
                         return 0;
                     }
@@ -1475,13 +2425,40 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
         }
 
     case WM_SEARCH_RESULT:
-        // Update UI with search results
-        DisplaySearchResults();
+        // New results of the current search: a fresh ranking replaces the
+        // list, plain results are appended at the frame pace
+        if (wParam == g_searchGeneration) {
+            if (g_searchRanked) {
+                DisplaySearchResults();
+            } else {
+                ScheduleResultAppend();
+            }
+        }
         return 0;
 
+    case WM_TIMER:
+        if (wParam == ID_RESULTS_TIMER) {
+            KillTimer(hwnd, ID_RESULTS_TIMER);
+            AppendSearchResults();
+            return 0;
+        }
+        break;
+
     case WM_SEARCH_COMPLETE:
-        // Search completed
-        StopSearch();
+        // Search completed (ignore completions of searches already replaced)
+        if (wParam == g_searchGeneration) {
+            StopSearch();
+        }
+        return 0;
+
+    case WM_METADATA_READY:
+        // Metadata of visible rows arrived in the background
+        ApplyRowMetadata();
+        return 0;
+
+    case WM_FOLDER_SIZES_READY:
+        // Subtrees of listed folders finished measuring
+        ApplyFolderSizes();
         return 0;
 
     case WM_SEARCH_PROGRESS:
@@ -1489,7 +2466,31 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
         UpdateSearchProgress();
         return 0;
 
+    case WM_INDEX_COMPLETE:
+        {
+            // Index build finished (wParam: entry count, lParam: running LiveIndexer or NULL)
+            g_isIndexing = false;
+            if (lParam) {
+                g_liveIndexer.reset(reinterpret_cast<ffe::LiveIndexer*>(lParam));
+            }
+            std::wstring status = lParam
+                ? std::format(L"Index ready. {} entries indexed, watching for changes.", wParam)
+                : std::wstring(L"Indexing failed.");
+            SendMessageW(g_hwndStatusBar, SB_SETTEXT, 0, (LPARAM)status.c_str());
+            return 0;
+        }
+
     case WM_DESTROY:
+        // Stop the background work for this window; what is still queued
+        // is dropped once nothing waits for it (see wWinMain)
+        StopSearch();
+        if (g_spaceAnalyzer)
+        {
+            g_spaceAnalyzer->cancel();
+        }
+        FolderSizes().cancel();
+        RowMetadata().reset();
+        Prefetcher().cancel();
         PostQuitMessage(0);
         return 0;
     }
@@ -1500,6 +2501,25 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 // Main entry point
 int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLine, int nCmdShow)
 {
+    // --trace FILE records from the start and saves the trace on exit
+    int argc = 0;
+    if (LPWSTR* argv = CommandLineToArgvW(GetCommandLineW(), &argc))
+    {
+        for (int i = 1; i + 1 < argc; i++)
+        {
+            if (wcscmp(argv[i], L"--trace") == 0)
+            {
+                g_traceFile = argv[i + 1];
+            }
+        }
+        LocalFree(argv);
+    }
+    ffe::Trace::SetThreadName("UI");
+    if (!g_traceFile.empty())
+    {
+        ffe::Trace::Enable(true);
+    }
+
     // Initialize common controls
     INITCOMMONCONTROLSEX icc = {};
     icc.dwSize = sizeof(INITCOMMONCONTROLSEX);
@@ -1638,7 +2658,7 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLi
 
     // Calculate search box position
     int searchBoxX = addressBarX + addressBarWidth + 40;
-    int searchWidth = 800 - searchBoxX - 80;  // Reserve space for search button
+    int searchWidth = 800 - searchBoxX - 130;  // Reserve space for search and index buttons
 
     // Create search box
     g_hwndSearchBox = CreateWindowExW(
@@ -1675,6 +2695,14 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLi
         g_hwndMain, (HMENU)(INT_PTR)ID_STOP_SEARCH_BUTTON, hInstance, NULL
     );
 
+    // Create index button (builds the name index of the current folder)
+    g_hwndIndexButton = CreateWindowW(
+        L"BUTTON", L"Index",
+        WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON,
+        searchBoxX + searchWidth + 85, UI_PADDING + 5, 45, 25,
+        g_hwndMain, (HMENU)(INT_PTR)ID_INDEX_BUTTON, hInstance, NULL
+    );
+
     // Create status bar
     g_hwndStatusBar = CreateWindowExW(
         0, STATUSCLASSNAMEW, NULL,
@@ -1715,11 +2743,41 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLi
     MSG msg = {};
     while (GetMessage(&msg, NULL, 0, 0))
     {
+        // Ctrl+Shift+T toggles tracing whichever control has the focus
+        if (msg.message == WM_KEYDOWN && msg.wParam == 'T' && GetKeyState(VK_CONTROL) < 0 && GetKeyState(VK_SHIFT) < 0)
+        {
+            ToggleTracing();
+            continue;
+        }
+        // Ctrl+Shift+A switches folder sizes between apparent and allocated bytes
+        if (msg.message == WM_KEYDOWN && msg.wParam == 'A' && GetKeyState(VK_CONTROL) < 0 && GetKeyState(VK_SHIFT) < 0)
+        {
+            ToggleAllocatedSize();
+            continue;
+        }
         TranslateMessage(&msg);
         DispatchMessage(&msg);
     }
 
     // Clean up
+    if (!g_traceFile.empty())
+    {
+        std::error_code ec;
+        ffe::Trace::WriteChromeJson(g_traceFile, ec);
+    }
+
+    // Stop background indexing before the shared executor goes away
+    g_liveIndexer.reset();
+    if (g_indexThread.joinable())
+    {
+        g_indexThread.join();
+    }
+
+    // Nothing waits for background work any more: drop the tasks still
+    // queued rather than finishing a walk of a whole drive on the way out
+    g_searchThreads.clear();
+    g_spaceAnalyzer.reset();
+    BackgroundExecutor().discardQueued();
     if (g_hFont)
     {
         DeleteObject(g_hFont);
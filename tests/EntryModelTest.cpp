@@ -0,0 +1,135 @@
+#include "Test.hpp"
+
+#include "engine/EntryModel.hpp"
+
+#include <string>
+
+namespace {
+
+ffe::DirEntry Entry(const char* name, ffe::EntryType type, std::uint64_t size = 0) {
+    ffe::DirEntry entry;
+    entry.name = fs::path(name).native();
+    entry.type = type;
+    if (size != 0) {
+        entry.hasStat = true;
+        entry.size = size;
+        entry.mtime = 1000;
+    }
+    return entry;
+}
+
+bool NameIs(const ffe::EntryModel::Row& row, const char* name) {
+    return row.name == fs::path(name).native();
+}
+
+} // namespace
+
+FFE_TEST(EntryModelAppend, "entry-model-append") {
+    ffe::EntryModel model;
+    FFE_CHECK(model.empty());
+
+    const fs::path dir = fs::path("root") / "docs";
+    const auto handle = model.addDirectory(dir);
+    FFE_CHECK(model.addDirectory(dir) == handle);
+    model.append(handle, Entry("notes.txt", ffe::EntryType::File, 42));
+    model.append(handle, Entry("old", ffe::EntryType::Directory));
+    model.appendPath(fs::path("root") / "src" / "main.cpp", ffe::EntryType::File);
+    model.appendPath(fs::path("root") / "src" / "util.cpp", ffe::EntryType::File);
+    FFE_CHECK(model.size() == 4);
+
+    const auto notes = model.row(0);
+    FFE_CHECK(NameIs(notes, "notes.txt"));
+    FFE_CHECK(notes.directory == handle);
+    FFE_CHECK(notes.type == ffe::EntryType::File);
+    FFE_CHECK(notes.hasStat && notes.size == 42 && notes.mtime == 1000);
+    FFE_CHECK(!notes.hasDetails);
+
+    const auto old = model.row(1);
+    FFE_CHECK(NameIs(old, "old"));
+    FFE_CHECK(old.isDirectory() && !old.hasStat);
+
+    // Results from one folder share it
+    FFE_CHECK(model.row(2).directory == model.row(3).directory);
+    FFE_CHECK(model.row(2).directory != handle);
+    FFE_CHECK(model.directoryPath(model.row(2).directory) == fs::path("root") / "src");
+
+    FFE_CHECK(model.path(0) == dir / "notes.txt");
+    FFE_CHECK(model.path(3) == fs::path("root") / "src" / "util.cpp");
+    FFE_CHECK(model.memoryUsage() != 0);
+
+    model.clear();
+    FFE_CHECK(model.empty());
+    FFE_CHECK(model.tag(0) == 0);
+}
+
+FFE_TEST(EntryModelRanges, "entry-model-ranges") {
+    ffe::EntryModel model;
+    const auto handle = model.addDirectory("dir");
+    for (int index = 0; index < 10; ++index) {
+        const std::string name = 'f' + std::to_string(index);
+        model.append(handle, Entry(name.c_str(), ffe::EntryType::File, index + 1));
+    }
+
+    std::vector<std::size_t> visited;
+    bool rowsMatch = true;
+    model.forEachRow(3, 6, [&](std::size_t index, const ffe::EntryModel::Row& row) {
+        visited.push_back(index);
+        rowsMatch = rowsMatch && row.size == index + 1;
+    });
+    FFE_CHECK((visited == std::vector<std::size_t>{3, 4, 5}));
+    FFE_CHECK(rowsMatch);
+
+    // Ranges past the end are clamped, empty ones visit nothing
+    visited.clear();
+    model.forEachRow(8, 100, [&](std::size_t index, const ffe::EntryModel::Row&) { visited.push_back(index); });
+    FFE_CHECK((visited == std::vector<std::size_t>{8, 9}));
+    visited.clear();
+    model.forEachRow(12, 20, [&](std::size_t index, const ffe::EntryModel::Row&) { visited.push_back(index); });
+    model.forEachRow(5, 5, [&](std::size_t index, const ffe::EntryModel::Row&) { visited.push_back(index); });
+    FFE_CHECK(visited.empty());
+}
+
+FFE_TEST(EntryModelSort, "entry-model-sort") {
+    ffe::EntryModel model;
+    const auto handle = model.addDirectory("dir");
+    model.append(handle, Entry("b", ffe::EntryType::File, 20));
+    model.append(handle, Entry("c", ffe::EntryType::File, 10));
+    model.append(handle, Entry("a", ffe::EntryType::File, 30));
+    model.setTag(0, 7);
+    model.setTag(2, 9);
+
+    model.sort([](const ffe::EntryModel::Row& a, const ffe::EntryModel::Row& b) { return a.name < b.name; });
+    FFE_CHECK(NameIs(model.row(0), "a") && NameIs(model.row(1), "b") && NameIs(model.row(2), "c"));
+    FFE_CHECK(model.row(0).size == 30 && model.row(1).size == 20 && model.row(2).size == 10);
+    // Tags move with their rows
+    FFE_CHECK(model.tag(0) == 9 && model.tag(1) == 7 && model.tag(2) == 0);
+    FFE_CHECK(model.path(0) == fs::path("dir") / "a");
+
+    const std::uint32_t reversed[] = {2, 1, 0};
+    model.reorder(reversed);
+    FFE_CHECK(NameIs(model.row(0), "c") && NameIs(model.row(2), "a"));
+    FFE_CHECK(model.tag(0) == 0 && model.tag(2) == 9);
+}
+
+FFE_TEST(EntryModelMetadata, "entry-model-metadata") {
+    ffe::EntryModel model;
+    model.appendPath(fs::path("dir") / "late.bin", ffe::EntryType::File);
+    model.appendPath(fs::path("dir") / "other.bin", ffe::EntryType::File);
+    FFE_CHECK(!model.row(0).hasStat && !model.row(0).hasDetails);
+
+    model.setStat(0, 4096, 123456789);
+    auto row = model.row(0);
+    FFE_CHECK(row.hasStat && row.size == 4096 && row.mtime == 123456789);
+    FFE_CHECK(!row.hasDetails);
+
+    model.setDetails(0, 0x20, 5);
+    row = model.row(0);
+    FFE_CHECK(row.hasDetails && row.attributes == 0x20 && row.kind == 5);
+    FFE_CHECK(row.hasStat && row.size == 4096);
+
+    // The other row is untouched
+    FFE_CHECK(!model.row(1).hasStat && !model.row(1).hasDetails);
+
+    model.setTag(1, 3);
+    FFE_CHECK(model.tag(0) == 0 && model.tag(1) == 3);
+}
@@ -0,0 +1,46 @@
+#include "Test.hpp"
+
+#include "engine/Executor.hpp"
+
+#include <atomic>
+#include <latch>
+#include <stdexcept>
+
+FFE_TEST(ExecutorFailures, "executor-failures") {
+    // One worker runs the tasks in submission order
+    ffe::Executor executor(1);
+    std::atomic<int> ran{0};
+    executor.submit([] { throw std::runtime_error("task failed"); });
+    executor.submit([] { throw 42; });
+    executor.submit([&] { ran++; });
+
+    // Whatever was thrown, the worker keeps running and the failures count
+    std::latch done(1);
+    executor.submit([&] { done.count_down(); });
+    done.wait();
+    FFE_CHECK(ran == 1);
+    FFE_CHECK(executor.failedTasks() == 2);
+}
+
+FFE_TEST(ExecutorDiscard, "executor-discard") {
+    std::atomic<int> ran{0};
+    {
+        ffe::Executor executor(1);
+        std::latch started(1);
+        std::latch release(1);
+        executor.submit([&] {
+            started.count_down();
+            release.wait();
+            ran++;
+        });
+        started.wait();
+        for (int task = 0; task < 100; ++task) {
+            executor.submit([&] { ran++; });
+        }
+
+        // The running task finishes, the queued ones are dropped
+        executor.discardQueued();
+        release.count_down();
+    }
+    FFE_CHECK(ran == 1);
+}
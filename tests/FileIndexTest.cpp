@@ -0,0 +1,151 @@
+#include "Test.hpp"
+
+#include "engine/FileIndex.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <set>
+
+namespace {
+
+// root/a.txt, root/docs/{notes.txt,report.doc}, root/docs/old/notes.txt
+void MakeTree(const fs::path& root) {
+    fs::create_directories(root / "docs" / "old");
+    for (const char* file : {"a.txt", "docs/notes.txt", "docs/report.doc", "docs/old/notes.txt"}) {
+        std::ofstream(root / file) << file;
+    }
+    // Out of the way of the racy window, so mtimes compare exactly
+    const auto past = fs::file_time_type::clock::now() - std::chrono::hours(1);
+    for (const fs::path& dir : {root / "docs" / "old", root / "docs", root}) {
+        fs::last_write_time(dir, past);
+    }
+}
+
+bool Contains(ffe::NameView name, const char* needle) {
+    return name.find(fs::path(needle).native()) != ffe::NameView::npos;
+}
+
+// Writes data and reports whether the file opens
+bool Opens(const ffe::IndexData& data, const fs::path& file) {
+    std::error_code ec;
+    ffe::IndexSnapshot snapshot;
+    return ffe::WriteIndex(data, file, ec) && snapshot.open(file, ec);
+}
+
+} // namespace
+
+FFE_TEST(FileIndexRoundTrip, "file-index") {
+    TempDir temp("file-index");
+    const fs::path root = temp.path() / "root";
+    MakeTree(root);
+
+    ffe::Executor executor(2);
+    const ffe::IndexData data = ffe::BuildIndex(root, executor);
+    FFE_CHECK(data.size() == 7); // The root, 2 folders and 4 files
+
+    const fs::path file = temp.path() / "index" / "root.ffindex";
+    std::error_code ec;
+    FFE_CHECK(ffe::WriteIndex(data, file, ec));
+    FFE_CHECK(!fs::exists(fs::path(file).concat(".tmp")));
+
+    ffe::IndexSnapshot snapshot;
+    FFE_CHECK(snapshot.open(file, ec) && snapshot.isOpen());
+    FFE_CHECK(snapshot.size() == 7);
+    FFE_CHECK(snapshot.root() == ffe::NormalizeRoot(root));
+    FFE_CHECK(!snapshot.isStale(std::chrono::hours(1)));
+
+    const auto docs = snapshot.find(root / "docs");
+    const auto report = snapshot.find(root / "docs" / "report.doc");
+    FFE_CHECK(docs && snapshot.type(*docs) == ffe::EntryType::Directory);
+    FFE_CHECK(report && snapshot.type(*report) == ffe::EntryType::File);
+    FFE_CHECK(report && snapshot.fileSize(*report) == 15);
+    FFE_CHECK(report && snapshot.path(*report) == ffe::NormalizeRoot(root) / "docs" / "report.doc");
+    FFE_CHECK(docs && report && snapshot.isWithin(*report, *docs));
+    FFE_CHECK(!snapshot.find(root / "docs" / "missing.txt"));
+    FFE_CHECK(!snapshot.find(temp.path() / "elsewhere"));
+
+    // Matches anywhere, then below docs only
+    std::set<fs::path> everywhere;
+    snapshot.forEachMatch(0, [](ffe::NameView name) { return Contains(name, "notes"); },
+                          [&](std::uint32_t entry) { everywhere.insert(snapshot.path(entry)); });
+    const fs::path normal = ffe::NormalizeRoot(root);
+    FFE_CHECK((everywhere == std::set<fs::path>{normal / "docs" / "notes.txt", normal / "docs" / "old" / "notes.txt"}));
+    const auto old = snapshot.find(root / "docs" / "old");
+    std::set<fs::path> below;
+    snapshot.forEachMatch(*old, [](ffe::NameView name) { return Contains(name, "notes"); },
+                          [&](std::uint32_t entry) { below.insert(snapshot.path(entry)); });
+    FFE_CHECK((below == std::set<fs::path>{normal / "docs" / "old" / "notes.txt"}));
+
+    // A change in the folder searched makes the index stale for it, not
+    // for the root
+    std::ofstream(root / "docs" / "new.txt") << "new";
+    FFE_CHECK(!snapshot.isStale(std::chrono::hours(1)));
+    FFE_CHECK(snapshot.isStale(std::chrono::hours(1), *docs));
+    FFE_CHECK(!snapshot.isStale(std::chrono::hours(1), *old));
+
+    // The mapped copy converts back to the data it was written from
+    const ffe::IndexData copy = snapshot.toData();
+    FFE_CHECK(copy.parents == data.parents && copy.nameOffsets == data.nameOffsets && copy.names == data.names);
+}
+
+FFE_TEST(FileIndexCorrupt, "file-index-corrupt") {
+    TempDir temp("file-index-corrupt");
+    const fs::path root = temp.path() / "root";
+    MakeTree(root);
+    ffe::Executor executor(1);
+    const ffe::IndexData data = ffe::BuildIndex(root, executor);
+    const fs::path file = temp.path() / "corrupt.ffindex";
+    FFE_CHECK(Opens(data, file));
+
+    // Links that would loop or point past the columns
+    ffe::IndexData cycle = data;
+    cycle.parents[3] = 5;
+    FFE_CHECK(!Opens(cycle, file));
+    ffe::IndexData orphan = data;
+    orphan.parents[0] = 0;
+    FFE_CHECK(!Opens(orphan, file));
+    ffe::IndexData children = data;
+    children.firstChildren[1] = 1000;
+    FFE_CHECK(!Opens(children, file));
+    ffe::IndexData names = data;
+    std::swap(names.nameOffsets[2], names.nameOffsets[3]);
+    FFE_CHECK(!Opens(names, file));
+
+    // Truncated
+    std::error_code ec;
+    FFE_CHECK(Opens(data, file));
+    fs::resize_file(file, fs::file_size(file) - 1);
+    ffe::IndexSnapshot snapshot;
+    FFE_CHECK(!snapshot.open(file, ec) && ec);
+
+    // A name count so large that the layout would overflow; nameChars
+    // follows the magic, version, char size and entry count
+    FFE_CHECK(Opens(data, file));
+    {
+        std::fstream patch(file, std::ios::in | std::ios::out | std::ios::binary);
+        const std::uint64_t huge = ~std::uint64_t{0} / 2;
+        patch.seekp(24);
+        patch.write(reinterpret_cast<const char*>(&huge), sizeof(huge));
+    }
+    FFE_CHECK(!snapshot.open(file, ec) && ec);
+
+    // Garbage
+    std::ofstream(file, std::ios::trunc) << "not an index";
+    FFE_CHECK(!snapshot.open(file, ec) && !snapshot.isOpen());
+}
+
+FFE_TEST(FileIndexWriteFailure, "file-index-write-failure") {
+    TempDir temp("file-index-write-failure");
+    const fs::path root = temp.path() / "root";
+    MakeTree(root);
+    ffe::Executor executor(1);
+    const ffe::IndexData data = ffe::BuildIndex(root, executor);
+
+    // The rename onto a folder that holds something fails
+    const fs::path file = temp.path() / "taken";
+    fs::create_directories(file / "inside");
+    std::error_code ec;
+    FFE_CHECK(!ffe::WriteIndex(data, file, ec) && ec);
+    FFE_CHECK(!fs::exists(fs::path(file).concat(".tmp")));
+}
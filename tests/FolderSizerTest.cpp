@@ -0,0 +1,69 @@
+#include "Test.hpp"
+
+#include "engine/FolderSizer.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Sets the mtime of dir an hour or more back, out of the racy window
+void AgeFolder(const fs::path& dir, int hours = 1) {
+    fs::last_write_time(dir, fs::file_time_type::clock::now() - std::chrono::hours(hours));
+}
+
+ffe::FolderSize Measure(ffe::FolderSizer& sizer, const fs::path& dir) {
+    sizer.measure({{0, dir}});
+    sizer.wait();
+    std::vector<ffe::FolderSizeResult> results;
+    sizer.drain(results);
+    return results.size() == 1 ? results.front().size : ffe::FolderSize{};
+}
+
+} // namespace
+
+FFE_TEST(FolderSizerSubtrees, "folder-sizer-subtrees") {
+    TempDir temp("folder-sizer-subtrees");
+    const fs::path root = temp.path() / "root";
+    const fs::path middle = root / "middle";
+    const fs::path deep = middle / "deep";
+    fs::create_directories(deep);
+    fs::create_directories(root / "other");
+    std::ofstream(root / "other" / "a.txt") << "12345";
+    std::ofstream(deep / "b.txt") << "1234567890";
+    for (const fs::path& dir : {deep, middle, root / "other", root}) {
+        AgeFolder(dir);
+    }
+
+    ffe::Executor executor(2);
+    ffe::FolderSizer sizer(executor);
+    ffe::FolderSize size = Measure(sizer, root);
+    FFE_CHECK(size.bytes == 15 && size.files == 2 && size.directories == 3 && size.errors == 0);
+    FFE_CHECK(sizer.stats().cachedSubtrees == 4);
+
+    // Measured again, the root's total is reused without going below it
+    size = Measure(sizer, root);
+    FFE_CHECK(size.bytes == 15 && size.files == 2 && size.directories == 3);
+    ffe::FolderSizer::Stats stats = sizer.stats();
+    FFE_CHECK(stats.subtreesReused == 1 && stats.listingsRead == 4);
+
+    // A change deep below shows above once the changed folder is measured
+    std::ofstream(deep / "c.txt") << "123";
+    AgeFolder(deep, 2);
+    size = Measure(sizer, deep);
+    FFE_CHECK(size.bytes == 13 && size.files == 2);
+    size = Measure(sizer, root);
+    FFE_CHECK(size.bytes == 18 && size.files == 3 && size.directories == 3);
+
+    // Only the changed folder was read again; its untouched sibling's
+    // total was reused
+    stats = sizer.stats();
+    FFE_CHECK(stats.listingsRead == 5);
+    FFE_CHECK(stats.subtreesReused == 3);
+
+    sizer.clear();
+    stats = sizer.stats();
+    FFE_CHECK(stats.cached == 0 && stats.cachedSubtrees == 0 && stats.cachedBytes == 0);
+}
@@ -0,0 +1,135 @@
+#include "Test.hpp"
+
+#include "engine/ListingCache.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <string>
+
+namespace {
+
+// Sets the mtime of dir an hour or more back, out of the racy window
+void AgeFolder(const fs::path& dir, int hours = 1) {
+    fs::last_write_time(dir, fs::file_time_type::clock::now() - std::chrono::hours(hours));
+}
+
+void MakeFolder(const fs::path& dir, int files) {
+    fs::create_directories(dir);
+    for (int index = 0; index < files; ++index) {
+        std::ofstream(dir / ("file_" + std::to_string(index) + ".txt")) << "contents " << index;
+    }
+    AgeFolder(dir);
+}
+
+} // namespace
+
+FFE_TEST(ListingCacheHits, "listing-cache-hits") {
+    TempDir temp("listing-cache-hits");
+    const fs::path dir = temp.path() / "folder";
+    MakeFolder(dir, 3);
+
+    ffe::ListingCache cache;
+    std::error_code ec;
+    const auto first = cache.read(dir, ec);
+    FFE_CHECK(!ec && first->size() == 3);
+    FFE_CHECK(cache.contains(dir));
+    const auto again = cache.read(dir, ec);
+    FFE_CHECK(!ec && again == first);
+
+    auto stats = cache.stats();
+    FFE_CHECK(stats.hits == 1 && stats.misses == 1 && stats.stale == 0);
+    FFE_CHECK(stats.listings == 1 && stats.bytes == ffe::ListingCache::ListingBytes(*first));
+
+    // Sizes come with the listing
+    bool sized = true;
+    for (const auto& entry : *first) {
+        sized = sized && entry.isFile() && entry.hasStat && entry.size == 10;
+    }
+    FFE_CHECK(sized);
+
+    // Adding an entry moves the mtime, so the listing is read again
+    std::ofstream(dir / "added.txt") << "new";
+    AgeFolder(dir, 2);
+    const auto changed = cache.read(dir, ec);
+    FFE_CHECK(!ec && changed->size() == 4 && changed != first);
+    stats = cache.stats();
+    FFE_CHECK(stats.hits == 1 && stats.misses == 2 && stats.stale == 1 && stats.listings == 1);
+
+    cache.invalidate(dir);
+    FFE_CHECK(!cache.contains(dir));
+    FFE_CHECK(cache.lookup(dir) == nullptr);
+    FFE_CHECK(cache.stats().bytes == 0);
+}
+
+FFE_TEST(ListingCacheRacy, "listing-cache-racy") {
+    TempDir temp("listing-cache-racy");
+    const fs::path dir = temp.path() / "folder";
+    fs::create_directories(dir);
+    std::ofstream(dir / "first.txt") << "first";
+    // Just changed, so read within the racy window
+    const auto modified = fs::last_write_time(dir);
+
+    ffe::ListingCache cache;
+    std::error_code ec;
+    const auto first = cache.read(dir, ec);
+    FFE_CHECK(!ec && first->size() == 1 && cache.contains(dir));
+
+    // Served after reading the names again
+    FFE_CHECK(cache.read(dir, ec) == first);
+    auto stats = cache.stats();
+    FFE_CHECK(stats.hits == 1 && stats.rechecks == 1 && stats.stale == 0);
+
+    // A change that leaves the mtime where it was, as on FAT, is caught
+    std::ofstream(dir / "second.txt") << "second";
+    fs::last_write_time(dir, modified);
+    const auto changed = cache.read(dir, ec);
+    FFE_CHECK(!ec && changed->size() == 2);
+    stats = cache.stats();
+    FFE_CHECK(stats.hits == 1 && stats.stale == 1 && stats.misses == 2);
+}
+
+FFE_TEST(ListingCacheErrors, "listing-cache-errors") {
+    TempDir temp("listing-cache-errors");
+    ffe::ListingCache cache;
+    std::error_code ec;
+    const auto entries = cache.read(temp.path() / "missing", ec);
+    FFE_CHECK(ec);
+    FFE_CHECK(entries && entries->empty());
+    FFE_CHECK(!cache.contains(temp.path() / "missing"));
+}
+
+FFE_TEST(ListingCacheEviction, "listing-cache-eviction") {
+    TempDir temp("listing-cache-eviction");
+    const fs::path a = temp.path() / "a";
+    const fs::path b = temp.path() / "b";
+    const fs::path c = temp.path() / "c";
+    for (const auto& dir : {a, b, c}) {
+        MakeFolder(dir, 8);
+    }
+
+    ffe::ListingCache::Fetched fetched;
+    std::error_code ec;
+    FFE_CHECK(ffe::ListingCache::Fetch(a, fetched, ec));
+    const std::size_t listingBytes = ffe::ListingCache::ListingBytes(*fetched.entries);
+
+    // Room for two listings
+    ffe::ListingCache cache(listingBytes * 2 + listingBytes / 2);
+    cache.insert(std::move(fetched), true);
+    cache.read(b, ec);
+    FFE_CHECK(cache.lookup(a) != nullptr); // a is now the most recently used
+    cache.read(c, ec);
+
+    FFE_CHECK(cache.contains(a) && !cache.contains(b) && cache.contains(c));
+    const auto stats = cache.stats();
+    FFE_CHECK(stats.evictions == 1 && stats.listings == 2);
+    FFE_CHECK(stats.prefetched == 1 && stats.prefetchHits == 1);
+    FFE_CHECK(stats.bytes <= listingBytes * 2 + listingBytes / 2);
+
+    // A listing larger than the whole cache is not kept
+    ffe::ListingCache tiny(16);
+    tiny.read(a, ec);
+    FFE_CHECK(!tiny.contains(a) && tiny.stats().bytes == 0);
+
+    cache.clear();
+    FFE_CHECK(!cache.contains(a) && cache.stats().listings == 0 && cache.stats().bytes == 0);
+}
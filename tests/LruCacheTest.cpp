@@ -0,0 +1,39 @@
+#include "Test.hpp"
+
+#include "engine/LruCache.hpp"
+
+#include <string>
+#include <vector>
+
+FFE_TEST(LruCacheEviction, "lru-cache-eviction") {
+    ffe::LruCache<std::string, int> cache(10);
+    std::vector<std::string> dropped;
+    const auto drop = [&dropped](const std::string& key, int) { dropped.push_back(key); };
+
+    FFE_CHECK(cache.insert("a", 1, 4, drop));
+    FFE_CHECK(cache.insert("b", 2, 4, drop));
+    FFE_CHECK(cache.cost() == 8);
+
+    // Finding a makes b the least recently used, so b goes first
+    FFE_CHECK(cache.find("a") && *cache.find("a") == 1);
+    FFE_CHECK(cache.insert("c", 3, 4, drop));
+    FFE_CHECK(dropped == std::vector<std::string>{"b"});
+    FFE_CHECK(cache.evictions() == 1);
+    FFE_CHECK(!cache.find("b"));
+    FFE_CHECK(cache.size() == 2 && cache.cost() == 8);
+
+    // Replacing a key takes back its old cost and is no eviction
+    FFE_CHECK(cache.insert("c", 30, 2, drop));
+    FFE_CHECK(*cache.find("c") == 30);
+    FFE_CHECK(cache.cost() == 6 && cache.evictions() == 1);
+
+    // A value costing more than the capacity is not kept
+    FFE_CHECK(!cache.insert("big", 4, 11, drop));
+    FFE_CHECK(!cache.contains("big"));
+
+    FFE_CHECK(cache.erase("a"));
+    FFE_CHECK(!cache.erase("a"));
+    FFE_CHECK(cache.cost() == 2);
+    cache.clear();
+    FFE_CHECK(cache.size() == 0 && cache.cost() == 0);
+}
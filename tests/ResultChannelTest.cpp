@@ -0,0 +1,119 @@
+#include "Test.hpp"
+
+#include "engine/FramePacer.hpp"
+#include "engine/ResultChannel.hpp"
+
+#include <atomic>
+#include <thread>
+
+FFE_TEST(ResultChannelOrder, "result-channel-order") {
+    int ready = 0;
+    ffe::ResultChannel<int> channel([&ready] { ready++; });
+    FFE_CHECK(channel.empty());
+
+    channel.publish({1, 2});
+    channel.publish({3});
+    channel.publish({});
+    channel.publish({4, 5});
+    FFE_CHECK(!channel.empty());
+    // Only the batch that found the channel empty wakes the consumer
+    FFE_CHECK(ready == 1);
+
+    std::vector<int> out{0};
+    FFE_CHECK(channel.drain(out) == 5);
+    FFE_CHECK((out == std::vector<int>{0, 1, 2, 3, 4, 5}));
+    FFE_CHECK(channel.empty());
+    FFE_CHECK(channel.drain(out) == 0);
+
+    channel.publish({6});
+    FFE_CHECK(ready == 2);
+}
+
+FFE_TEST(ResultChannelBatch, "result-channel-batch") {
+    ffe::ResultChannel<int> channel;
+    std::vector<int> out;
+    {
+        ffe::ResultChannel<int>::Batch batch(channel, 3);
+        batch.add(1);
+        batch.add(2);
+        FFE_CHECK(channel.empty());
+        batch.add(3);
+        FFE_CHECK(channel.drain(out) == 3);
+        batch.add(4);
+    }
+    // The rest is published when the batch goes away
+    FFE_CHECK(channel.drain(out) == 1);
+    FFE_CHECK((out == std::vector<int>{1, 2, 3, 4}));
+}
+
+FFE_TEST(ResultChannelProducers, "result-channel-producers") {
+    constexpr int Producers = 4;
+    constexpr int PerProducer = 10000;
+    ffe::ResultChannel<int> channel;
+    std::atomic<int> done{0};
+    std::vector<std::thread> producers;
+    for (int producer = 0; producer < Producers; ++producer) {
+        producers.emplace_back([&, producer] {
+            ffe::ResultChannel<int>::Batch batch(channel, 64);
+            for (int index = 0; index < PerProducer; ++index) {
+                batch.add(producer * PerProducer + index);
+            }
+            batch.flush();
+            done++;
+        });
+    }
+
+    // Drains while the producers run; each one's results stay in order
+    std::vector<int> out;
+    while (done.load() != Producers) {
+        channel.drain(out);
+        std::this_thread::yield();
+    }
+    for (auto& thread : producers) {
+        thread.join();
+    }
+    channel.drain(out);
+
+    FFE_CHECK(out.size() == static_cast<std::size_t>(Producers * PerProducer));
+    std::vector<int> next(Producers);
+    bool ordered = true;
+    for (int value : out) {
+        const int producer = value / PerProducer;
+        ordered = ordered && value == producer * PerProducer + next[producer]++;
+    }
+    FFE_CHECK(ordered);
+}
+
+FFE_TEST(FramePacerBudget, "frame-pacer") {
+    using namespace std::chrono_literals;
+    using Clock = ffe::FramePacer::Clock;
+    ffe::FramePacer pacer(16ms, 8ms);
+    const Clock::time_point start{};
+
+    // Nothing measured yet
+    FFE_CHECK(pacer.itemBudget() == ffe::FramePacer::InitialItems);
+    FFE_CHECK(pacer.wait(start) == Clock::duration::zero());
+
+    // 1000 items in 4 ms: 4 us each, so 2000 fit in the 8 ms budget
+    pacer.record(start, start + 4ms, 1000);
+    FFE_CHECK(pacer.itemBudget() == 2000);
+    // The next frame starts a frame after this one
+    FFE_CHECK(pacer.wait(start + 4ms) == 12ms);
+    FFE_CHECK(pacer.wait(start + 20ms) == Clock::duration::zero());
+
+    // A slow frame leaves the rest of the frame to the UI after it
+    pacer.record(start + 16ms, start + 36ms, 1000);
+    FFE_CHECK(pacer.wait(start + 36ms) == 8ms);
+    // The cost moves a quarter of the way to 20 us: 8 us an item
+    FFE_CHECK(pacer.itemBudget() == 1000);
+
+    // Very slow items still get a few per frame
+    for (int frame = 0; frame < 50; ++frame) {
+        pacer.record(start, start + 1s, 1);
+    }
+    FFE_CHECK(pacer.itemBudget() == ffe::FramePacer::MinItems);
+
+    pacer.reset();
+    FFE_CHECK(pacer.itemBudget() == ffe::FramePacer::InitialItems);
+    FFE_CHECK(pacer.wait(start) == Clock::duration::zero());
+}
@@ -0,0 +1,75 @@
+#include "Test.hpp"
+
+#include "engine/DirectoryReader.hpp"
+#include "engine/StatEngine.hpp"
+
+#include <fstream>
+#include <latch>
+#include <string>
+
+namespace {
+
+// Lists dir with sizes and times forgotten, as enumeration on Linux leaves them
+std::vector<ffe::DirEntry> Unstated(const fs::path& dir) {
+    std::vector<ffe::DirEntry> entries;
+    std::error_code ec;
+    ffe::ReadDirectory(dir, entries, ec);
+    for (auto& entry : entries) {
+        entry.hasStat = false;
+        entry.size = 0;
+    }
+    return entries;
+}
+
+// Whether every entry got the size its name gives
+bool Sized(const std::vector<ffe::DirEntry>& entries) {
+    for (const auto& entry : entries) {
+        const std::string name = fs::path(entry.name).string();
+        if (!entry.hasStat || entry.size != std::stoul(name.substr(0, name.find('.')))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+FFE_TEST(StatEngineBackends, "stat-engine") {
+    TempDir temp("stat-engine");
+    // More entries than are stat'ed together, so the pool splits them
+    constexpr int Files = 600;
+    for (int index = 0; index < Files; ++index) {
+        std::ofstream(temp.path() / (std::to_string(index) + ".bin")) << std::string(index, 'x');
+    }
+
+    using Backend = ffe::StatEngine::Backend;
+    ffe::Executor executor(2);
+    std::vector<ffe::StatEngine> engines = {ffe::StatEngine(nullptr, Backend::Threads),
+                                            ffe::StatEngine(&executor, Backend::Threads)};
+    if (ffe::StatEngine::IoUringAvailable()) {
+        engines.emplace_back(nullptr, Backend::IoUring, 8);
+    }
+    for (const auto& engine : engines) {
+        auto entries = Unstated(temp.path());
+        FFE_CHECK(engine.statEntries(temp.path(), entries) == Files);
+        FFE_CHECK(Sized(entries));
+    }
+
+    // The shared engine, from outside an executor and from one of its workers
+    auto entries = Unstated(temp.path());
+    std::vector<ffe::FileIdentity> identities(entries.size());
+    FFE_CHECK(ffe::StatEntries(temp.path(), entries, identities) == Files);
+    FFE_CHECK(Sized(entries));
+    FFE_CHECK(identities.front().known() && identities.front().links == 1);
+
+    auto workerEntries = Unstated(temp.path());
+    std::size_t filled = 0;
+    std::latch done(1);
+    executor.submit([&] {
+        filled = ffe::StatEntries(temp.path(), workerEntries);
+        done.count_down();
+    });
+    done.wait();
+    FFE_CHECK(filled == Files);
+    FFE_CHECK(Sized(workerEntries));
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <filesystem>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+using TestFunction = void (*)();
+
+struct TestInfo {
+    const char* name;
+    TestFunction function;
+};
+
+// Registers a test at static initialization time
+struct TestRegistration {
+    TestRegistration(const char* name, TestFunction function);
+};
+
+const std::vector<TestInfo>& RegisteredTests();
+
+// Records a failed check of the running test; the test goes on, so one run
+// shows every check that fails
+void ReportFailure(const char* file, int line, const char* expression);
+
+#define FFE_TEST(id, name)                                        \
+    static void id();                                             \
+    static const TestRegistration id##Registration(name, id);     \
+    static void id()
+
+#define FFE_CHECK(expression)                                \
+    do {                                                     \
+        if (!(expression)) {                                 \
+            ReportFailure(__FILE__, __LINE__, #expression);  \
+        }                                                    \
+    } while (false)
+
+// An empty folder below the temporary directory, removed with everything
+// in it when the test is done
+class TempDir {
+public:
+    explicit TempDir(const char* name);
+    ~TempDir();
+
+    TempDir(const TempDir&) = delete;
+    TempDir& operator=(const TempDir&) = delete;
+
+    const fs::path& path() const noexcept {
+        return root;
+    }
+
+private:
+    fs::path root;
+};
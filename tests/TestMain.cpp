@@ -0,0 +1,76 @@
+#include "Test.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <exception>
+#include <string>
+#include <system_error>
+
+namespace {
+
+std::vector<TestInfo>& Registry() {
+    static std::vector<TestInfo> tests;
+    return tests;
+}
+
+int g_failures = 0; // Failed checks of the running test
+
+} // namespace
+
+TestRegistration::TestRegistration(const char* name, TestFunction function) {
+    Registry().push_back({name, function});
+}
+
+const std::vector<TestInfo>& RegisteredTests() {
+    return Registry();
+}
+
+void ReportFailure(const char* file, int line, const char* expression) {
+    std::printf("  %s:%d: check failed: %s\n", file, line, expression);
+    g_failures++;
+}
+
+TempDir::TempDir(const char* name) : root(fs::temp_directory_path() / (std::string("ffe-test-") + name)) {
+    fs::remove_all(root);
+    fs::create_directories(root);
+}
+
+TempDir::~TempDir() {
+    std::error_code ec;
+    fs::remove_all(root, ec);
+}
+
+// Runs the tests named on the command line, or all of them; --list prints
+// their names
+int main(int argc, char** argv) {
+    std::vector<std::string> selected(argv + 1, argv + argc);
+    if (selected.size() == 1 && selected.front() == "--list") {
+        for (const auto& test : RegisteredTests()) {
+            std::printf("%s\n", test.name);
+        }
+        return 0;
+    }
+
+    int failed = 0;
+    int ran = 0;
+    for (const auto& test : RegisteredTests()) {
+        if (!selected.empty() && std::find(selected.begin(), selected.end(), test.name) == selected.end()) {
+            continue;
+        }
+        g_failures = 0;
+        std::printf("== %s\n", test.name);
+        try {
+            test.function();
+        } catch (const std::exception& error) {
+            std::printf("  threw: %s\n", error.what());
+            g_failures++;
+        }
+        if (g_failures != 0) {
+            std::printf("!! %s failed\n", test.name);
+            failed++;
+        }
+        ran++;
+    }
+    std::printf("\n%d of %d tests passed\n", ran - failed, ran);
+    return failed == 0 && ran != 0 ? 0 : 1;
+}
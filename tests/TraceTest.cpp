@@ -0,0 +1,47 @@
+#include "Test.hpp"
+
+#include "engine/Trace.hpp"
+
+#include <string>
+#include <thread>
+
+namespace {
+
+std::string Export() {
+    std::string json;
+    ffe::Trace::AppendChromeJson(json);
+    return json;
+}
+
+} // namespace
+
+FFE_TEST(TraceExitedThreads, "trace-exited-threads") {
+    ffe::Trace::Clear();
+    ffe::Trace::Enable(true);
+
+    // A thread that recorded spans keeps them after it exits
+    std::thread([] {
+        ffe::Trace::SetThreadName("trace test recorder");
+        ffe::TraceSpan span("trace test span");
+    }).join();
+
+    // A thread with nothing recorded leaves nothing behind
+    std::thread([] { ffe::Trace::SetThreadName("trace test idle"); }).join();
+
+    const std::string recorded = Export();
+    FFE_CHECK(recorded.find("trace test recorder") != std::string::npos);
+    FFE_CHECK(recorded.find("trace test span") != std::string::npos);
+    FFE_CHECK(recorded.find("trace test idle") == std::string::npos);
+
+    // Clearing drops the exited thread altogether
+    ffe::Trace::Clear();
+    const std::string cleared = Export();
+    FFE_CHECK(cleared.find("trace test recorder") == std::string::npos);
+
+    // A later thread records into a reused buffer
+    std::thread([] { ffe::TraceSpan span("trace test reused"); }).join();
+    FFE_CHECK(Export().find("trace test reused") != std::string::npos);
+
+    ffe::Trace::Enable(false);
+    ffe::Trace::Clear();
+}